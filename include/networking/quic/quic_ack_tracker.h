@@ -0,0 +1,128 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_ACK_TRACKER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_ACK_TRACKER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "quic_frame.h"
+#include "quic_packet_builder.h"
+#include "quic_version.h"
+#include "rfc9000.h"
+
+namespace bedrock::network {
+
+// Ranges kept per packet number space. An ACK frame of this many ranges
+// still fits a minimum sized datagram.
+inline constexpr std::size_t kQuicAckTrackerMaxRanges = 32;
+// ack_delay_exponent default (rfc9000 section 18.2)
+inline constexpr std::uint8_t kQuicDefaultAckDelayExponent = 3;
+
+enum class QuicAckTrackerErrorStatus {
+  kSuccess,
+  kDuplicate,  // already received, or below the tracked window
+};
+
+// Received packet numbers of one packet number space, kept as a sorted set
+// of disjoint ranges from the largest packet number down, the order an ACK
+// frame is written in. A connection owns one tracker per
+// QuicPacketNumberSpaceV1.
+//
+// The ranges live in a fixed array twice kQuicAckTrackerMaxRanges long and
+// grow towards its front. In-order arrival extends the top range in place,
+// and a new top range after a gap only moves the live ranges back to the end
+// once the front is used up, so both are O(1) amortized. Reordered packets
+// are inserted by binary search. When more than kQuicAckTrackerMaxRanges
+// ranges would be needed, the smallest range is dropped and everything below
+// it is treated as a duplicate from then on.
+class QuicAckTracker {
+ public:
+  explicit QuicAckTracker(
+      QuicPacketNumberSpaceV1 packet_number_space =
+          QuicPacketNumberSpaceV1::kApplicationData) noexcept
+      : space(packet_number_space) {}
+
+  // Records a packet after it was successfully unprotected. Duplicates must
+  // not be processed again (rfc9000 section 12.3).
+  QuicAckTrackerErrorStatus OnPacketReceived(
+      std::uint64_t packet_number, bool ack_eliciting,
+      std::chrono::steady_clock::time_point now) noexcept;
+
+  bool Contains(std::uint64_t packet_number) const noexcept;
+
+  std::span<const QuicAckRangeV1> Ranges() const noexcept {
+    return std::span(ranges).subspan(begin, count);
+  }
+  bool Empty() const noexcept { return count == 0; }
+  // 0 while Empty().
+  std::uint64_t LargestReceived() const noexcept {
+    return count == 0 ? 0 : ranges[begin].largest;
+  }
+
+  // Whether ack-eliciting packets arrived since the last ACK was written.
+  bool AckPending() const noexcept { return ack_eliciting_pending != 0; }
+  // Whether the pending ACK must not wait for max_ack_delay: Initial and
+  // Handshake packets, every second ack-eliciting packet and reordered or
+  // gapped packets are acknowledged at once (rfc9000 section 13.2.1).
+  bool AckImmediately() const noexcept {
+    return ack_eliciting_pending != 0 &&
+           (immediate || ack_eliciting_pending >= 2 ||
+            space != QuicPacketNumberSpaceV1::kApplicationData);
+  }
+
+  // Time since the largest packet number was received, in units of
+  // 2^ack_delay_exponent microseconds.
+  std::uint64_t AckDelay(std::chrono::steady_clock::time_point now,
+                         std::uint8_t ack_delay_exponent =
+                             kQuicDefaultAckDelayExponent) const noexcept;
+
+  // Writes an ACK frame of the tracked ranges to the open packet and clears
+  // the pending state. Smallest ranges are left out when space runs short.
+  template <QuicVersionTraits Version>
+  QuicPacketBuilderErrorStatus WriteAckFrame(
+      QuicPacketBuilder<Version>& builder,
+      std::chrono::steady_clock::time_point now,
+      std::uint8_t ack_delay_exponent =
+          kQuicDefaultAckDelayExponent) noexcept {
+    if (count == 0) {
+      return QuicPacketBuilderErrorStatus::kInternal;
+    }
+    QuicPacketBuilderErrorStatus status = builder.AppendAckFrame(
+        Ranges(), AckDelay(now, ack_delay_exponent));
+    if (status == QuicPacketBuilderErrorStatus::kSuccess) {
+      ack_eliciting_pending = 0;
+      immediate = false;
+    }
+    return status;
+  }
+
+  // A packet carrying our ACK with this Largest Acknowledged was itself
+  // acknowledged, so packets below it need not be reported again
+  // (rfc9000 section 13.2.4).
+  void OnAckAcknowledged(std::uint64_t largest_acknowledged) noexcept;
+
+ private:
+  // Opens a new top range for a packet above LargestReceived() + 1.
+  void PushLargest(std::uint64_t packet_number) noexcept;
+  // Slow path for a packet below LargestReceived().
+  QuicAckTrackerErrorStatus InsertReordered(
+      std::uint64_t packet_number) noexcept;
+  void DropSmallest() noexcept;
+
+  std::array<QuicAckRangeV1, 2 * kQuicAckTrackerMaxRanges> ranges{};
+  std::size_t begin = ranges.size();
+  std::size_t count = 0;
+  // Packets below this are duplicates or too old to track.
+  std::uint64_t smallest_tracked = 0;
+
+  QuicPacketNumberSpaceV1 space;
+  std::uint32_t ack_eliciting_pending = 0;
+  bool immediate = false;
+  std::chrono::steady_clock::time_point largest_received_time{};
+};
+
+}  // namespace bedrock::network
+
+#endif
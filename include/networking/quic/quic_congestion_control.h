@@ -0,0 +1,314 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CONGESTION_CONTROL_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CONGESTION_CONTROL_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "quic_loss_detection.h"
+
+namespace bedrock::network {
+
+struct QuicCongestionConfig {
+ public:
+  std::uint64_t max_datagram_size = 1200;
+  // rfc9002 section 7.2
+  std::uint64_t initial_window_packets = 10;
+  std::uint64_t minimum_window_packets = 2;
+};
+
+// A congestion controller fed by QuicLossDetection. The sender takes the
+// controller as a template argument, so the algorithm is fixed at compile
+// time and the per-ACK calls inline into the ACK path.
+//
+// OnPacketsAcked and OnPacketsLost take the outcome of one ACK frame or loss
+// timeout and the bytes in flight after it. PacingRate is in bytes per
+// second. OnPathChanged starts over from the initial window when the
+// connection migrates, since what was learned about the old path says
+// nothing about the new one (rfc9000 section 9.4).
+template <typename T>
+concept QuicCongestionController =
+    requires(T controller, const T& const_controller,
+             const QuicLossDetectionOutcome& outcome,
+             const QuicRTTEstimator& rtt, std::uint64_t bytes,
+             std::chrono::steady_clock::time_point now) {
+      controller.OnPacketSent(bytes, now);
+      controller.OnPacketsAcked(outcome, rtt, bytes, now);
+      controller.OnPacketsLost(outcome, rtt, bytes, now);
+      controller.OnPathChanged();
+      { const_controller.CongestionWindow() } -> std::same_as<std::uint64_t>;
+      { const_controller.PacingRate(rtt) } -> std::same_as<std::uint64_t>;
+    };
+
+// rfc9002 section 7.7: pace at 5/4 of cwnd per smoothed RTT, so that
+// pacing alone does not keep a window based controller below its cwnd.
+inline std::uint64_t QuicWindowPacingRate(std::uint64_t congestion_window,
+                                          const QuicRTTEstimator& rtt) {
+  auto smoothed = static_cast<std::uint64_t>(
+      std::max<std::int64_t>(rtt.SmoothedRTT().count(), 1));
+  return congestion_window * 5 / 4 * 1000000 / smoothed;
+}
+
+// NewReno (rfc9002 section 7.3 and appendix B)
+class QuicNewReno {
+ public:
+  explicit QuicNewReno(const QuicCongestionConfig& congestion_config = {})
+      noexcept
+      : config(congestion_config),
+        congestion_window(config.initial_window_packets *
+                          config.max_datagram_size) {}
+
+  void OnPathChanged() noexcept { *this = QuicNewReno(config); }
+
+  void OnPacketSent(std::uint64_t, std::chrono::steady_clock::time_point)
+      noexcept {}
+
+  void OnPacketsAcked(const QuicLossDetectionOutcome& outcome,
+                      const QuicRTTEstimator&, std::uint64_t,
+                      std::chrono::steady_clock::time_point) noexcept {
+    // no growth for packets sent before the recovery period began
+    if (outcome.acked_bytes == 0 ||
+        outcome.largest_acked_time_sent <= recovery_start_time) {
+      return;
+    }
+    if (congestion_window < slow_start_threshold) {
+      congestion_window += outcome.acked_bytes;
+      return;
+    }
+    // one datagram per congestion window acknowledged
+    bytes_acked += outcome.acked_bytes;
+    while (bytes_acked >= congestion_window) {
+      bytes_acked -= congestion_window;
+      congestion_window += config.max_datagram_size;
+    }
+  }
+
+  void OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                     const QuicRTTEstimator& rtt,
+                     std::uint64_t bytes_in_flight,
+                     std::chrono::steady_clock::time_point now) noexcept;
+
+  std::uint64_t CongestionWindow() const noexcept { return congestion_window; }
+  std::uint64_t SlowStartThreshold() const noexcept {
+    return slow_start_threshold;
+  }
+  std::uint64_t PacingRate(const QuicRTTEstimator& rtt) const noexcept {
+    return QuicWindowPacingRate(congestion_window, rtt);
+  }
+
+ private:
+  QuicCongestionConfig config;
+  std::uint64_t congestion_window;
+  std::uint64_t slow_start_threshold =
+      std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t bytes_acked = 0;
+  std::chrono::steady_clock::time_point recovery_start_time{};
+};
+
+// CUBIC (rfc9438) with its Reno-friendly region and fast convergence.
+// Slow start is the same as NewReno's; HyStart++ is not implemented.
+class QuicCubic {
+ public:
+  // rfc9438 section 4.6 and 5
+  static constexpr double kC = 0.4;
+  static constexpr double kBeta = 0.7;
+
+  explicit QuicCubic(const QuicCongestionConfig& congestion_config = {})
+      noexcept
+      : config(congestion_config),
+        congestion_window(config.initial_window_packets *
+                          config.max_datagram_size) {}
+
+  void OnPathChanged() noexcept { *this = QuicCubic(config); }
+
+  void OnPacketSent(std::uint64_t, std::chrono::steady_clock::time_point)
+      noexcept {}
+
+  void OnPacketsAcked(const QuicLossDetectionOutcome& outcome,
+                      const QuicRTTEstimator& rtt, std::uint64_t,
+                      std::chrono::steady_clock::time_point now) noexcept {
+    if (outcome.acked_bytes == 0 ||
+        outcome.largest_acked_time_sent <= recovery_start_time) {
+      return;
+    }
+    if (congestion_window < slow_start_threshold) {
+      congestion_window += outcome.acked_bytes;
+      return;
+    }
+    if (!in_epoch) {
+      StartEpoch(now);
+    }
+    CongestionAvoidance(outcome.acked_bytes, rtt, now);
+  }
+
+  void OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                     const QuicRTTEstimator& rtt,
+                     std::uint64_t bytes_in_flight,
+                     std::chrono::steady_clock::time_point now) noexcept;
+
+  std::uint64_t CongestionWindow() const noexcept { return congestion_window; }
+  std::uint64_t SlowStartThreshold() const noexcept {
+    return slow_start_threshold;
+  }
+  // Time for the cubic function to climb back to W_max, in seconds
+  double K() const noexcept { return k; }
+  std::uint64_t PacingRate(const QuicRTTEstimator& rtt) const noexcept {
+    return QuicWindowPacingRate(congestion_window, rtt);
+  }
+
+ private:
+  void StartEpoch(std::chrono::steady_clock::time_point now) noexcept;
+  void CongestionAvoidance(std::uint64_t acked_bytes,
+                           const QuicRTTEstimator& rtt,
+                           std::chrono::steady_clock::time_point now) noexcept;
+
+  QuicCongestionConfig config;
+  std::uint64_t congestion_window;
+  std::uint64_t slow_start_threshold =
+      std::numeric_limits<std::uint64_t>::max();
+  std::chrono::steady_clock::time_point recovery_start_time{};
+
+  // In datagrams, as rfc9438 defines the window function
+  bool in_epoch = false;
+  std::chrono::steady_clock::time_point epoch_start{};
+  double k = 0;
+  double window_max = 0;
+  double previous_window_max = 0;
+  double reno_window = 0;  // W_est
+};
+
+// A BBR style model based controller. It paces at the bottleneck bandwidth
+// (the maximum delivery rate of the last ten rounds) and bounds the window
+// by a multiple of the bandwidth-delay product built from that bandwidth
+// and a ten second windowed min RTT. It moves through Startup, Drain,
+// ProbeBW gain cycling and ProbeRTT like BBR, and reacts to loss the way
+// BBRv2 does: a round losing more than 2% of its deliveries caps the
+// inflight bound, which then grows back exponentially while probing.
+//
+// Delivery rate is sampled once per round from the bytes acknowledged in
+// it rather than per packet, so no per packet delivery state is kept.
+class QuicBBR {
+ public:
+  enum class Mode : std::uint8_t { kStartup, kDrain, kProbeBW, kProbeRTT };
+
+  // 2/ln(2), BBR's Startup gain
+  static constexpr double kHighGain = 2.885;
+  static constexpr std::size_t kBandwidthFilterRounds = 10;
+  static constexpr std::array<double, 8> kProbeBWGains = {
+      1.25, 0.75, 1, 1, 1, 1, 1, 1};
+  static constexpr std::chrono::seconds kMinRTTWindow{10};
+  static constexpr std::chrono::milliseconds kProbeRTTDuration{200};
+  // BBRv2 loss threshold, 2% of a round's deliveries
+  static constexpr std::uint64_t kLossThresholdDivisor = 50;
+  static constexpr double kBeta = 0.7;
+
+  explicit QuicBBR(const QuicCongestionConfig& congestion_config = {})
+      noexcept
+      : config(congestion_config),
+        congestion_window(config.initial_window_packets *
+                          config.max_datagram_size) {}
+
+  void OnPathChanged() noexcept { *this = QuicBBR(config); }
+
+  void OnPacketSent(std::uint64_t, std::chrono::steady_clock::time_point)
+      noexcept {}
+
+  void OnPacketsAcked(const QuicLossDetectionOutcome& outcome,
+                      const QuicRTTEstimator& rtt,
+                      std::uint64_t bytes_in_flight,
+                      std::chrono::steady_clock::time_point now) noexcept {
+    delivered += outcome.acked_bytes;
+    if (outcome.rtt_updated) {
+      UpdateMinRTT(rtt.LatestRTT(), now);
+    }
+    if (outcome.acked_bytes != 0 &&
+        outcome.largest_acked_time_sent > round_start) {
+      OnRoundEnd(now);
+    }
+    UpdateMode(bytes_in_flight, now);
+
+    std::uint64_t target = Target();
+    if (full_bandwidth_reached) {
+      congestion_window =
+          std::min(congestion_window + outcome.acked_bytes, target);
+    } else if (congestion_window < target ||
+               delivered < config.initial_window_packets *
+                               config.max_datagram_size) {
+      congestion_window += outcome.acked_bytes;
+    }
+    congestion_window = std::max(congestion_window, MinimumWindow());
+  }
+
+  void OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                     const QuicRTTEstimator& rtt,
+                     std::uint64_t bytes_in_flight,
+                     std::chrono::steady_clock::time_point now) noexcept;
+
+  std::uint64_t CongestionWindow() const noexcept {
+    return mode == Mode::kProbeRTT
+               ? std::min(congestion_window, MinimumWindow())
+               : std::min(congestion_window, inflight_high);
+  }
+  std::uint64_t PacingRate(const QuicRTTEstimator& rtt) const noexcept;
+
+  Mode CurrentMode() const noexcept { return mode; }
+  // Bytes per second
+  std::uint64_t BottleneckBandwidth() const noexcept { return bandwidth; }
+  std::chrono::microseconds MinRTT() const noexcept { return min_rtt; }
+
+ private:
+  void UpdateMinRTT(std::chrono::microseconds sample,
+                    std::chrono::steady_clock::time_point now) noexcept;
+  void OnRoundEnd(std::chrono::steady_clock::time_point now) noexcept;
+  void UpdateMode(std::uint64_t bytes_in_flight,
+                  std::chrono::steady_clock::time_point now) noexcept;
+  // gain * BDP, plus room for delayed and aggregated ACKs
+  std::uint64_t Target() const noexcept;
+  std::uint64_t BandwidthDelayProduct() const noexcept;
+  std::uint64_t MinimumWindow() const noexcept {
+    return 4 * config.max_datagram_size;
+  }
+  double PacingGain() const noexcept;
+  double WindowGain() const noexcept;
+
+  QuicCongestionConfig config;
+  std::uint64_t congestion_window;
+  Mode mode = Mode::kStartup;
+
+  // Delivery rate samples, one per round, and their windowed maximum
+  std::uint64_t delivered = 0;
+  std::uint64_t round_count = 0;
+  std::chrono::steady_clock::time_point round_start{};
+  std::uint64_t round_delivered = 0;
+  std::uint64_t round_lost = 0;
+  bool round_loss_handled = false;
+  std::array<std::uint64_t, kBandwidthFilterRounds> bandwidth_samples{};
+  std::uint64_t bandwidth = 0;
+
+  // Startup ends once bandwidth stops growing by 25% for three rounds
+  bool full_bandwidth_reached = false;
+  std::uint64_t full_bandwidth = 0;
+  std::uint32_t full_bandwidth_rounds = 0;
+
+  std::chrono::microseconds min_rtt{0};
+  std::chrono::steady_clock::time_point min_rtt_stamp{};
+  std::size_t cycle_index = 0;
+  std::chrono::steady_clock::time_point cycle_start{};
+  std::chrono::steady_clock::time_point probe_rtt_done{};
+
+  // BBRv2 inflight_hi and its growth while probing without loss
+  std::uint64_t inflight_high = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t probe_up_packets = 1;
+};
+
+static_assert(QuicCongestionController<QuicNewReno>);
+static_assert(QuicCongestionController<QuicCubic>);
+static_assert(QuicCongestionController<QuicBBR>);
+
+}  // namespace bedrock::network
+
+#endif
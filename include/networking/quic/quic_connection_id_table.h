@@ -0,0 +1,127 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CONNECTION_ID_TABLE_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CONNECTION_ID_TABLE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace bedrock::network {
+
+// Connection IDs are at most 20 bytes in QUIC version 1 (rfc9000 section
+// 17.2)
+inline constexpr std::size_t kQuicMaxConnectionIDLength = 20;
+inline constexpr std::size_t kQuicConnectionIDTableShards = 64;
+// Lookups prefetched together by the batched Find()
+inline constexpr std::size_t kQuicConnectionIDTableBatch = 16;
+
+// Identifies a connection and the worker that owns it.
+struct QuicConnectionHandle {
+ public:
+  std::uint32_t worker = 0;
+  std::uint32_t connection = 0;
+
+  bool operator==(const QuicConnectionHandle&) const = default;
+};
+
+enum class QuicConnectionIDTableErrorStatus {
+  kSuccess,
+  kDuplicate,  // connection ID is already routed
+  kNotFound,   // connection ID is not in the table
+  kFull,       // the shard of the connection ID has no free slot
+  kInvalid     // connection ID length differs from the table's
+};
+
+// Maps server chosen connection IDs of one fixed length to connections, so the
+// Destination Connection ID of a short header packet can be read without
+// knowing its length from the packet. A connection may own any number of
+// entries; each is added when issued in NEW_CONNECTION_ID and retired on its
+// own.
+//
+// The table is split into shards by hash. Each shard is an open addressing
+// table of fixed capacity guarded by a sequence lock: writers of a shard take
+// its mutex, while Find() never writes shared memory and only retries if a
+// writer touched the shard meanwhile. Lookups from any number of threads thus
+// scale without cache line contention.
+class QuicConnectionIDTable {
+ public:
+  // capacity is the number of entries the table must hold. Each shard is
+  // sized for its share plus a margin for uneven hashing, at a load factor
+  // of at most 3/4.
+  QuicConnectionIDTable(std::size_t connection_id_length,
+                        std::size_t capacity) noexcept;
+  QuicConnectionIDTable(const QuicConnectionIDTable&) = delete;
+  QuicConnectionIDTable& operator=(const QuicConnectionIDTable&) = delete;
+
+  std::size_t ConnectionIDLength() const noexcept { return length; }
+  std::size_t Size() const noexcept;
+
+  // The Destination Connection ID of a short header packet
+  std::span<const std::uint8_t> ShortHeaderConnectionID(
+      std::span<const std::uint8_t> packet) const noexcept;
+
+  QuicConnectionIDTableErrorStatus Insert(
+      std::span<const std::uint8_t> connection_id,
+      QuicConnectionHandle handle) noexcept;
+  QuicConnectionIDTableErrorStatus Retire(
+      std::span<const std::uint8_t> connection_id) noexcept;
+
+  // Only the first ConnectionIDLength() bytes of connection_id are used, so
+  // the bytes following a short header's first byte can be passed directly.
+  // Safe to call concurrently with Insert() and Retire().
+  bool Find(std::span<const std::uint8_t> connection_id,
+            QuicConnectionHandle& handle) const noexcept;
+  // Resolves a burst of received packets at once. All slots are prefetched
+  // before any is probed, so the cache misses of a large table overlap
+  // instead of adding up. found[i] tells whether handles[i] was set; returns
+  // the number found.
+  std::size_t Find(
+      std::span<const std::span<const std::uint8_t>> connection_ids,
+      std::span<QuicConnectionHandle> handles,
+      std::span<bool> found) const noexcept;
+
+ private:
+  // Key words, with a state tag in the last byte of key[2], and the handle.
+  // Every field is atomic because readers may race with a writer; the
+  // sequence lock then discards what they read.
+  struct Slot {
+   public:
+    std::array<std::atomic<std::uint64_t>, 3> key;
+    std::atomic<std::uint64_t> value;
+  };
+
+  struct alignas(64) Shard {
+   public:
+    std::atomic<std::uint64_t> sequence{0};
+    std::mutex mutex;
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask = 0;
+    std::size_t limit = 0;
+    std::atomic<std::size_t> size{0};
+    std::size_t tombstones = 0;
+  };
+
+  using Key = std::array<std::uint64_t, 3>;
+
+  Key MakeKey(std::span<const std::uint8_t> connection_id) const noexcept;
+  static std::uint64_t Hash(const Key& key) noexcept;
+  static std::size_t ShardIndex(std::uint64_t hash) noexcept;
+  bool Find(const Key& key, std::uint64_t hash,
+            QuicConnectionHandle& handle) const noexcept;
+
+  // Writer side helpers, called with the shard mutex held.
+  static void BeginWrite(Shard& shard) noexcept;
+  static void EndWrite(Shard& shard) noexcept;
+  static void Rebuild(Shard& shard) noexcept;
+
+  std::size_t length = 0;
+  void (*load_key)(const std::uint8_t* connection_id, Key& key) = nullptr;
+  std::array<Shard, kQuicConnectionIDTableShards> shards;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CRYPTO_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_CRYPTO_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace bedrock::network {
+
+inline constexpr std::size_t kQuicAESBlockSize = 16;
+inline constexpr std::size_t kQuicAES128KeySize = 16;
+
+// AES-128 block cipher for the single block operations QUIC needs on every
+// packet (connection ID encryption, header protection masks). Round keys are
+// expanded once so each block costs ten rounds. The AES-NI code is private
+// to quic_crypto.cc; round keys are kept as plain bytes here.
+class QuicAES128 {
+ public:
+  QuicAES128() = default;
+  explicit QuicAES128(
+      std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept {
+    SetKey(key);
+  }
+
+  void SetKey(std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept;
+
+  // input and output may be the same block.
+  void EncryptBlock(const std::uint8_t* input,
+                    std::uint8_t* output) const noexcept;
+  void DecryptBlock(const std::uint8_t* input,
+                    std::uint8_t* output) const noexcept;
+  // ECB over consecutive blocks. Independent blocks are interleaved so the
+  // latency of aesenc is hidden; input.size() must be a multiple of the
+  // block size and at most output.size(). Encrypting in place is allowed.
+  void Encrypt(std::span<const std::uint8_t> input,
+               std::span<std::uint8_t> output) const noexcept;
+  // Encrypts count blocks gathered from inputs into consecutive blocks of
+  // output, interleaved as above, e.g. header protection samples taken from
+  // different packets.
+  void EncryptBlocks(const std::uint8_t* const* inputs, std::uint8_t* output,
+                     std::size_t count) const noexcept;
+
+ private:
+  friend class QuicAES128GCM;
+
+  using RoundKeys = std::array<std::uint8_t, 11 * kQuicAESBlockSize>;
+
+  alignas(16) RoundKeys encrypt_keys{};
+  alignas(16) RoundKeys decrypt_keys{};
+};
+
+inline constexpr std::size_t kQuicAEADNonceSize = 12;
+inline constexpr std::size_t kQuicAEADTagSize = 16;
+
+// AES-128-GCM (NIST SP 800-38D) with 96 bit nonces, working in place.
+// Counter blocks are encrypted eight at a time and GHASH folds four blocks
+// per reduction with carry-less multiplication, so a packet is a single pass
+// over its bytes.
+class QuicAES128GCM {
+ public:
+  QuicAES128GCM() = default;
+  explicit QuicAES128GCM(
+      std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept {
+    SetKey(key);
+  }
+
+  void SetKey(std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept;
+
+  // Encrypts text in place and writes the tag.
+  void Seal(std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+            std::span<const std::uint8_t> associated_data,
+            std::span<std::uint8_t> text,
+            std::uint8_t* tag) const noexcept;
+  // Decrypts text in place and returns whether the tag matched. On failure
+  // text holds unauthenticated plaintext and must be discarded.
+  bool Open(std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+            std::span<const std::uint8_t> associated_data,
+            std::span<std::uint8_t> text,
+            const std::uint8_t* tag) const noexcept;
+
+ private:
+  // Runs CTR over text in place, hashing the ciphertext after encryption
+  // or before decryption, and writes the tag.
+  void Crypt(std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+             std::span<const std::uint8_t> associated_data,
+             std::span<std::uint8_t> text, bool encrypt,
+             std::uint8_t* tag) const noexcept;
+
+  QuicAES128 cipher;
+  // H, H^2, H^3 and H^4 in GHASH's bit reflected representation
+  alignas(16) std::array<std::uint8_t, 4 * kQuicAESBlockSize> hash_keys{};
+};
+
+inline constexpr std::size_t kQuicSHA256Size = 32;
+
+using QuicSHA256Digest = std::array<std::uint8_t, kQuicSHA256Size>;
+
+// SHA-256 (FIPS 180-4). Only used for key derivation, which happens per
+// connection and key update rather than per packet.
+class QuicSHA256 {
+ public:
+  QuicSHA256() noexcept { Reset(); }
+
+  void Reset() noexcept;
+  void Update(std::span<const std::uint8_t> data) noexcept;
+  QuicSHA256Digest Final() noexcept;
+
+  static QuicSHA256Digest Hash(std::span<const std::uint8_t> data) noexcept;
+
+ private:
+  void Compress(const std::uint8_t* block) noexcept;
+
+  std::array<std::uint32_t, 8> state{};
+  std::array<std::uint8_t, 64> pending{};
+  std::size_t pending_size = 0;
+  std::uint64_t total_size = 0;
+};
+
+QuicSHA256Digest QuicHMACSHA256(std::span<const std::uint8_t> key,
+                                std::span<const std::uint8_t> data) noexcept;
+
+// HKDF-Extract (rfc5869) with SHA-256
+QuicSHA256Digest QuicHKDFExtract(std::span<const std::uint8_t> salt,
+                                 std::span<const std::uint8_t> ikm) noexcept;
+
+// HkdfLabel limits: the label vector holds at most 255 bytes including the
+// "tls13 " prefix, the context at most 255 bytes, and HKDF-Expand yields at
+// most 255 hash blocks.
+inline constexpr std::size_t kQuicHKDFMaxLabelSize = 255 - 6;
+inline constexpr std::size_t kQuicHKDFMaxContextSize = 255;
+inline constexpr std::size_t kQuicHKDFMaxOutputSize = 255 * kQuicSHA256Size;
+
+// HKDF-Expand-Label (rfc8446 section 7.1). label is given without the
+// "tls13 " prefix; output.size() is the requested length. QUIC packet
+// protection uses an empty context; Derive-Secret passes a transcript
+// hash. Returns false and zeroes output if label, context or output exceed
+// the limits above.
+bool QuicHKDFExpandLabel(std::span<const std::uint8_t> secret,
+                         std::string_view label,
+                         std::span<std::uint8_t> output,
+                         std::span<const std::uint8_t> context = {}) noexcept;
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_DATAGRAM_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_DATAGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "quic_connection_id_table.h"
+#include "quic_frame.h"
+#include "quic_packet_buffer.h"
+#include "quic_packet_builder.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// max_datagram_frame_size transport parameter (rfc9221 section 3)
+inline constexpr std::uint64_t kQuicMaxDatagramFrameSizeParameterID = 0x20;
+// Largest value worth advertising: a DATAGRAM frame can not span packets.
+inline constexpr std::uint64_t kQuicDefaultMaxDatagramFrameSize = 65535;
+inline constexpr std::size_t kQuicDefaultDatagramQueueLength = 64;
+// Bytes of a 1-RTT packet around its frames besides the Destination
+// Connection ID: first byte, longest packet number and AEAD tag.
+inline constexpr std::size_t kQuicShortHeaderOverheadV1 =
+    1 + 4 + kQuicAeadTagLengthV1;
+
+enum class QuicDatagramErrorStatus {
+  kSuccess,
+  kDisabled,  // the peer did not advertise max_datagram_frame_size
+  kTooLarge,  // the frame would exceed the peer's limit or a packet
+  kBusy,      // send queue full; the datagram was dropped
+  kProtocol,  // peer sent a frame we did not allow (PROTOCOL_VIOLATION)
+  kMalformed  // transport parameter could not be decoded
+};
+
+// Writes the max_datagram_frame_size transport parameter, returns the
+// number of bytes written or 0 if out is too small.
+std::size_t WriteQuicMaxDatagramFrameSize(std::uint64_t max_frame_size,
+                                          std::span<std::uint8_t> out) noexcept;
+// Looks for max_datagram_frame_size among the peer's transport parameters.
+// max_frame_size is 0 when the parameter is absent, which means the peer
+// does not accept DATAGRAM frames.
+QuicDatagramErrorStatus ReadQuicMaxDatagramFrameSize(
+    std::span<const std::uint8_t> transport_parameters,
+    std::uint64_t& max_frame_size) noexcept;
+
+// A received datagram. data points into packet, which stays alive as long
+// as the record does, so nothing is copied on the way to the application.
+struct QuicReceivedDatagramV1 {
+ public:
+  QuicPacketBufferRef packet;
+  std::span<const std::uint8_t> data;
+};
+
+// Unreliable messages of a connection (rfc9221).
+//
+// Outgoing datagrams wait in a short queue of fixed slots and go into the
+// very next packet the connection builds, ahead of stream data, so they
+// never wait behind retransmissions. A lost datagram is not sent again.
+// When the queue is full new datagrams are refused rather than delayed:
+// for this kind of traffic a late message is worth less than a fresh one.
+// A datagram must fit one packet of the validated PLPMTU; one queued before
+// the path shrank is dropped instead of blocking the queue.
+//
+// Incoming DATAGRAM frames are kept as spans into their packet buffer. If
+// the application falls behind, the oldest unread datagram is dropped.
+class QuicDatagramChannel {
+ public:
+  // local_max_frame_size is what we advertise; 0 disables receiving.
+  explicit QuicDatagramChannel(
+      std::uint64_t local_max_frame_size = kQuicDefaultMaxDatagramFrameSize,
+      std::size_t queue_length = kQuicDefaultDatagramQueueLength);
+
+  std::uint64_t LocalMaxFrameSize() const noexcept { return local_max; }
+  // Our transport parameter, 0 bytes when receiving is disabled.
+  std::size_t WriteTransportParameter(
+      std::span<std::uint8_t> out) const noexcept;
+  QuicDatagramErrorStatus OnPeerTransportParameters(
+      std::span<const std::uint8_t> transport_parameters) noexcept;
+  void SetPeerMaxFrameSize(std::uint64_t max_frame_size) noexcept {
+    peer_max = max_frame_size;
+  }
+  std::uint64_t PeerMaxFrameSize() const noexcept { return peer_max; }
+  bool SendEnabled() const noexcept { return peer_max != 0; }
+  // The PLPMTU from path MTU discovery and the length of the Destination
+  // Connection ID the packets carry. Until set, the base PLPMTU and the
+  // longest connection ID are assumed.
+  void SetPathMTU(std::size_t plpmtu,
+                  std::size_t connection_id_length) noexcept;
+  // Largest payload the peer accepts that also fits a packet on the path.
+  std::size_t MaxPayload() const noexcept;
+
+  // Copies data into the send queue.
+  QuicDatagramErrorStatus Send(std::span<const std::uint8_t> data) noexcept;
+  bool HasDataToSend() const noexcept { return send_count != 0; }
+  std::size_t QueuedCount() const noexcept { return send_count; }
+  // Moves queued datagrams into the open packet in order until one does not
+  // fit, returns the number written.
+  template <QuicVersionTraits Version>
+  std::size_t WriteFrames(QuicPacketBuilder<Version>& builder) noexcept {
+    std::size_t written = 0;
+    while (send_count != 0) {
+      if (SendFront().size() > MaxPayload()) {
+        PopSend();
+        continue;
+      }
+      if (builder.AppendDatagramFrame(SendFront()) !=
+          QuicPacketBuilderErrorStatus::kSuccess) {
+        break;
+      }
+      PopSend();
+      written++;
+    }
+    return written;
+  }
+
+  // frame is a decoded DATAGRAM frame of packet.
+  QuicDatagramErrorStatus OnDatagramFrame(
+      const QuicFrameV1& frame, const QuicPacketBufferRef& packet) noexcept;
+  // Takes the oldest unread datagram, false if there is none.
+  bool Receive(QuicReceivedDatagramV1& datagram) noexcept;
+  std::size_t ReceivedCount() const noexcept { return receive_count; }
+  // Datagrams dropped because the application did not read them in time.
+  std::uint64_t DroppedCount() const noexcept { return dropped; }
+
+ private:
+  std::span<const std::uint8_t> SendFront() const noexcept {
+    return {send_slots.data() + send_head * kQuicPacketBufferCapacity,
+            send_sizes[send_head]};
+  }
+  void PopSend() noexcept {
+    send_head = (send_head + 1) % send_sizes.size();
+    send_count--;
+  }
+
+  std::uint64_t local_max = 0;
+  std::uint64_t peer_max = 0;
+  // Largest frame that fits a 1-RTT packet of PLPMTU bytes
+  std::size_t path_frame_limit = 0;
+
+  // send_sizes.size() slots of kQuicPacketBufferCapacity bytes, which no
+  // validated PLPMTU exceeds, used as a ring starting at send_head
+  std::vector<std::uint8_t> send_slots;
+  std::vector<std::size_t> send_sizes;
+  std::size_t send_head = 0;
+  std::size_t send_count = 0;
+
+  std::vector<QuicReceivedDatagramV1> received;
+  std::size_t receive_head = 0;
+  std::size_t receive_count = 0;
+  std::uint64_t dropped = 0;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_DISPATCHER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_DISPATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "networking/socket.h"
+#include "quic_connection_id_table.h"
+#include "quic_packet_buffer.h"
+#include "quic_spsc_ring.h"
+
+namespace bedrock::network {
+
+// Receive buffer size of a datagram, one packet buffer. Larger datagrams
+// exceed our max_udp_payload_size and are dropped as truncated.
+inline constexpr std::size_t kQuicMaxReceiveDatagramSize =
+    kQuicPacketBufferCapacity;
+
+// A datagram handed from a receiver to a worker.
+struct QuicReceivedDatagram {
+ public:
+  // Pooled buffer the datagram was read into. The slot's reference is
+  // dropped once the handler returns; a handler keeps the data, e.g. for
+  // reassembly, by copying the reference.
+  QuicPacketBufferRef buffer;
+  Address peer;
+  // Owner of the Destination Connection ID. Only meaningful if routed;
+  // otherwise the datagram is a long header packet for a connection the
+  // server has not issued an ID for yet, such as a client's first Initial.
+  QuicConnectionHandle handle;
+  bool routed = false;
+
+  std::span<const std::uint8_t> Datagram() const noexcept {
+    return buffer->Datagram();
+  }
+};
+
+enum class QuicDispatcherErrorStatus {
+  kSuccess,
+  kMalformed,          // too short to hold a Destination Connection ID
+  kTruncated,          // larger than kQuicMaxReceiveDatagramSize
+  kUnknownConnection,  // short header packet for no known connection
+  kFull,               // the worker's ring is full or no packet buffer is
+                       // free, datagram dropped
+  kSocket,             // the socket failed, see its error message
+  kInvalidReceiver     // receiver is not below ReceiverCount()
+};
+
+// Steers received datagrams to the worker thread that owns their
+// connection, so each connection is only ever processed on one thread and
+// needs no locks.
+//
+// Only the rfc8999 invariants are parsed: the header form and the
+// Destination Connection ID. Short header packets are routed through the
+// connection ID table. Long header packets are routed through it too if
+// their Destination Connection ID has the table's length; others go to a
+// worker chosen by hashing that ID, so all Initials of one connection
+// attempt reach the same worker until it issues its own connection IDs.
+//
+// Every receiver thread has its own single producer, single consumer ring
+// to every worker, so no ring is ever shared between two producers or two
+// consumers. Receiver and worker indices identify the calling thread.
+//
+// Every receiver also owns a QuicPacketBufferPool. Datagrams are read into
+// its buffers and the buffer itself is queued, so the data is never copied
+// between the socket and the frame handlers, and workers release buffers
+// back to the pool of the receiver that read them.
+class QuicDispatcher {
+ public:
+  // Creates receivers * workers rings of ring_capacity datagrams each. Each
+  // receiver's pool holds enough buffers to fill its rings, plus
+  // retained_buffers for the references handlers keep after returning,
+  // which must be dropped before the dispatcher is destroyed.
+  QuicDispatcher(const QuicConnectionIDTable& connection_ids,
+                 std::size_t receivers, std::size_t workers,
+                 std::size_t ring_capacity,
+                 std::size_t retained_buffers = 0) noexcept;
+  QuicDispatcher(const QuicDispatcher&) = delete;
+  QuicDispatcher& operator=(const QuicDispatcher&) = delete;
+
+  std::size_t ReceiverCount() const noexcept { return receiver_count; }
+  std::size_t WorkerCount() const noexcept { return worker_count; }
+
+  // Receiver side. Blocks for one datagram from a UDP socket and dispatches
+  // it. The datagram is read straight into the buffer it is queued with;
+  // if the pool has none free, it is read and dropped as kFull.
+  QuicDispatcherErrorStatus Receive(std::size_t receiver, Socket& socket);
+  // Dispatches a copy of a datagram read by other means.
+  QuicDispatcherErrorStatus Dispatch(std::size_t receiver,
+                                     std::span<const std::uint8_t> datagram,
+                                     const Address& peer);
+
+  // Worker side. Calls handler(const QuicReceivedDatagram&) for the
+  // datagrams queued to worker, taking at most one ring's capacity from
+  // each receiver so a busy receiver cannot starve the others, and drops
+  // each slot's buffer reference after its handler. Returns the number
+  // handled; none if worker is not below WorkerCount().
+  template <typename Handler>
+  std::size_t Drain(std::size_t worker, Handler&& handler) {
+    std::size_t count = 0;
+    if (worker >= worker_count) {
+      return count;
+    }
+    for (std::size_t receiver = 0; receiver < receiver_count; receiver++) {
+      auto& ring = RingOf(receiver, worker);
+      for (std::size_t i = 0; i < ring.Capacity(); i++) {
+        QuicReceivedDatagram* datagram = ring.Front();
+        if (datagram == nullptr) {
+          break;
+        }
+        handler(std::as_const(*datagram));
+        datagram->buffer.Reset();
+        ring.Pop();
+        count++;
+      }
+    }
+    return count;
+  }
+
+ private:
+  using Ring = QuicSPSCRing<QuicReceivedDatagram>;
+
+  Ring& RingOf(std::size_t receiver, std::size_t worker) noexcept {
+    return *rings[receiver * worker_count + worker];
+  }
+  QuicDispatcherErrorStatus Route(std::span<const std::uint8_t> datagram,
+                                  QuicConnectionHandle& handle,
+                                  bool& routed) const noexcept;
+  // The receiver's spare buffer, allocated from its pool if it has none.
+  // Empty if the pool is exhausted.
+  QuicPacketBufferRef& Spare(std::size_t receiver) noexcept;
+  // Routes the datagram held in the receiver's spare buffer and queues the
+  // buffer to its worker.
+  QuicDispatcherErrorStatus Enqueue(std::size_t receiver,
+                                    const Address& peer) noexcept;
+
+  const QuicConnectionIDTable& table;
+  std::size_t receiver_count = 0;
+  std::size_t worker_count = 0;
+  // Declared before the rings and spares, whose references it outlives
+  std::vector<std::unique_ptr<QuicPacketBufferPool>> pools;
+  std::vector<std::unique_ptr<Ring>> rings;
+  // Buffer of each receiver that the next datagram is read into before its
+  // worker is known.
+  std::vector<QuicPacketBufferRef> spares;
+};
+
+}  // namespace bedrock::network
+
+#endif
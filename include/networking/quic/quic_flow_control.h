@@ -0,0 +1,151 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_FLOW_CONTROL_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_FLOW_CONTROL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "quic_loss_detection.h"
+
+namespace bedrock::network {
+
+inline constexpr std::uint64_t kQuicDefaultStreamWindow = 64 * 1024;
+inline constexpr std::uint64_t kQuicDefaultMaxStreamWindow = 16 << 20;
+// The connection window is kept this much larger than any stream window
+// so a single stream cannot be blocked by the connection limit.
+inline constexpr double kQuicConnectionWindowMultiplier = 1.5;
+
+// Connection window that keeps ahead of a stream window.
+constexpr std::uint64_t QuicConnectionWindowFor(
+    std::uint64_t stream_window) noexcept {
+  return static_cast<std::uint64_t>(static_cast<double>(stream_window) *
+                                    kQuicConnectionWindowMultiplier);
+}
+
+enum class QuicFlowControlErrorStatus {
+  kSuccess,
+  kFlowControl,  // the peer sent beyond our limit, a FLOW_CONTROL_ERROR
+};
+
+// Memory that receive windows of all connections may grow into, usually
+// one per node. Only growth beyond a window's initial size is charged, so
+// thousands of idle streams cost nothing here while busy ones compete for
+// the budget. Safe to share between threads.
+class QuicFlowControlBudget {
+ public:
+  explicit QuicFlowControlBudget(std::uint64_t bytes) noexcept
+      : limit(bytes) {}
+  QuicFlowControlBudget(const QuicFlowControlBudget&) = delete;
+  QuicFlowControlBudget& operator=(const QuicFlowControlBudget&) = delete;
+
+  bool TryReserve(std::uint64_t bytes) noexcept;
+  void Release(std::uint64_t bytes) noexcept {
+    reserved.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  std::uint64_t Limit() const noexcept { return limit; }
+  std::uint64_t Reserved() const noexcept {
+    return reserved.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::uint64_t limit;
+  std::atomic<std::uint64_t> reserved{0};
+};
+
+// Receive credit of one stream (MAX_STREAM_DATA) or of the connection
+// (MAX_DATA); offsets are absolute, for the connection the sum over all
+// streams.
+//
+// Credit is extended to consumed + window once less than half the window
+// is left, the usual rfc9000 section 4.2 strategy. The window is tuned
+// like TCP receive buffer auto-tuning: if the previous extension was used
+// up within two smoothed RTTs, the window limits the transfer rather than
+// the application does, so it doubles, up to max_window and as far as the
+// budget allows. A reader slower than the network never triggers growth.
+class QuicReceiveFlowController {
+ public:
+  QuicReceiveFlowController(
+      std::uint64_t initial_window,
+      std::uint64_t max_window = kQuicDefaultMaxStreamWindow,
+      QuicFlowControlBudget* shared_budget = nullptr) noexcept
+      : window(initial_window),
+        window_limit(max_window < initial_window ? initial_window
+                                                 : max_window),
+        max_data(initial_window),
+        budget(shared_budget) {}
+  QuicReceiveFlowController(const QuicReceiveFlowController&) = delete;
+  QuicReceiveFlowController& operator=(const QuicReceiveFlowController&) =
+      delete;
+  QuicReceiveFlowController(QuicReceiveFlowController&& other) noexcept;
+  QuicReceiveFlowController& operator=(
+      QuicReceiveFlowController&& other) noexcept;
+  ~QuicReceiveFlowController() { ReleaseBudget(); }
+
+  // largest_offset is the end of the data received so far.
+  QuicFlowControlErrorStatus OnDataReceived(
+      std::uint64_t largest_offset) noexcept;
+  // consumed is the offset the application has read up to. Returns true
+  // when a MAX_STREAM_DATA or MAX_DATA frame carrying MaxData() should be
+  // sent.
+  bool OnDataConsumed(std::uint64_t consumed,
+                      std::chrono::steady_clock::time_point now,
+                      const QuicRTTEstimator& rtt) noexcept;
+  // Grows the window to at least minimum_window; the budget is charged
+  // like for auto-tuning.
+  void EnsureWindow(std::uint64_t minimum_window) noexcept;
+  // Called on the connection's controller when one of its streams' windows
+  // grew to stream_window, so the connection window stays
+  // QuicConnectionWindowFor() the largest stream window.
+  void OnStreamWindowGrown(std::uint64_t stream_window) noexcept {
+    EnsureWindow(QuicConnectionWindowFor(stream_window));
+  }
+
+  // The stream is done; its window growth goes back to the budget.
+  void ReleaseBudget() noexcept;
+
+  std::uint64_t MaxData() const noexcept { return max_data; }
+  std::uint64_t Window() const noexcept { return window; }
+  std::uint64_t Received() const noexcept { return received; }
+  std::uint64_t Consumed() const noexcept { return consumed_offset; }
+
+ private:
+  // Grows window towards target within max_window and the budget.
+  void Grow(std::uint64_t target) noexcept;
+
+  std::uint64_t window;
+  std::uint64_t window_limit;
+  std::uint64_t max_data;
+  std::uint64_t received = 0;
+  std::uint64_t consumed_offset = 0;
+  // Window growth charged to budget.
+  std::uint64_t charged = 0;
+  QuicFlowControlBudget* budget;
+  std::chrono::steady_clock::time_point last_update{};
+};
+
+// Credit for streams the peer opens (MAX_STREAMS) of one type. The limit
+// moves forward as streams close, keeping window streams available, and
+// an update is due once half of that was used (rfc9000 section 4.6).
+class QuicStreamCreditController {
+ public:
+  explicit QuicStreamCreditController(std::uint64_t window_streams) noexcept
+      : window(window_streams), max_streams(window_streams) {}
+
+  // Returns true when a MAX_STREAMS frame carrying MaxStreams() should be
+  // sent.
+  bool OnStreamClosed() noexcept;
+
+  std::uint64_t MaxStreams() const noexcept { return max_streams; }
+  std::uint64_t Closed() const noexcept { return closed; }
+
+ private:
+  std::uint64_t window;
+  std::uint64_t max_streams;
+  std::uint64_t closed = 0;
+};
+
+}  // namespace bedrock::network
+
+#endif
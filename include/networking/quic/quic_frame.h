@@ -0,0 +1,170 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_FRAME_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace bedrock::network {
+
+// Frame types defined in rfc9000 section 19 and the DATAGRAM frame of
+// rfc9221. STREAM frames (0x08..0x0f), ACK frames (0x02..0x03) and DATAGRAM
+// frames (0x30..0x31) are normalized to kStream / kAck / kDatagram, the low
+// bits of the type byte are kept in QuicFrameV1::flags.
+enum class QuicFrameTypeV1 : std::uint8_t {
+  kPadding = 0x00,
+  kPing = 0x01,
+  kAck = 0x02,
+  kResetStream = 0x04,
+  kStopSending = 0x05,
+  kCrypto = 0x06,
+  kNewToken = 0x07,
+  kStream = 0x08,
+  kMaxData = 0x10,
+  kMaxStreamData = 0x11,
+  kMaxStreamsBidi = 0x12,
+  kMaxStreamsUni = 0x13,
+  kDataBlocked = 0x14,
+  kStreamDataBlocked = 0x15,
+  kStreamsBlockedBidi = 0x16,
+  kStreamsBlockedUni = 0x17,
+  kNewConnectionID = 0x18,
+  kRetireConnectionID = 0x19,
+  kPathChallenge = 0x1a,
+  kPathResponse = 0x1b,
+  kConnectionClose = 0x1c,
+  kConnectionCloseApplication = 0x1d,
+  kHandshakeDone = 0x1e,
+  kDatagram = 0x30
+};
+
+// Low bits of the STREAM frame type byte
+inline constexpr std::uint8_t kQuicStreamFrameFinBitV1 = 0x01;
+inline constexpr std::uint8_t kQuicStreamFrameLenBitV1 = 0x02;
+inline constexpr std::uint8_t kQuicStreamFrameOffBitV1 = 0x04;
+// Low bit of the ACK frame type byte
+inline constexpr std::uint8_t kQuicAckFrameEcnBitV1 = 0x01;
+// Low bit of the DATAGRAM frame type byte (rfc9221 section 4)
+inline constexpr std::uint8_t kQuicDatagramFrameLenBitV1 = 0x01;
+
+inline constexpr std::size_t kQuicStatelessResetTokenLengthV1 = 16;
+inline constexpr std::size_t kQuicPathChallengeDataLengthV1 = 8;
+
+enum class QuicFrameErrorStatus {
+  kSuccess,
+  kEnd,          // payload exhausted
+  kTruncated,    // frame runs past the end of the payload
+  kUnknownType,  // frame type not known to this decoder
+  kMalformed     // field value violates rfc9000
+};
+
+// Fixed-size decoded frame record. Variable length parts of a frame are spans
+// into the packet payload, so the payload must outlive the record.
+//
+// Field usage per frame type:
+//   PADDING               length = number of consecutive padding bytes
+//   ACK                   id = Largest Acknowledged, offset = First ACK Range,
+//                         length = ACK Range Count, extra = ACK Delay,
+//                         data = ACK Range list, aux = ECN Counts (ECN only)
+//   RESET_STREAM          id = Stream ID, offset = Final Size,
+//                         extra = Application Protocol Error Code
+//   STOP_SENDING          id = Stream ID,
+//                         extra = Application Protocol Error Code
+//   CRYPTO                offset = Offset, length = Length, data = Crypto Data
+//   NEW_TOKEN             length = Token Length, data = Token
+//   STREAM                id = Stream ID, offset = Offset, length = Length,
+//                         data = Stream Data, flags = OFF/LEN/FIN bits
+//   MAX_DATA              offset = Maximum Data
+//   MAX_STREAM_DATA       id = Stream ID, offset = Maximum Stream Data
+//   MAX_STREAMS           offset = Maximum Streams
+//   DATA_BLOCKED          offset = Maximum Data
+//   STREAM_DATA_BLOCKED   id = Stream ID, offset = Maximum Stream Data
+//   STREAMS_BLOCKED       offset = Maximum Streams
+//   NEW_CONNECTION_ID     id = Sequence Number, offset = Retire Prior To,
+//                         length = Length, data = Connection ID,
+//                         aux = Stateless Reset Token
+//   RETIRE_CONNECTION_ID  id = Sequence Number
+//   PATH_CHALLENGE        data = Data
+//   PATH_RESPONSE         data = Data
+//   CONNECTION_CLOSE      extra = Error Code, offset = Frame Type (0x1c only),
+//                         length = Reason Phrase Length, data = Reason Phrase
+//   DATAGRAM              length = Length, data = Datagram Data,
+//                         flags = LEN bit
+//   PING, HANDSHAKE_DONE  (no fields)
+struct QuicFrameV1 {
+ public:
+  QuicFrameTypeV1 type = QuicFrameTypeV1::kPadding;
+  std::uint8_t flags = 0;
+
+  std::uint64_t id = 0;
+  std::uint64_t offset = 0;
+  std::uint64_t length = 0;
+  std::uint64_t extra = 0;
+
+  std::span<const std::uint8_t> data;
+  std::span<const std::uint8_t> aux;
+};
+
+// Every frame but ACK, PADDING and CONNECTION_CLOSE elicits an acknowledgement
+// (rfc9002 section 2).
+constexpr bool IsAckEliciting(QuicFrameTypeV1 type) noexcept {
+  return type != QuicFrameTypeV1::kAck && type != QuicFrameTypeV1::kPadding &&
+         type != QuicFrameTypeV1::kConnectionClose &&
+         type != QuicFrameTypeV1::kConnectionCloseApplication;
+}
+
+// Packet numbers acknowledged by one ACK Range, both ends inclusive.
+struct QuicAckRangeV1 {
+ public:
+  std::uint64_t smallest = 0;
+  std::uint64_t largest = 0;
+};
+
+// Walks the ranges of a decoded ACK frame from the largest packet number down.
+class QuicAckRangeIteratorV1 {
+ public:
+  explicit QuicAckRangeIteratorV1(const QuicFrameV1& ack_frame) noexcept;
+
+  // Returns kEnd after the last range, kMalformed if a range would go below
+  // packet number zero.
+  QuicFrameErrorStatus Next(QuicAckRangeV1& range) noexcept;
+
+ private:
+  std::span<const std::uint8_t> ranges;
+  std::size_t position = 0;
+  std::uint64_t remaining = 0;
+  std::uint64_t next_largest = 0;
+  std::uint64_t first_range = 0;
+  std::uint64_t previous_smallest = 0;
+  bool first = true;
+};
+
+// Table driven decoder over a decrypted packet payload.
+class QuicFrameDecoderV1 {
+ public:
+  // skip_padding: PADDING runs are consumed without producing a record.
+  explicit QuicFrameDecoderV1(std::span<const std::uint8_t> packet_payload,
+                              bool skip_padding_frames = true) noexcept
+      : payload(packet_payload), skip_padding(skip_padding_frames) {}
+
+  // Decodes the next frame. Returns kEnd once the payload is exhausted; on any
+  // other error the decoder stops at the offending frame.
+  QuicFrameErrorStatus Next(QuicFrameV1& frame) noexcept;
+
+  // Decodes up to frames.size() frames, returns the number decoded. status is
+  // kEnd when the whole payload was consumed.
+  std::size_t Decode(std::span<QuicFrameV1> frames,
+                     QuicFrameErrorStatus& status) noexcept;
+
+  std::size_t Offset() const noexcept { return position; }
+  bool Empty() const noexcept { return position >= payload.size(); }
+
+ private:
+  std::span<const std::uint8_t> payload;
+  std::size_t position = 0;
+  bool skip_padding = true;
+};
+
+}  // namespace bedrock::network
+
+#endif
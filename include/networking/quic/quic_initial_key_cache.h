@@ -0,0 +1,99 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_INITIAL_KEY_CACHE_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_INITIAL_KEY_CACHE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "quic_connection_id_table.h"
+#include "quic_crypto.h"
+#include "quic_packet_protection.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Entries sharing one hash bucket
+inline constexpr std::size_t kQuicInitialKeyCacheWays = 4;
+
+// Initial keys of recently seen client Destination Connection IDs, so a
+// retransmitted or duplicated Initial skips HKDF. Keyed by (version, DCID).
+//
+// The cache is a fixed array of buckets of kQuicInitialKeyCacheWays entries;
+// memory never grows. The client picks the DCID, so buckets are chosen by
+// an AES based MAC under a random per cache key, and an attacker cannot aim
+// a flood at the bucket of a given connection. A new entry starts out
+// unreferenced and only a hit marks it referenced. A new entry replaces the
+// oldest unreferenced entry of its bucket and never a referenced one, so a
+// flood of spoofed one-off DCIDs only evicts its own entries. When every
+// entry of the bucket is referenced the new keys are returned uncached and
+// a per bucket clock hand clears one referenced bit, so entries that stop
+// being reused age out one miss at a time.
+//
+// Not thread safe; meant to be owned by one receive worker.
+class QuicInitialKeyCache {
+ public:
+  // capacity is rounded up to a power of two number of buckets.
+  explicit QuicInitialKeyCache(std::size_t capacity) noexcept;
+  // Uses hash_key for bucket selection instead of a random one, which makes
+  // placement reproducible; for tests.
+  QuicInitialKeyCache(
+      std::size_t capacity,
+      std::span<const std::uint8_t, kQuicAES128KeySize> hash_key) noexcept;
+  QuicInitialKeyCache(const QuicInitialKeyCache&) = delete;
+  QuicInitialKeyCache& operator=(const QuicInitialKeyCache&) = delete;
+
+  // Returns the Initial keys for destination_connection_id, deriving and
+  // caching them on a miss. The reference is valid until the next call.
+  // DCIDs longer than kQuicMaxConnectionIDLength are derived every time.
+  template <QuicVersionTraits Version>
+  const QuicInitialKeys& Find(
+      std::span<const std::uint8_t> destination_connection_id) noexcept {
+    return Find(Version::kVersion, destination_connection_id,
+                &DeriveQuicInitialKeys<Version>);
+  }
+
+  std::size_t Capacity() const noexcept {
+    return (mask + 1) * kQuicInitialKeyCacheWays;
+  }
+  std::uint64_t Hits() const noexcept { return hits; }
+  std::uint64_t Misses() const noexcept { return misses; }
+
+ private:
+  using Derive = void (*)(std::span<const std::uint8_t>,
+                          QuicInitialKeys&) noexcept;
+
+  struct Entry {
+   public:
+    std::uint32_t version = 0;
+    std::uint8_t length = 0;
+    bool valid = false;
+    bool referenced = false;
+    std::uint64_t inserted = 0;  // miss count when the entry was filled
+    std::array<std::uint8_t, kQuicMaxConnectionIDLength> connection_id{};
+    QuicInitialKeys keys;
+  };
+
+  const QuicInitialKeys& Find(
+      std::uint32_t version,
+      std::span<const std::uint8_t> destination_connection_id,
+      Derive derive) noexcept;
+  std::size_t Bucket(std::uint32_t version,
+                     std::span<const std::uint8_t> destination_connection_id)
+      const noexcept;
+
+  QuicAES128 hash_key;
+  std::unique_ptr<Entry[]> entries;
+  // Clock hand of each bucket
+  std::unique_ptr<std::uint8_t[]> hands;
+  std::size_t mask = 0;
+  // Keys for DCIDs that cannot be cached or find their bucket referenced
+  QuicInitialKeys uncached;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+};
+
+}  // namespace bedrock::network
+
+#endif
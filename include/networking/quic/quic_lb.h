@@ -0,0 +1,117 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_LB_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_LB_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "quic_crypto.h"
+
+namespace bedrock::network {
+
+// Server ID encoding in connection IDs, after draft-ietf-quic-load-balancers.
+// A stateless load balancer sharing the configuration recovers the server ID
+// from the Destination Connection ID of any packet, so a connection keeps
+// reaching the same server when the client's address changes.
+//
+// Connection ID {
+//   Config Rotation (3),
+//   Random or Length Self-Description (5),
+//   Server ID (8..120),
+//   Nonce (32..144),
+// }
+// Server ID and Nonce are encrypted together in the encrypted mode.
+inline constexpr std::uint8_t kQuicLBUnroutableConfigID = 0b111;
+inline constexpr std::size_t kQuicLBMaxServerIDLength = 15;
+inline constexpr std::size_t kQuicLBMinNonceLength = 4;
+inline constexpr std::size_t kQuicLBMaxNonceLength = 18;
+// Server ID and Nonce, so the connection ID stays within 20 bytes
+inline constexpr std::size_t kQuicLBMaxPlaintextLength = 19;
+
+struct QuicLBConfig {
+ public:
+  std::uint8_t config_id = 0;  // Config Rotation bits, 0 to 6
+  std::uint8_t server_id_length = 0;
+  std::uint8_t nonce_length = 0;
+  // The low first byte bits carry the connection ID length minus one
+  // instead of random bits.
+  bool length_self_description = false;
+  bool encrypted = false;
+  std::array<std::uint8_t, kQuicAES128KeySize> key{};
+
+  std::size_t ConnectionIDLength() const noexcept {
+    return 1 + std::size_t{server_id_length} + nonce_length;
+  }
+  bool IsValid() const noexcept;
+};
+
+enum class QuicLBErrorStatus {
+  kSuccess,
+  kInvalid,    // invalid configuration or server ID
+  kLength,     // connection ID shorter than the configuration's
+  kConfig,     // connection ID of another configuration
+  kExhausted   // every nonce of this generator has been used
+};
+
+// Issues connection IDs encoding one server ID. Meant to be owned by one
+// thread, e.g. a worker of QuicDispatcher; give each worker its own server
+// ID if the balancer should tell them apart.
+class QuicLBConnectionIDGenerator {
+ public:
+  QuicLBConnectionIDGenerator(const QuicLBConfig& config,
+                              std::span<const std::uint8_t> server_id) noexcept;
+
+  bool IsValid() const noexcept { return valid; }
+  std::size_t ConnectionIDLength() const noexcept {
+    return config.ConnectionIDLength();
+  }
+
+  // Writes ConnectionIDLength() bytes to connection_id. Nonces are a counter
+  // in the encrypted mode, so connection IDs never repeat, and random in the
+  // plaintext mode, so they do not reveal how many were issued.
+  QuicLBErrorStatus Generate(std::span<std::uint8_t> connection_id) noexcept;
+
+ private:
+  std::uint64_t Random() noexcept;
+
+  bool valid = false;
+  QuicLBConfig config;
+  std::array<std::uint8_t, kQuicLBMaxServerIDLength> server_id{};
+  QuicAES128 cipher;
+  // nonce bytes above the counter, fixed per generator
+  std::array<std::uint8_t, kQuicLBMaxNonceLength> nonce_prefix{};
+  std::uint64_t counter = 0;
+  std::uint64_t issued = 0;
+  std::uint64_t random_state = 0;
+};
+
+// Recovers server IDs from connection IDs without any per connection state.
+class QuicLBConnectionIDDecoder {
+ public:
+  explicit QuicLBConnectionIDDecoder(const QuicLBConfig& config) noexcept;
+
+  bool IsValid() const noexcept { return valid; }
+
+  // Config Rotation bits, which select the configuration during key
+  // rotation. kQuicLBUnroutableConfigID marks IDs chosen by a server
+  // without a configuration.
+  static std::uint8_t ConfigID(std::uint8_t first_byte) noexcept {
+    return static_cast<std::uint8_t>(first_byte >> 5);
+  }
+
+  // Only the first ConnectionIDLength() bytes of connection_id are used, so
+  // the bytes following a short header's first byte can be passed directly.
+  // server_id must hold the configured server ID length.
+  QuicLBErrorStatus ServerID(std::span<const std::uint8_t> connection_id,
+                             std::span<std::uint8_t> server_id) const noexcept;
+
+ private:
+  bool valid = false;
+  QuicLBConfig config;
+  QuicAES128 cipher;
+};
+
+}  // namespace bedrock::network
+
+#endif
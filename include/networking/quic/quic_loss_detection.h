@@ -0,0 +1,244 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_LOSS_DETECTION_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_LOSS_DETECTION_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "quic_frame.h"
+#include "rfc9000.h"
+
+namespace bedrock::network {
+
+// rfc9002 section 6.1.1
+inline constexpr std::uint64_t kQuicPacketThreshold = 3;
+// rfc9002 section 6.1.2, time threshold of 9/8 RTT
+inline constexpr std::int64_t kQuicTimeThresholdNumerator = 9;
+inline constexpr std::int64_t kQuicTimeThresholdDenominator = 8;
+inline constexpr std::chrono::microseconds kQuicTimerGranularity{1000};
+// rfc9002 section 6.2.2
+inline constexpr std::chrono::microseconds kQuicInitialRTT{333000};
+// rfc9002 section 7.6.1
+inline constexpr std::int64_t kQuicPersistentCongestionThreshold = 3;
+// Initial and Handshake packets in flight are few; these spaces get a ring
+// of this size.
+inline constexpr std::size_t kQuicHandshakeMaxPacketsInFlight = 64;
+
+enum class QuicLossDetectionErrorStatus {
+  kSuccess,
+  kNoSpace,  // sent packet window full, wait for acknowledgements
+  kInvalid   // packet number reused, or an ACK of a packet never sent
+};
+
+// rfc9002 section 5
+class QuicRTTEstimator {
+ public:
+  // ack_delay is the peer's reported delay, already limited to its
+  // max_ack_delay once the handshake is confirmed.
+  void Update(std::chrono::microseconds latest_rtt,
+              std::chrono::microseconds ack_delay) noexcept;
+
+  bool HasSample() const noexcept { return has_sample; }
+  std::chrono::microseconds LatestRTT() const noexcept { return latest; }
+  std::chrono::microseconds SmoothedRTT() const noexcept { return smoothed; }
+  std::chrono::microseconds RTTVariance() const noexcept { return variance; }
+  std::chrono::microseconds MinRTT() const noexcept { return min; }
+
+  // Probe timeout without max_ack_delay and backoff (rfc9002 section 6.2.1)
+  std::chrono::microseconds ProbeTimeout() const noexcept;
+  // max(9/8 * max(smoothed_rtt, latest_rtt), kQuicTimerGranularity)
+  std::chrono::microseconds LossDelay() const noexcept;
+
+ private:
+  bool has_sample = false;
+  std::chrono::microseconds latest{0};
+  std::chrono::microseconds smoothed{kQuicInitialRTT};
+  std::chrono::microseconds variance{kQuicInitialRTT / 2};
+  std::chrono::microseconds min{0};
+};
+
+enum class QuicSentPacketState : std::uint8_t {
+  kEmpty,  // packet number skipped, or the slot was released
+  kInFlight,
+  kAcked,
+  kLost
+};
+
+struct QuicSentPacket {
+ public:
+  std::chrono::steady_clock::time_point time_sent{};
+  std::uint32_t bytes = 0;
+  bool ack_eliciting = false;
+  bool in_flight = false;  // counts towards bytes in flight
+  QuicSentPacketState state = QuicSentPacketState::kEmpty;
+};
+
+// Sent packets of one packet number space in a power of two ring indexed by
+// packet number. Packet numbers only grow, so the window [First(), Next())
+// slides forward and lookups are one mask away. First() moves past packets
+// as soon as nothing older is outstanding.
+class QuicSentPacketRing {
+ public:
+  // capacity is rounded up to a power of two.
+  explicit QuicSentPacketRing(std::size_t capacity) noexcept;
+
+  // packet_number must be at least Next(); numbers in between are skipped.
+  QuicLossDetectionErrorStatus Add(std::uint64_t packet_number,
+                                   const QuicSentPacket& packet) noexcept;
+
+  // Slot of a packet number inside the window
+  QuicSentPacket& At(std::uint64_t packet_number) noexcept {
+    return packets[packet_number & mask];
+  }
+  const QuicSentPacket& At(std::uint64_t packet_number) const noexcept {
+    return packets[packet_number & mask];
+  }
+
+  // Releases leading packets that are no longer in flight.
+  void Advance() noexcept;
+  void Clear() noexcept;
+
+  std::uint64_t First() const noexcept { return first; }
+  std::uint64_t Next() const noexcept { return next; }
+  std::size_t Capacity() const noexcept { return mask + 1; }
+
+ private:
+  std::unique_ptr<QuicSentPacket[]> packets;
+  std::size_t mask = 0;
+  std::uint64_t first = 0;
+  std::uint64_t next = 0;
+};
+
+// What processing an ACK frame or a loss timeout changed. Bytes only count
+// packets that were in flight.
+struct QuicLossDetectionOutcome {
+ public:
+  std::uint64_t acked_bytes = 0;
+  std::uint64_t acked_packets = 0;
+  std::uint64_t lost_bytes = 0;
+  // packet numbers written to the lost output
+  std::size_t lost_packets = 0;
+  bool rtt_updated = false;
+  // Sent times of the largest newly acknowledged and the last lost packet,
+  // for the congestion controller's recovery period (rfc9002 section 7.3.2)
+  std::chrono::steady_clock::time_point largest_acked_time_sent{};
+  std::chrono::steady_clock::time_point largest_lost_time_sent{};
+  bool persistent_congestion = false;
+};
+
+enum class QuicLossDetectionTimeout {
+  kNone,
+  kLossDetected,  // packets were declared lost by the time threshold
+  kProbe          // send one or two ack-eliciting probe packets
+};
+
+// Loss detection of one connection over its three packet number spaces
+// (rfc9002 section 6 and appendix A).
+//
+// ACK processing touches only the newly acknowledged packets and the few
+// unacknowledged ones below the largest acknowledged, since the packet
+// threshold declares everything older lost. Lost packet numbers are written
+// to a caller supplied span so their frames can be retransmitted; when it
+// fills, the rest are declared by the next call or loss timeout.
+//
+// Persistent congestion is only recognized among the packets declared lost
+// by one call. Not thread safe.
+class QuicLossDetection {
+ public:
+  // max_packets_in_flight bounds the application data space window.
+  explicit QuicLossDetection(std::size_t max_packets_in_flight) noexcept;
+
+  // The peer's max_ack_delay transport parameter
+  void SetMaxAckDelay(std::chrono::microseconds max_ack_delay) noexcept {
+    peer_max_ack_delay = max_ack_delay;
+  }
+  void SetHandshakeConfirmed() noexcept { handshake_confirmed = true; }
+
+  QuicLossDetectionErrorStatus OnPacketSent(
+      QuicPacketNumberSpaceV1 space, std::uint64_t packet_number,
+      std::uint32_t bytes, bool ack_eliciting, bool in_flight,
+      std::chrono::steady_clock::time_point now) noexcept;
+
+  // ranges as decoded from the ACK frame, largest first; ack_delay already
+  // scaled by the peer's ack_delay_exponent.
+  QuicLossDetectionErrorStatus OnAckReceived(
+      QuicPacketNumberSpaceV1 space, std::span<const QuicAckRangeV1> ranges,
+      std::chrono::microseconds ack_delay,
+      std::chrono::steady_clock::time_point now,
+      std::span<std::uint64_t> lost,
+      QuicLossDetectionOutcome& outcome) noexcept;
+
+  // When the loss detection timer fires, time_point::max() if unarmed
+  // (rfc9002 appendix A.8).
+  std::chrono::steady_clock::time_point LossDetectionTimer() const noexcept;
+  // space is where lost packets were found or probes must be sent.
+  QuicLossDetectionTimeout OnLossDetectionTimeout(
+      std::chrono::steady_clock::time_point now,
+      std::span<std::uint64_t> lost, QuicPacketNumberSpaceV1& space,
+      QuicLossDetectionOutcome& outcome) noexcept;
+
+  // Initial or Handshake keys were discarded (rfc9002 section 6.4).
+  void DiscardSpace(QuicPacketNumberSpaceV1 space) noexcept;
+  // The connection moved to a new path: RTT samples start over from
+  // kQuicInitialRTT (rfc9000 section 9.4). Packets in flight on the old
+  // path stay tracked and are still acknowledged or declared lost.
+  void OnPathChanged() noexcept;
+
+  const QuicRTTEstimator& RTT() const noexcept { return rtt; }
+  std::uint64_t BytesInFlight() const noexcept { return bytes_in_flight; }
+  std::uint32_t PTOCount() const noexcept { return pto_count; }
+  std::uint64_t LargestAcked(QuicPacketNumberSpaceV1 space) const noexcept {
+    return Space(space).largest_acked;
+  }
+
+ private:
+  struct PacketNumberSpace {
+   public:
+    explicit PacketNumberSpace(std::size_t capacity) noexcept
+        : sent(capacity) {}
+
+    QuicSentPacketRing sent;
+    std::uint64_t largest_acked = 0;
+    bool has_largest_acked = false;
+    std::uint64_t ack_eliciting_in_flight = 0;
+    std::chrono::steady_clock::time_point loss_time =
+        std::chrono::steady_clock::time_point::max();
+    std::chrono::steady_clock::time_point last_ack_eliciting_time{};
+  };
+
+  PacketNumberSpace& Space(QuicPacketNumberSpaceV1 space) noexcept {
+    return spaces[static_cast<std::size_t>(space)];
+  }
+  const PacketNumberSpace& Space(
+      QuicPacketNumberSpaceV1 space) const noexcept {
+    return spaces[static_cast<std::size_t>(space)];
+  }
+
+  void DetectLostPackets(PacketNumberSpace& pn_space,
+                         std::chrono::steady_clock::time_point now,
+                         std::span<std::uint64_t> lost,
+                         QuicLossDetectionOutcome& outcome) noexcept;
+  // Removes a packet from bytes in flight once acknowledged or lost.
+  void OnPacketLeftFlight(PacketNumberSpace& pn_space,
+                          const QuicSentPacket& packet) noexcept;
+  std::chrono::steady_clock::time_point ProbeTimeout(
+      QuicPacketNumberSpaceV1& space) const noexcept;
+
+  std::array<PacketNumberSpace, kQuicPacketNumberSpaceCountV1> spaces;
+  QuicRTTEstimator rtt;
+  std::chrono::microseconds peer_max_ack_delay{25000};
+  bool handshake_confirmed = false;
+  std::uint32_t pto_count = 0;
+  std::uint64_t bytes_in_flight = 0;
+  // Persistent congestion only counts packets sent after the first RTT
+  // sample (rfc9002 section 7.6.2).
+  std::chrono::steady_clock::time_point first_rtt_sample_time =
+      std::chrono::steady_clock::time_point::max();
+};
+
+}  // namespace bedrock::network
+
+#endif
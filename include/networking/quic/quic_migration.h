@@ -0,0 +1,346 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_MIGRATION_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_MIGRATION_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "networking/socket/address.h"
+#include "quic_connection_id_table.h"
+#include "quic_frame.h"
+#include "quic_packet_builder.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Our active_connection_id_limit transport parameter: connection IDs of the
+// peer kept for later migrations (rfc9000 section 18.2).
+inline constexpr std::size_t kQuicActiveConnectionIDLimit = 8;
+// RETIRE_CONNECTION_ID frames that may wait to be sent. A peer retiring
+// more of its connection IDs at once is closed with
+// CONNECTION_ID_LIMIT_ERROR (rfc9000 section 5.1.2).
+inline constexpr std::size_t kQuicMaxPendingRetirements =
+    2 * kQuicActiveConnectionIDLimit;
+// Paths tracked at once: the one in use, the last validated one to fall
+// back to, and one being probed.
+inline constexpr std::size_t kQuicMaxPaths = 3;
+// Challenges of a path remembered at once; a PATH_RESPONSE to any of them
+// validates it.
+inline constexpr std::size_t kQuicPathChallengesKept = 4;
+// Bytes sent to an address not yet validated, per byte received from it
+// (rfc9000 section 8).
+inline constexpr std::uint64_t kQuicAmplificationFactor = 3;
+
+enum class QuicMigrationErrorStatus {
+  kSuccess,
+  kProtocolViolation,  // a sequence number reused for another connection ID
+  kLimitExceeded,      // too many connection IDs: CONNECTION_ID_LIMIT_ERROR
+  kNoConnectionID      // no unused connection ID left to move to
+};
+
+// What a received packet or a timeout did to the connection's paths.
+enum class QuicPathEvent : std::uint8_t {
+  kNone,
+  kProbed,     // a packet came from a new address, which is being validated
+  kRebound,    // only the peer's port changed (NAT rebinding)
+  kMigrated,   // the connection moved to another peer address
+  kValidated,  // a PATH_RESPONSE validated a path
+  kFailed,     // a path failed validation and was dropped
+  kReverted    // the path in use failed validation, back to the previous
+};
+
+// PATH_CHALLENGE, PATH_RESPONSE, NEW_CONNECTION_ID and PADDING are probing
+// frames (rfc9000 section 9.1): a packet of nothing else does not move the
+// connection to the path it arrived on.
+constexpr bool IsProbingFrame(QuicFrameTypeV1 type) noexcept {
+  return type == QuicFrameTypeV1::kPathChallenge ||
+         type == QuicFrameTypeV1::kPathResponse ||
+         type == QuicFrameTypeV1::kNewConnectionID ||
+         type == QuicFrameTypeV1::kPadding;
+}
+
+// The peer's end of a path: IP version, address and port in network byte
+// order, cheap to compare for every received datagram.
+struct QuicPathAddress {
+ public:
+  static QuicPathAddress From(const Address& address) noexcept;
+
+  // Same IP address, the port may differ.
+  bool SameHost(const QuicPathAddress& other) const noexcept {
+    return version == other.version && ip == other.ip;
+  }
+  bool operator==(const QuicPathAddress&) const = default;
+
+  std::uint8_t version = 0;
+  std::uint16_t port = 0;
+  std::array<std::uint8_t, 16> ip{};
+};
+
+// Connection IDs the peer issued for us to send to (rfc9000 section 5.1).
+//
+// A connection ID is never used on two paths, so that an observer can not
+// link the old path to the new one (rfc9000 section 9.5): Rotate() moves
+// to the unused ID with the lowest sequence number and retires the one in
+// use. IDs are used in sequence order, so a NEW_CONNECTION_ID below the
+// one in use names an ID that is retired already or must be, and only
+// queues a RETIRE_CONNECTION_ID. Retire Prior To retires older IDs, moving
+// off the one in use if needed. Not thread safe.
+class QuicPeerConnectionIDs {
+ public:
+  // connection_id is the Source Connection ID of the peer's first packet,
+  // sequence number 0. active_connection_id_limit is our transport
+  // parameter, at most kQuicActiveConnectionIDLimit.
+  explicit QuicPeerConnectionIDs(
+      std::span<const std::uint8_t> connection_id,
+      std::size_t active_connection_id_limit =
+          kQuicActiveConnectionIDLimit) noexcept;
+
+  // frame is a decoded NEW_CONNECTION_ID frame (rfc9000 section 19.15).
+  QuicMigrationErrorStatus OnNewConnectionID(const QuicFrameV1& frame) noexcept;
+  // Before sending on a new path. With zero-length connection IDs there is
+  // nothing to rotate. kNoConnectionID leaves the ID in use in place; the
+  // peer has to issue more before the connection can migrate unlinkably.
+  QuicMigrationErrorStatus Rotate() noexcept;
+
+  std::span<const std::uint8_t> Current() const noexcept {
+    const Entry& entry = entries[current];
+    return {entry.connection_id.data(), entry.length};
+  }
+  std::uint64_t CurrentSequence() const noexcept {
+    return entries[current].sequence;
+  }
+  // IDs ready for the next migrations.
+  std::size_t Unused() const noexcept { return count - 1; }
+  // token is the last 16 bytes of a datagram that could not be decrypted
+  // (rfc9000 section 10.3.1).
+  bool IsStatelessReset(std::span<const std::uint8_t> token) const noexcept;
+
+  std::size_t PendingRetirements() const noexcept { return retirement_count; }
+  // Moves pending RETIRE_CONNECTION_ID frames into the open packet until one
+  // does not fit, returns the number written.
+  template <QuicVersionTraits Version>
+  std::size_t WriteFrames(QuicPacketBuilder<Version>& builder) noexcept {
+    QuicFrameV1 frame;
+    frame.type = QuicFrameTypeV1::kRetireConnectionID;
+    std::size_t written = 0;
+    while (written < retirement_count) {
+      frame.id = retirements[written];
+      if (builder.AppendFrame(frame) !=
+          QuicPacketBuilderErrorStatus::kSuccess) {
+        break;
+      }
+      written++;
+    }
+    std::copy(retirements.begin() + written,
+              retirements.begin() + retirement_count, retirements.begin());
+    retirement_count -= written;
+    return written;
+  }
+  // A packet carrying RETIRE_CONNECTION_ID for sequence was lost.
+  QuicMigrationErrorStatus OnRetireLost(std::uint64_t sequence) noexcept {
+    return QueueRetirement(sequence);
+  }
+
+ private:
+  struct Entry {
+   public:
+    std::uint64_t sequence = 0;
+    std::uint8_t length = 0;
+    bool has_token = false;
+    std::array<std::uint8_t, kQuicMaxConnectionIDLength> connection_id{};
+    std::array<std::uint8_t, kQuicStatelessResetTokenLengthV1> token{};
+  };
+
+  std::size_t Find(std::uint64_t sequence) const noexcept;
+  // Drops entries[index] and queues its retirement.
+  QuicMigrationErrorStatus Retire(std::size_t index) noexcept;
+  QuicMigrationErrorStatus QueueRetirement(std::uint64_t sequence) noexcept;
+
+  // One more than the limit: a new ID is stored before Retire Prior To
+  // retires the one in use.
+  std::array<Entry, kQuicActiveConnectionIDLimit + 1> entries;
+  std::size_t count = 1;
+  std::size_t current = 0;
+  std::size_t limit = kQuicActiveConnectionIDLimit;
+  std::uint64_t retire_prior_to = 0;
+
+  std::array<std::uint64_t, kQuicMaxPendingRetirements> retirements{};
+  std::size_t retirement_count = 0;
+};
+
+// Path validation and connection migration (rfc9000 sections 8.2 and 9)
+// for one connection.
+//
+// Every datagram is reported with the address it came from. A new address
+// is validated with PATH_CHALLENGE frames of random data in datagrams
+// padded to 1200 bytes, sent again every probe timeout until a
+// PATH_RESPONSE echoes one of them or three probe timeouts pass (rfc9000
+// section 8.2.4); until then at most three times the bytes received from
+// it are sent there. The connection moves to a new address only on a
+// packet with non-probing frames that is the largest packet number seen
+// (rfc9000 section 9.3), so reordered or replayed old packets can not pull
+// it back.
+//
+// The caller acts on the returned events. On kMigrated and kReverted the
+// route is a different one, so the congestion controller and
+// QuicLossDetection start over with OnPathChanged(), a new
+// QuicPathMTUDiscovery takes over, and QuicPeerConnectionIDs::Rotate()
+// picks the connection ID to send with (rfc9000 sections 9.4 and 9.5).
+// On kRebound a NAT in front of the peer changed only the port: the route
+// is the same, so congestion state and connection ID stay. The session
+// continues either way; no handshake is repeated.
+//
+// The manager knows the peer's addresses only. A client moving to a new
+// local address calls Migrate(), which revalidates the path in use; the
+// old local path is not tracked. Not thread safe.
+class QuicPathManager {
+ public:
+  // peer is the address the handshake completed with, which the handshake
+  // validated.
+  explicit QuicPathManager(const Address& peer) noexcept;
+
+  // The current probe timeout of the connection (rfc9002 section 6.2.1).
+  // Challenges are not sent more often than the Initial probe timeout.
+  void SetProbeTimeout(std::chrono::microseconds probe_timeout) noexcept {
+    current_probe_timeout = probe_timeout;
+  }
+
+  // Every datagram that was decrypted. probing is whether its packets held
+  // only probing frames, largest_packet_number whether one of them is the
+  // largest packet number received so far.
+  QuicPathEvent OnPacketReceived(
+      const Address& from, std::size_t size, bool probing,
+      bool largest_packet_number,
+      std::chrono::steady_clock::time_point now) noexcept;
+  // A PATH_CHALLENGE frame received from from; the response goes back to
+  // the same address (rfc9000 section 8.2.2).
+  void OnPathChallenge(const Address& from,
+                       std::span<const std::uint8_t> data) noexcept;
+  // A PATH_RESPONSE from any address validates the path its challenge was
+  // sent on (rfc9000 section 8.2.3).
+  QuicPathEvent OnPathResponse(std::span<const std::uint8_t> data) noexcept;
+  // The client moved to a new local address.
+  QuicPathEvent Migrate(std::chrono::steady_clock::time_point now) noexcept;
+
+  // When OnTimeout is due, time_point::max() if no path is being validated.
+  std::chrono::steady_clock::time_point Timer() const noexcept;
+  // Schedules challenges that are due again and fails paths whose
+  // validation ran out. kFailed with Validated() false means the path in
+  // use failed with none to fall back to: the connection should be closed
+  // (rfc9000 section 8.2.4).
+  QuicPathEvent OnTimeout(std::chrono::steady_clock::time_point now) noexcept;
+
+  // Where packets other than probes go.
+  const Address& Peer() const noexcept { return paths[active].peer; }
+  bool Validated() const noexcept { return paths[active].validated; }
+  // Bytes that may still be sent to Peer() under the amplification limit,
+  // max() once the address is validated.
+  std::uint64_t SendAllowance() const noexcept {
+    return Allowance(paths[active]);
+  }
+  // Every datagram sent to Peer() other than WriteProbe()'s.
+  void OnDatagramSent(std::size_t size) noexcept {
+    paths[active].bytes_sent += size;
+  }
+
+  // A PATH_CHALLENGE or PATH_RESPONSE waits to be sent.
+  bool ProbeDue() const noexcept { return ProbeIndex() != kNoPath; }
+  // Writes the PATH_RESPONSE and PATH_CHALLENGE due on one path into the
+  // open packet, which must be the only one of its datagram, and pads the
+  // datagram to 1200 bytes as far as the amplification limit allows
+  // (rfc9000 section 8.2.1). destination is the address to send it to,
+  // not necessarily Peer().
+  template <QuicVersionTraits Version>
+  QuicPacketBuilderErrorStatus WriteProbe(
+      QuicPacketBuilder<Version>& builder,
+      std::chrono::steady_clock::time_point now,
+      Address& destination) noexcept {
+    std::size_t index = ProbeIndex();
+    if (index == kNoPath) {
+      return QuicPacketBuilderErrorStatus::kInternal;
+    }
+    Path& path = paths[index];
+    QuicPacketBuilderErrorStatus status =
+        QuicPacketBuilderErrorStatus::kSuccess;
+    QuicFrameV1 frame;
+    if (path.response_due) {
+      frame.type = QuicFrameTypeV1::kPathResponse;
+      frame.data = path.response;
+      status = builder.AppendFrame(frame);
+    }
+    bool challenged = false;
+    if (status == QuicPacketBuilderErrorStatus::kSuccess &&
+        path.challenge_due) {
+      frame.type = QuicFrameTypeV1::kPathChallenge;
+      frame.data = NextChallenge(path);
+      status = builder.AppendFrame(frame);
+      challenged = true;
+    }
+    if (status == QuicPacketBuilderErrorStatus::kSuccess) {
+      status = builder.FinishPacket(std::min<std::uint64_t>(
+          kQuicMinInitialDatagramSizeV1, Allowance(path)));
+    }
+    if (status != QuicPacketBuilderErrorStatus::kSuccess) {
+      return status;
+    }
+    OnProbeSent(path, challenged, builder.Datagram().size(), now);
+    destination = path.peer;
+    return status;
+  }
+
+ private:
+  static constexpr std::size_t kNoPath = kQuicMaxPaths;
+
+  struct Path {
+   public:
+    bool in_use = false;
+    bool validated = false;
+    // The peer's address changed to this one: the amplification limit
+    // applies until it is validated.
+    bool amplification_limited = false;
+    Address peer;
+    QuicPathAddress address;
+
+    bool validating = false;
+    bool challenge_due = false;
+    std::chrono::steady_clock::time_point challenge_sent{};
+    std::chrono::microseconds challenge_interval{0};
+    std::chrono::steady_clock::time_point deadline{};
+    // ring of the last challenges sent
+    std::array<std::array<std::uint8_t, kQuicPathChallengeDataLengthV1>,
+               kQuicPathChallengesKept>
+        challenges{};
+    std::size_t challenge_count = 0;
+
+    bool response_due = false;
+    std::array<std::uint8_t, kQuicPathChallengeDataLengthV1> response{};
+
+    std::uint64_t bytes_received = 0;
+    std::uint64_t bytes_sent = 0;
+  };
+
+  static std::uint64_t Allowance(const Path& path) noexcept;
+  std::size_t Find(const QuicPathAddress& address) const noexcept;
+  // A slot for a new path: a free one, else the one neither in use nor
+  // kept to fall back to.
+  std::size_t Allocate() noexcept;
+  void StartValidation(Path& path,
+                       std::chrono::steady_clock::time_point now) noexcept;
+  std::size_t ProbeIndex() const noexcept;
+  // Fresh random data for a challenge, remembered in the path's ring.
+  std::span<const std::uint8_t> NextChallenge(Path& path) noexcept;
+  void OnProbeSent(Path& path, bool challenged, std::size_t size,
+                   std::chrono::steady_clock::time_point now) noexcept;
+
+  std::array<Path, kQuicMaxPaths> paths;
+  std::size_t active = 0;
+  std::size_t fallback = kNoPath;
+  std::chrono::microseconds current_probe_timeout{0};
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -5,6 +5,8 @@
 #include <span>
 #include <vector>
 
+#include "quic_wire.h"
+
 namespace bedrock::network {
 
 struct QuicPacketRawData {
@@ -33,6 +35,18 @@ struct QuicPacketBase : public QuicPacketRawData {
 //   Source Connection ID (0..2040),
 //   Version-Specific Data (..),
 // }
+// Fixed prefix shared by every long header packet, up to and including the
+// Destination Connection ID Length.
+struct QuicLongPacketHeaderLayout {
+ public:
+  using FirstByte = QuicWireField<0, std::uint8_t>;
+  using Version = QuicWireField<1, std::uint32_t>;
+  using DestinationConnectionIDLength = QuicWireField<5, std::uint8_t>;
+
+  static constexpr std::size_t kSize =
+      kQuicWireLayoutSize<FirstByte, Version, DestinationConnectionIDLength>;
+};
+
 struct QuicLongPacketHeader : public QuicPacketBase {
  public:
   // bool HeaderForm() const;
@@ -66,7 +80,8 @@ struct QuicVersionNegotiationPacket : public QuicPacketBase {
   std::span<const std::uint8_t> DestinationConnectionID() const;
   std::uint8_t SourceConnectionIDLength() const;
   std::span<const std::uint8_t> SourceConnectionID() const;
-  std::span<const std::uint32_t> SupportedVersion() const;
+  std::size_t SupportedVersionCount() const;
+  std::uint32_t SupportedVersion(std::size_t index) const;
 };
 
 // Short Header Packet {
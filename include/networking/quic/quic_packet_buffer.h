@@ -0,0 +1,144 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_BUFFER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_BUFFER_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace bedrock::network {
+
+#ifndef BEDROCK_QUIC_MAX_UDP_PAYLOAD_SIZE
+#define BEDROCK_QUIC_MAX_UDP_PAYLOAD_SIZE 1500
+#endif
+
+// Largest UDP payload this endpoint receives. It sizes every receive and
+// packet buffer, is advertised as our max_udp_payload_size and caps the
+// path MTU search, so nothing the peer is allowed to send gets truncated.
+// One Ethernet MTU unless the build sets BEDROCK_QUIC_MAX_UDP_PAYLOAD_SIZE.
+inline constexpr std::size_t kQuicLocalMaxUDPPayloadSize =
+    BEDROCK_QUIC_MAX_UDP_PAYLOAD_SIZE;
+// rfc9000 section 18.2
+static_assert(kQuicLocalMaxUDPPayloadSize >= 1200 &&
+              kQuicLocalMaxUDPPayloadSize <= 65527);
+
+// Every received datagram is read into a packet buffer.
+inline constexpr std::size_t kQuicPacketBufferCapacity =
+    kQuicLocalMaxUDPPayloadSize;
+
+class QuicPacketBufferPool;
+
+// A received datagram that frames can keep referring to after the packet
+// was processed, for example stream data waiting to be read. Buffers come
+// from a QuicPacketBufferPool and go back to it when the last
+// QuicPacketBufferRef is dropped.
+class QuicPacketBuffer {
+ public:
+  std::array<std::uint8_t, kQuicPacketBufferCapacity> data;
+  std::size_t size = 0;
+
+  std::span<std::uint8_t> Datagram() noexcept { return {data.data(), size}; }
+  std::span<const std::uint8_t> Datagram() const noexcept {
+    return {data.data(), size};
+  }
+
+ private:
+  friend class QuicPacketBufferPool;
+  friend class QuicPacketBufferRef;
+
+  QuicPacketBufferPool* pool = nullptr;
+  QuicPacketBuffer* next_free = nullptr;
+  std::uint32_t references = 0;
+};
+
+// Counted reference to a pooled buffer. Counting is not atomic: all
+// references to a buffer are used by one thread at a time. A buffer may
+// move to another thread through a queue that synchronizes, such as
+// QuicSPSCRing, and be released there.
+class QuicPacketBufferRef {
+ public:
+  QuicPacketBufferRef() noexcept = default;
+  QuicPacketBufferRef(const QuicPacketBufferRef& other) noexcept
+      : buffer(other.buffer) {
+    if (buffer != nullptr) {
+      buffer->references++;
+    }
+  }
+  QuicPacketBufferRef(QuicPacketBufferRef&& other) noexcept
+      : buffer(other.buffer) {
+    other.buffer = nullptr;
+  }
+  QuicPacketBufferRef& operator=(const QuicPacketBufferRef& other) noexcept {
+    QuicPacketBufferRef copy(other);
+    std::swap(buffer, copy.buffer);
+    return *this;
+  }
+  QuicPacketBufferRef& operator=(QuicPacketBufferRef&& other) noexcept {
+    std::swap(buffer, other.buffer);
+    return *this;
+  }
+  ~QuicPacketBufferRef() { Reset(); }
+
+  void Reset() noexcept;
+
+  explicit operator bool() const noexcept { return buffer != nullptr; }
+  QuicPacketBuffer* Get() const noexcept { return buffer; }
+  QuicPacketBuffer* operator->() const noexcept { return buffer; }
+  QuicPacketBuffer& operator*() const noexcept { return *buffer; }
+
+ private:
+  friend class QuicPacketBufferPool;
+
+  explicit QuicPacketBufferRef(QuicPacketBuffer* referenced) noexcept
+      : buffer(referenced) {}
+
+  QuicPacketBuffer* buffer = nullptr;
+};
+
+// Fixed set of packet buffers with a free list; nothing is allocated after
+// construction. Only the owning thread allocates, but the last reference
+// to a buffer may be dropped on any thread: released buffers go to a lock
+// free stack that Allocate() takes over whole once its own list is empty.
+// Must outlive every reference it hands out.
+class QuicPacketBufferPool {
+ public:
+  explicit QuicPacketBufferPool(std::size_t capacity) noexcept;
+  QuicPacketBufferPool(const QuicPacketBufferPool&) = delete;
+  QuicPacketBufferPool& operator=(const QuicPacketBufferPool&) = delete;
+
+  // An empty reference when every buffer is in use; the datagram should be
+  // dropped then.
+  QuicPacketBufferRef Allocate() noexcept;
+
+  std::size_t Capacity() const noexcept { return capacity; }
+  std::size_t Available() const noexcept {
+    return available.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class QuicPacketBufferRef;
+
+  void Free(QuicPacketBuffer* buffer) noexcept;
+
+  std::size_t capacity = 0;
+  std::atomic<std::size_t> available = 0;
+  std::unique_ptr<QuicPacketBuffer[]> buffers;
+  // Only touched by the owning thread
+  QuicPacketBuffer* free_list = nullptr;
+  // Buffers released by any thread since free_list was last refilled
+  std::atomic<QuicPacketBuffer*> returned = nullptr;
+};
+
+inline void QuicPacketBufferRef::Reset() noexcept {
+  if (buffer != nullptr && --buffer->references == 0) {
+    buffer->pool->Free(buffer);
+  }
+  buffer = nullptr;
+}
+
+}  // namespace bedrock::network
+
+#endif
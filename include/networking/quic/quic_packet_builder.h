@@ -0,0 +1,134 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_BUILDER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_BUILDER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "quic_frame.h"
+#include "quic_version.h"
+#include "rfc9000.h"
+
+namespace bedrock::network {
+
+// Smallest datagram allowed to carry a client Initial (rfc9000 section 14.1)
+inline constexpr std::size_t kQuicMinInitialDatagramSizeV1 = 1200;
+// AES-128-GCM, AES-256-GCM and ChaCha20-Poly1305 all use 16 byte tags
+inline constexpr std::size_t kQuicAeadTagLengthV1 = 16;
+// Initial, 0-RTT, Handshake and 1-RTT can share a single datagram
+inline constexpr std::size_t kQuicMaxCoalescedPacketsV1 = 4;
+
+enum class QuicPacketBuilderErrorStatus {
+  kSuccess,
+  kNoSpace,   // does not fit in the datagram
+  kInternal,  // call is not valid in the current builder state
+  kInvalid    // argument out of range
+};
+
+// Location of one serialized packet inside the send buffer. The AEAD tag space
+// at the end of the packet is reserved but left unwritten until protection.
+struct QuicBuiltPacketV1 {
+ public:
+  std::size_t header_offset = 0;
+  std::size_t packet_number_offset = 0;
+  std::size_t payload_offset = 0;
+  std::size_t end_offset = 0;
+  std::uint64_t packet_number = 0;
+  std::uint8_t packet_number_length = 0;
+  bool long_header = false;
+  bool ack_eliciting = false;
+};
+
+// Serializes packet headers and frames directly into a caller owned send
+// buffer, coalescing long header packets into one datagram until the path MTU
+// is reached. A short header packet has no Length field, so it closes the
+// datagram. Version fixes the Version field and the Long Packet Type
+// encoding at compile time.
+template <QuicVersionTraits Version>
+class QuicPacketBuilder {
+ public:
+  QuicPacketBuilder(std::span<std::uint8_t> send_buffer,
+                    std::size_t max_datagram_size) noexcept;
+
+  // Starts a new datagram in the same send buffer.
+  void Reset() noexcept;
+  void SetMaxDatagramSize(std::size_t max_datagram_size) noexcept;
+
+  // token is only written for Initial packets.
+  QuicPacketBuilderErrorStatus BeginLongPacket(
+      QuicLongHeaderPacketTypeV1 type,
+      std::span<const std::uint8_t> destination_connection_id,
+      std::span<const std::uint8_t> source_connection_id,
+      std::span<const std::uint8_t> token, std::uint64_t packet_number,
+      std::uint8_t packet_number_length) noexcept;
+  QuicPacketBuilderErrorStatus BeginShortPacket(
+      std::span<const std::uint8_t> destination_connection_id,
+      std::uint64_t packet_number, std::uint8_t packet_number_length,
+      bool key_phase, bool spin_bit = false) noexcept;
+
+  // Serializes a whole frame record as produced by QuicFrameDecoderV1. STREAM
+  // frames always carry an explicit Length. Nothing is written on failure.
+  QuicPacketBuilderErrorStatus AppendFrame(const QuicFrameV1& frame) noexcept;
+  // Appends frames in order until one does not fit, returns the count written.
+  std::size_t AppendFrames(std::span<const QuicFrameV1> frames) noexcept;
+
+  // Writes as much of data as fits and returns the number of bytes taken.
+  // FIN is only set when all of data was written.
+  std::size_t AppendStreamFrame(std::uint64_t stream_id, std::uint64_t offset,
+                                std::span<const std::uint8_t> data,
+                                bool fin) noexcept;
+  std::size_t AppendCryptoFrame(std::uint64_t offset,
+                                std::span<const std::uint8_t> data) noexcept;
+  // Writes all of data as one DATAGRAM frame (rfc9221 section 4) or
+  // nothing. The frame is not retransmitted if the packet is lost.
+  QuicPacketBuilderErrorStatus AppendDatagramFrame(
+      std::span<const std::uint8_t> data) noexcept;
+  // ranges must be sorted from the largest packet number down. Trailing
+  // ranges are dropped when the frame would not fit.
+  QuicPacketBuilderErrorStatus AppendAckFrame(
+      std::span<const QuicAckRangeV1> ranges, std::uint64_t ack_delay) noexcept;
+  QuicPacketBuilderErrorStatus AppendPadding(std::size_t length) noexcept;
+
+  // Closes the open packet, back-filling its Length field. If the datagram is
+  // still shorter than pad_datagram_to, PADDING is added to this packet.
+  QuicPacketBuilderErrorStatus FinishPacket(
+      std::size_t pad_datagram_to = 0) noexcept;
+
+  // Frame bytes still available in the open packet.
+  std::size_t Remaining() const noexcept;
+  bool PacketOpen() const noexcept { return packet_open; }
+
+  std::span<std::uint8_t> Datagram() const noexcept {
+    return buffer.subspan(0, datagram_size);
+  }
+  std::span<const QuicBuiltPacketV1> Packets() const noexcept {
+    return std::span<const QuicBuiltPacketV1>(packets.data(), packet_count);
+  }
+
+ private:
+  std::size_t Limit() const noexcept;
+  std::uint8_t* Cursor() const noexcept { return buffer.data() + position; }
+
+  std::span<std::uint8_t> buffer;
+  std::size_t max_datagram = 0;
+
+  std::size_t position = 0;
+  std::size_t datagram_size = 0;
+  std::size_t length_offset = 0;
+  bool packet_open = false;
+  bool datagram_closed = false;
+
+  std::array<QuicBuiltPacketV1, kQuicMaxCoalescedPacketsV1> packets{};
+  std::size_t packet_count = 0;
+};
+
+extern template class QuicPacketBuilder<QuicVersion1>;
+extern template class QuicPacketBuilder<QuicVersion2>;
+
+using QuicPacketBuilderV1 = QuicPacketBuilder<QuicVersion1>;
+using QuicPacketBuilderV2 = QuicPacketBuilder<QuicVersion2>;
+
+}  // namespace bedrock::network
+
+#endif
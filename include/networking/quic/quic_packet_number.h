@@ -0,0 +1,61 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_NUMBER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_NUMBER_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace bedrock::network {
+
+// Packet numbers run from 0 to 2^62 - 1 (rfc9000 section 12.3).
+inline constexpr std::uint64_t kQuicMaxPacketNumber =
+    (std::uint64_t{1} << 62) - 1;
+// Stands for "no packet yet" wherever a largest packet number is expected.
+// It is -1 modulo 2^64, so the arithmetic of rfc9000 appendix A, which
+// treats a missing largest packet number as -1, works on it unchanged.
+inline constexpr std::uint64_t kQuicNoPacketNumber = ~std::uint64_t{0};
+
+// Bytes needed to send packet_number so that the peer can recover it: room
+// for twice the distance to the largest acknowledged packet (rfc9000
+// appendix A.2). Uses kQuicNoPacketNumber before anything was acknowledged.
+constexpr std::uint8_t QuicPacketNumberLength(
+    std::uint64_t packet_number, std::uint64_t largest_acked) noexcept {
+  std::uint64_t unacked = packet_number - largest_acked;
+  // one bit more than unacked takes, rounded up to whole bytes
+  auto bits = std::bit_width(unacked) + 1;
+  return static_cast<std::uint8_t>(std::min<decltype(bits)>((bits + 7) / 8, 4));
+}
+
+// The low length bytes that go on the wire.
+constexpr std::uint64_t TruncateQuicPacketNumber(std::uint64_t packet_number,
+                                                 std::size_t length) noexcept {
+  return packet_number & ((std::uint64_t{1} << (length * 8)) - 1);
+}
+
+// Expands a truncated packet number to the value closest to
+// largest_packet_number + 1 (rfc9000 appendix A.3). length is 1 to 4.
+//
+// Rather than aligning a candidate to the expected window and then moving
+// it one window up or down, the distance from the expected number is taken
+// modulo the window: the result is that distance ahead, or one window less
+// when the distance passes half a window. The window is subtracted through
+// a mask rather than a branch, since for reordered packets the direction
+// is as good as random.
+constexpr std::uint64_t DecodeQuicPacketNumber(
+    std::uint64_t largest_packet_number, std::uint64_t truncated,
+    std::size_t length) noexcept {
+  std::uint64_t expected = largest_packet_number + 1;
+  std::uint64_t window = std::uint64_t{1} << (length * 8);
+  std::uint64_t distance = (truncated - expected) & (window - 1);
+  std::uint64_t ahead = expected + distance;
+  // stay ahead when going back would pass zero; go back when ahead would
+  // pass the largest packet number
+  std::uint64_t back = ((distance > window / 2) & (ahead >= window)) |
+                       (ahead > kQuicMaxPacketNumber);
+  return ahead - (window & (0 - back));
+}
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_PROTECTION_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PACKET_PROTECTION_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "quic_crypto.h"
+#include "quic_packet_builder.h"
+#include "quic_packet_number.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Header protection samples 16 bytes starting 4 bytes after the start of the
+// Packet Number field, as if it were always 4 bytes long (rfc9001 5.4.2).
+inline constexpr std::size_t kQuicHeaderProtectionSampleOffset = 4;
+inline constexpr std::size_t kQuicHeaderProtectionSampleSize = 16;
+// Only the first 5 bytes of the mask are used
+inline constexpr std::size_t kQuicHeaderProtectionMaskSize = 5;
+// Samples whose AES rounds are interleaved by one batched mask computation
+inline constexpr std::size_t kQuicHeaderProtectionBatchSize = 8;
+
+using QuicHeaderProtectionMask =
+    std::array<std::uint8_t, kQuicHeaderProtectionMaskSize>;
+
+enum class QuicPacketProtectionErrorStatus {
+  kSuccess,
+  kMalformed,      // header cannot be parsed or is not a protected packet
+  kTooShort,       // not enough bytes after the Packet Number for a sample
+  kAuthentication  // AEAD tag mismatch, the packet must be dropped
+};
+
+// Packet protection keys of one direction at one encryption level:
+// AEAD_AES_128_GCM for the payload and AES-128-ECB header protection.
+// Packets are protected and unprotected in place in the datagram buffer.
+class QuicPacketProtectionKeys {
+ public:
+  QuicPacketProtectionKeys() = default;
+
+  void SetKeys(std::span<const std::uint8_t, kQuicAES128KeySize> key,
+               std::span<const std::uint8_t, kQuicAEADNonceSize> packet_iv,
+               std::span<const std::uint8_t, kQuicAES128KeySize>
+                   header_protection_key) noexcept;
+  // Expands key, iv and hp from a traffic secret with the labels of Version
+  // (rfc9001 section 5.1, rfc9369 section 3.3.2).
+  template <QuicVersionTraits Version>
+  void SetSecret(std::span<const std::uint8_t> secret) noexcept {
+    SetSecret(secret, Version::kKeyLabel, Version::kIvLabel,
+              Version::kHpLabel);
+  }
+  void SetSecret(std::span<const std::uint8_t> secret,
+                 std::string_view key_label, std::string_view iv_label,
+                 std::string_view hp_label) noexcept;
+
+  // Encrypts the payload of a packet laid out by QuicPacketBuilder, writes
+  // the tag into the reserved space at its end and then applies header
+  // protection.
+  QuicPacketProtectionErrorStatus Protect(
+      std::span<std::uint8_t> datagram,
+      const QuicBuiltPacketV1& packet) const noexcept;
+  // Removes header protection and decrypts the payload of a packet found by
+  // LocateQuicProtectedPacket. packet_number, packet_number_length and
+  // payload_offset are filled in; the packet number is expanded against
+  // largest_packet_number (rfc9000 appendix A.3). Afterwards the header
+  // reads as plaintext, e.g. through QuicInitialPacketV1, and the payload
+  // spans [payload_offset, end_offset - kQuicAEADTagSize).
+  QuicPacketProtectionErrorStatus Unprotect(
+      std::span<std::uint8_t> datagram, QuicBuiltPacketV1& packet,
+      std::uint64_t largest_packet_number) const noexcept;
+
+  // Unprotects a burst of received packets, packets[i] located in
+  // datagrams[i], e.g. the 1-RTT packets of one connection drained from a
+  // recvmmsg receive. The header protection masks of up to
+  // kQuicHeaderProtectionBatchSize packets are computed together, so their
+  // AES rounds overlap instead of each mask waiting out the full aesenc
+  // latency. Every packet number is expanded against largest_packet_number.
+  void UnprotectBatch(std::span<const std::span<std::uint8_t>> datagrams,
+                      std::span<QuicBuiltPacketV1> packets,
+                      std::uint64_t largest_packet_number,
+                      std::span<QuicPacketProtectionErrorStatus> results)
+      const noexcept;
+
+  // AES-ECB(hp_key, sample), truncated to the bytes that are used
+  QuicHeaderProtectionMask HeaderProtectionMask(
+      const std::uint8_t* sample) const noexcept;
+  // Masks of count samples, at most kQuicHeaderProtectionBatchSize, with
+  // the AES rounds of all samples interleaved.
+  void HeaderProtectionMasks(const std::uint8_t* const* samples,
+                             QuicHeaderProtectionMask* masks,
+                             std::size_t count) const noexcept;
+
+ private:
+  // Checks the packet bounds and returns the sample offset through
+  // sample_offset.
+  static QuicPacketProtectionErrorStatus SampleOffset(
+      std::span<const std::uint8_t> datagram, const QuicBuiltPacketV1& packet,
+      std::size_t& sample_offset) noexcept;
+  void RemoveHeaderProtection(std::span<std::uint8_t> datagram,
+                              QuicBuiltPacketV1& packet,
+                              const QuicHeaderProtectionMask& mask,
+                              std::uint64_t largest_packet_number)
+      const noexcept;
+  QuicPacketProtectionErrorStatus OpenPayload(
+      std::span<std::uint8_t> datagram,
+      const QuicBuiltPacketV1& packet) const noexcept;
+  std::array<std::uint8_t, kQuicAEADNonceSize> Nonce(
+      std::uint64_t packet_number) const noexcept;
+
+  QuicAES128GCM aead;
+  std::array<std::uint8_t, kQuicAEADNonceSize> iv{};
+  QuicAES128 header_protection;
+};
+
+// Both directions of the Initial encryption level
+struct QuicInitialKeys {
+ public:
+  QuicPacketProtectionKeys client;
+  QuicPacketProtectionKeys server;
+};
+
+// Derives the Initial keys from the Destination Connection ID of the
+// client's first Initial packet and the salt of Version (rfc9001 5.2).
+template <QuicVersionTraits Version>
+void DeriveQuicInitialKeys(
+    std::span<const std::uint8_t> destination_connection_id,
+    QuicInitialKeys& keys) noexcept;
+
+// Finds the bounds of the protected packet starting at offset in a received
+// datagram: header_offset, packet_number_offset, end_offset and
+// long_header. A long header packet ends where its Length field says; a
+// short header packet, whose connection ID length is only known to the
+// receiver, runs to the end of the datagram. Retry and Version Negotiation
+// packets are not protected and yield kMalformed.
+template <QuicVersionTraits Version>
+QuicPacketProtectionErrorStatus LocateQuicProtectedPacket(
+    std::span<const std::uint8_t> datagram, std::size_t offset,
+    std::size_t short_connection_id_length,
+    QuicBuiltPacketV1& packet) noexcept;
+
+extern template void DeriveQuicInitialKeys<QuicVersion1>(
+    std::span<const std::uint8_t>, QuicInitialKeys&) noexcept;
+extern template void DeriveQuicInitialKeys<QuicVersion2>(
+    std::span<const std::uint8_t>, QuicInitialKeys&) noexcept;
+extern template QuicPacketProtectionErrorStatus
+LocateQuicProtectedPacket<QuicVersion1>(std::span<const std::uint8_t>,
+                                        std::size_t, std::size_t,
+                                        QuicBuiltPacketV1&) noexcept;
+extern template QuicPacketProtectionErrorStatus
+LocateQuicProtectedPacket<QuicVersion2>(std::span<const std::uint8_t>,
+                                        std::size_t, std::size_t,
+                                        QuicBuiltPacketV1&) noexcept;
+
+}  // namespace bedrock::network
+
+#endif
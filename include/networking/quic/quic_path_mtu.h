@@ -0,0 +1,159 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PATH_MTU_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_PATH_MTU_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "quic_frame.h"
+#include "quic_packet_buffer.h"
+#include "quic_packet_builder.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Sizes here are UDP payload sizes, the unit of max_udp_payload_size.
+// Every QUIC path carries 1200 bytes (rfc9000 section 14), so that is the
+// base PLPMTU (rfc8899 section 5.1.2).
+inline constexpr std::size_t kQuicBasePLPMTU = kQuicMinInitialDatagramSizeV1;
+// max_udp_payload_size transport parameter (rfc9000 section 18.2)
+inline constexpr std::uint64_t kQuicMaxUDPPayloadSizeParameterID = 0x03;
+// Its default, assumed for a peer that does not send it
+inline constexpr std::size_t kQuicMaxUDPPayloadSize = 65527;
+// A size is only given up after this many of its probes were lost
+// (MAX_PROBES, rfc8899 section 5.1.2).
+inline constexpr std::uint32_t kQuicMaxPMTUProbes = 3;
+// The search stops once the bounds are closer than this.
+inline constexpr std::size_t kQuicPMTUSearchGranularity = 16;
+// PMTU_RAISE_TIMER (rfc8899 section 5.1.1)
+inline constexpr std::chrono::seconds kQuicPMTURaiseInterval{600};
+// Packets larger than the base lost in a row, with none acknowledged in
+// between, before the path is taken to have shrunk. Larger than a burst of
+// congestion loss usually is.
+inline constexpr std::uint32_t kQuicPMTUBlackHoleThreshold = 6;
+
+// Writes the max_udp_payload_size transport parameter, returns the number
+// of bytes written or 0 if out is too small.
+std::size_t WriteQuicMaxUDPPayloadSize(std::uint64_t max_udp_payload_size,
+                                       std::span<std::uint8_t> out) noexcept;
+// Looks for max_udp_payload_size among the peer's transport parameters;
+// kQuicMaxUDPPayloadSize when absent. False if the parameters are malformed
+// or the value is below 1200 (TRANSPORT_PARAMETER_ERROR).
+bool ReadQuicMaxUDPPayloadSize(
+    std::span<const std::uint8_t> transport_parameters,
+    std::uint64_t& max_udp_payload_size) noexcept;
+
+// rfc8899 section 5.2. There is no ERROR state: QUIC can not run below the
+// base PLPMTU at all.
+enum class QuicPMTUState : std::uint8_t {
+  kDisabled,
+  kSearching,
+  kSearchComplete
+};
+
+// Datagram Packetization Layer Path MTU Discovery (rfc8899, rfc9000
+// section 14.3) for one path.
+//
+// Probes are PING frames padded to the probe size, sent in a packet of
+// their own. The largest acknowledged probe size becomes the PLPMTU, which
+// is what every other packet may use. Sizes between the PLPMTU and the
+// ceiling are binary searched, so the search takes about a dozen probe
+// sizes rather than hundreds. The ceiling never exceeds
+// kQuicLocalMaxUDPPayloadSize, 1500 by default; using a 9000 byte jumbo
+// frame path needs a build with BEDROCK_QUIC_MAX_UDP_PAYLOAD_SIZE raised to
+// 9000. A size counts as too big once kQuicMaxPMTUProbes of its probes are
+// lost, or at once when the local stack refuses to send it (EMSGSIZE) or
+// an ICMP Packet Too Big arrives.
+//
+// Probe loss is expected and must not be reported to congestion control
+// (rfc9000 section 14.4). The connection's loss detection tells this class
+// about every acknowledged and lost packet; losing many large packets in a
+// row drops the PLPMTU back to the base and searches again below it.
+class QuicPathMTUDiscovery {
+ public:
+  // max_udp_payload_size is our own limit, typically the interface MTU
+  // minus IP and UDP headers. The search never goes above
+  // kQuicLocalMaxUDPPayloadSize, the largest datagram we can receive.
+  explicit QuicPathMTUDiscovery(
+      std::size_t max_udp_payload_size = kQuicLocalMaxUDPPayloadSize) noexcept;
+
+  // Starts the search, once the handshake is confirmed (rfc9000 section
+  // 14.3.1).
+  void Enable() noexcept;
+  // The peer's max_udp_payload_size transport parameter
+  void SetPeerMaxUDPPayloadSize(std::size_t size) noexcept;
+  // Our max_udp_payload_size, kQuicLocalMaxUDPPayloadSize.
+  std::size_t WriteTransportParameter(
+      std::span<std::uint8_t> out) const noexcept {
+    return WriteQuicMaxUDPPayloadSize(kQuicLocalMaxUDPPayloadSize, out);
+  }
+  // False on a malformed or invalid max_udp_payload_size.
+  bool OnPeerTransportParameters(
+      std::span<const std::uint8_t> transport_parameters) noexcept;
+
+  QuicPMTUState State() const noexcept { return state; }
+  // Largest datagram the path is known to carry.
+  std::size_t PLPMTU() const noexcept { return plpmtu; }
+
+  // A probe is due: searching with no probe outstanding, or the search
+  // completed PMTU_RAISE_TIMER ago and the path may have grown.
+  bool ShouldProbe(std::chrono::steady_clock::time_point now) noexcept;
+  std::size_t ProbeSize() const noexcept { return probe_size; }
+  // Fills the open packet with PING and PADDING so that the datagram is
+  // ProbeSize() bytes. The packet must be the first of its datagram.
+  template <QuicVersionTraits Version>
+  QuicPacketBuilderErrorStatus WriteProbe(
+      QuicPacketBuilder<Version>& builder) const noexcept {
+    QuicFrameV1 ping;
+    ping.type = QuicFrameTypeV1::kPing;
+    builder.SetMaxDatagramSize(probe_size);
+    QuicPacketBuilderErrorStatus status = builder.AppendFrame(ping);
+    if (status == QuicPacketBuilderErrorStatus::kSuccess) {
+      status = builder.FinishPacket(probe_size);
+    }
+    if (status == QuicPacketBuilderErrorStatus::kSuccess &&
+        builder.Datagram().size() != probe_size) {
+      status = QuicPacketBuilderErrorStatus::kNoSpace;
+    }
+    builder.SetMaxDatagramSize(plpmtu);
+    return status;
+  }
+  void OnProbeSent(std::uint64_t packet_number) noexcept;
+  bool IsProbe(std::uint64_t packet_number) const noexcept {
+    return probe_in_flight && packet_number == probe_packet_number;
+  }
+  void OnProbeAcked(std::uint64_t packet_number) noexcept;
+  void OnProbeLost(std::uint64_t packet_number) noexcept;
+  // Datagrams of size bytes or more can not take this path: sending one
+  // failed with EMSGSIZE, or a Packet Too Big message reported an MTU that
+  // leaves size - 1 bytes for the UDP payload.
+  void OnPacketTooBig(std::size_t size) noexcept;
+
+  // Every other packet, for black hole detection.
+  void OnPacketAcked(std::size_t size) noexcept;
+  void OnPacketLost(std::size_t size) noexcept;
+
+ private:
+  // Picks the next probe size, or completes the search.
+  void NextProbe() noexcept;
+  void Restart(std::size_t high) noexcept;
+
+  QuicPMTUState state = QuicPMTUState::kDisabled;
+  std::size_t max_size = kQuicLocalMaxUDPPayloadSize;
+  std::size_t plpmtu = kQuicBasePLPMTU;
+  // Largest size that may still work, at least plpmtu.
+  std::size_t search_high = kQuicLocalMaxUDPPayloadSize;
+
+  std::size_t probe_size = kQuicBasePLPMTU;
+  std::uint32_t probe_count = 0;
+  std::uint64_t probe_packet_number = 0;
+  bool probe_in_flight = false;
+
+  std::uint32_t large_losses = 0;
+  std::chrono::steady_clock::time_point search_completed{};
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_REASSEMBLY_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_REASSEMBLY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "quic_packet_buffer.h"
+
+namespace bedrock::network {
+
+// Fragments held by default: the datagrams a 1 MiB window of full sized
+// packets takes.
+inline constexpr std::size_t kQuicReassemblyDefaultMaxFragments = 1024;
+
+enum class QuicReassemblyErrorStatus {
+  kSuccess,
+  kFlowControl,  // data beyond the advertised limit, a FLOW_CONTROL_ERROR
+  kFinalSize,    // data or FIN contradicting the final size, a
+                 // FINAL_SIZE_ERROR (rfc9000 section 4.5)
+  kBusy,         // too many fragments held; the packet must not be
+                 // acknowledged so that the peer sends the data again
+};
+
+// Receive side of one stream, or of the CRYPTO stream of one packet number
+// space: STREAM or CRYPTO frame data at any offset in, in-order bytes out.
+//
+// Data is not copied. A fragment keeps a reference to the packet buffer the
+// frame was decoded from and the application reads straight out of it;
+// the buffer returns to its pool once every fragment in it has been read.
+// Overlapping and duplicate data is trimmed against what is already held,
+// so every byte is stored once and the first copy received wins.
+//
+// Fragments are kept sorted by offset in a vector. In-order data is
+// appended and read from the front, both O(1) amortized; a reordered
+// fragment is placed by binary search. Held data is bounded by the
+// flow-control window, since nothing beyond the advertised limit is
+// accepted, and the number of pinned packet buffers by max_fragments.
+class QuicReassemblyBuffer {
+ public:
+  // max_data is the initial MAX_STREAM_DATA limit, an absolute offset.
+  explicit QuicReassemblyBuffer(
+      std::uint64_t max_data,
+      std::size_t max_fragments = kQuicReassemblyDefaultMaxFragments) noexcept
+      : limit(max_data), fragment_limit(max_fragments) {}
+
+  // Stores the frame data, which must lie in packet. fin marks offset +
+  // data.size() as the final size.
+  QuicReassemblyErrorStatus Insert(std::uint64_t offset,
+                                   std::span<const std::uint8_t> data,
+                                   bool fin, const QuicPacketBufferRef& packet);
+
+  // Contiguous bytes at ReadOffset(), the first part of ReadableBytes().
+  // Empty when nothing can be read.
+  std::span<const std::uint8_t> Front() const noexcept;
+  // Fills spans with the readable parts in order, as for a gathering
+  // write, and returns how many were filled.
+  std::size_t Peek(std::span<std::span<const std::uint8_t>> spans) const;
+  // Marks bytes, at most ReadableBytes(), as read and releases the packet
+  // buffers that are no longer referenced.
+  void Consume(std::uint64_t bytes) noexcept;
+
+  // Raises the limit after a MAX_STREAM_DATA frame was sent. Limits never
+  // shrink (rfc9000 section 4.1).
+  void SetMaxData(std::uint64_t max_data) noexcept {
+    limit = max_data > limit ? max_data : limit;
+  }
+  std::uint64_t MaxData() const noexcept { return limit; }
+
+  std::uint64_t ReadOffset() const noexcept { return read_offset; }
+  std::uint64_t ReadableBytes() const noexcept {
+    return contiguous_end - read_offset;
+  }
+  // Largest offset received, which counts towards connection flow control.
+  std::uint64_t LargestReceived() const noexcept { return largest_received; }
+  bool FinalSizeKnown() const noexcept { return final_size_known; }
+  // Every byte up to the final size arrived (Data Recvd).
+  bool AllDataReceived() const noexcept {
+    return final_size_known && contiguous_end == largest_received;
+  }
+  // Every byte up to the final size was read (Data Read).
+  bool Finished() const noexcept {
+    return final_size_known && read_offset == largest_received;
+  }
+  std::size_t FragmentCount() const noexcept {
+    return fragments.size() - head;
+  }
+
+ private:
+  struct Fragment {
+   public:
+    std::uint64_t offset = 0;
+    const std::uint8_t* data = nullptr;
+    std::uint64_t length = 0;
+    QuicPacketBufferRef packet;
+
+    std::uint64_t End() const noexcept { return offset + length; }
+  };
+
+  // Moves contiguous_end over fragments that now follow it directly.
+  void ExtendContiguous() noexcept;
+
+  // fragments[head] is the first unread fragment; fragments from index
+  // contiguous start at or after contiguous_end.
+  std::vector<Fragment> fragments;
+  std::size_t head = 0;
+  std::size_t contiguous = 0;
+
+  std::uint64_t read_offset = 0;
+  std::uint64_t contiguous_end = 0;
+  std::uint64_t largest_received = 0;
+  std::uint64_t limit;
+  std::size_t fragment_limit;
+  bool final_size_known = false;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_RETRY_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_RETRY_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "networking/socket/address.h"
+#include "quic_connection_id_table.h"
+#include "quic_crypto.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+inline constexpr std::size_t kQuicRetryIntegrityTagSize = 16;
+// Key epoch, nonce, sealed (issue time, ODCID length, ODCID) and tag
+inline constexpr std::size_t kQuicMaxRetryTokenSize =
+    1 + kQuicAEADNonceSize + 8 + 1 + kQuicMaxConnectionIDLength +
+    kQuicAEADTagSize;
+// First byte, Version, both connection IDs with lengths, token and tag
+inline constexpr std::size_t kQuicMaxRetryPacketSize =
+    1 + 4 + 2 * (1 + kQuicMaxConnectionIDLength) + kQuicMaxRetryTokenSize +
+    kQuicRetryIntegrityTagSize;
+
+using QuicRetrySecret = std::array<std::uint8_t, kQuicSHA256Size>;
+
+enum class QuicRetryErrorStatus {
+  kSuccess,
+  kMalformed,  // not a parsable Initial of the expected version
+  kInvalid,    // token was not issued by this server or not for this peer
+  kExpired,    // token is older than the configured lifetime
+  kNoSpace     // output buffer too small
+};
+
+struct QuicRetryConfig {
+ public:
+  // Handshakes per second started without a token above which the
+  // responder switches to Retry; 0 sends a Retry for every handshake.
+  std::uint32_t handshake_rate_threshold = 1000;
+  // Token keys are derived per epoch of this length, counted on the system
+  // clock so servers with synchronized clocks agree on it. Tokens of the
+  // current and the previous epoch are accepted.
+  std::chrono::milliseconds key_rotation_period{std::chrono::seconds(30)};
+  std::chrono::milliseconds token_lifetime{std::chrono::seconds(10)};
+  // Shared by every responder that must accept the others' tokens, e.g.
+  // all receive workers of one listener. A responder given the all-zero
+  // default generates its own random secret, so its tokens are accepted by
+  // no other responder.
+  QuicRetrySecret secret{};
+};
+
+// Header fields of a client Initial needed to answer it
+struct QuicInitialHeaderView {
+ public:
+  std::span<const std::uint8_t> destination_connection_id;
+  std::span<const std::uint8_t> source_connection_id;
+  std::span<const std::uint8_t> token;
+};
+
+template <QuicVersionTraits Version>
+QuicRetryErrorStatus ParseQuicInitialHeader(
+    std::span<const std::uint8_t> datagram,
+    QuicInitialHeaderView& header) noexcept;
+
+// Checks the Retry Integrity Tag (rfc9001 section 5.8), as a client does.
+template <QuicVersionTraits Version>
+bool VerifyQuicRetryIntegrity(
+    std::span<const std::uint8_t> retry_packet,
+    std::span<const std::uint8_t> original_connection_id) noexcept;
+
+// Stateless address validation with Retry (rfc9000 section 8.1.2).
+//
+// A token is AES-128-GCM sealed under a key derived from the shared secret
+// and the current key epoch, so keys rotate without coordination between
+// workers or servers. It carries its issue time and the client's original
+// Destination Connection ID, and authenticates the client address as
+// associated data. Validation needs nothing but the secret.
+//
+// Retry costs a round trip, so it only starts when the rate of handshakes
+// without a token, measured over a sliding one second window, rises above
+// the configured threshold. Not thread safe; each receive worker owns one
+// responder built from the same config.
+class QuicRetryResponder {
+ public:
+  explicit QuicRetryResponder(const QuicRetryConfig& retry_config) noexcept;
+
+  static QuicRetrySecret GenerateSecret() noexcept;
+
+  // Counts a handshake started without a token and returns whether it must
+  // be answered with a Retry.
+  bool RetryRequired(std::chrono::steady_clock::time_point now) noexcept;
+
+  // Writes a Retry for the parsed client Initial with retry_connection_id
+  // as the new server connection ID, which the client then uses as its
+  // Destination Connection ID.
+  template <QuicVersionTraits Version>
+  QuicRetryErrorStatus Respond(
+      const QuicInitialHeaderView& initial, const Address& peer,
+      std::span<const std::uint8_t> retry_connection_id,
+      std::chrono::system_clock::time_point now,
+      std::span<std::uint8_t> response, std::size_t& size) noexcept;
+
+  // Seals a token for peer. size is only set on kSuccess.
+  QuicRetryErrorStatus IssueToken(
+      const Address& peer,
+      std::span<const std::uint8_t> original_connection_id,
+      std::chrono::system_clock::time_point now,
+      std::span<std::uint8_t> token, std::size_t& size) noexcept;
+  // Opens a token from an Initial and returns the original Destination
+  // Connection ID it carries, for the original_destination_connection_id
+  // transport parameter.
+  QuicRetryErrorStatus ValidateToken(
+      std::span<const std::uint8_t> token, const Address& peer,
+      std::chrono::system_clock::time_point now,
+      std::span<std::uint8_t> original_connection_id,
+      std::size_t& size) noexcept;
+
+ private:
+  // Key of the given epoch; the last two epochs stay cached.
+  const QuicAES128GCM& EpochKey(std::uint64_t epoch) noexcept;
+  std::uint64_t Epoch(std::chrono::system_clock::time_point now)
+      const noexcept;
+
+  struct CachedKey {
+   public:
+    std::uint64_t epoch = 0;
+    bool valid = false;
+    QuicAES128GCM aead;
+  };
+
+  QuicRetryConfig config;
+  std::array<CachedKey, 2> keys{};
+
+  // nonce = random prefix of this responder || counter
+  std::uint32_t nonce_prefix = 0;
+  std::uint64_t nonce_counter = 0;
+
+  // Sliding window handshake rate: counts of the current and previous
+  // one second window.
+  std::int64_t window = 0;
+  std::uint32_t window_count = 0;
+  std::uint32_t previous_window_count = 0;
+};
+
+extern template QuicRetryErrorStatus ParseQuicInitialHeader<QuicVersion1>(
+    std::span<const std::uint8_t>, QuicInitialHeaderView&) noexcept;
+extern template QuicRetryErrorStatus ParseQuicInitialHeader<QuicVersion2>(
+    std::span<const std::uint8_t>, QuicInitialHeaderView&) noexcept;
+extern template bool VerifyQuicRetryIntegrity<QuicVersion1>(
+    std::span<const std::uint8_t>, std::span<const std::uint8_t>) noexcept;
+extern template bool VerifyQuicRetryIntegrity<QuicVersion2>(
+    std::span<const std::uint8_t>, std::span<const std::uint8_t>) noexcept;
+extern template QuicRetryErrorStatus
+QuicRetryResponder::Respond<QuicVersion1>(
+    const QuicInitialHeaderView&, const Address&,
+    std::span<const std::uint8_t>, std::chrono::system_clock::time_point,
+    std::span<std::uint8_t>, std::size_t&) noexcept;
+extern template QuicRetryErrorStatus
+QuicRetryResponder::Respond<QuicVersion2>(
+    const QuicInitialHeaderView&, const Address&,
+    std::span<const std::uint8_t>, std::chrono::system_clock::time_point,
+    std::span<std::uint8_t>, std::size_t&) noexcept;
+
+}  // namespace bedrock::network
+
+#endif
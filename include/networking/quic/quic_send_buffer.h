@@ -0,0 +1,161 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SEND_BUFFER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SEND_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "quic_packet_builder.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Stream data is held in blocks of this size, released one by one as the
+// acknowledged prefix moves past them.
+inline constexpr std::size_t kQuicSendBufferBlockSize = 16384;
+// Unacknowledged bytes one stream may hold by default.
+inline constexpr std::size_t kQuicSendBufferDefaultLimit = 1 << 20;
+
+// Disjoint byte ranges [begin, end) in ascending order. Meant for the few
+// ranges loss and reordering leave behind, so it is a sorted vector.
+class QuicByteRangeSet {
+ public:
+  struct Range {
+   public:
+    std::uint64_t begin = 0;
+    std::uint64_t end = 0;
+  };
+
+  void Add(std::uint64_t begin, std::uint64_t end);
+  void Subtract(std::uint64_t begin, std::uint64_t end);
+  // Removes everything below offset.
+  void TrimBelow(std::uint64_t offset);
+
+  bool Empty() const noexcept { return ranges.empty(); }
+  const Range& Front() const noexcept { return ranges.front(); }
+  std::span<const Range> Ranges() const noexcept { return ranges; }
+
+ private:
+  std::vector<Range> ranges;
+};
+
+// What a sent packet must remember of a STREAM or CRYPTO frame: where its
+// data is in the stream, not the data itself.
+struct QuicSentStreamFrameV1 {
+ public:
+  std::uint64_t stream_id = 0;
+  std::uint64_t offset = 0;
+  std::uint64_t length = 0;
+  bool fin = false;
+};
+
+// Send side of one stream. Application data is copied in once and stays
+// until it is acknowledged; every transmission, first or repeated, is
+// serialized straight from it, so a sent packet only records a
+// QuicSentStreamFrameV1.
+//
+// Acknowledgements may arrive for any part of the sent data. The bytes
+// below the first gap form the acknowledged prefix, and each block wholly
+// inside it is released right away, so memory follows the unacknowledged
+// bytes rather than the bytes ever sent. Lost ranges are queued and sent
+// again, ahead of new data, unless acknowledged in the meantime.
+class QuicSendBuffer {
+ public:
+  explicit QuicSendBuffer(
+      std::size_t limit = kQuicSendBufferDefaultLimit) noexcept
+      : buffer_limit(limit) {}
+
+  // Copies as much of data as the buffer limit allows and returns the
+  // number of bytes taken. Nothing is taken after Finish().
+  std::size_t Write(std::span<const std::uint8_t> data);
+  // The stream ends after the data written so far.
+  void Finish() noexcept {
+    fin_pending |= !finished;
+    finished = true;
+  }
+
+  // Whether a frame could be sent with the peer's MAX_STREAM_DATA at
+  // send_limit.
+  bool HasDataToSend(std::uint64_t send_limit) const noexcept;
+  // Proposes the next frame: lost data first, then new data up to
+  // send_limit, then a lone FIN. Data is limited to one block so that it
+  // is contiguous. Returns false if there is nothing to send.
+  bool NextFrame(std::uint64_t send_limit,
+                 QuicSentStreamFrameV1& frame) const noexcept;
+  // Bytes of [offset, offset + length) that are contiguous in memory. The
+  // range must be held, as a frame from NextFrame() is.
+  std::span<const std::uint8_t> Data(std::uint64_t offset,
+                                     std::uint64_t length) const noexcept;
+  // Records that frame, or a prefix of the frame NextFrame() proposed, was
+  // sent.
+  void OnSent(const QuicSentStreamFrameV1& frame);
+
+  // Writes the next frame into the open packet and fills sent with what
+  // was written. Returns false if there was nothing to send or no room.
+  template <QuicVersionTraits Version>
+  bool WriteStreamFrame(QuicPacketBuilder<Version>& builder,
+                        std::uint64_t stream_id, std::uint64_t send_limit,
+                        QuicSentStreamFrameV1& sent) {
+    if (!NextFrame(send_limit, sent)) {
+      return false;
+    }
+    std::span<const std::uint8_t> data = Data(sent.offset, sent.length);
+    std::size_t remaining = builder.Remaining();
+    std::size_t taken =
+        builder.AppendStreamFrame(stream_id, sent.offset, data, sent.fin);
+    if (builder.Remaining() == remaining) {
+      return false;
+    }
+    sent.stream_id = stream_id;
+    sent.fin = sent.fin && taken == data.size();
+    sent.length = taken;
+    OnSent(sent);
+    return true;
+  }
+
+  void OnAcked(const QuicSentStreamFrameV1& frame);
+  void OnLost(const QuicSentStreamFrameV1& frame);
+
+  std::uint64_t WriteOffset() const noexcept { return write_offset; }
+  // Largest offset sent so far.
+  std::uint64_t SentOffset() const noexcept { return sent_offset; }
+  std::uint64_t AckedOffset() const noexcept { return acked_offset; }
+  // Written and not yet acknowledged.
+  std::uint64_t BufferedBytes() const noexcept {
+    return write_offset - acked_offset;
+  }
+  std::size_t BlockCount() const noexcept { return blocks.size(); }
+  // Every byte and the FIN were acknowledged (Data Recvd).
+  bool AllDataAcked() const noexcept {
+    return finished && fin_acked && acked_offset == write_offset;
+  }
+
+ private:
+  using Block = std::unique_ptr<std::uint8_t[]>;
+
+  // Frees the blocks below acked_offset, or all of them once everything
+  // written was acknowledged, keeping one for reuse.
+  void Release();
+
+  // blocks[0] holds stream offsets from first_block * block size on.
+  std::vector<Block> blocks;
+  Block spare;
+  std::uint64_t first_block = 0;
+
+  std::uint64_t write_offset = 0;
+  std::uint64_t sent_offset = 0;
+  std::uint64_t acked_offset = 0;
+  std::size_t buffer_limit;
+  QuicByteRangeSet acked;  // above acked_offset
+  QuicByteRangeSet lost;   // waiting to be sent again
+
+  bool finished = false;
+  bool fin_pending = false;  // FIN to send, first time or again
+  bool fin_acked = false;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SESSION_TICKET_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SESSION_TICKET_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+
+#include "quic_crypto.h"
+
+namespace bedrock::network {
+
+// Ticket identities larger than this are not cached. Stateless tickets of
+// common servers take 100 to 300 bytes.
+inline constexpr std::size_t kQuicMaxSessionTicketSize = 1024;
+// Longest DNS name (rfc1035 section 2.3.4), the key of the cache
+inline constexpr std::size_t kQuicMaxServerNameLength = 253;
+// ticket_lifetime is capped at seven days (rfc8446 section 4.6.1).
+inline constexpr std::chrono::seconds kQuicMaxSessionTicketLifetime{604800};
+inline constexpr std::size_t kQuicSessionTicketCacheShards = 16;
+// Slots sharing one hash bucket
+inline constexpr std::size_t kQuicSessionTicketCacheWays = 8;
+// Tickets kept per server. Servers send several, so that each reconnect
+// has a ticket of its own and can not be linked to the others.
+inline constexpr std::size_t kQuicSessionTicketsPerServer = 4;
+
+enum class QuicSessionTicketErrorStatus {
+  kSuccess,
+  kNotFound,  // no unexpired ticket for the server
+  kTooLarge,  // ticket identity or server name too long to cache
+  kExpired    // the ticket is already past its lifetime
+};
+
+// Transport parameters a client remembers with a ticket, so that its 0-RTT
+// data honours the limits of the earlier connection (rfc9000 section
+// 7.4.1, rfc9221 section 3).
+struct QuicZeroRTTTransportParameters {
+ public:
+  std::uint64_t active_connection_id_limit = 2;
+  std::uint64_t initial_max_data = 0;
+  std::uint64_t initial_max_stream_data_bidi_local = 0;
+  std::uint64_t initial_max_stream_data_bidi_remote = 0;
+  std::uint64_t initial_max_stream_data_uni = 0;
+  std::uint64_t initial_max_streams_bidi = 0;
+  std::uint64_t initial_max_streams_uni = 0;
+  std::uint64_t max_datagram_frame_size = 0;
+};
+
+// A NewSessionTicket (rfc8446 section 4.6.1) as the client keeps it. The
+// resumption PSK is derived when the ticket arrives, so neither the
+// resumption secret nor the ticket nonce has to be kept.
+struct QuicSessionTicket {
+ public:
+  std::chrono::steady_clock::time_point received{};
+  std::chrono::seconds lifetime{0};
+  std::uint32_t age_add = 0;
+  // max_early_data_size was 0xffffffff, the only value QUIC allows
+  // (rfc9001 section 4.6.1)
+  bool early_data = false;
+  QuicSHA256Digest psk{};
+  QuicZeroRTTTransportParameters transport_parameters;
+  std::uint16_t identity_size = 0;
+  std::array<std::uint8_t, kQuicMaxSessionTicketSize> identity{};
+
+  QuicSessionTicketErrorStatus SetIdentity(
+      std::span<const std::uint8_t> ticket) noexcept;
+  std::span<const std::uint8_t> Identity() const noexcept {
+    return std::span(identity).first(identity_size);
+  }
+
+  std::chrono::steady_clock::time_point Expiry() const noexcept {
+    return received + std::min(lifetime, kQuicMaxSessionTicketLifetime);
+  }
+  bool Expired(std::chrono::steady_clock::time_point now) const noexcept {
+    return now >= Expiry();
+  }
+  // obfuscated_ticket_age of the pre_shared_key extension (rfc8446 section
+  // 4.2.11): milliseconds since the ticket arrived plus age_add, modulo
+  // 2^32.
+  std::uint32_t ObfuscatedAge(
+      std::chrono::steady_clock::time_point now) const noexcept;
+};
+
+// Client side store of session tickets by server name, so that reconnects
+// resume, and send 0-RTT data where the ticket allows it, instead of paying
+// a full handshake.
+//
+// Tickets are single use: Take() removes the ticket it returns, since
+// offering one ticket twice lets an observer link the connections (rfc8446
+// appendix C.4). Each server keeps at most kQuicSessionTicketsPerServer
+// tickets; a new one replaces its oldest.
+//
+// Memory is fixed: a power of two number of buckets of
+// kQuicSessionTicketCacheWays slots, chosen by a hash of the server name,
+// so that all tickets of a server share a bucket and a lookup scans one
+// bucket only. A full bucket reuses an expired slot, or else the one
+// holding the oldest ticket. Expired tickets are also dropped whenever a
+// lookup comes across them. Buckets are guarded by
+// kQuicSessionTicketCacheShards mutexes, so connections to different
+// servers rarely contend.
+class QuicSessionTicketCache {
+ public:
+  // capacity is the number of tickets kept, rounded up to a power of two
+  // number of buckets.
+  explicit QuicSessionTicketCache(std::size_t capacity) noexcept;
+  QuicSessionTicketCache(const QuicSessionTicketCache&) = delete;
+  QuicSessionTicketCache& operator=(const QuicSessionTicketCache&) = delete;
+
+  // server_name is compared byte by byte; callers normalize its case.
+  QuicSessionTicketErrorStatus Insert(
+      std::string_view server_name, const QuicSessionTicket& ticket,
+      std::chrono::steady_clock::time_point now) noexcept;
+  // Removes the most recently received unexpired ticket of server_name and
+  // copies it to ticket.
+  QuicSessionTicketErrorStatus Take(std::string_view server_name,
+                                    std::chrono::steady_clock::time_point now,
+                                    QuicSessionTicket& ticket) noexcept;
+  // Drops every ticket of server_name, e.g. after the server refused to
+  // resume.
+  void Erase(std::string_view server_name) noexcept;
+
+  std::size_t Capacity() const noexcept {
+    return (mask + 1) * kQuicSessionTicketCacheWays;
+  }
+  std::size_t Size() const noexcept;
+
+ private:
+  struct Entry {
+   public:
+    std::uint8_t name_length = 0;
+    std::array<char, kQuicMaxServerNameLength> name{};
+    QuicSessionTicket ticket;
+
+    bool Matches(std::string_view server_name) const noexcept {
+      return server_name == std::string_view(name.data(), name_length);
+    }
+  };
+
+  // What a lookup needs of a slot, kept apart from the entries so a scan
+  // reads a few dense cache lines and only touches the entries of its
+  // server. A hash of 0 marks a free slot.
+  struct Slot {
+   public:
+    std::uint64_t hash = 0;
+    std::chrono::steady_clock::time_point received{};
+    std::chrono::steady_clock::time_point expiry{};
+  };
+
+  struct alignas(64) Shard {
+   public:
+    std::mutex mutex;
+    std::atomic<std::size_t> size{0};
+  };
+
+  static std::uint64_t Hash(std::string_view server_name) noexcept;
+  std::size_t Bucket(std::uint64_t hash) const noexcept {
+    return hash & mask;
+  }
+  Shard& ShardOf(std::size_t bucket) noexcept {
+    return shards[bucket % kQuicSessionTicketCacheShards];
+  }
+  void Free(Shard& shard, std::size_t index) noexcept;
+
+  std::unique_ptr<Slot[]> slots;
+  std::unique_ptr<Entry[]> entries;
+  std::size_t mask = 0;
+  std::array<Shard, kQuicSessionTicketCacheShards> shards;
+};
+
+}  // namespace bedrock::network
+
+#endif
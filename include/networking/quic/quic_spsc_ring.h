@@ -0,0 +1,84 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SPSC_RING_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_SPSC_RING_H_
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+namespace bedrock::network {
+
+// Lock free ring between exactly one producer thread and one consumer thread.
+// Elements are filled and read in place: the producer writes into the slot
+// returned by Reserve() and publishes it with Push(), the consumer reads
+// Front() and releases it with Pop(). Slots are reused, never destroyed, so
+// large elements such as datagram buffers are not copied or allocated per
+// item.
+//
+// Each side keeps a private copy of the other side's index and only reloads
+// it when the ring looks full or empty, so the two cache lines are shared
+// once per batch rather than once per element.
+template <typename T>
+class QuicSPSCRing {
+ public:
+  // capacity is rounded up to a power of two.
+  explicit QuicSPSCRing(std::size_t capacity) noexcept
+      : mask(std::bit_ceil(capacity < 2 ? 2 : capacity) - 1),
+        slots(std::make_unique<T[]>(mask + 1)) {}
+  QuicSPSCRing(const QuicSPSCRing&) = delete;
+  QuicSPSCRing& operator=(const QuicSPSCRing&) = delete;
+
+  std::size_t Capacity() const noexcept { return mask + 1; }
+
+  // Producer side. Returns nullptr if the ring is full.
+  T* Reserve() noexcept {
+    std::size_t tail = producer.index.load(std::memory_order_relaxed);
+    if (tail - producer.cached > mask) {
+      producer.cached = consumer.index.load(std::memory_order_acquire);
+      if (tail - producer.cached > mask) {
+        return nullptr;
+      }
+    }
+    return &slots[tail & mask];
+  }
+  // Publishes the slot returned by the last Reserve().
+  void Push() noexcept {
+    producer.index.store(producer.index.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_release);
+  }
+
+  // Consumer side. Returns nullptr if the ring is empty.
+  T* Front() noexcept {
+    std::size_t head = consumer.index.load(std::memory_order_relaxed);
+    if (head == consumer.cached) {
+      consumer.cached = producer.index.load(std::memory_order_acquire);
+      if (head == consumer.cached) {
+        return nullptr;
+      }
+    }
+    return &slots[head & mask];
+  }
+  // Releases the slot returned by the last Front() to the producer.
+  void Pop() noexcept {
+    consumer.index.store(consumer.index.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_release);
+  }
+
+ private:
+  // index is written by its own side only; cached is the last value seen of
+  // the other side's index.
+  struct alignas(64) Side {
+   public:
+    std::atomic<std::size_t> index{0};
+    std::size_t cached = 0;
+  };
+
+  Side producer;
+  Side consumer;
+  std::size_t mask = 0;
+  std::unique_ptr<T[]> slots;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_STREAM_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_STREAM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rfc9000.h"
+
+namespace bedrock::network {
+
+// Stream IDs carry their type in the two low bits, so at most 2^60 streams
+// of each type exist (rfc9000 section 2.1).
+inline constexpr std::uint64_t kQuicMaxStreamsV1 = std::uint64_t{1} << 60;
+
+enum class QuicStreamErrorStatus {
+  kSuccess,
+  kLimit,     // beyond MAX_STREAMS, a STREAM_LIMIT_ERROR
+  kState,     // not allowed in the current state, a STREAM_STATE_ERROR
+  kNotFound,  // never opened
+  kClosed,    // opened and already closed; late frames are ignored
+};
+
+constexpr QuicStreamTypeV1 GetQuicStreamType(std::uint64_t id) noexcept {
+  return static_cast<QuicStreamTypeV1>(id & 0x03);
+}
+constexpr bool IsQuicStreamServerInitiated(std::uint64_t id) noexcept {
+  return (id & 0x01) != 0;
+}
+constexpr bool IsQuicStreamUniDirectional(std::uint64_t id) noexcept {
+  return (id & 0x02) != 0;
+}
+
+// Per-stream state kept by a connection. Buffers and scheduling live
+// elsewhere and are looked up by stream ID, so that walking or updating
+// many streams only touches these few bytes.
+struct QuicStreamRecordV1 {
+ public:
+  // Next offset to send, and the peer's MAX_STREAM_DATA for this stream.
+  std::uint64_t sent_offset = 0;
+  std::uint64_t send_limit = 0;
+  // Largest offset received; the final size once it is known.
+  std::uint64_t received_offset = 0;
+  // MAX_STREAM_DATA we advertised.
+  std::uint64_t receive_limit = 0;
+  QuicSendStreamStateV1 send_state = QuicSendStreamStateV1::kReady;
+  QuicReceiveStreamStateV1 receive_state = QuicReceiveStreamStateV1::kRecv;
+
+  // Both halves reached a terminal state; the stream can be forgotten.
+  constexpr bool Closed() const noexcept {
+    return IsTerminal(send_state) && IsTerminal(receive_state);
+  }
+};
+static_assert(sizeof(QuicStreamRecordV1) <= 40);
+
+// Streams of one connection. Each of the four stream types keeps its records
+// in a vector indexed by stream number (ID >> 2) relative to the oldest
+// stream still open, since IDs of a type are opened in order. Closed streams
+// at the front are released as soon as the oldest one closes, so memory
+// follows the span of open streams, not the number ever opened.
+//
+// A unidirectional stream only has one half; the other is created in its
+// terminal state so that Closed() needs no special case.
+class QuicStreamTableV1 {
+ public:
+  explicit QuicStreamTableV1(bool is_server) noexcept : server(is_server) {}
+
+  // MAX_STREAMS for the type: for our own types the limit the peer
+  // granted, for the peer's types the one we advertised. Limits only grow
+  // (rfc9000 section 4.6).
+  void SetStreamLimit(QuicStreamTypeV1 type,
+                      std::uint64_t max_streams) noexcept;
+  // initial_max_stream_data_* for streams opened from now on.
+  void SetInitialMaxStreamData(QuicStreamTypeV1 type,
+                               std::uint64_t send_limit,
+                               std::uint64_t receive_limit) noexcept;
+
+  // ID the next stream of our own type would get.
+  std::uint64_t NextStreamID(QuicStreamTypeV1 type) const noexcept;
+
+  // Opens id and every lower unopened ID of the same type
+  // (rfc9000 section 3.2). Returns the record of an already open stream.
+  // The peer may not open IDs of our types (rfc9000 section 19.8).
+  // Opening may move the records, invalidating earlier pointers.
+  QuicStreamErrorStatus Open(std::uint64_t id, bool local,
+                             QuicStreamRecordV1*& record);
+  // nullptr unless the stream is open.
+  QuicStreamRecordV1* Find(std::uint64_t id) noexcept;
+
+  // Drive the state machines of the stream. A stream whose halves both
+  // became terminal is closed and its record must no longer be used.
+  QuicStreamErrorStatus OnSendEvent(std::uint64_t id,
+                                    QuicSendStreamEventV1 event) noexcept;
+  QuicStreamErrorStatus OnReceiveEvent(
+      std::uint64_t id, QuicReceiveStreamEventV1 event) noexcept;
+
+  std::size_t OpenCount() const noexcept { return open_count; }
+
+ private:
+  struct Lane {
+   public:
+    // records[head] belongs to stream number base.
+    std::vector<QuicStreamRecordV1> records;
+    std::size_t head = 0;
+    std::uint64_t base = 0;
+    std::uint64_t opened = 0;
+    std::uint64_t limit = 0;
+    std::uint64_t initial_send_limit = 0;
+    std::uint64_t initial_receive_limit = 0;
+  };
+
+  bool IsLocal(std::uint64_t id) const noexcept {
+    return IsQuicStreamServerInitiated(id) == server;
+  }
+  Lane& LaneOf(std::uint64_t id) noexcept { return lanes[id & 0x03]; }
+  QuicStreamErrorStatus Lookup(std::uint64_t id,
+                               QuicStreamRecordV1*& record) noexcept;
+  // Releases closed records at the front of the lane.
+  void Release(Lane& lane) noexcept;
+
+  std::array<Lane, 4> lanes{};
+  std::size_t open_count = 0;
+  bool server;
+};
+
+}  // namespace bedrock::network
+
+#endif
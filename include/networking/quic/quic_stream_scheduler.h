@@ -0,0 +1,107 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_STREAM_SCHEDULER_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_STREAM_SCHEDULER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace bedrock::network {
+
+// Urgency 0 is the most urgent (rfc9218 section 4.1).
+inline constexpr std::uint8_t kQuicUrgencyLevels = 8;
+inline constexpr std::uint8_t kQuicDefaultUrgency = 3;
+
+struct QuicStreamPriority {
+ public:
+  std::uint8_t urgency = kQuicDefaultUrgency;
+  bool incremental = false;
+};
+
+// Reads the u and i parameters of a Priority field value such as
+// "u=1, i" (rfc9218 section 4). Unknown parameters and out of range values
+// are ignored, leaving the defaults in place.
+QuicStreamPriority ParseQuicStreamPriority(std::string_view field) noexcept;
+
+// Picks the stream that fills the next packet (rfc9218 section 10).
+//
+// Streams of a lower urgency always go first. Within an urgency,
+// non-incremental streams are served one at a time, each until it has no
+// more data, before incremental streams, which take turns a packet at a
+// time.
+//
+// Every (urgency, incremental) pair has its own intrusive, doubly linked
+// queue over the stream slots, and a bitmap marks the queues that are not
+// empty, so picking, requeueing, adding and removing a stream are all O(1)
+// whatever the number of streams. Non-incremental streams are served in
+// the order they became ready, which is stream ID order when, as usual,
+// streams get data in the order they are opened.
+class QuicStreamScheduler {
+ public:
+  using Handle = std::uint32_t;
+  static constexpr Handle kInvalidHandle =
+      std::numeric_limits<Handle>::max();
+
+  // Registers a stream that has no data yet.
+  Handle Add(std::uint64_t stream_id, QuicStreamPriority priority = {});
+  void Remove(Handle handle) noexcept;
+  // A PRIORITY_UPDATE arrived; a ready stream moves to its new queue.
+  void SetPriority(Handle handle, QuicStreamPriority priority) noexcept;
+
+  // The stream has data to send. No effect if it is already queued.
+  void Schedule(Handle handle) noexcept;
+  void Unschedule(Handle handle) noexcept;
+
+  bool Empty() const noexcept { return non_empty == 0; }
+  // The stream to send from next, kInvalidHandle if none has data.
+  Handle Next() const noexcept;
+  // A frame of the stream was written. An incremental stream yields to the
+  // next one of its urgency; a stream with no more data leaves the queue.
+  void OnSent(Handle handle, bool more_data) noexcept;
+
+  std::uint64_t StreamID(Handle handle) const noexcept {
+    return slots[handle].stream_id;
+  }
+  QuicStreamPriority Priority(Handle handle) const noexcept {
+    return {slots[handle].urgency, slots[handle].incremental};
+  }
+  bool Scheduled(Handle handle) const noexcept {
+    return slots[handle].scheduled;
+  }
+  std::size_t ScheduledCount() const noexcept { return scheduled_count; }
+
+ private:
+  struct Slot {
+   public:
+    std::uint64_t stream_id = 0;
+    Handle previous = kInvalidHandle;
+    Handle next = kInvalidHandle;  // also links the free slots
+    std::uint8_t urgency = kQuicDefaultUrgency;
+    bool incremental = false;
+    bool scheduled = false;
+  };
+  struct Queue {
+   public:
+    Handle head = kInvalidHandle;
+    Handle tail = kInvalidHandle;
+  };
+
+  static std::size_t QueueIndex(const Slot& slot) noexcept {
+    return std::size_t{slot.urgency} * 2 + (slot.incremental ? 1 : 0);
+  }
+  void PushBack(Handle handle) noexcept;
+  void Unlink(Handle handle) noexcept;
+
+  std::vector<Slot> slots;
+  Handle free_slots = kInvalidHandle;
+  std::array<Queue, 2 * kQuicUrgencyLevels> queues{};
+  // Bit QueueIndex() is set while that queue holds a stream.
+  std::uint32_t non_empty = 0;
+  std::size_t scheduled_count = 0;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_VERSION_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_VERSION_H_
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+
+#include "rfc9000.h"
+
+namespace bedrock::network {
+
+// Everything that differs between QUIC versions sharing the rfc9000 wire
+// image. Code that handles packets of a fixed version takes one of these as
+// a template argument, so the version is resolved at compile time and the
+// packet path carries no version branches. QuicLongHeaderPacketTypeV1 is
+// used as the version independent packet type.
+template <typename T>
+concept QuicVersionTraits =
+    requires(QuicLongHeaderPacketTypeV1 type, std::uint8_t first_byte) {
+      { T::kVersion } -> std::convertible_to<std::uint32_t>;
+      T::kInitialSalt;
+      { T::kKeyLabel } -> std::convertible_to<std::string_view>;
+      { T::kIvLabel } -> std::convertible_to<std::string_view>;
+      { T::kHpLabel } -> std::convertible_to<std::string_view>;
+      { T::kKuLabel } -> std::convertible_to<std::string_view>;
+      T::kRetryIntegrityKey;
+      T::kRetryIntegrityNonce;
+      { T::LongPacketTypeBits(type) } -> std::same_as<std::uint8_t>;
+      {
+        T::LongPacketType(first_byte)
+      } -> std::same_as<QuicLongHeaderPacketTypeV1>;
+    };
+
+// QUIC version 1 (rfc9000, rfc9001)
+struct QuicVersion1 {
+ public:
+  static constexpr std::uint32_t kVersion =
+      static_cast<std::uint32_t>(QuicVersionV1::kTLS);
+
+  // rfc9001 section 5.2
+  static constexpr std::array<std::uint8_t, 20> kInitialSalt = {
+      0x38, 0x76, 0x2c, 0xf7, 0xf5, 0x59, 0x34, 0xb3, 0x4d, 0x17,
+      0x9a, 0xe6, 0xa4, 0xc8, 0x0c, 0xad, 0xcc, 0xbb, 0x7f, 0x0a};
+  // rfc9001 section 5.1 and 6.1, without the "tls13 " prefix
+  static constexpr std::string_view kKeyLabel = "quic key";
+  static constexpr std::string_view kIvLabel = "quic iv";
+  static constexpr std::string_view kHpLabel = "quic hp";
+  static constexpr std::string_view kKuLabel = "quic ku";
+  // rfc9001 section 5.8
+  static constexpr std::array<std::uint8_t, 16> kRetryIntegrityKey = {
+      0xbe, 0x0c, 0x69, 0x0b, 0x9f, 0x66, 0x57, 0x5a,
+      0x1d, 0x76, 0x6b, 0x54, 0xe3, 0x68, 0xc8, 0x4e};
+  static constexpr std::array<std::uint8_t, 12> kRetryIntegrityNonce = {
+      0x46, 0x15, 0x99, 0xd3, 0x5d, 0x63, 0x2b, 0xf2, 0x23, 0x98, 0x25, 0xbb};
+
+  // Long Packet Type field, already shifted into the first byte
+  static constexpr std::uint8_t LongPacketTypeBits(
+      QuicLongHeaderPacketTypeV1 type) noexcept {
+    return static_cast<std::uint8_t>(static_cast<unsigned>(type) << 4);
+  }
+  static constexpr QuicLongHeaderPacketTypeV1 LongPacketType(
+      std::uint8_t first_byte) noexcept {
+    return static_cast<QuicLongHeaderPacketTypeV1>((first_byte >> 4) & 0b11);
+  }
+};
+
+// QUIC version 2 (rfc9369). Identical to version 1 apart from the constants
+// below and a rotated Long Packet Type encoding.
+struct QuicVersion2 {
+ public:
+  static constexpr std::uint32_t kVersion =
+      static_cast<std::uint32_t>(QuicVersionV1::kVersion2);
+
+  // rfc9369 section 3.3.1
+  static constexpr std::array<std::uint8_t, 20> kInitialSalt = {
+      0x0d, 0xed, 0xe3, 0xde, 0xf7, 0x00, 0xa6, 0xdb, 0x81, 0x93,
+      0x81, 0xbe, 0x6e, 0x26, 0x9d, 0xcb, 0xf9, 0xbd, 0x2e, 0xd9};
+  // rfc9369 section 3.3.2
+  static constexpr std::string_view kKeyLabel = "quicv2 key";
+  static constexpr std::string_view kIvLabel = "quicv2 iv";
+  static constexpr std::string_view kHpLabel = "quicv2 hp";
+  static constexpr std::string_view kKuLabel = "quicv2 ku";
+  // rfc9369 section 3.3.3
+  static constexpr std::array<std::uint8_t, 16> kRetryIntegrityKey = {
+      0x8f, 0xb4, 0xb0, 0x1b, 0x56, 0xac, 0x48, 0xe2,
+      0x60, 0xfb, 0xcb, 0xce, 0xad, 0x7c, 0xcc, 0x92};
+  static constexpr std::array<std::uint8_t, 12> kRetryIntegrityNonce = {
+      0xd8, 0x69, 0x69, 0xbc, 0x2d, 0x7c, 0x6d, 0x99, 0x90, 0xef, 0xb0, 0x4a};
+
+  // rfc9369 section 3.2: Initial 0b01, 0-RTT 0b10, Handshake 0b11, Retry 0b00
+  static constexpr std::uint8_t LongPacketTypeBits(
+      QuicLongHeaderPacketTypeV1 type) noexcept {
+    return static_cast<std::uint8_t>(((static_cast<unsigned>(type) + 1) & 0b11)
+                                     << 4);
+  }
+  static constexpr QuicLongHeaderPacketTypeV1 LongPacketType(
+      std::uint8_t first_byte) noexcept {
+    return static_cast<QuicLongHeaderPacketTypeV1>(((first_byte >> 4) + 3) &
+                                                   0b11);
+  }
+};
+
+static_assert(QuicVersionTraits<QuicVersion1>);
+static_assert(QuicVersionTraits<QuicVersion2>);
+
+// The single run time version branch: calls visitor with the traits type of
+// version, e.g. when a connection is created, and returns false for a version
+// that is not implemented. Everything below the visitor is specialized.
+template <typename Visitor>
+constexpr bool VisitQuicVersion(std::uint32_t version, Visitor&& visitor) {
+  switch (version) {
+    case QuicVersion1::kVersion:
+      visitor(QuicVersion1{});
+      return true;
+    case QuicVersion2::kVersion:
+      visitor(QuicVersion2{});
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace bedrock::network
+
+#endif
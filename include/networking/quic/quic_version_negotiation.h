@@ -0,0 +1,63 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_VERSION_NEGOTIATION_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_VERSION_NEGOTIATION_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "quic_packet.h"
+
+namespace bedrock::network {
+
+// Versions a single responder can advertise
+inline constexpr std::size_t kQuicMaxSupportedVersions = 8;
+// Long header connection IDs of an unknown version may be up to 255 bytes
+// (rfc8999 section 5.1), and both are echoed back.
+inline constexpr std::size_t kQuicMaxVersionNegotiationPacketSize =
+    QuicLongPacketHeaderLayout::kSize + 255 + 1 + 255 +
+    kQuicMaxSupportedVersions * 4;
+
+// Fits any response, meant to live on the stack of the receive loop.
+using QuicVersionNegotiationBuffer =
+    std::array<std::uint8_t, kQuicMaxVersionNegotiationPacketSize>;
+
+enum class QuicVersionNegotiationErrorStatus {
+  kSuccess,
+  kShortHeader,  // not a long header packet, never answered
+  kSupported,    // version is supported, hand the packet to a connection
+  kNegotiation,  // a Version Negotiation packet must not be answered
+  kTooSmall,     // datagram below the minimum Initial size, dropped
+  kNoSpace       // response buffer too small
+};
+
+// Answers long header packets of unsupported versions without touching any
+// connection state (rfc9000 section 6.1). The supported version list is
+// serialized once at construction, so a response is the header echo plus a
+// single copy of that list.
+class QuicVersionNegotiationResponder {
+ public:
+  // Versions beyond kQuicMaxSupportedVersions are ignored. Version 0 is
+  // reserved for Version Negotiation and is skipped.
+  explicit QuicVersionNegotiationResponder(
+      std::span<const std::uint32_t> supported_versions) noexcept;
+
+  bool Supported(std::uint32_t version) const noexcept;
+  std::size_t SupportedVersionCount() const noexcept { return version_count; }
+
+  // Builds the Version Negotiation packet for datagram into response, with
+  // the client's Source Connection ID as Destination Connection ID and vice
+  // versa. size is only set on kSuccess.
+  QuicVersionNegotiationErrorStatus Respond(
+      std::span<const std::uint8_t> datagram,
+      std::span<std::uint8_t> response, std::size_t& size) const noexcept;
+
+ private:
+  std::array<std::uint32_t, kQuicMaxSupportedVersions> versions{};
+  std::array<std::uint8_t, kQuicMaxSupportedVersions * 4> encoded_versions{};
+  std::size_t version_count = 0;
+};
+
+}  // namespace bedrock::network
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_WIRE_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_WIRE_H_
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace bedrock::network {
+
+// Network byte order loads and stores on possibly unaligned bytes. At run
+// time this is a memcpy plus std::byteswap, which compilers lower to a single
+// movbe or mov + bswap; in constant evaluation it falls back to shifts.
+template <std::unsigned_integral T>
+constexpr T LoadBigEndian(const std::uint8_t* source) noexcept {
+  if consteval {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+      value = (value << 8) | source[i];
+    }
+    return static_cast<T>(value);
+  } else {
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+    if constexpr (std::endian::native == std::endian::little) {
+      value = std::byteswap(value);
+    }
+    return value;
+  }
+}
+
+template <std::unsigned_integral T>
+constexpr void StoreBigEndian(std::uint8_t* destination, T value) noexcept {
+  if consteval {
+    std::uint64_t wide = value;
+    for (std::size_t i = sizeof(T); i > 0; i--) {
+      destination[i - 1] = static_cast<std::uint8_t>(wide);
+      wide >>= 8;
+    }
+  } else {
+    if constexpr (std::endian::native == std::endian::little) {
+      value = std::byteswap(value);
+    }
+    std::memcpy(destination, &value, sizeof(T));
+  }
+}
+
+// Variable width big endian integer, used for truncated packet numbers.
+constexpr std::uint64_t LoadBigEndian(const std::uint8_t* source,
+                                      std::size_t length) noexcept {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < length; i++) {
+    value = (value << 8) | source[i];
+  }
+  return value;
+}
+
+constexpr void StoreBigEndian(std::uint8_t* destination, std::uint64_t value,
+                              std::size_t length) noexcept {
+  for (std::size_t i = length; i > 0; i--) {
+    destination[i - 1] = static_cast<std::uint8_t>(value);
+    value >>= 8;
+  }
+}
+
+// Variable-Length Integer Encoding (rfc9000 section 16)
+inline constexpr std::uint64_t kQuicVarIntMax = (std::uint64_t{1} << 62) - 1;
+
+constexpr std::size_t QuicVarIntLength(std::uint64_t value) noexcept {
+  if (value < (std::uint64_t{1} << 6)) {
+    return 1;
+  } else if (value < (std::uint64_t{1} << 14)) {
+    return 2;
+  } else if (value < (std::uint64_t{1} << 30)) {
+    return 4;
+  }
+  return 8;
+}
+
+// Length of the encoding whose first byte is first_byte
+constexpr std::size_t QuicVarIntLengthFromFirstByte(
+    std::uint8_t first_byte) noexcept {
+  return std::size_t{1} << (first_byte >> 6);
+}
+
+// Writes value using exactly length (1, 2, 4 or 8) bytes, returns the end.
+constexpr std::uint8_t* StoreQuicVarInt(std::uint8_t* destination,
+                                        std::uint64_t value,
+                                        std::size_t length) noexcept {
+  StoreBigEndian(destination, value, length);
+  destination[0] = static_cast<std::uint8_t>(
+      (destination[0] & 0x3F) | (std::countr_zero(length) << 6));
+  return destination + length;
+}
+
+constexpr std::uint8_t* StoreQuicVarInt(std::uint8_t* destination,
+                                        std::uint64_t value) noexcept {
+  return StoreQuicVarInt(destination, value, QuicVarIntLength(value));
+}
+
+// Caller guarantees QuicVarIntLengthFromFirstByte(source[0]) readable bytes.
+constexpr std::uint64_t LoadQuicVarInt(const std::uint8_t* source) noexcept {
+  switch (source[0] >> 6) {
+    case 0:
+      return source[0];
+    case 1:
+      return LoadBigEndian<std::uint16_t>(source) & 0x3FFF;
+    case 2:
+      return LoadBigEndian<std::uint32_t>(source) & 0x3FFFFFFF;
+    default:
+      return LoadBigEndian<std::uint64_t>(source) & kQuicVarIntMax;
+  }
+}
+
+// A fixed size big endian field at a compile time offset. Grouping fields in
+// a layout lets a parser check the layout size once and then load every
+// field without further bounds checks.
+template <std::size_t Offset, std::unsigned_integral T>
+struct QuicWireField {
+ public:
+  using Type = T;
+  static constexpr std::size_t kOffset = Offset;
+  static constexpr std::size_t kEnd = Offset + sizeof(T);
+
+  static constexpr T Load(const std::uint8_t* base) noexcept {
+    return LoadBigEndian<T>(base + Offset);
+  }
+  static constexpr void Store(std::uint8_t* base, T value) noexcept {
+    StoreBigEndian<T>(base + Offset, value);
+  }
+};
+
+template <typename... Fields>
+inline constexpr std::size_t kQuicWireLayoutSize = std::max({Fields::kEnd...});
+
+// Bounds checked reader. A failed read makes the reader invalid and every
+// later read returns zero or an empty span, so a parser can read a whole
+// structure and check Ok() once.
+class QuicWireReader {
+ public:
+  constexpr explicit QuicWireReader(std::span<const std::uint8_t> source,
+                                    std::size_t start = 0) noexcept
+      : bytes(source), position(start), ok(start <= source.size()) {}
+
+  constexpr bool Ok() const noexcept { return ok; }
+  constexpr std::size_t Position() const noexcept { return position; }
+  constexpr std::size_t Remaining() const noexcept {
+    return ok ? bytes.size() - position : 0;
+  }
+  constexpr bool Empty() const noexcept { return Remaining() == 0; }
+  constexpr std::span<const std::uint8_t> Rest() const noexcept {
+    return ok ? bytes.subspan(position) : std::span<const std::uint8_t>();
+  }
+
+  // Checks that length bytes are readable, failing the reader otherwise.
+  constexpr bool Require(std::size_t length) noexcept {
+    if (!ok || bytes.size() - position < length) {
+      ok = false;
+    }
+    return ok;
+  }
+
+  // Loads a layout field relative to the current position. Only valid after
+  // a successful Require() covering the layout.
+  template <typename Field>
+  constexpr typename Field::Type Load() const noexcept {
+    return Field::Load(bytes.data() + position);
+  }
+
+  template <std::unsigned_integral T>
+  constexpr T Read() noexcept {
+    if (!Require(sizeof(T))) {
+      return 0;
+    }
+    T value = LoadBigEndian<T>(bytes.data() + position);
+    position += sizeof(T);
+    return value;
+  }
+
+  constexpr std::uint8_t Peek() const noexcept {
+    return Remaining() > 0 ? bytes[position] : 0;
+  }
+
+  constexpr std::uint64_t ReadVarInt() noexcept {
+    if (!ok || position >= bytes.size()) {
+      ok = false;
+      return 0;
+    }
+    std::size_t length = QuicVarIntLengthFromFirstByte(bytes[position]);
+    if (bytes.size() - position < length) {
+      ok = false;
+      return 0;
+    }
+    std::uint64_t value = LoadQuicVarInt(bytes.data() + position);
+    position += length;
+    return value;
+  }
+
+  // Lengths decoded from the wire are 62 bit values, so any unsigned width is
+  // accepted and checked before narrowing.
+  template <std::unsigned_integral T>
+  constexpr std::span<const std::uint8_t> ReadBytes(T length) noexcept {
+    if (!ok || bytes.size() - position < length) {
+      ok = false;
+      return {};
+    }
+    auto result = bytes.subspan(position, static_cast<std::size_t>(length));
+    position += result.size();
+    return result;
+  }
+
+  template <std::unsigned_integral T>
+  constexpr void Skip(T length) noexcept {
+    ReadBytes(length);
+  }
+
+ private:
+  std::span<const std::uint8_t> bytes;
+  std::size_t position = 0;
+  bool ok = true;
+};
+
+// Bounds checked writer with the same sticky error behaviour as the reader.
+class QuicWireWriter {
+ public:
+  constexpr explicit QuicWireWriter(std::span<std::uint8_t> destination,
+                                    std::size_t start = 0) noexcept
+      : bytes(destination), position(start), ok(start <= destination.size()) {}
+
+  constexpr bool Ok() const noexcept { return ok; }
+  constexpr std::size_t Position() const noexcept { return position; }
+  constexpr std::size_t Remaining() const noexcept {
+    return ok ? bytes.size() - position : 0;
+  }
+  constexpr std::span<std::uint8_t> Written() const noexcept {
+    return bytes.subspan(0, position);
+  }
+
+  constexpr bool Require(std::size_t length) noexcept {
+    if (!ok || bytes.size() - position < length) {
+      ok = false;
+    }
+    return ok;
+  }
+
+  template <typename Field>
+  constexpr void Store(typename Field::Type value) noexcept {
+    Field::Store(bytes.data() + position, value);
+  }
+
+  template <std::unsigned_integral T>
+  constexpr void Write(T value) noexcept {
+    if (Require(sizeof(T))) {
+      StoreBigEndian<T>(bytes.data() + position, value);
+      position += sizeof(T);
+    }
+  }
+
+  constexpr void WriteVarInt(std::uint64_t value) noexcept {
+    WriteVarInt(value, QuicVarIntLength(value));
+  }
+  // Fixed width encoding, e.g. a 2 byte Length field filled in later
+  constexpr void WriteVarInt(std::uint64_t value, std::size_t length) noexcept {
+    if (Require(length)) {
+      StoreQuicVarInt(bytes.data() + position, value, length);
+      position += length;
+    }
+  }
+
+  constexpr void WriteBytes(std::span<const std::uint8_t> source) noexcept {
+    if (Require(source.size())) {
+      std::copy(source.begin(), source.end(),
+                bytes.subspan(position).begin());
+      position += source.size();
+    }
+  }
+
+  constexpr void Fill(std::uint8_t value, std::size_t length) noexcept {
+    if (Require(length)) {
+      std::fill_n(bytes.subspan(position).begin(), length, value);
+      position += length;
+    }
+  }
+
+  constexpr void Skip(std::size_t length) noexcept {
+    if (Require(length)) {
+      position += length;
+    }
+  }
+
+ private:
+  std::span<std::uint8_t> bytes;
+  std::size_t position = 0;
+  bool ok = true;
+};
+
+}  // namespace bedrock::network
+
+#endif
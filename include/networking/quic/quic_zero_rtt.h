@@ -0,0 +1,144 @@
+#ifndef BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_ZERO_RTT_H_
+#define BEDROCK_NETWORKING_NETWORKING_QUIC_QUIC_ZERO_RTT_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+
+#include "quic_crypto.h"
+#include "quic_frame.h"
+#include "quic_packet_protection.h"
+#include "quic_version.h"
+
+namespace bedrock::network {
+
+// Largest difference between the ticket age a client reports and the one
+// the server measures that still counts as fresh, and how long a
+// ClientHello is remembered (rfc8446 section 8.3).
+inline constexpr std::chrono::milliseconds kQuicZeroRTTReplayWindow{10000};
+inline constexpr std::size_t kQuicZeroRTTAntiReplayShards = 16;
+
+enum class QuicZeroRTTErrorStatus {
+  kSuccess,
+  kStale,   // the ticket age is too far off, the ClientHello may be old
+  kReplay,  // this ClientHello was seen within the window
+  kFull     // too many ClientHellos in the window to remember another
+};
+
+// PSK of a NewSessionTicket (rfc8446 section 4.6.1):
+// HKDF-Expand-Label(resumption_master_secret, "resumption", ticket_nonce).
+QuicSHA256Digest DeriveQuicResumptionPSK(
+    std::span<const std::uint8_t> resumption_master_secret,
+    std::span<const std::uint8_t> ticket_nonce) noexcept;
+
+// client_early_traffic_secret of a ClientHello offering psk (rfc8446
+// section 7.1): Derive-Secret(HKDF-Extract(0, psk), "c e traffic",
+// ClientHello), client_hello_hash being the SHA-256 of the ClientHello.
+QuicSHA256Digest DeriveQuicEarlyTrafficSecret(
+    std::span<const std::uint8_t> psk,
+    const QuicSHA256Digest& client_hello_hash) noexcept;
+
+// 0-RTT packet protection keys (rfc9001 section 5.1). Only the client
+// sends 0-RTT packets, so there is one direction.
+template <QuicVersionTraits Version>
+void DeriveQuicZeroRTTKeys(std::span<const std::uint8_t> psk,
+                           const QuicSHA256Digest& client_hello_hash,
+                           QuicPacketProtectionKeys& keys) noexcept {
+  keys.SetSecret<Version>(DeriveQuicEarlyTrafficSecret(psk,
+                                                       client_hello_hash));
+}
+
+// Frames a 0-RTT packet may carry (rfc9000 section 12.5). The rest belong
+// to the handshake or answer something of the server's, which the client
+// has not seen yet; a server receiving one closes the connection with
+// PROTOCOL_VIOLATION.
+constexpr bool QuicFrameAllowedInZeroRTT(QuicFrameTypeV1 type) noexcept {
+  switch (type) {
+    case QuicFrameTypeV1::kAck:
+    case QuicFrameTypeV1::kCrypto:
+    case QuicFrameTypeV1::kNewToken:
+    case QuicFrameTypeV1::kPathResponse:
+    case QuicFrameTypeV1::kRetireConnectionID:
+    case QuicFrameTypeV1::kHandshakeDone:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Server side replay protection for 0-RTT data (rfc8446 sections 8.2 and
+// 8.3, rfc9001 section 9.2).
+//
+// Early data is only accepted from a ClientHello whose ticket age matches
+// the server's view within half the window, and only the first time that
+// ClientHello is seen. Every accepted ClientHello is recorded for at least
+// one window, so a copy either arrives while it is still recorded or is
+// rejected as stale. A rejected ClientHello still completes the handshake;
+// its 0-RTT packets are dropped and the client sends the data again in
+// 1-RTT.
+//
+// Records live in two generations of one window each, the older dropped
+// whenever a window passes, in shards chosen by a keyed hash of the
+// ClientHello. Each shard is a fixed open addressing table of 64 bit
+// fingerprints under its own mutex, so one register serves every receive
+// worker of a listener. When a shard fills up, further early data is
+// rejected rather than accepted unrecorded. Replays across servers are
+// only caught if the servers share a register or tickets are bound to one
+// server.
+class QuicZeroRTTAntiReplay {
+ public:
+  // capacity is the number of ClientHellos with early data that must be
+  // recordable within one window.
+  explicit QuicZeroRTTAntiReplay(
+      std::size_t capacity,
+      std::chrono::milliseconds window = kQuicZeroRTTReplayWindow) noexcept;
+  QuicZeroRTTAntiReplay(const QuicZeroRTTAntiReplay&) = delete;
+  QuicZeroRTTAntiReplay& operator=(const QuicZeroRTTAntiReplay&) = delete;
+
+  // Decides whether the early data of a ClientHello may be accepted and
+  // records it if so. client_hello_id identifies the ClientHello, e.g. its
+  // PSK binder, and must only be passed once the binder was verified.
+  // client_ticket_age is obfuscated_ticket_age minus the ticket's age_add;
+  // server_ticket_age is the time since the server issued the ticket.
+  QuicZeroRTTErrorStatus Accept(
+      std::span<const std::uint8_t> client_hello_id,
+      std::chrono::milliseconds client_ticket_age,
+      std::chrono::milliseconds server_ticket_age,
+      std::chrono::steady_clock::time_point now) noexcept;
+
+  std::chrono::milliseconds Window() const noexcept { return window; }
+
+ private:
+  struct alignas(64) Shard {
+   public:
+    std::mutex mutex;
+    std::int64_t generation = 0;
+    // generations[current] records this window, the other the previous one
+    std::array<std::unique_ptr<std::uint64_t[]>, 2> generations;
+    std::array<std::size_t, 2> sizes{};
+    std::size_t current = 0;
+  };
+
+  // 128 bit keyed hash: the shard, the first slot and the fingerprint.
+  std::array<std::uint64_t, 2> Hash(
+      std::span<const std::uint8_t> client_hello_id) const noexcept;
+  // Moves the shard to generation, forgetting what is older than the
+  // previous window. Called with the shard mutex held.
+  void Advance(Shard& shard, std::int64_t generation) const noexcept;
+  bool Contains(const Shard& shard, std::size_t generation,
+                std::uint64_t start, std::uint64_t fingerprint) const noexcept;
+
+  std::chrono::milliseconds window;
+  QuicAES128 hash_key;
+  std::size_t mask = 0;
+  std::size_t limit = 0;
+  std::array<Shard, kQuicZeroRTTAntiReplayShards> shards;
+};
+
+}  // namespace bedrock::network
+
+#endif
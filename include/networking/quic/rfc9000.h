@@ -58,7 +58,8 @@ struct QuicVersionNegotiationPacketV1 : public QuicVersionNegotiationPacket {
   // std::span<const std::uint8_t> DestinationConnectionID() const;
   // std::uint8_t SourceConnectionIDLength() const;
   // std::span<const std::uint8_t> SourceConnectionID() const;
-  // std::span<const std::uint32_t> SupportedVersion() const;
+  // std::size_t SupportedVersionCount() const;
+  // std::uint32_t SupportedVersion(std::size_t index) const;
 };
 
 // Initial Packet {
@@ -106,6 +107,7 @@ enum class QuicStreamTypeV1 {
 enum class QuicVersionV1 {
   kVersionNegotiation = 0x00,
   kTLS = 0x01,
+  kVersion2 = 0x6B3343CF,  // rfc9369
 };
 
 // This presents in MSB
@@ -148,25 +150,168 @@ enum class QuicLongHeaderPacketTypeV1 {
   kRetry = 0x03
 };
 
-class QuicStreamStateV1 {};
+// Packet numbers and acknowledgements are independent in each space
+// (rfc9000 section 12.3). 0-RTT and 1-RTT share kApplicationData.
+enum class QuicPacketNumberSpaceV1 : std::uint8_t {
+  kInitial = 0,
+  kHandshake = 1,
+  kApplicationData = 2
+};
+inline constexpr std::size_t kQuicPacketNumberSpaceCountV1 = 3;
+
+// Sending part of a stream (rfc9000 section 3.1)
+enum class QuicSendStreamStateV1 : std::uint8_t {
+  kReady,
+  kSend,
+  kDataSent,
+  kDataRecvd,  // terminal
+  kResetSent,
+  kResetRecvd  // terminal
+};
+inline constexpr std::size_t kQuicSendStreamStateCountV1 = 6;
 
-class QuicSendStateV1 : public QuicStreamStateV1 {};
+enum class QuicSendStreamEventV1 : std::uint8_t {
+  kSendData,      // STREAM or STREAM_DATA_BLOCKED sent
+  kSendFin,       // STREAM with FIN sent
+  kAllDataAcked,  // every byte up to the final size acknowledged
+  kSendReset,     // RESET_STREAM sent
+  kResetAcked     // RESET_STREAM acknowledged
+};
+inline constexpr std::size_t kQuicSendStreamEventCountV1 = 5;
 
-class QuicSendReadyStateV1 : public QuicSendStateV1 {};
-class QuicSendSendStateV1 : public QuicSendStateV1 {};
-class QuicSendDataSentStateV1 : public QuicSendStateV1 {};
-class QuicSendDataRecvdStateV1 : public QuicSendStateV1 {};
-class QuicSendResetSentStateV1 : public QuicSendStateV1 {};
-class QuicSendResetRecvdStateV1 : public QuicSendStateV1 {};
+// Receiving part of a stream (rfc9000 section 3.2)
+enum class QuicReceiveStreamStateV1 : std::uint8_t {
+  kRecv,
+  kSizeKnown,
+  kDataRecvd,
+  kDataRead,  // terminal
+  kResetRecvd,
+  kResetRead  // terminal
+};
+inline constexpr std::size_t kQuicReceiveStreamStateCountV1 = 6;
+
+enum class QuicReceiveStreamEventV1 : std::uint8_t {
+  kReceiveData,      // STREAM or STREAM_DATA_BLOCKED received
+  kReceiveFin,       // STREAM with FIN received
+  kAllDataReceived,  // no gaps left below the final size
+  kAllDataRead,      // application consumed everything
+  kReceiveReset,     // RESET_STREAM received
+  kResetRead         // application was told about the reset
+};
+inline constexpr std::size_t kQuicReceiveStreamEventCountV1 = 6;
 
-class QuicReceiveStateV1 : public QuicStreamStateV1 {};
+// Transition tables indexed by [state][event]. kQuicInvalidStreamStateV1
+// marks events that are not allowed in a state; repeated frames that the
+// rfc9000 state diagrams ignore keep the state.
+inline constexpr std::uint8_t kQuicInvalidStreamStateV1 = 0xFF;
+
+using QuicSendStreamTransitionTableV1 =
+    std::array<std::array<std::uint8_t, kQuicSendStreamEventCountV1>,
+               kQuicSendStreamStateCountV1>;
+using QuicReceiveStreamTransitionTableV1 =
+    std::array<std::array<std::uint8_t, kQuicReceiveStreamEventCountV1>,
+               kQuicReceiveStreamStateCountV1>;
+
+inline constexpr QuicSendStreamTransitionTableV1
+    kQuicSendStreamTransitionsV1 = [] {
+      using State = QuicSendStreamStateV1;
+      using Event = QuicSendStreamEventV1;
+      QuicSendStreamTransitionTableV1 table{};
+      for (auto& row : table) {
+        row.fill(kQuicInvalidStreamStateV1);
+      }
+      auto set = [&table](State from, Event event, State to) {
+        table[static_cast<std::size_t>(from)]
+             [static_cast<std::size_t>(event)] =
+                 static_cast<std::uint8_t>(to);
+      };
+      set(State::kReady, Event::kSendData, State::kSend);
+      set(State::kReady, Event::kSendFin, State::kDataSent);
+      set(State::kReady, Event::kSendReset, State::kResetSent);
+      set(State::kSend, Event::kSendData, State::kSend);
+      set(State::kSend, Event::kSendFin, State::kDataSent);
+      set(State::kSend, Event::kSendReset, State::kResetSent);
+      // retransmissions after FIN
+      set(State::kDataSent, Event::kSendData, State::kDataSent);
+      set(State::kDataSent, Event::kSendFin, State::kDataSent);
+      set(State::kDataSent, Event::kAllDataAcked, State::kDataRecvd);
+      set(State::kDataSent, Event::kSendReset, State::kResetSent);
+      set(State::kResetSent, Event::kSendReset, State::kResetSent);
+      set(State::kResetSent, Event::kResetAcked, State::kResetRecvd);
+      return table;
+    }();
+
+inline constexpr QuicReceiveStreamTransitionTableV1
+    kQuicReceiveStreamTransitionsV1 = [] {
+      using State = QuicReceiveStreamStateV1;
+      using Event = QuicReceiveStreamEventV1;
+      QuicReceiveStreamTransitionTableV1 table{};
+      for (auto& row : table) {
+        row.fill(kQuicInvalidStreamStateV1);
+      }
+      auto set = [&table](State from, Event event, State to) {
+        table[static_cast<std::size_t>(from)]
+             [static_cast<std::size_t>(event)] =
+                 static_cast<std::uint8_t>(to);
+      };
+      set(State::kRecv, Event::kReceiveData, State::kRecv);
+      set(State::kRecv, Event::kReceiveFin, State::kSizeKnown);
+      set(State::kRecv, Event::kReceiveReset, State::kResetRecvd);
+      set(State::kSizeKnown, Event::kReceiveData, State::kSizeKnown);
+      set(State::kSizeKnown, Event::kReceiveFin, State::kSizeKnown);
+      set(State::kSizeKnown, Event::kAllDataReceived, State::kDataRecvd);
+      set(State::kSizeKnown, Event::kReceiveReset, State::kResetRecvd);
+      // duplicates of frames already received
+      set(State::kDataRecvd, Event::kReceiveData, State::kDataRecvd);
+      set(State::kDataRecvd, Event::kReceiveFin, State::kDataRecvd);
+      set(State::kDataRecvd, Event::kAllDataRead, State::kDataRead);
+      set(State::kDataRecvd, Event::kReceiveReset, State::kResetRecvd);
+      set(State::kDataRead, Event::kReceiveData, State::kDataRead);
+      set(State::kDataRead, Event::kReceiveFin, State::kDataRead);
+      set(State::kDataRead, Event::kReceiveReset, State::kDataRead);
+      set(State::kResetRecvd, Event::kReceiveData, State::kResetRecvd);
+      set(State::kResetRecvd, Event::kReceiveFin, State::kResetRecvd);
+      set(State::kResetRecvd, Event::kReceiveReset, State::kResetRecvd);
+      set(State::kResetRecvd, Event::kResetRead, State::kResetRead);
+      set(State::kResetRead, Event::kReceiveData, State::kResetRead);
+      set(State::kResetRead, Event::kReceiveFin, State::kResetRead);
+      set(State::kResetRead, Event::kReceiveReset, State::kResetRead);
+      return table;
+    }();
+
+// Applies event to state. Returns false and leaves state unchanged when the
+// event is not allowed, which the caller reports as STREAM_STATE_ERROR.
+constexpr bool TransitionQuicStream(QuicSendStreamStateV1& state,
+                                    QuicSendStreamEventV1 event) noexcept {
+  std::uint8_t next =
+      kQuicSendStreamTransitionsV1[static_cast<std::size_t>(state)]
+                                  [static_cast<std::size_t>(event)];
+  if (next == kQuicInvalidStreamStateV1) {
+    return false;
+  }
+  state = static_cast<QuicSendStreamStateV1>(next);
+  return true;
+}
+constexpr bool TransitionQuicStream(QuicReceiveStreamStateV1& state,
+                                    QuicReceiveStreamEventV1 event) noexcept {
+  std::uint8_t next =
+      kQuicReceiveStreamTransitionsV1[static_cast<std::size_t>(state)]
+                                     [static_cast<std::size_t>(event)];
+  if (next == kQuicInvalidStreamStateV1) {
+    return false;
+  }
+  state = static_cast<QuicReceiveStreamStateV1>(next);
+  return true;
+}
 
-class QuicReceiveRecvStateV1 : public QuicReceiveStateV1 {};
-class QuicReceiveSizeKnownStateV1 : public QuicReceiveStateV1 {};
-class QuicReceiveDataRecvdStateV1 : public QuicReceiveStateV1 {};
-class QuicReceiveDataReadStateV1 : public QuicReceiveStateV1 {};
-class QuicReceiveResetRecvdStateV1 : public QuicReceiveStateV1 {};
-class QuicReceiveResetReadStateV1 : public QuicReceiveStateV1 {};
+constexpr bool IsTerminal(QuicSendStreamStateV1 state) noexcept {
+  return state == QuicSendStreamStateV1::kDataRecvd ||
+         state == QuicSendStreamStateV1::kResetRecvd;
+}
+constexpr bool IsTerminal(QuicReceiveStreamStateV1 state) noexcept {
+  return state == QuicReceiveStreamStateV1::kDataRead ||
+         state == QuicReceiveStreamStateV1::kResetRead;
+}
 
 }  // namespace bedrock::network
 
@@ -77,6 +77,20 @@ class Socket : public Validatable,
   Read(std::uint32_t request_size) final override;
   SocketErrorStatus Write(std::span<const std::byte> data) final override;
 
+  // Receives one datagram into buffer without allocating, for receive loops
+  // that reuse their buffers. Returns the full size of the datagram, which
+  // exceeds buffer.size() if it was truncated. Unlike Read(), the socket's
+  // address is left untouched and the sender is stored in peer.
+  DataWithStatus<std::uint32_t, SocketErrorStatus> ReadFrom(
+      std::span<std::byte> buffer, Address& peer);
+
+  // Sets the Don't Fragment bit on outgoing UDP datagrams, as datagram path
+  // MTU discovery needs (rfc8899 section 3). A datagram larger than the
+  // local interface allows then fails to send with EMSGSIZE instead of being
+  // fragmented. On Linux the kernel's own path MTU estimate is ignored, so
+  // probes larger than a previously reported MTU still go out.
+  SocketErrorStatus SetDontFragment(bool dont_fragment);
+
  private:
   bool valid = false;
 
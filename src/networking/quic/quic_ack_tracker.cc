@@ -0,0 +1,133 @@
+#include "networking/quic/quic_ack_tracker.h"
+
+#include <algorithm>
+
+namespace bedrock::network {
+
+QuicAckTrackerErrorStatus QuicAckTracker::OnPacketReceived(
+    std::uint64_t packet_number, bool ack_eliciting,
+    std::chrono::steady_clock::time_point now) noexcept {
+  if (packet_number < smallest_tracked) {
+    return QuicAckTrackerErrorStatus::kDuplicate;
+  }
+
+  if (count != 0 && packet_number == ranges[begin].largest + 1) {
+    ranges[begin].largest = packet_number;
+    largest_received_time = now;
+  } else if (count == 0 || packet_number > ranges[begin].largest) {
+    immediate |= ack_eliciting && count != 0;
+    PushLargest(packet_number);
+    largest_received_time = now;
+  } else {
+    if (InsertReordered(packet_number) !=
+        QuicAckTrackerErrorStatus::kSuccess) {
+      return QuicAckTrackerErrorStatus::kDuplicate;
+    }
+    immediate |= ack_eliciting;
+  }
+
+  if (ack_eliciting) {
+    ack_eliciting_pending++;
+  }
+  return QuicAckTrackerErrorStatus::kSuccess;
+}
+
+bool QuicAckTracker::Contains(std::uint64_t packet_number) const noexcept {
+  auto tracked = Ranges();
+  // first range, from the top, that starts at or below packet_number
+  auto range = std::partition_point(
+      tracked.begin(), tracked.end(), [packet_number](const QuicAckRangeV1& r) {
+        return r.smallest > packet_number;
+      });
+  return range != tracked.end() && range->largest >= packet_number;
+}
+
+std::uint64_t QuicAckTracker::AckDelay(
+    std::chrono::steady_clock::time_point now,
+    std::uint8_t ack_delay_exponent) const noexcept {
+  if (count == 0 || now <= largest_received_time) {
+    return 0;
+  }
+  auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+      now - largest_received_time);
+  return static_cast<std::uint64_t>(delay.count()) >> ack_delay_exponent;
+}
+
+void QuicAckTracker::OnAckAcknowledged(
+    std::uint64_t largest_acknowledged) noexcept {
+  if (largest_acknowledged <= smallest_tracked) {
+    return;
+  }
+  smallest_tracked = largest_acknowledged;
+  while (count != 0 &&
+         ranges[begin + count - 1].largest < largest_acknowledged) {
+    count--;
+  }
+  if (count != 0) {
+    QuicAckRangeV1& smallest = ranges[begin + count - 1];
+    smallest.smallest = std::max(smallest.smallest, largest_acknowledged);
+  }
+}
+
+void QuicAckTracker::PushLargest(std::uint64_t packet_number) noexcept {
+  if (begin == 0) {
+    // front used up: move the live ranges back to the end of the array
+    std::copy_backward(ranges.begin(),
+                       ranges.begin() + static_cast<std::ptrdiff_t>(count),
+                       ranges.end());
+    begin = ranges.size() - count;
+  }
+  ranges[--begin] = {packet_number, packet_number};
+  if (++count > kQuicAckTrackerMaxRanges) {
+    DropSmallest();
+  }
+}
+
+QuicAckTrackerErrorStatus QuicAckTracker::InsertReordered(
+    std::uint64_t packet_number) noexcept {
+  auto first = ranges.begin() + static_cast<std::ptrdiff_t>(begin);
+  auto last = first + static_cast<std::ptrdiff_t>(count);
+  // below is the first range under packet_number, above the one over it
+  auto below = std::partition_point(
+      first, last, [packet_number](const QuicAckRangeV1& range) {
+        return range.smallest > packet_number;
+      });
+  if (below != last && below->largest >= packet_number) {
+    return QuicAckTrackerErrorStatus::kDuplicate;
+  }
+  // packet_number is not above the top range, so one exists over it
+  auto above = below - 1;
+  bool joins_above = above->smallest == packet_number + 1;
+  bool joins_below = below != last && below->largest + 1 == packet_number;
+
+  if (joins_above && joins_below) {
+    above->smallest = below->smallest;
+    std::copy(below + 1, last, below);
+    count--;
+  } else if (joins_above) {
+    above->smallest = packet_number;
+  } else if (joins_below) {
+    below->largest = packet_number;
+  } else {
+    if (begin != 0) {
+      // make room by moving the larger ranges one slot forward
+      std::copy(first, below, first - 1);
+      begin--;
+      below--;
+    } else {
+      std::copy_backward(below, last, last + 1);
+    }
+    *below = {packet_number, packet_number};
+    if (++count > kQuicAckTrackerMaxRanges) {
+      DropSmallest();
+    }
+  }
+  return QuicAckTrackerErrorStatus::kSuccess;
+}
+
+void QuicAckTracker::DropSmallest() noexcept {
+  count--;
+  smallest_tracked = ranges[begin + count].largest + 1;
+}
+
+}  // namespace bedrock::network
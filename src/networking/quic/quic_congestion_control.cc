@@ -0,0 +1,264 @@
+#include "networking/quic/quic_congestion_control.h"
+
+#include <cmath>
+
+namespace bedrock::network {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+// rfc9002 appendix B.6 to B.8
+void QuicNewReno::OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                                const QuicRTTEstimator&, std::uint64_t,
+                                TimePoint now) noexcept {
+  if (outcome.lost_bytes == 0) {
+    return;
+  }
+  std::uint64_t minimum_window =
+      config.minimum_window_packets * config.max_datagram_size;
+  // one reduction per round trip: losses of packets sent before the
+  // current recovery period began are part of the same event
+  if (outcome.largest_lost_time_sent > recovery_start_time) {
+    recovery_start_time = now;
+    slow_start_threshold = congestion_window / 2;
+    congestion_window = std::max(slow_start_threshold, minimum_window);
+    bytes_acked = 0;
+  }
+  if (outcome.persistent_congestion) {
+    congestion_window = minimum_window;
+    recovery_start_time = TimePoint();
+  }
+}
+
+// rfc9438 section 4.6 and 4.7
+void QuicCubic::OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                              const QuicRTTEstimator&, std::uint64_t,
+                              TimePoint now) noexcept {
+  if (outcome.lost_bytes == 0) {
+    return;
+  }
+  std::uint64_t minimum_window =
+      config.minimum_window_packets * config.max_datagram_size;
+  if (outcome.largest_lost_time_sent > recovery_start_time) {
+    recovery_start_time = now;
+    double window = static_cast<double>(congestion_window) /
+                    static_cast<double>(config.max_datagram_size);
+    // fast convergence: release bandwidth to newer flows when the window
+    // stopped short of the previous maximum
+    window_max = window < previous_window_max
+                     ? window * (1 + kBeta) / 2
+                     : window;
+    previous_window_max = window;
+    slow_start_threshold = static_cast<std::uint64_t>(
+        static_cast<double>(congestion_window) * kBeta);
+    congestion_window = std::max(slow_start_threshold, minimum_window);
+    in_epoch = false;
+  }
+  if (outcome.persistent_congestion) {
+    congestion_window = minimum_window;
+    recovery_start_time = TimePoint();
+    in_epoch = false;
+  }
+}
+
+void QuicCubic::StartEpoch(TimePoint now) noexcept {
+  in_epoch = true;
+  epoch_start = now;
+  double window = static_cast<double>(congestion_window) /
+                  static_cast<double>(config.max_datagram_size);
+  if (window_max > window) {
+    k = std::cbrt((window_max - window) / kC);
+  } else {
+    // left slow start without a loss: the plateau is where we are
+    k = 0;
+    window_max = window;
+  }
+  reno_window = window;
+}
+
+// rfc9438 section 4.2 to 4.4
+void QuicCubic::CongestionAvoidance(std::uint64_t acked_bytes,
+                                    const QuicRTTEstimator& rtt,
+                                    TimePoint now) noexcept {
+  double segment = static_cast<double>(config.max_datagram_size);
+  double window = static_cast<double>(congestion_window) / segment;
+  double acked = static_cast<double>(acked_bytes) / segment;
+
+  // W_cubic one RTT ahead, limited to 1.5x the current window
+  double t = std::chrono::duration<double>(now - epoch_start).count() +
+             std::chrono::duration<double>(rtt.SmoothedRTT()).count() - k;
+  double target = std::clamp(kC * t * t * t + window_max, window,
+                             1.5 * window);
+  // Reno-friendly region (rfc9438 section 4.3)
+  constexpr double kAlpha = 3 * (1 - kBeta) / (1 + kBeta);
+  reno_window += kAlpha * acked / window;
+  target = std::max(target, reno_window);
+
+  double increase = (target - window) / window * acked * segment;
+  congestion_window += static_cast<std::uint64_t>(increase);
+}
+
+void QuicBBR::OnPacketsLost(const QuicLossDetectionOutcome& outcome,
+                            const QuicRTTEstimator&,
+                            std::uint64_t bytes_in_flight,
+                            TimePoint) noexcept {
+  if (outcome.lost_bytes == 0) {
+    return;
+  }
+  if (outcome.persistent_congestion) {
+    congestion_window = MinimumWindow();
+  }
+  round_lost += outcome.lost_bytes;
+  if (round_loss_handled ||
+      round_lost * kLossThresholdDivisor <= bytes_in_flight + round_lost) {
+    return;
+  }
+  // too much loss this round: bound inflight below the level that caused
+  // it, but never under the estimated BDP
+  round_loss_handled = true;
+  probe_up_packets = 1;
+  auto reduced = static_cast<std::uint64_t>(
+      static_cast<double>(bytes_in_flight + round_lost) * kBeta);
+  inflight_high =
+      std::max({reduced, BandwidthDelayProduct(), MinimumWindow()});
+  full_bandwidth_reached = true;
+}
+
+std::uint64_t QuicBBR::PacingRate(const QuicRTTEstimator& rtt) const noexcept {
+  if (bandwidth == 0) {
+    auto smoothed = std::max<std::int64_t>(rtt.SmoothedRTT().count(), 1);
+    return static_cast<std::uint64_t>(
+        kHighGain * static_cast<double>(congestion_window) * 1e6 /
+        static_cast<double>(smoothed));
+  }
+  return static_cast<std::uint64_t>(PacingGain() *
+                                    static_cast<double>(bandwidth));
+}
+
+void QuicBBR::UpdateMinRTT(std::chrono::microseconds sample,
+                           TimePoint now) noexcept {
+  bool expired = now > min_rtt_stamp + kMinRTTWindow;
+  if (min_rtt.count() == 0 || sample <= min_rtt || expired) {
+    min_rtt = sample;
+    min_rtt_stamp = now;
+  }
+  if (expired && mode != Mode::kProbeRTT) {
+    mode = Mode::kProbeRTT;
+    probe_rtt_done = TimePoint::max();
+  }
+}
+
+void QuicBBR::OnRoundEnd(TimePoint now) noexcept {
+  if (round_count != 0 && now > round_start) {
+    double elapsed = std::chrono::duration<double>(now - round_start).count();
+    bandwidth_samples[round_count % kBandwidthFilterRounds] =
+        static_cast<std::uint64_t>(
+            static_cast<double>(delivered - round_delivered) / elapsed);
+    bandwidth = *std::max_element(bandwidth_samples.begin(),
+                                  bandwidth_samples.end());
+  }
+
+  if (!full_bandwidth_reached && bandwidth != 0) {
+    if (bandwidth >= full_bandwidth + full_bandwidth / 4) {
+      full_bandwidth = bandwidth;
+      full_bandwidth_rounds = 0;
+    } else if (++full_bandwidth_rounds >= 3) {
+      full_bandwidth_reached = true;
+    }
+  }
+
+  // a loss free round spent probing up raises the inflight bound,
+  // doubling the step each time (BBRv2 ProbeBW_UP)
+  if (!round_loss_handled && mode == Mode::kProbeBW && cycle_index == 0 &&
+      inflight_high != std::numeric_limits<std::uint64_t>::max()) {
+    inflight_high += probe_up_packets * config.max_datagram_size;
+    probe_up_packets = std::min<std::uint64_t>(probe_up_packets * 2, 1024);
+  }
+
+  round_count++;
+  round_start = now;
+  round_delivered = delivered;
+  round_lost = 0;
+  round_loss_handled = false;
+}
+
+void QuicBBR::UpdateMode(std::uint64_t bytes_in_flight,
+                         TimePoint now) noexcept {
+  switch (mode) {
+    case Mode::kStartup:
+      if (full_bandwidth_reached) {
+        mode = Mode::kDrain;
+      }
+      break;
+    case Mode::kDrain:
+      if (bytes_in_flight <= BandwidthDelayProduct()) {
+        mode = Mode::kProbeBW;
+        // start cruising; probing up comes after a full cycle
+        cycle_index = 2;
+        cycle_start = now;
+      }
+      break;
+    case Mode::kProbeBW:
+      if (now - cycle_start > min_rtt) {
+        cycle_index = (cycle_index + 1) % kProbeBWGains.size();
+        cycle_start = now;
+      }
+      break;
+    case Mode::kProbeRTT:
+      if (probe_rtt_done == TimePoint::max()) {
+        if (bytes_in_flight <= MinimumWindow()) {
+          probe_rtt_done = now + kProbeRTTDuration;
+        }
+      } else if (now >= probe_rtt_done) {
+        min_rtt_stamp = now;
+        mode = full_bandwidth_reached ? Mode::kProbeBW : Mode::kStartup;
+        cycle_index = 2;
+        cycle_start = now;
+      }
+      break;
+  }
+}
+
+std::uint64_t QuicBBR::BandwidthDelayProduct() const noexcept {
+  return static_cast<std::uint64_t>(
+      static_cast<double>(bandwidth) *
+      std::chrono::duration<double>(min_rtt).count());
+}
+
+std::uint64_t QuicBBR::Target() const noexcept {
+  if (bandwidth == 0) {
+    // no estimate yet, keep growing as in slow start
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  return static_cast<std::uint64_t>(
+             WindowGain() * static_cast<double>(BandwidthDelayProduct())) +
+         3 * config.max_datagram_size;
+}
+
+double QuicBBR::PacingGain() const noexcept {
+  switch (mode) {
+    case Mode::kStartup:
+      return kHighGain;
+    case Mode::kDrain:
+      return 1 / kHighGain;
+    case Mode::kProbeBW:
+      return kProbeBWGains[cycle_index];
+    case Mode::kProbeRTT:
+      break;
+  }
+  return 1;
+}
+
+double QuicBBR::WindowGain() const noexcept {
+  switch (mode) {
+    case Mode::kStartup:
+    case Mode::kDrain:
+      return kHighGain;
+    case Mode::kProbeBW:
+      return 2;
+    case Mode::kProbeRTT:
+      break;
+  }
+  return 1;
+}
+
+}  // namespace bedrock::network
@@ -0,0 +1,379 @@
+#include "networking/quic/quic_connection_id_table.h"
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace bedrock::network {
+
+namespace QuicConnectionIDTableUtil {
+
+// The last key byte is never part of a connection ID and holds the slot state.
+// An empty slot is all zero, so the tag alone tells the three states apart.
+static constexpr std::uint8_t kOccupied = 0x01;
+static constexpr std::uint8_t kTombstone = 0x02;
+
+static constexpr std::uint64_t TagWord(std::uint8_t tag) {
+  if constexpr (std::endian::native == std::endian::little) {
+    return std::uint64_t{tag} << 56;
+  } else {
+    return tag;
+  }
+}
+static constexpr std::uint64_t kTagMask = TagWord(0xFF);
+
+static constexpr std::uint64_t Tag(std::uint64_t last_word) {
+  return last_word & kTagMask;
+}
+
+using Key = std::array<std::uint64_t, 3>;
+
+// Loads a connection ID of a compile time length straight into key words, so
+// building a key is a few fixed size loads instead of a byte copy.
+template <std::size_t Length>
+static void LoadKey(const std::uint8_t* connection_id, Key& key) {
+  key = {};
+  for (std::size_t word = 0; word < key.size(); word++) {
+    std::size_t begin = word * sizeof(std::uint64_t);
+    if (begin < Length) {
+      std::memcpy(&key[word], connection_id + begin,
+                  std::min(sizeof(std::uint64_t), Length - begin));
+    }
+  }
+  key[2] |= TagWord(kOccupied);
+}
+
+static constexpr auto kKeyLoaders =
+    []<std::size_t... Lengths>(std::index_sequence<Lengths...>) {
+      return std::array<void (*)(const std::uint8_t*, Key&),
+                        sizeof...(Lengths)>{&LoadKey<Lengths>...};
+    }(std::make_index_sequence<kQuicMaxConnectionIDLength + 1>{});
+
+static constexpr std::uint64_t PackHandle(QuicConnectionHandle handle) {
+  return (std::uint64_t{handle.worker} << 32) | handle.connection;
+}
+
+static constexpr QuicConnectionHandle UnpackHandle(std::uint64_t value) {
+  return {static_cast<std::uint32_t>(value >> 32),
+          static_cast<std::uint32_t>(value)};
+}
+
+}  // namespace QuicConnectionIDTableUtil
+
+QuicConnectionIDTable::QuicConnectionIDTable(std::size_t connection_id_length,
+                                             std::size_t capacity) noexcept
+    : length(std::min(connection_id_length, kQuicMaxConnectionIDLength)),
+      load_key(QuicConnectionIDTableUtil::kKeyLoaders[length]) {
+  std::size_t per_shard = (capacity + kQuicConnectionIDTableShards - 1) /
+                          kQuicConnectionIDTableShards;
+  // Entries do not spread evenly over the shards, so leave room for four
+  // standard deviations above the mean before applying the 3/4 load factor.
+  per_shard += static_cast<std::size_t>(
+      4 * std::sqrt(static_cast<double>(per_shard)));
+  std::size_t slot_count =
+      std::bit_ceil(std::max<std::size_t>(16, per_shard * 4 / 3 + 1));
+  for (auto& shard : shards) {
+    shard.slots = std::make_unique<Slot[]>(slot_count);
+    shard.mask = slot_count - 1;
+    shard.limit = slot_count / 4 * 3;
+  }
+}
+
+std::size_t QuicConnectionIDTable::Size() const noexcept {
+  std::size_t total = 0;
+  for (const auto& shard : shards) {
+    total += shard.size.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+std::span<const std::uint8_t> QuicConnectionIDTable::ShortHeaderConnectionID(
+    std::span<const std::uint8_t> packet) const noexcept {
+  if (packet.size() < 1 + length) {
+    return {};
+  }
+  return packet.subspan(1, length);
+}
+
+QuicConnectionIDTable::Key QuicConnectionIDTable::MakeKey(
+    std::span<const std::uint8_t> connection_id) const noexcept {
+  Key key;
+  load_key(connection_id.data(), key);
+  return key;
+}
+
+std::uint64_t QuicConnectionIDTable::Hash(const Key& key) noexcept {
+  constexpr std::uint64_t kMultiplier = 0x9E3779B97F4A7C15;
+  std::uint64_t hash = key[0] * kMultiplier;
+  hash = (hash ^ (hash >> 32) ^ key[1]) * kMultiplier;
+  hash = (hash ^ (hash >> 32) ^ key[2]) * kMultiplier;
+  return hash ^ (hash >> 29);
+}
+
+// The top bits choose the shard, the low bits the slot inside it.
+std::size_t QuicConnectionIDTable::ShardIndex(std::uint64_t hash) noexcept {
+  return hash >> (64 - std::countr_zero(kQuicConnectionIDTableShards));
+}
+
+// An odd sequence marks a write in progress. The release fence keeps the slot
+// stores after the odd sequence becomes visible.
+void QuicConnectionIDTable::BeginWrite(Shard& shard) noexcept {
+  shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void QuicConnectionIDTable::EndWrite(Shard& shard) noexcept {
+  shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+}
+
+// Reinserts the live entries so retired ones stop lengthening probes.
+void QuicConnectionIDTable::Rebuild(Shard& shard) noexcept {
+  std::vector<std::pair<Key, std::uint64_t>> live;
+  live.reserve(shard.size.load(std::memory_order_relaxed));
+  for (std::size_t i = 0; i <= shard.mask; i++) {
+    Slot& slot = shard.slots[i];
+    Key key = {slot.key[0].load(std::memory_order_relaxed),
+               slot.key[1].load(std::memory_order_relaxed),
+               slot.key[2].load(std::memory_order_relaxed)};
+    if (QuicConnectionIDTableUtil::Tag(key[2]) ==
+        QuicConnectionIDTableUtil::TagWord(
+            QuicConnectionIDTableUtil::kOccupied)) {
+      live.emplace_back(key, slot.value.load(std::memory_order_relaxed));
+    }
+  }
+
+  BeginWrite(shard);
+  for (std::size_t i = 0; i <= shard.mask; i++) {
+    for (auto& word : shard.slots[i].key) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+  for (const auto& [key, value] : live) {
+    std::size_t i = Hash(key) & shard.mask;
+    while (shard.slots[i].key[2].load(std::memory_order_relaxed) != 0) {
+      i = (i + 1) & shard.mask;
+    }
+    Slot& slot = shard.slots[i];
+    slot.key[0].store(key[0], std::memory_order_relaxed);
+    slot.key[1].store(key[1], std::memory_order_relaxed);
+    slot.key[2].store(key[2], std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+  }
+  EndWrite(shard);
+  shard.tombstones = 0;
+}
+
+QuicConnectionIDTableErrorStatus QuicConnectionIDTable::Insert(
+    std::span<const std::uint8_t> connection_id,
+    QuicConnectionHandle handle) noexcept {
+  using namespace QuicConnectionIDTableUtil;
+
+  if (connection_id.size() != length) {
+    return QuicConnectionIDTableErrorStatus::kInvalid;
+  }
+  Key key = MakeKey(connection_id);
+  std::uint64_t hash = Hash(key);
+  Shard& shard = shards[ShardIndex(hash)];
+  std::lock_guard lock(shard.mutex);
+
+  // The key may sit behind a tombstone, so probe up to an empty slot before
+  // reusing the first free one.
+  std::size_t free_slot = shard.mask + 1;
+  for (std::size_t i = hash & shard.mask;;
+       i = (i + 1) & shard.mask) {
+    const Slot& slot = shard.slots[i];
+    std::uint64_t last = slot.key[2].load(std::memory_order_relaxed);
+    if (last == 0) {
+      if (free_slot > shard.mask) {
+        free_slot = i;
+      }
+      break;
+    }
+    if (Tag(last) == TagWord(kTombstone)) {
+      if (free_slot > shard.mask) {
+        free_slot = i;
+      }
+    } else if (last == key[2] &&
+               slot.key[0].load(std::memory_order_relaxed) == key[0] &&
+               slot.key[1].load(std::memory_order_relaxed) == key[1]) {
+      return QuicConnectionIDTableErrorStatus::kDuplicate;
+    }
+  }
+
+  bool reuses_tombstone =
+      shard.slots[free_slot].key[2].load(std::memory_order_relaxed) != 0;
+  std::size_t size = shard.size.load(std::memory_order_relaxed);
+  if (!reuses_tombstone && size + shard.tombstones >= shard.limit) {
+    if (shard.tombstones == 0 || size >= shard.limit) {
+      return QuicConnectionIDTableErrorStatus::kFull;
+    }
+    // Rebuilding drops every tombstone, and the key is known to be absent.
+    Rebuild(shard);
+    free_slot = hash & shard.mask;
+    while (shard.slots[free_slot].key[2].load(std::memory_order_relaxed) !=
+           0) {
+      free_slot = (free_slot + 1) & shard.mask;
+    }
+    reuses_tombstone = false;
+  }
+
+  Slot& slot = shard.slots[free_slot];
+  BeginWrite(shard);
+  slot.key[0].store(key[0], std::memory_order_relaxed);
+  slot.key[1].store(key[1], std::memory_order_relaxed);
+  slot.value.store(PackHandle(handle), std::memory_order_relaxed);
+  slot.key[2].store(key[2], std::memory_order_relaxed);
+  EndWrite(shard);
+
+  if (reuses_tombstone) {
+    shard.tombstones--;
+  }
+  shard.size.store(size + 1, std::memory_order_relaxed);
+  return QuicConnectionIDTableErrorStatus::kSuccess;
+}
+
+QuicConnectionIDTableErrorStatus QuicConnectionIDTable::Retire(
+    std::span<const std::uint8_t> connection_id) noexcept {
+  using namespace QuicConnectionIDTableUtil;
+
+  if (connection_id.size() != length) {
+    return QuicConnectionIDTableErrorStatus::kInvalid;
+  }
+  Key key = MakeKey(connection_id);
+  std::uint64_t hash = Hash(key);
+  Shard& shard = shards[ShardIndex(hash)];
+  std::lock_guard lock(shard.mutex);
+
+  std::size_t i = hash & shard.mask;
+  for (;; i = (i + 1) & shard.mask) {
+    const Slot& slot = shard.slots[i];
+    std::uint64_t last = slot.key[2].load(std::memory_order_relaxed);
+    if (last == 0) {
+      return QuicConnectionIDTableErrorStatus::kNotFound;
+    }
+    if (last == key[2] &&
+        slot.key[0].load(std::memory_order_relaxed) == key[0] &&
+        slot.key[1].load(std::memory_order_relaxed) == key[1]) {
+      break;
+    }
+  }
+
+  // A slot followed by an empty one ends no other probe, so it and the
+  // tombstones right before it can become empty again.
+  BeginWrite(shard);
+  std::size_t next = (i + 1) & shard.mask;
+  if (shard.slots[next].key[2].load(std::memory_order_relaxed) == 0) {
+    shard.slots[i].key[2].store(0, std::memory_order_relaxed);
+    for (i = (i - 1) & shard.mask;
+         Tag(shard.slots[i].key[2].load(std::memory_order_relaxed)) ==
+         TagWord(kTombstone);
+         i = (i - 1) & shard.mask) {
+      shard.slots[i].key[2].store(0, std::memory_order_relaxed);
+      shard.tombstones--;
+    }
+  } else {
+    shard.slots[i].key[2].store((key[2] & ~kTagMask) | TagWord(kTombstone),
+                                std::memory_order_relaxed);
+    shard.tombstones++;
+  }
+  EndWrite(shard);
+
+  shard.size.store(shard.size.load(std::memory_order_relaxed) - 1,
+                   std::memory_order_relaxed);
+  if (shard.tombstones > shard.limit / 3) {
+    Rebuild(shard);
+  }
+  return QuicConnectionIDTableErrorStatus::kSuccess;
+}
+
+bool QuicConnectionIDTable::Find(std::span<const std::uint8_t> connection_id,
+                                 QuicConnectionHandle& handle) const noexcept {
+  if (connection_id.size() < length) {
+    return false;
+  }
+  Key key = MakeKey(connection_id);
+  return Find(key, Hash(key), handle);
+}
+
+std::size_t QuicConnectionIDTable::Find(
+    std::span<const std::span<const std::uint8_t>> connection_ids,
+    std::span<QuicConnectionHandle> handles,
+    std::span<bool> found) const noexcept {
+  std::size_t count = std::min({connection_ids.size(), handles.size(),
+                                found.size()});
+  std::size_t total = 0;
+  std::array<Key, kQuicConnectionIDTableBatch> keys;
+  std::array<std::uint64_t, kQuicConnectionIDTableBatch> hashes;
+
+  for (std::size_t begin = 0; begin < count;
+       begin += kQuicConnectionIDTableBatch) {
+    std::size_t batch = std::min(kQuicConnectionIDTableBatch, count - begin);
+    for (std::size_t i = 0; i < batch; i++) {
+      if (connection_ids[begin + i].size() < length) {
+        hashes[i] = 0;
+        continue;
+      }
+      load_key(connection_ids[begin + i].data(), keys[i]);
+      hashes[i] = Hash(keys[i]);
+      const Shard& shard = shards[ShardIndex(hashes[i])];
+      _mm_prefetch(reinterpret_cast<const char*>(
+                       &shard.slots[hashes[i] & shard.mask]),
+                   _MM_HINT_T0);
+    }
+    for (std::size_t i = 0; i < batch; i++) {
+      found[begin + i] = connection_ids[begin + i].size() >= length &&
+                         Find(keys[i], hashes[i], handles[begin + i]);
+      total += found[begin + i];
+    }
+  }
+  return total;
+}
+
+bool QuicConnectionIDTable::Find(const Key& key, std::uint64_t hash,
+                                 QuicConnectionHandle& handle) const noexcept {
+  const Shard& shard = shards[ShardIndex(hash)];
+
+  for (;;) {
+    std::uint64_t sequence = shard.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      continue;
+    }
+
+    bool found = false;
+    std::uint64_t value = 0;
+    // Bounded, since a racing writer may show the reader a torn table.
+    std::size_t i = hash & shard.mask;
+    for (std::size_t probes = 0; probes <= shard.mask; probes++) {
+      const Slot& slot = shard.slots[i];
+      std::uint64_t last = slot.key[2].load(std::memory_order_relaxed);
+      if (last == 0) {
+        break;
+      }
+      if (last == key[2] &&
+          slot.key[0].load(std::memory_order_relaxed) == key[0] &&
+          slot.key[1].load(std::memory_order_relaxed) == key[1]) {
+        value = slot.value.load(std::memory_order_relaxed);
+        found = true;
+        break;
+      }
+      i = (i + 1) & shard.mask;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (shard.sequence.load(std::memory_order_relaxed) == sequence) {
+      if (found) {
+        handle = QuicConnectionIDTableUtil::UnpackHandle(value);
+      }
+      return found;
+    }
+  }
+}
+
+}  // namespace bedrock::network
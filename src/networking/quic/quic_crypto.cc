@@ -0,0 +1,579 @@
+#include "networking/quic/quic_crypto.h"
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+namespace QuicCryptoUtil {
+
+static __m128i Load(const std::uint8_t* source) noexcept {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+static void Store(std::uint8_t* destination, __m128i block) noexcept {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), block);
+}
+
+// Block index of a 16 byte aligned array such as a key schedule. The load
+// folds into the instruction that uses the block.
+static __m128i AlignedBlock(const std::uint8_t* blocks,
+                            std::size_t index) noexcept {
+  return _mm_load_si128(
+      reinterpret_cast<const __m128i*>(blocks + index * kQuicAESBlockSize));
+}
+
+// One step of the FIPS-197 key schedule; generated is the aeskeygenassist
+// result of the previous round key.
+static __m128i ExpandKey(__m128i key, __m128i generated) noexcept {
+  generated = _mm_shuffle_epi32(generated, 0xFF);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, generated);
+}
+
+static __m128i EncryptBlock(const std::uint8_t* keys,
+                            __m128i block) noexcept {
+  block = _mm_xor_si128(block, AlignedBlock(keys, 0));
+  for (std::size_t round = 1; round < 10; round++) {
+    block = _mm_aesenc_si128(block, AlignedBlock(keys, round));
+  }
+  return _mm_aesenclast_si128(block, AlignedBlock(keys, 10));
+}
+
+// Encrypts count blocks in place. Four independent blocks in flight hide
+// the aesenc latency. They are spelled out so they stay in registers at any
+// optimization level.
+static void EncryptBlocks(const std::uint8_t* keys, __m128i* blocks,
+                          std::size_t count) noexcept {
+  std::size_t block = 0;
+  for (; block + 4 <= count; block += 4) {
+    __m128i key = AlignedBlock(keys, 0);
+    __m128i block0 = _mm_xor_si128(blocks[block], key);
+    __m128i block1 = _mm_xor_si128(blocks[block + 1], key);
+    __m128i block2 = _mm_xor_si128(blocks[block + 2], key);
+    __m128i block3 = _mm_xor_si128(blocks[block + 3], key);
+    for (std::size_t round = 1; round < 10; round++) {
+      key = AlignedBlock(keys, round);
+      block0 = _mm_aesenc_si128(block0, key);
+      block1 = _mm_aesenc_si128(block1, key);
+      block2 = _mm_aesenc_si128(block2, key);
+      block3 = _mm_aesenc_si128(block3, key);
+    }
+    key = AlignedBlock(keys, 10);
+    blocks[block] = _mm_aesenclast_si128(block0, key);
+    blocks[block + 1] = _mm_aesenclast_si128(block1, key);
+    blocks[block + 2] = _mm_aesenclast_si128(block2, key);
+    blocks[block + 3] = _mm_aesenclast_si128(block3, key);
+  }
+  for (; block < count; block++) {
+    blocks[block] = EncryptBlock(keys, blocks[block]);
+  }
+}
+
+// GHASH works on bit reflected blocks. Byte swapping every block on load
+// and store lets carry-less multiplication do the field arithmetic with a
+// single extra shift, as in Intel's carry-less multiplication white paper.
+static __m128i ByteSwap(__m128i block) noexcept {
+  return _mm_shuffle_epi8(block, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                              10, 11, 12, 13, 14, 15));
+}
+
+// Adds the unreduced 256 bit product a * b to high:low.
+static void MultiplyAccumulate(__m128i a, __m128i b, __m128i& low,
+                               __m128i& high) noexcept {
+  __m128i middle = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+                                 _mm_clmulepi64_si128(a, b, 0x01));
+  low = _mm_xor_si128(low, _mm_clmulepi64_si128(a, b, 0x00));
+  high = _mm_xor_si128(high, _mm_clmulepi64_si128(a, b, 0x11));
+  low = _mm_xor_si128(low, _mm_slli_si128(middle, 8));
+  high = _mm_xor_si128(high, _mm_srli_si128(middle, 8));
+}
+
+// Shifts high:low left by one bit to undo the reflection and reduces it
+// modulo x^128 + x^7 + x^2 + x + 1.
+static __m128i Reduce(__m128i low, __m128i high) noexcept {
+  __m128i low_carry = _mm_srli_epi32(low, 31);
+  __m128i high_carry = _mm_srli_epi32(high, 31);
+  low = _mm_slli_epi32(low, 1);
+  high = _mm_slli_epi32(high, 1);
+  __m128i cross_carry = _mm_srli_si128(low_carry, 12);
+  high_carry = _mm_slli_si128(high_carry, 4);
+  low_carry = _mm_slli_si128(low_carry, 4);
+  low = _mm_or_si128(low, low_carry);
+  high = _mm_or_si128(_mm_or_si128(high, high_carry), cross_carry);
+
+  __m128i folded = _mm_xor_si128(
+      _mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)),
+      _mm_slli_epi32(low, 25));
+  __m128i folded_high = _mm_srli_si128(folded, 4);
+  low = _mm_xor_si128(low, _mm_slli_si128(folded, 12));
+
+  __m128i shifted = _mm_xor_si128(
+      _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)),
+      _mm_xor_si128(_mm_srli_epi32(low, 7), folded_high));
+  return _mm_xor_si128(high, _mm_xor_si128(low, shifted));
+}
+
+static __m128i Multiply(__m128i a, __m128i b) noexcept {
+  __m128i low = _mm_setzero_si128();
+  __m128i high = _mm_setzero_si128();
+  MultiplyAccumulate(a, b, low, high);
+  return Reduce(low, high);
+}
+
+// Folds whole blocks into state. Four blocks share one reduction:
+// ((((X + C1)H + C2)H + C3)H + C4)H = (X + C1)H^4 + C2 H^3 + C3 H^2 + C4 H
+static __m128i HashBlocks(const __m128i* keys, __m128i state,
+                          const std::uint8_t* data,
+                          std::size_t blocks) noexcept {
+  std::size_t block = 0;
+  for (; block + 4 <= blocks; block += 4) {
+    const std::uint8_t* source = data + block * kQuicAESBlockSize;
+    __m128i low = _mm_setzero_si128();
+    __m128i high = _mm_setzero_si128();
+    MultiplyAccumulate(_mm_xor_si128(state, ByteSwap(Load(source))), keys[3],
+                       low, high);
+    MultiplyAccumulate(ByteSwap(Load(source + 16)), keys[2], low, high);
+    MultiplyAccumulate(ByteSwap(Load(source + 32)), keys[1], low, high);
+    MultiplyAccumulate(ByteSwap(Load(source + 48)), keys[0], low, high);
+    state = Reduce(low, high);
+  }
+  for (; block < blocks; block++) {
+    state = Multiply(
+        _mm_xor_si128(state,
+                      ByteSwap(Load(data + block * kQuicAESBlockSize))),
+        keys[0]);
+  }
+  return state;
+}
+
+// Folds data, zero padding its last block.
+static __m128i Hash(const __m128i* keys, __m128i state,
+                    std::span<const std::uint8_t> data) noexcept {
+  std::size_t blocks = data.size() / kQuicAESBlockSize;
+  state = HashBlocks(keys, state, data.data(), blocks);
+  std::size_t rest = data.size() - blocks * kQuicAESBlockSize;
+  if (rest != 0) {
+    std::array<std::uint8_t, kQuicAESBlockSize> last{};
+    std::memcpy(last.data(), data.data() + blocks * kQuicAESBlockSize, rest);
+    state = HashBlocks(keys, state, last.data(), 1);
+  }
+  return state;
+}
+
+// SHA-256 constants (FIPS 180-4 sections 4.2.2 and 5.3.3)
+static constexpr std::array<std::uint32_t, 64> kSHA256RoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static constexpr std::array<std::uint32_t, 8> kSHA256InitialState = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static constexpr std::size_t kSHA256BlockSize = 64;
+
+}  // namespace QuicCryptoUtil
+
+void QuicAES128::SetKey(
+    std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept {
+  using QuicCryptoUtil::ExpandKey;
+
+  __m128i keys[11];
+  // aeskeygenassist takes the round constant as an immediate.
+  keys[0] = QuicCryptoUtil::Load(key.data());
+  keys[1] = ExpandKey(keys[0], _mm_aeskeygenassist_si128(keys[0], 0x01));
+  keys[2] = ExpandKey(keys[1], _mm_aeskeygenassist_si128(keys[1], 0x02));
+  keys[3] = ExpandKey(keys[2], _mm_aeskeygenassist_si128(keys[2], 0x04));
+  keys[4] = ExpandKey(keys[3], _mm_aeskeygenassist_si128(keys[3], 0x08));
+  keys[5] = ExpandKey(keys[4], _mm_aeskeygenassist_si128(keys[4], 0x10));
+  keys[6] = ExpandKey(keys[5], _mm_aeskeygenassist_si128(keys[5], 0x20));
+  keys[7] = ExpandKey(keys[6], _mm_aeskeygenassist_si128(keys[6], 0x40));
+  keys[8] = ExpandKey(keys[7], _mm_aeskeygenassist_si128(keys[7], 0x80));
+  keys[9] = ExpandKey(keys[8], _mm_aeskeygenassist_si128(keys[8], 0x1B));
+  keys[10] = ExpandKey(keys[9], _mm_aeskeygenassist_si128(keys[9], 0x36));
+
+  // Equivalent inverse cipher (FIPS-197 section 5.3.5)
+  for (std::size_t round = 0; round < 11; round++) {
+    __m128i inverse = keys[10 - round];
+    if (round != 0 && round != 10) {
+      inverse = _mm_aesimc_si128(inverse);
+    }
+    QuicCryptoUtil::Store(encrypt_keys.data() + round * kQuicAESBlockSize,
+                          keys[round]);
+    QuicCryptoUtil::Store(decrypt_keys.data() + round * kQuicAESBlockSize,
+                          inverse);
+  }
+}
+
+void QuicAES128::EncryptBlock(const std::uint8_t* input,
+                              std::uint8_t* output) const noexcept {
+  QuicCryptoUtil::Store(output,
+                        QuicCryptoUtil::EncryptBlock(
+                            encrypt_keys.data(), QuicCryptoUtil::Load(input)));
+}
+
+void QuicAES128::DecryptBlock(const std::uint8_t* input,
+                              std::uint8_t* output) const noexcept {
+  using QuicCryptoUtil::AlignedBlock;
+
+  const std::uint8_t* keys = decrypt_keys.data();
+  __m128i block =
+      _mm_xor_si128(QuicCryptoUtil::Load(input), AlignedBlock(keys, 0));
+  for (std::size_t round = 1; round < 10; round++) {
+    block = _mm_aesdec_si128(block, AlignedBlock(keys, round));
+  }
+  QuicCryptoUtil::Store(output,
+                        _mm_aesdeclast_si128(block, AlignedBlock(keys, 10)));
+}
+
+void QuicAES128::Encrypt(std::span<const std::uint8_t> input,
+                         std::span<std::uint8_t> output) const noexcept {
+  constexpr std::size_t kChunk = 8;
+  std::size_t blocks = input.size() / kQuicAESBlockSize;
+
+  __m128i chunk[kChunk];
+  for (std::size_t block = 0; block < blocks; block += kChunk) {
+    std::size_t count = std::min(blocks - block, kChunk);
+    for (std::size_t i = 0; i < count; i++) {
+      chunk[i] = QuicCryptoUtil::Load(input.data() +
+                                      (block + i) * kQuicAESBlockSize);
+    }
+    QuicCryptoUtil::EncryptBlocks(encrypt_keys.data(), chunk, count);
+    for (std::size_t i = 0; i < count; i++) {
+      QuicCryptoUtil::Store(output.data() + (block + i) * kQuicAESBlockSize,
+                            chunk[i]);
+    }
+  }
+}
+
+void QuicAES128::EncryptBlocks(const std::uint8_t* const* inputs,
+                               std::uint8_t* output,
+                               std::size_t count) const noexcept {
+  constexpr std::size_t kChunk = 8;
+
+  __m128i chunk[kChunk];
+  for (std::size_t block = 0; block < count; block += kChunk) {
+    std::size_t size = std::min(count - block, kChunk);
+    for (std::size_t i = 0; i < size; i++) {
+      chunk[i] = QuicCryptoUtil::Load(inputs[block + i]);
+    }
+    QuicCryptoUtil::EncryptBlocks(encrypt_keys.data(), chunk, size);
+    for (std::size_t i = 0; i < size; i++) {
+      QuicCryptoUtil::Store(output + (block + i) * kQuicAESBlockSize,
+                            chunk[i]);
+    }
+  }
+}
+
+void QuicAES128GCM::SetKey(
+    std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept {
+  using QuicCryptoUtil::ByteSwap;
+
+  cipher.SetKey(key);
+  __m128i keys[4];
+  keys[0] = ByteSwap(QuicCryptoUtil::EncryptBlock(cipher.encrypt_keys.data(),
+                                                  _mm_setzero_si128()));
+  for (std::size_t power = 1; power < 4; power++) {
+    keys[power] = QuicCryptoUtil::Multiply(keys[power - 1], keys[0]);
+  }
+  for (std::size_t power = 0; power < 4; power++) {
+    QuicCryptoUtil::Store(hash_keys.data() + power * kQuicAESBlockSize,
+                          keys[power]);
+  }
+}
+
+void QuicAES128GCM::Crypt(
+    std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+    std::span<const std::uint8_t> associated_data,
+    std::span<std::uint8_t> text, bool encrypt,
+    std::uint8_t* tag) const noexcept {
+  using QuicCryptoUtil::ByteSwap;
+  using QuicCryptoUtil::Load;
+  using QuicCryptoUtil::Store;
+  constexpr std::size_t kChunk = 8;
+
+  const std::uint8_t* round_keys = cipher.encrypt_keys.data();
+  __m128i keys[4];
+  for (std::size_t power = 0; power < 4; power++) {
+    keys[power] = QuicCryptoUtil::AlignedBlock(hash_keys.data(), power);
+  }
+
+  // J0 = nonce || 1; the counter is incremented as a little endian lane of
+  // the byte swapped block.
+  std::array<std::uint8_t, kQuicAESBlockSize> first_counter{};
+  std::memcpy(first_counter.data(), nonce.data(), kQuicAEADNonceSize);
+  first_counter[15] = 1;
+  __m128i counter = ByteSwap(Load(first_counter.data()));
+  const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+  __m128i tag_mask =
+      QuicCryptoUtil::EncryptBlock(round_keys, Load(first_counter.data()));
+
+  __m128i state =
+      QuicCryptoUtil::Hash(keys, _mm_setzero_si128(), associated_data);
+
+  __m128i keystream[kChunk];
+  for (std::size_t offset = 0; offset < text.size();
+       offset += kChunk * kQuicAESBlockSize) {
+    std::size_t size =
+        std::min(text.size() - offset, kChunk * kQuicAESBlockSize);
+    std::size_t blocks = (size + kQuicAESBlockSize - 1) / kQuicAESBlockSize;
+    for (std::size_t block = 0; block < blocks; block++) {
+      counter = _mm_add_epi32(counter, one);
+      keystream[block] = ByteSwap(counter);
+    }
+    QuicCryptoUtil::EncryptBlocks(round_keys, keystream, blocks);
+
+    std::span<std::uint8_t> chunk = text.subspan(offset, size);
+    if (!encrypt) {
+      state = QuicCryptoUtil::Hash(keys, state, chunk);
+    }
+    std::size_t whole = size / kQuicAESBlockSize;
+    for (std::size_t block = 0; block < whole; block++) {
+      std::uint8_t* bytes = chunk.data() + block * kQuicAESBlockSize;
+      Store(bytes, _mm_xor_si128(Load(bytes), keystream[block]));
+    }
+    if (whole != blocks) {
+      std::array<std::uint8_t, kQuicAESBlockSize> last;
+      Store(last.data(), keystream[whole]);
+      for (std::size_t i = whole * kQuicAESBlockSize; i < size; i++) {
+        chunk[i] ^= last[i - whole * kQuicAESBlockSize];
+      }
+    }
+    if (encrypt) {
+      state = QuicCryptoUtil::Hash(keys, state, chunk);
+    }
+  }
+
+  __m128i lengths = _mm_set_epi64x(
+      static_cast<long long>(associated_data.size() * 8),
+      static_cast<long long>(text.size() * 8));
+  state = QuicCryptoUtil::Multiply(_mm_xor_si128(state, lengths), keys[0]);
+  Store(tag, _mm_xor_si128(ByteSwap(state), tag_mask));
+}
+
+void QuicAES128GCM::Seal(
+    std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+    std::span<const std::uint8_t> associated_data,
+    std::span<std::uint8_t> text, std::uint8_t* tag) const noexcept {
+  Crypt(nonce, associated_data, text, true, tag);
+}
+
+bool QuicAES128GCM::Open(
+    std::span<const std::uint8_t, kQuicAEADNonceSize> nonce,
+    std::span<const std::uint8_t> associated_data,
+    std::span<std::uint8_t> text, const std::uint8_t* tag) const noexcept {
+  using QuicCryptoUtil::Load;
+
+  std::array<std::uint8_t, kQuicAEADTagSize> expected;
+  Crypt(nonce, associated_data, text, false, expected.data());
+  // compares all bytes at once, so timing does not reveal a matching prefix
+  return _mm_movemask_epi8(
+             _mm_cmpeq_epi8(Load(expected.data()), Load(tag))) == 0xFFFF;
+}
+
+void QuicSHA256::Reset() noexcept {
+  state = QuicCryptoUtil::kSHA256InitialState;
+  pending_size = 0;
+  total_size = 0;
+}
+
+void QuicSHA256::Compress(const std::uint8_t* block) noexcept {
+  std::array<std::uint32_t, 64> w;
+  for (std::size_t i = 0; i < 16; i++) {
+    w[i] = LoadBigEndian<std::uint32_t>(block + i * 4);
+  }
+  for (std::size_t i = 16; i < 64; i++) {
+    std::uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^
+                       (w[i - 15] >> 3);
+    std::uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^
+                       (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  auto [a, b, c, d, e, f, g, h] = state;
+  for (std::size_t i = 0; i < 64; i++) {
+    std::uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+    std::uint32_t choose = (e & f) ^ (~e & g);
+    std::uint32_t t1 =
+        h + s1 + choose + QuicCryptoUtil::kSHA256RoundConstants[i] + w[i];
+    std::uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+    std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + s0 + majority;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+void QuicSHA256::Update(std::span<const std::uint8_t> data) noexcept {
+  using QuicCryptoUtil::kSHA256BlockSize;
+
+  total_size += data.size();
+  if (pending_size != 0) {
+    std::size_t taken = std::min(kSHA256BlockSize - pending_size, data.size());
+    std::memcpy(pending.data() + pending_size, data.data(), taken);
+    pending_size += taken;
+    data = data.subspan(taken);
+    if (pending_size < kSHA256BlockSize) {
+      return;
+    }
+    Compress(pending.data());
+    pending_size = 0;
+  }
+  while (data.size() >= kSHA256BlockSize) {
+    Compress(data.data());
+    data = data.subspan(kSHA256BlockSize);
+  }
+  std::memcpy(pending.data(), data.data(), data.size());
+  pending_size = data.size();
+}
+
+QuicSHA256Digest QuicSHA256::Final() noexcept {
+  using QuicCryptoUtil::kSHA256BlockSize;
+
+  std::uint64_t bit_size = total_size * 8;
+  pending[pending_size++] = 0x80;
+  if (pending_size > kSHA256BlockSize - 8) {
+    std::fill(pending.begin() + static_cast<std::ptrdiff_t>(pending_size),
+              pending.end(), std::uint8_t{0});
+    Compress(pending.data());
+    pending_size = 0;
+  }
+  std::fill(pending.begin() + static_cast<std::ptrdiff_t>(pending_size),
+            pending.end() - 8, std::uint8_t{0});
+  StoreBigEndian(pending.data() + kSHA256BlockSize - 8, bit_size);
+  Compress(pending.data());
+
+  QuicSHA256Digest digest;
+  for (std::size_t i = 0; i < state.size(); i++) {
+    StoreBigEndian(digest.data() + i * 4, state[i]);
+  }
+  Reset();
+  return digest;
+}
+
+QuicSHA256Digest QuicSHA256::Hash(
+    std::span<const std::uint8_t> data) noexcept {
+  QuicSHA256 hash;
+  hash.Update(data);
+  return hash.Final();
+}
+
+QuicSHA256Digest QuicHMACSHA256(std::span<const std::uint8_t> key,
+                                std::span<const std::uint8_t> data) noexcept {
+  using QuicCryptoUtil::kSHA256BlockSize;
+
+  std::array<std::uint8_t, kSHA256BlockSize> block_key{};
+  if (key.size() > kSHA256BlockSize) {
+    auto digest = QuicSHA256::Hash(key);
+    std::copy(digest.begin(), digest.end(), block_key.begin());
+  } else {
+    std::copy(key.begin(), key.end(), block_key.begin());
+  }
+
+  std::array<std::uint8_t, kSHA256BlockSize> pad;
+  for (std::size_t i = 0; i < kSHA256BlockSize; i++) {
+    pad[i] = block_key[i] ^ 0x36;
+  }
+  QuicSHA256 inner;
+  inner.Update(pad);
+  inner.Update(data);
+  auto inner_digest = inner.Final();
+
+  for (std::size_t i = 0; i < kSHA256BlockSize; i++) {
+    pad[i] = block_key[i] ^ 0x5c;
+  }
+  QuicSHA256 outer;
+  outer.Update(pad);
+  outer.Update(inner_digest);
+  return outer.Final();
+}
+
+QuicSHA256Digest QuicHKDFExtract(std::span<const std::uint8_t> salt,
+                                 std::span<const std::uint8_t> ikm) noexcept {
+  return QuicHMACSHA256(salt, ikm);
+}
+
+// HkdfLabel {
+//   uint16 length,
+//   opaque label<7..255> = "tls13 " + Label,
+//   opaque context<0..255>,
+// }
+bool QuicHKDFExpandLabel(std::span<const std::uint8_t> secret,
+                         std::string_view label,
+                         std::span<std::uint8_t> output,
+                         std::span<const std::uint8_t> context) noexcept {
+  constexpr std::string_view kPrefix = "tls13 ";
+  static_assert(kPrefix.size() + kQuicHKDFMaxLabelSize == 255);
+  if (label.size() > kQuicHKDFMaxLabelSize ||
+      output.size() > kQuicHKDFMaxOutputSize ||
+      context.size() > kQuicHKDFMaxContextSize) {
+    std::fill(output.begin(), output.end(), std::uint8_t{0});
+    return false;
+  }
+
+  std::array<std::uint8_t, 2 + 1 + 255 + 1 + kQuicHKDFMaxContextSize> info;
+  std::size_t info_size = 0;
+  StoreBigEndian(info.data(), static_cast<std::uint16_t>(output.size()));
+  info_size += 2;
+  info[info_size++] =
+      static_cast<std::uint8_t>(kPrefix.size() + label.size());
+  std::memcpy(info.data() + info_size, kPrefix.data(), kPrefix.size());
+  info_size += kPrefix.size();
+  std::memcpy(info.data() + info_size, label.data(), label.size());
+  info_size += label.size();
+  info[info_size++] = static_cast<std::uint8_t>(context.size());
+  std::copy(context.begin(), context.end(),
+            info.begin() + static_cast<std::ptrdiff_t>(info_size));
+  info_size += context.size();
+
+  // T(0) is empty; each block is HMAC(secret, T(i-1) | info | i)
+  QuicSHA256Digest block{};
+  std::size_t block_size = 0;
+  std::array<std::uint8_t, kQuicSHA256Size + sizeof(info) + 1> message;
+  for (std::uint8_t counter = 1; !output.empty(); counter++) {
+    std::memcpy(message.data(), block.data(), block_size);
+    std::memcpy(message.data() + block_size, info.data(), info_size);
+    message[block_size + info_size] = counter;
+    block = QuicHMACSHA256(
+        secret, std::span(message).first(block_size + info_size + 1));
+    block_size = block.size();
+
+    std::size_t taken = std::min(output.size(), block.size());
+    std::memcpy(output.data(), block.data(), taken);
+    output = output.subspan(taken);
+  }
+  return true;
+}
+
+}  // namespace bedrock::network
@@ -0,0 +1,161 @@
+#include "networking/quic/quic_datagram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+// Transport Parameter {
+//   Transport Parameter ID (i),
+//   Transport Parameter Length (i),
+//   Transport Parameter Value (..),
+// }
+std::size_t WriteQuicMaxDatagramFrameSize(
+    std::uint64_t max_frame_size, std::span<std::uint8_t> out) noexcept {
+  std::size_t value_size = QuicVarIntLength(max_frame_size);
+  std::size_t size = QuicVarIntLength(kQuicMaxDatagramFrameSizeParameterID) +
+                     QuicVarIntLength(value_size) + value_size;
+  if (out.size() < size) {
+    return 0;
+  }
+  std::uint8_t* cursor =
+      StoreQuicVarInt(out.data(), kQuicMaxDatagramFrameSizeParameterID);
+  cursor = StoreQuicVarInt(cursor, value_size);
+  StoreQuicVarInt(cursor, max_frame_size);
+  return size;
+}
+
+QuicDatagramErrorStatus ReadQuicMaxDatagramFrameSize(
+    std::span<const std::uint8_t> transport_parameters,
+    std::uint64_t& max_frame_size) noexcept {
+  max_frame_size = 0;
+  QuicWireReader reader(transport_parameters);
+  while (!reader.Empty()) {
+    std::uint64_t id = reader.ReadVarInt();
+    std::uint64_t length = reader.ReadVarInt();
+    std::span<const std::uint8_t> value = reader.ReadBytes(length);
+    if (!reader.Ok()) {
+      return QuicDatagramErrorStatus::kMalformed;
+    }
+    if (id != kQuicMaxDatagramFrameSizeParameterID) {
+      continue;
+    }
+    QuicWireReader value_reader(value);
+    max_frame_size = value_reader.ReadVarInt();
+    if (!value_reader.Ok() || !value_reader.Empty()) {
+      max_frame_size = 0;
+      return QuicDatagramErrorStatus::kMalformed;
+    }
+  }
+  return QuicDatagramErrorStatus::kSuccess;
+}
+
+QuicDatagramChannel::QuicDatagramChannel(std::uint64_t local_max_frame_size,
+                                         std::size_t queue_length)
+    : local_max(local_max_frame_size),
+      send_slots(std::max<std::size_t>(queue_length, 1) *
+                 kQuicPacketBufferCapacity),
+      send_sizes(std::max<std::size_t>(queue_length, 1)),
+      received(std::max<std::size_t>(queue_length, 1)) {
+  SetPathMTU(kQuicMinInitialDatagramSizeV1, kQuicMaxConnectionIDLength);
+}
+
+std::size_t QuicDatagramChannel::WriteTransportParameter(
+    std::span<std::uint8_t> out) const noexcept {
+  if (local_max == 0) {
+    return 0;
+  }
+  return WriteQuicMaxDatagramFrameSize(local_max, out);
+}
+
+QuicDatagramErrorStatus QuicDatagramChannel::OnPeerTransportParameters(
+    std::span<const std::uint8_t> transport_parameters) noexcept {
+  return ReadQuicMaxDatagramFrameSize(transport_parameters, peer_max);
+}
+
+void QuicDatagramChannel::SetPathMTU(
+    std::size_t plpmtu, std::size_t connection_id_length) noexcept {
+  std::size_t overhead = kQuicShortHeaderOverheadV1 + connection_id_length;
+  plpmtu = std::min(plpmtu, kQuicPacketBufferCapacity);
+  path_frame_limit = plpmtu > overhead ? plpmtu - overhead : 0;
+}
+
+// The limit covers the whole frame, type byte and Length field included.
+std::size_t QuicDatagramChannel::MaxPayload() const noexcept {
+  std::uint64_t limit = std::min<std::uint64_t>(peer_max, path_frame_limit);
+  for (std::size_t length_size :
+       {std::size_t{1}, std::size_t{2}, std::size_t{4}}) {
+    if (limit < 1 + length_size) {
+      return 0;
+    }
+    std::uint64_t fit = limit - 1 - length_size;
+    if (QuicVarIntLength(fit) <= length_size) {
+      return fit;
+    }
+  }
+  return 0;
+}
+
+QuicDatagramErrorStatus QuicDatagramChannel::Send(
+    std::span<const std::uint8_t> data) noexcept {
+  if (peer_max == 0) {
+    return QuicDatagramErrorStatus::kDisabled;
+  }
+  if (data.size() > MaxPayload()) {
+    return QuicDatagramErrorStatus::kTooLarge;
+  }
+  if (send_count == send_sizes.size()) {
+    return QuicDatagramErrorStatus::kBusy;
+  }
+  std::size_t slot = (send_head + send_count) % send_sizes.size();
+  if (!data.empty()) {
+    std::memcpy(send_slots.data() + slot * kQuicPacketBufferCapacity,
+                data.data(), data.size());
+  }
+  send_sizes[slot] = data.size();
+  send_count++;
+  return QuicDatagramErrorStatus::kSuccess;
+}
+
+QuicDatagramErrorStatus QuicDatagramChannel::OnDatagramFrame(
+    const QuicFrameV1& frame, const QuicPacketBufferRef& packet) noexcept {
+  std::uint64_t frame_size = 1 + frame.data.size();
+  if (frame.flags & kQuicDatagramFrameLenBitV1) {
+    frame_size += QuicVarIntLength(frame.length);
+  }
+  if (local_max == 0 || frame_size > local_max) {
+    return QuicDatagramErrorStatus::kProtocol;
+  }
+
+  std::size_t slot;
+  if (receive_count == received.size()) {
+    slot = receive_head;
+    receive_head = (receive_head + 1) % received.size();
+    dropped++;
+  } else {
+    slot = (receive_head + receive_count) % received.size();
+    receive_count++;
+  }
+  received[slot].packet = packet;
+  received[slot].data = frame.data;
+  return QuicDatagramErrorStatus::kSuccess;
+}
+
+bool QuicDatagramChannel::Receive(QuicReceivedDatagramV1& datagram) noexcept {
+  if (receive_count == 0) {
+    return false;
+  }
+  QuicReceivedDatagramV1& front = received[receive_head];
+  datagram.packet = std::move(front.packet);
+  datagram.data = front.data;
+  front.packet.Reset();
+  front.data = {};
+  receive_head = (receive_head + 1) % received.size();
+  receive_count--;
+  return true;
+}
+
+}  // namespace bedrock::network
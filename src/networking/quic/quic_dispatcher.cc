@@ -0,0 +1,185 @@
+#include "networking/quic/quic_dispatcher.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "networking/quic/quic_packet.h"
+
+namespace bedrock::network {
+
+namespace QuicDispatcherUtil {
+
+// FNV-1a, only used to spread connection attempts over the workers.
+static std::uint64_t HashConnectionID(
+    std::span<const std::uint8_t> connection_id) noexcept {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (auto byte : connection_id) {
+    hash = (hash ^ byte) * 0x100000001b3;
+  }
+  return hash;
+}
+
+}  // namespace QuicDispatcherUtil
+
+QuicDispatcher::QuicDispatcher(const QuicConnectionIDTable& connection_ids,
+                               std::size_t receivers, std::size_t workers,
+                               std::size_t ring_capacity,
+                               std::size_t retained_buffers) noexcept
+    : table(connection_ids),
+      receiver_count(std::max<std::size_t>(receivers, 1)),
+      worker_count(std::max<std::size_t>(workers, 1)),
+      spares(receiver_count) {
+  rings.reserve(receiver_count * worker_count);
+  for (std::size_t i = 0; i < receiver_count * worker_count; i++) {
+    rings.push_back(std::make_unique<Ring>(ring_capacity));
+  }
+  // Every slot of the receiver's rings, its spare and what handlers retain
+  std::size_t buffers =
+      worker_count * rings.front()->Capacity() + 1 + retained_buffers;
+  pools.reserve(receiver_count);
+  for (std::size_t i = 0; i < receiver_count; i++) {
+    pools.push_back(std::make_unique<QuicPacketBufferPool>(buffers));
+  }
+}
+
+QuicDispatcherErrorStatus QuicDispatcher::Receive(std::size_t receiver,
+                                                  Socket& socket) {
+  if (receiver >= receiver_count) {
+    return QuicDispatcherErrorStatus::kInvalidReceiver;
+  }
+  QuicPacketBufferRef& buffer = Spare(receiver);
+  Address peer;
+  if (!buffer) {
+    // Still read the datagram, so the caller does not spin on it
+    std::array<std::byte, 1> discarded;
+    auto returned = socket.ReadFrom(discarded, peer);
+    return returned.status == SocketErrorStatus::kSuccess
+               ? QuicDispatcherErrorStatus::kFull
+               : QuicDispatcherErrorStatus::kSocket;
+  }
+  auto returned =
+      socket.ReadFrom(std::as_writable_bytes(std::span(buffer->data)), peer);
+  if (returned.status != SocketErrorStatus::kSuccess) {
+    return QuicDispatcherErrorStatus::kSocket;
+  }
+  if (returned.data > buffer->data.size()) {
+    return QuicDispatcherErrorStatus::kTruncated;
+  }
+  buffer->size = returned.data;
+  return Enqueue(receiver, peer);
+}
+
+QuicDispatcherErrorStatus QuicDispatcher::Dispatch(
+    std::size_t receiver, std::span<const std::uint8_t> datagram,
+    const Address& peer) {
+  if (receiver >= receiver_count) {
+    return QuicDispatcherErrorStatus::kInvalidReceiver;
+  }
+  if (datagram.size() > kQuicMaxReceiveDatagramSize) {
+    return QuicDispatcherErrorStatus::kTruncated;
+  }
+  QuicPacketBufferRef& buffer = Spare(receiver);
+  if (!buffer) {
+    return QuicDispatcherErrorStatus::kFull;
+  }
+  std::memcpy(buffer->data.data(), datagram.data(), datagram.size());
+  buffer->size = datagram.size();
+  return Enqueue(receiver, peer);
+}
+
+QuicPacketBufferRef& QuicDispatcher::Spare(std::size_t receiver) noexcept {
+  QuicPacketBufferRef& buffer = spares[receiver];
+  if (!buffer) {
+    buffer = pools[receiver]->Allocate();
+  }
+  return buffer;
+}
+
+QuicDispatcherErrorStatus QuicDispatcher::Enqueue(
+    std::size_t receiver, const Address& peer) noexcept {
+  QuicPacketBufferRef& buffer = spares[receiver];
+  QuicConnectionHandle handle;
+  bool routed = false;
+  auto status = Route(buffer->Datagram(), handle, routed);
+  if (status != QuicDispatcherErrorStatus::kSuccess) {
+    return status;
+  }
+
+  Ring& ring = RingOf(receiver, handle.worker);
+  QuicReceivedDatagram* slot = ring.Reserve();
+  if (slot == nullptr) {
+    return QuicDispatcherErrorStatus::kFull;
+  }
+  // Drain() left the slot without a buffer, so the spare is empty after
+  // the move and the next datagram gets a fresh one.
+  slot->buffer = std::move(buffer);
+  slot->peer = peer;
+  slot->handle = handle;
+  slot->routed = routed;
+  ring.Push();
+  return QuicDispatcherErrorStatus::kSuccess;
+}
+
+// Long Header Packet {
+//   Header Form (1) = 1,
+//   Version-Specific Bits (7),
+//   Version (32),
+//   Destination Connection ID Length (8),
+//   Destination Connection ID (0..2040),
+//   ...
+// }
+// Short Header Packet {
+//   Header Form (1) = 0,
+//   Version-Specific Bits (7),
+//   Destination Connection ID (..),
+//   ...
+// }
+QuicDispatcherErrorStatus QuicDispatcher::Route(
+    std::span<const std::uint8_t> datagram, QuicConnectionHandle& handle,
+    bool& routed) const noexcept {
+  using Layout = QuicLongPacketHeaderLayout;
+
+  if (datagram.empty()) {
+    return QuicDispatcherErrorStatus::kMalformed;
+  }
+
+  if (!(datagram[0] & 0x80)) {
+    if (datagram.size() < 1 + table.ConnectionIDLength()) {
+      return QuicDispatcherErrorStatus::kMalformed;
+    }
+    if (!table.Find(table.ShortHeaderConnectionID(datagram), handle) ||
+        handle.worker >= worker_count) {
+      return QuicDispatcherErrorStatus::kUnknownConnection;
+    }
+    routed = true;
+    return QuicDispatcherErrorStatus::kSuccess;
+  }
+
+  if (datagram.size() < Layout::kSize) {
+    return QuicDispatcherErrorStatus::kMalformed;
+  }
+  std::size_t length =
+      Layout::DestinationConnectionIDLength::Load(datagram.data());
+  if (datagram.size() < Layout::kSize + length) {
+    return QuicDispatcherErrorStatus::kMalformed;
+  }
+  auto destination_connection_id = datagram.subspan(Layout::kSize, length);
+
+  if (length == table.ConnectionIDLength() &&
+      table.Find(destination_connection_id, handle) &&
+      handle.worker < worker_count) {
+    routed = true;
+    return QuicDispatcherErrorStatus::kSuccess;
+  }
+  handle = {};
+  handle.worker = static_cast<std::uint32_t>(
+      QuicDispatcherUtil::HashConnectionID(destination_connection_id) %
+      worker_count);
+  routed = false;
+  return QuicDispatcherErrorStatus::kSuccess;
+}
+
+}  // namespace bedrock::network
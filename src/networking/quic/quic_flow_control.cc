@@ -0,0 +1,118 @@
+#include "networking/quic/quic_flow_control.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bedrock::network {
+
+bool QuicFlowControlBudget::TryReserve(std::uint64_t bytes) noexcept {
+  std::uint64_t current = reserved.load(std::memory_order_relaxed);
+  do {
+    if (current + bytes > limit) {
+      return false;
+    }
+  } while (!reserved.compare_exchange_weak(current, current + bytes,
+                                           std::memory_order_relaxed));
+  return true;
+}
+
+QuicReceiveFlowController::QuicReceiveFlowController(
+    QuicReceiveFlowController&& other) noexcept
+    : window(other.window),
+      window_limit(other.window_limit),
+      max_data(other.max_data),
+      received(other.received),
+      consumed_offset(other.consumed_offset),
+      charged(std::exchange(other.charged, 0)),
+      budget(other.budget),
+      last_update(other.last_update) {}
+
+QuicReceiveFlowController& QuicReceiveFlowController::operator=(
+    QuicReceiveFlowController&& other) noexcept {
+  if (this != &other) {
+    ReleaseBudget();
+    window = other.window;
+    window_limit = other.window_limit;
+    max_data = other.max_data;
+    received = other.received;
+    consumed_offset = other.consumed_offset;
+    charged = std::exchange(other.charged, 0);
+    budget = other.budget;
+    last_update = other.last_update;
+  }
+  return *this;
+}
+
+QuicFlowControlErrorStatus QuicReceiveFlowController::OnDataReceived(
+    std::uint64_t largest_offset) noexcept {
+  if (largest_offset > max_data) {
+    return QuicFlowControlErrorStatus::kFlowControl;
+  }
+  received = std::max(received, largest_offset);
+  return QuicFlowControlErrorStatus::kSuccess;
+}
+
+bool QuicReceiveFlowController::OnDataConsumed(
+    std::uint64_t consumed, std::chrono::steady_clock::time_point now,
+    const QuicRTTEstimator& rtt) noexcept {
+  consumed_offset = std::max(consumed_offset, consumed);
+  if (max_data - consumed_offset > window / 2) {
+    return false;
+  }
+  // half a window consumed within two round trips of the last update:
+  // the window, not the reader, is what limits the rate
+  if (last_update != std::chrono::steady_clock::time_point{} &&
+      now - last_update < 2 * rtt.SmoothedRTT()) {
+    Grow(2 * window);
+  }
+  last_update = now;
+  max_data = consumed_offset + window;
+  return true;
+}
+
+void QuicReceiveFlowController::EnsureWindow(
+    std::uint64_t minimum_window) noexcept {
+  if (minimum_window > window) {
+    Grow(minimum_window);
+  }
+}
+
+void QuicReceiveFlowController::ReleaseBudget() noexcept {
+  if (budget != nullptr && charged != 0) {
+    budget->Release(charged);
+  }
+  charged = 0;
+}
+
+void QuicReceiveFlowController::Grow(std::uint64_t target) noexcept {
+  target = std::min(target, window_limit);
+  if (target <= window) {
+    return;
+  }
+  std::uint64_t growth = target - window;
+  if (budget != nullptr) {
+    // take what is left of the budget if the whole growth does not fit
+    while (!budget->TryReserve(growth)) {
+      std::uint64_t reserved = budget->Reserved();
+      std::uint64_t left =
+          budget->Limit() > reserved ? budget->Limit() - reserved : 0;
+      if (left == 0) {
+        return;
+      }
+      growth = std::min(growth, left);
+    }
+    charged += growth;
+  }
+  window += growth;
+}
+
+bool QuicStreamCreditController::OnStreamClosed() noexcept {
+  closed++;
+  if (closed + window - max_streams < std::max<std::uint64_t>(window / 2, 1)) {
+    return false;
+  }
+  max_streams = closed + window;
+  return true;
+}
+
+}  // namespace bedrock::network
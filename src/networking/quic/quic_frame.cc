@@ -0,0 +1,447 @@
+#include "networking/quic/quic_frame.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+namespace QuicFrameV1Util {
+
+using Parser = QuicFrameErrorStatus (*)(QuicWireReader& reader,
+                                        std::uint8_t type_byte,
+                                        QuicFrameV1& frame);
+
+static QuicFrameErrorStatus Finish(const QuicWireReader& reader) {
+  return reader.Ok() ? QuicFrameErrorStatus::kSuccess
+                     : QuicFrameErrorStatus::kTruncated;
+}
+
+// The end of STREAM and CRYPTO data can not exceed 2^62-1, the largest
+// variable-length integer (rfc9000 sections 19.6 and 19.8).
+static QuicFrameErrorStatus FinishData(const QuicWireReader& reader,
+                                       const QuicFrameV1& frame) {
+  if (reader.Ok() && frame.offset + frame.length > kQuicVarIntMax) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+  return Finish(reader);
+}
+
+static QuicFrameErrorStatus ParseUnknown(QuicWireReader&, std::uint8_t,
+                                         QuicFrameV1&) {
+  return QuicFrameErrorStatus::kUnknownType;
+}
+
+// The type byte is already consumed; the rest of the run of zero bytes is
+// skipped 8 bytes at a time.
+static QuicFrameErrorStatus ParsePadding(QuicWireReader& reader, std::uint8_t,
+                                         QuicFrameV1& frame) {
+  auto rest = reader.Rest();
+  std::size_t position = 0;
+
+  while (rest.size() - position >= 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, rest.data() + position, 8);
+    if (word != 0) {
+      if constexpr (std::endian::native == std::endian::little) {
+        position += static_cast<std::size_t>(std::countr_zero(word)) / 8;
+      } else {
+        position += static_cast<std::size_t>(std::countl_zero(word)) / 8;
+      }
+      break;
+    }
+    position += 8;
+  }
+  while (position < rest.size() && rest[position] == 0) {
+    position++;
+  }
+
+  reader.Skip(position);
+  frame.length = position + 1;
+  return QuicFrameErrorStatus::kSuccess;
+}
+
+static QuicFrameErrorStatus ParseEmpty(QuicWireReader&, std::uint8_t,
+                                       QuicFrameV1&) {
+  return QuicFrameErrorStatus::kSuccess;
+}
+
+// ACK Frame {
+//   Type (i) = 0x02..0x03,
+//   Largest Acknowledged (i),
+//   ACK Delay (i),
+//   ACK Range Count (i),
+//   First ACK Range (i),
+//   ACK Range (..) ...,
+//   [ECN Counts (..)],
+// }
+static QuicFrameErrorStatus ParseAck(QuicWireReader& reader,
+                                     std::uint8_t type_byte,
+                                     QuicFrameV1& frame) {
+  frame.flags = type_byte & kQuicAckFrameEcnBitV1;
+  frame.id = reader.ReadVarInt();
+  frame.extra = reader.ReadVarInt();
+  frame.length = reader.ReadVarInt();
+  frame.offset = reader.ReadVarInt();
+  if (!reader.Ok()) {
+    return QuicFrameErrorStatus::kTruncated;
+  }
+  if (frame.offset > frame.id) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+
+  auto ranges = reader.Rest();
+  std::size_t ranges_begin = reader.Position();
+  for (std::uint64_t i = 0; i < frame.length && reader.Ok(); i++) {
+    reader.ReadVarInt();
+    reader.ReadVarInt();
+  }
+  if (!reader.Ok()) {
+    return QuicFrameErrorStatus::kTruncated;
+  }
+  frame.data = ranges.first(reader.Position() - ranges_begin);
+
+  if (frame.flags & kQuicAckFrameEcnBitV1) {
+    auto ecn_counts = reader.Rest();
+    std::size_t ecn_begin = reader.Position();
+    reader.ReadVarInt();
+    reader.ReadVarInt();
+    reader.ReadVarInt();
+    if (reader.Ok()) {
+      frame.aux = ecn_counts.first(reader.Position() - ecn_begin);
+    }
+  }
+  return Finish(reader);
+}
+
+// RESET_STREAM Frame {
+//   Type (i) = 0x04,
+//   Stream ID (i),
+//   Application Protocol Error Code (i),
+//   Final Size (i),
+// }
+static QuicFrameErrorStatus ParseResetStream(QuicWireReader& reader,
+                                             std::uint8_t, QuicFrameV1& frame) {
+  frame.id = reader.ReadVarInt();
+  frame.extra = reader.ReadVarInt();
+  frame.offset = reader.ReadVarInt();
+  return Finish(reader);
+}
+
+// STOP_SENDING Frame {
+//   Type (i) = 0x05,
+//   Stream ID (i),
+//   Application Protocol Error Code (i),
+// }
+static QuicFrameErrorStatus ParseStopSending(QuicWireReader& reader,
+                                             std::uint8_t, QuicFrameV1& frame) {
+  frame.id = reader.ReadVarInt();
+  frame.extra = reader.ReadVarInt();
+  return Finish(reader);
+}
+
+// CRYPTO Frame {
+//   Type (i) = 0x06,
+//   Offset (i),
+//   Length (i),
+//   Crypto Data (..),
+// }
+static QuicFrameErrorStatus ParseCrypto(QuicWireReader& reader, std::uint8_t,
+                                        QuicFrameV1& frame) {
+  frame.offset = reader.ReadVarInt();
+  frame.length = reader.ReadVarInt();
+  frame.data = reader.ReadBytes(frame.length);
+  return FinishData(reader, frame);
+}
+
+// NEW_TOKEN Frame {
+//   Type (i) = 0x07,
+//   Token Length (i),
+//   Token (..),
+// }
+static QuicFrameErrorStatus ParseNewToken(QuicWireReader& reader, std::uint8_t,
+                                          QuicFrameV1& frame) {
+  frame.length = reader.ReadVarInt();
+  frame.data = reader.ReadBytes(frame.length);
+  if (reader.Ok() && frame.length == 0) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+  return Finish(reader);
+}
+
+// STREAM Frame {
+//   Type (i) = 0x08..0x0f,
+//   Stream ID (i),
+//   [Offset (i)],
+//   [Length (i)],
+//   Stream Data (..),
+// }
+static QuicFrameErrorStatus ParseStream(QuicWireReader& reader,
+                                        std::uint8_t type_byte,
+                                        QuicFrameV1& frame) {
+  frame.flags = type_byte & 0x07;
+  frame.id = reader.ReadVarInt();
+  if (type_byte & kQuicStreamFrameOffBitV1) {
+    frame.offset = reader.ReadVarInt();
+  }
+  if (type_byte & kQuicStreamFrameLenBitV1) {
+    frame.length = reader.ReadVarInt();
+  } else if (reader.Ok()) {
+    frame.length = reader.Remaining();
+  }
+  frame.data = reader.ReadBytes(frame.length);
+  return FinishData(reader, frame);
+}
+
+// MAX_DATA, MAX_STREAMS, DATA_BLOCKED and STREAMS_BLOCKED Frame {
+//   Type (i),
+//   Value (i),
+// }
+static QuicFrameErrorStatus ParseSingleValue(QuicWireReader& reader,
+                                             std::uint8_t, QuicFrameV1& frame) {
+  frame.offset = reader.ReadVarInt();
+  return Finish(reader);
+}
+
+// MAX_STREAMS and STREAMS_BLOCKED can not exceed 2^60 (rfc9000 section 19.11)
+static QuicFrameErrorStatus ParseStreamCount(QuicWireReader& reader,
+                                             std::uint8_t type_byte,
+                                             QuicFrameV1& frame) {
+  auto status = ParseSingleValue(reader, type_byte, frame);
+  if (status == QuicFrameErrorStatus::kSuccess &&
+      frame.offset > (std::uint64_t{1} << 60)) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+  return status;
+}
+
+// MAX_STREAM_DATA and STREAM_DATA_BLOCKED Frame {
+//   Type (i),
+//   Stream ID (i),
+//   Value (i),
+// }
+static QuicFrameErrorStatus ParseStreamValue(QuicWireReader& reader,
+                                             std::uint8_t, QuicFrameV1& frame) {
+  frame.id = reader.ReadVarInt();
+  frame.offset = reader.ReadVarInt();
+  return Finish(reader);
+}
+
+// NEW_CONNECTION_ID Frame {
+//   Type (i) = 0x18,
+//   Sequence Number (i),
+//   Retire Prior To (i),
+//   Length (8),
+//   Connection ID (8..160),
+//   Stateless Reset Token (128),
+// }
+static QuicFrameErrorStatus ParseNewConnectionID(QuicWireReader& reader,
+                                                 std::uint8_t,
+                                                 QuicFrameV1& frame) {
+  frame.id = reader.ReadVarInt();
+  frame.offset = reader.ReadVarInt();
+  frame.length = reader.Read<std::uint8_t>();
+  if (!reader.Ok()) {
+    return QuicFrameErrorStatus::kTruncated;
+  }
+  if (frame.length < 1 || frame.length > 20 || frame.offset > frame.id) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+  frame.data = reader.ReadBytes(frame.length);
+  frame.aux = reader.ReadBytes(kQuicStatelessResetTokenLengthV1);
+  return Finish(reader);
+}
+
+// RETIRE_CONNECTION_ID Frame {
+//   Type (i) = 0x19,
+//   Sequence Number (i),
+// }
+static QuicFrameErrorStatus ParseRetireConnectionID(QuicWireReader& reader,
+                                                    std::uint8_t,
+                                                    QuicFrameV1& frame) {
+  frame.id = reader.ReadVarInt();
+  return Finish(reader);
+}
+
+// PATH_CHALLENGE and PATH_RESPONSE Frame {
+//   Type (i),
+//   Data (64),
+// }
+static QuicFrameErrorStatus ParsePath(QuicWireReader& reader, std::uint8_t,
+                                      QuicFrameV1& frame) {
+  frame.data = reader.ReadBytes(kQuicPathChallengeDataLengthV1);
+  return Finish(reader);
+}
+
+// CONNECTION_CLOSE Frame {
+//   Type (i) = 0x1c..0x1d,
+//   Error Code (i),
+//   [Frame Type (i)],
+//   Reason Phrase Length (i),
+//   Reason Phrase (..),
+// }
+static QuicFrameErrorStatus ParseConnectionClose(QuicWireReader& reader,
+                                                 std::uint8_t type_byte,
+                                                 QuicFrameV1& frame) {
+  frame.extra = reader.ReadVarInt();
+  if (type_byte ==
+      static_cast<std::uint8_t>(QuicFrameTypeV1::kConnectionClose)) {
+    frame.offset = reader.ReadVarInt();
+  }
+  frame.length = reader.ReadVarInt();
+  frame.data = reader.ReadBytes(frame.length);
+  return Finish(reader);
+}
+
+// DATAGRAM Frame {
+//   Type (i) = 0x30..0x31,
+//   [Length (i)],
+//   Datagram Data (..),
+// }
+static QuicFrameErrorStatus ParseDatagram(QuicWireReader& reader,
+                                          std::uint8_t type_byte,
+                                          QuicFrameV1& frame) {
+  frame.flags = type_byte & kQuicDatagramFrameLenBitV1;
+  if (type_byte & kQuicDatagramFrameLenBitV1) {
+    frame.length = reader.ReadVarInt();
+  } else if (reader.Ok()) {
+    frame.length = reader.Remaining();
+  }
+  frame.data = reader.ReadBytes(frame.length);
+  return Finish(reader);
+}
+
+struct TableEntry {
+ public:
+  Parser parse = ParseUnknown;
+  QuicFrameTypeV1 type = QuicFrameTypeV1::kPadding;
+};
+
+// Every frame type of rfc9000 and rfc9221 fits in a single byte
+// variable-length integer, so the first payload byte indexes this table
+// directly.
+static constexpr std::array<TableEntry, 64> kFrameTable = [] {
+  std::array<TableEntry, 64> table{};
+  auto set = [&table](QuicFrameTypeV1 type, Parser parse) {
+    table[static_cast<std::size_t>(type)] = {parse, type};
+  };
+
+  set(QuicFrameTypeV1::kPadding, ParsePadding);
+  set(QuicFrameTypeV1::kPing, ParseEmpty);
+  table[0x02] = {ParseAck, QuicFrameTypeV1::kAck};
+  table[0x03] = {ParseAck, QuicFrameTypeV1::kAck};
+  set(QuicFrameTypeV1::kResetStream, ParseResetStream);
+  set(QuicFrameTypeV1::kStopSending, ParseStopSending);
+  set(QuicFrameTypeV1::kCrypto, ParseCrypto);
+  set(QuicFrameTypeV1::kNewToken, ParseNewToken);
+  for (std::size_t i = 0x08; i <= 0x0f; i++) {
+    table[i] = {ParseStream, QuicFrameTypeV1::kStream};
+  }
+  set(QuicFrameTypeV1::kMaxData, ParseSingleValue);
+  set(QuicFrameTypeV1::kMaxStreamData, ParseStreamValue);
+  set(QuicFrameTypeV1::kMaxStreamsBidi, ParseStreamCount);
+  set(QuicFrameTypeV1::kMaxStreamsUni, ParseStreamCount);
+  set(QuicFrameTypeV1::kDataBlocked, ParseSingleValue);
+  set(QuicFrameTypeV1::kStreamDataBlocked, ParseStreamValue);
+  set(QuicFrameTypeV1::kStreamsBlockedBidi, ParseStreamCount);
+  set(QuicFrameTypeV1::kStreamsBlockedUni, ParseStreamCount);
+  set(QuicFrameTypeV1::kNewConnectionID, ParseNewConnectionID);
+  set(QuicFrameTypeV1::kRetireConnectionID, ParseRetireConnectionID);
+  set(QuicFrameTypeV1::kPathChallenge, ParsePath);
+  set(QuicFrameTypeV1::kPathResponse, ParsePath);
+  set(QuicFrameTypeV1::kConnectionClose, ParseConnectionClose);
+  set(QuicFrameTypeV1::kConnectionCloseApplication, ParseConnectionClose);
+  set(QuicFrameTypeV1::kHandshakeDone, ParseEmpty);
+  table[0x30] = {ParseDatagram, QuicFrameTypeV1::kDatagram};
+  table[0x31] = {ParseDatagram, QuicFrameTypeV1::kDatagram};
+  return table;
+}();
+
+}  // namespace QuicFrameV1Util
+
+QuicAckRangeIteratorV1::QuicAckRangeIteratorV1(
+    const QuicFrameV1& ack_frame) noexcept
+    : ranges(ack_frame.data),
+      remaining(ack_frame.length),
+      next_largest(ack_frame.id),
+      first_range(ack_frame.offset) {}
+
+QuicFrameErrorStatus QuicAckRangeIteratorV1::Next(
+    QuicAckRangeV1& range) noexcept {
+  if (first) {
+    first = false;
+    if (first_range > next_largest) {
+      return QuicFrameErrorStatus::kMalformed;
+    }
+    range = {next_largest - first_range, next_largest};
+    previous_smallest = range.smallest;
+    return QuicFrameErrorStatus::kSuccess;
+  }
+  if (remaining == 0) {
+    return QuicFrameErrorStatus::kEnd;
+  }
+
+  QuicWireReader reader(ranges, position);
+  std::uint64_t gap = reader.ReadVarInt();
+  std::uint64_t length = reader.ReadVarInt();
+  if (!reader.Ok()) {
+    return QuicFrameErrorStatus::kTruncated;
+  }
+  position = reader.Position();
+  remaining--;
+
+  // previous smallest - gap - 2 is the largest of this range
+  if (previous_smallest < gap + 2 || previous_smallest - gap - 2 < length) {
+    return QuicFrameErrorStatus::kMalformed;
+  }
+  range.largest = previous_smallest - gap - 2;
+  range.smallest = range.largest - length;
+  previous_smallest = range.smallest;
+  return QuicFrameErrorStatus::kSuccess;
+}
+
+QuicFrameErrorStatus QuicFrameDecoderV1::Next(QuicFrameV1& frame) noexcept {
+  while (position < payload.size()) {
+    std::uint8_t type_byte = payload[position];
+    if (type_byte >= QuicFrameV1Util::kFrameTable.size()) {
+      return QuicFrameErrorStatus::kUnknownType;
+    }
+    const auto& entry = QuicFrameV1Util::kFrameTable[type_byte];
+
+    frame = {};
+    frame.type = entry.type;
+    QuicWireReader reader(payload, position + 1);
+    auto status = entry.parse(reader, type_byte, frame);
+    if (status != QuicFrameErrorStatus::kSuccess) {
+      return status;
+    }
+    position = reader.Position();
+
+    if (!skip_padding || frame.type != QuicFrameTypeV1::kPadding) {
+      return QuicFrameErrorStatus::kSuccess;
+    }
+  }
+
+  return QuicFrameErrorStatus::kEnd;
+}
+
+std::size_t QuicFrameDecoderV1::Decode(std::span<QuicFrameV1> frames,
+                                       QuicFrameErrorStatus& status) noexcept {
+  std::size_t count = 0;
+  status = QuicFrameErrorStatus::kSuccess;
+  while (count < frames.size()) {
+    status = Next(frames[count]);
+    if (status != QuicFrameErrorStatus::kSuccess) {
+      return count;
+    }
+    count++;
+  }
+  if (Empty()) {
+    status = QuicFrameErrorStatus::kEnd;
+  }
+  return count;
+}
+
+}  // namespace bedrock::network
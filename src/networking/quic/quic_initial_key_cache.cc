@@ -0,0 +1,121 @@
+#include "networking/quic/quic_initial_key_cache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <random>
+
+namespace bedrock::network {
+
+static std::array<std::uint8_t, kQuicAES128KeySize> RandomKey() noexcept {
+  std::random_device device;
+  std::array<std::uint8_t, kQuicAES128KeySize> key;
+  for (std::size_t i = 0; i < key.size(); i += 4) {
+    std::uint32_t value = device();
+    std::memcpy(key.data() + i, &value, 4);
+  }
+  return key;
+}
+
+QuicInitialKeyCache::QuicInitialKeyCache(std::size_t capacity) noexcept
+    : QuicInitialKeyCache(capacity, RandomKey()) {}
+
+QuicInitialKeyCache::QuicInitialKeyCache(
+    std::size_t capacity,
+    std::span<const std::uint8_t, kQuicAES128KeySize> key) noexcept
+    : hash_key(key) {
+  std::size_t buckets = std::bit_ceil(std::max<std::size_t>(
+      1, (capacity + kQuicInitialKeyCacheWays - 1) / kQuicInitialKeyCacheWays));
+  entries = std::make_unique<Entry[]>(buckets * kQuicInitialKeyCacheWays);
+  hands = std::make_unique<std::uint8_t[]>(buckets);
+  mask = buckets - 1;
+}
+
+// CBC-MAC under the secret key over version, length and DCID, zero padded
+// to exactly two blocks.
+std::size_t QuicInitialKeyCache::Bucket(
+    std::uint32_t version,
+    std::span<const std::uint8_t> destination_connection_id) const noexcept {
+  std::array<std::uint8_t, 2 * kQuicAESBlockSize> input{};
+  std::memcpy(input.data(), &version, sizeof(version));
+  input[sizeof(version)] =
+      static_cast<std::uint8_t>(destination_connection_id.size());
+  std::memcpy(input.data() + sizeof(version) + 1,
+              destination_connection_id.data(),
+              destination_connection_id.size());
+
+  std::array<std::uint8_t, kQuicAESBlockSize> block;
+  hash_key.EncryptBlock(input.data(), block.data());
+  for (std::size_t i = 0; i < kQuicAESBlockSize; i++) {
+    block[i] ^= input[kQuicAESBlockSize + i];
+  }
+  hash_key.EncryptBlock(block.data(), block.data());
+  std::uint64_t hash;
+  std::memcpy(&hash, block.data(), sizeof(hash));
+  return hash & mask;
+}
+
+const QuicInitialKeys& QuicInitialKeyCache::Find(
+    std::uint32_t version,
+    std::span<const std::uint8_t> destination_connection_id,
+    Derive derive) noexcept {
+  if (destination_connection_id.size() > kQuicMaxConnectionIDLength) {
+    misses++;
+    derive(destination_connection_id, uncached);
+    return uncached;
+  }
+
+  std::size_t index = Bucket(version, destination_connection_id);
+  Entry* bucket = entries.get() + index * kQuicInitialKeyCacheWays;
+  Entry* empty = nullptr;
+  for (std::size_t way = 0; way < kQuicInitialKeyCacheWays; way++) {
+    Entry& entry = bucket[way];
+    if (!entry.valid) {
+      empty = empty ? empty : &entry;
+      continue;
+    }
+    if (entry.version == version &&
+        entry.length == destination_connection_id.size() &&
+        std::equal(destination_connection_id.begin(),
+                   destination_connection_id.end(),
+                   entry.connection_id.begin())) {
+      hits++;
+      entry.referenced = true;
+      return entry.keys;
+    }
+  }
+
+  // The oldest unreferenced entry goes first, so a new connection outlives
+  // the next few flood entries landing in its bucket.
+  misses++;
+  Entry* victim = empty;
+  for (std::size_t way = 0; way < kQuicInitialKeyCacheWays && !empty;
+       way++) {
+    Entry& entry = bucket[way];
+    if (!entry.referenced &&
+        (!victim || entry.inserted < victim->inserted)) {
+      victim = &entry;
+    }
+  }
+  if (!victim) {
+    // Every entry was reused since its bit was last cleared. Keep them all
+    // and age the one under the hand; a later miss may take its slot.
+    std::uint8_t& hand = hands[index];
+    bucket[hand].referenced = false;
+    hand = static_cast<std::uint8_t>((hand + 1) % kQuicInitialKeyCacheWays);
+    derive(destination_connection_id, uncached);
+    return uncached;
+  }
+
+  victim->valid = true;
+  victim->inserted = misses;
+  victim->referenced = false;
+  victim->version = version;
+  victim->length = static_cast<std::uint8_t>(destination_connection_id.size());
+  std::copy(destination_connection_id.begin(),
+            destination_connection_id.end(), victim->connection_id.begin());
+  derive(destination_connection_id, victim->keys);
+  return victim->keys;
+}
+
+}  // namespace bedrock::network
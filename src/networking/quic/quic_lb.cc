@@ -0,0 +1,289 @@
+#include "networking/quic/quic_lb.h"
+
+#include <tmmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace bedrock::network {
+
+namespace QuicLBUtil {
+
+using Block = std::array<std::uint8_t, kQuicAESBlockSize>;
+
+// Masks and byte shuffles of the Feistel network for one plaintext length.
+struct FeistelConstants {
+ public:
+  std::size_t half = 0;
+  Block left_mask{};
+  Block right_mask{};
+  Block to_back{};    // moves the first half bytes to the end of a block
+  Block from_back{};  // moves the last half bytes to the front
+};
+
+static constexpr FeistelConstants MakeFeistelConstants(std::size_t length) {
+  FeistelConstants constants;
+  std::size_t half = (length + 1) / 2;
+  constants.half = half;
+  for (std::size_t i = 0; i < kQuicAESBlockSize; i++) {
+    constants.left_mask[i] = i < half ? 0xFF : 0x00;
+    constants.right_mask[i] = constants.left_mask[i];
+    // pshufb zeroes bytes whose index has the high bit set
+    constants.to_back[i] = i >= kQuicAESBlockSize - half
+                               ? static_cast<std::uint8_t>(
+                                     i - (kQuicAESBlockSize - half))
+                               : 0x80;
+    constants.from_back[i] =
+        i < half ? static_cast<std::uint8_t>(kQuicAESBlockSize - half + i)
+                 : 0x80;
+  }
+  if (length & 1) {
+    constants.left_mask[half - 1] = 0xF0;
+    constants.right_mask[0] = 0x0F;
+  }
+  return constants;
+}
+
+static constexpr auto kFeistelConstants = [] {
+  std::array<FeistelConstants, kQuicLBMaxPlaintextLength + 1> table;
+  for (std::size_t length = 1; length < table.size(); length++) {
+    table[length] = MakeFeistelConstants(length);
+  }
+  return table;
+}();
+
+static __m128i Load(const std::uint8_t* source) noexcept {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+static __m128i EncryptBlock(const QuicAES128& cipher, __m128i block) noexcept {
+  alignas(16) Block bytes;
+  _mm_store_si128(reinterpret_cast<__m128i*>(bytes.data()), block);
+  cipher.EncryptBlock(bytes.data(), bytes.data());
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(bytes.data()));
+}
+
+// The four pass Feistel network for Server ID and Nonce lengths other than
+// one AES block. The plaintext is split into halves of (length + 1) / 2
+// bytes; for an odd length the middle byte is split by nibble, the high one
+// to the left half. Each pass encrypts one half, padded to a block with the
+// plaintext length and pass index, and XORs the result into the other half.
+// Both halves stay in registers, so a pass is one AES block and a few
+// shuffles.
+class Feistel {
+ public:
+  explicit Feistel(std::size_t plaintext_length) noexcept
+      : length(plaintext_length),
+        constants(kFeistelConstants[plaintext_length]) {}
+
+  std::size_t Half() const noexcept { return constants.half; }
+  bool Odd() const noexcept { return length & 1; }
+
+  void Split(const std::uint8_t* text) noexcept {
+    std::array<std::uint8_t, 2 * kQuicAESBlockSize> buffer{};
+    std::memcpy(buffer.data(), text, length);
+    left =
+        _mm_and_si128(Load(buffer.data()), Load(constants.left_mask.data()));
+    right = _mm_and_si128(Load(buffer.data() + length - constants.half),
+                          Load(constants.right_mask.data()));
+  }
+
+  // The halves only share the middle nibbles, so OR-ing them in place
+  // rebuilds the text.
+  void Merge(std::uint8_t* text) const noexcept {
+    std::array<std::uint8_t, 2 * kQuicAESBlockSize> buffer{};
+    auto* back = reinterpret_cast<__m128i*>(buffer.data() + length -
+                                            constants.half);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer.data()), left);
+    _mm_storeu_si128(back, _mm_or_si128(_mm_loadu_si128(back), right));
+    std::memcpy(text, buffer.data(), length);
+  }
+
+  // right ^= truncate_right(AES(expand_left(left, index)))
+  void LeftPass(const QuicAES128& cipher, int index) noexcept {
+    __m128i block = _mm_or_si128(left, _mm_slli_si128(Tweak(index), 14));
+    block = _mm_shuffle_epi8(EncryptBlock(cipher, block),
+                             Load(constants.from_back.data()));
+    right = _mm_xor_si128(
+        right, _mm_and_si128(block, Load(constants.right_mask.data())));
+  }
+
+  // left ^= truncate_left(AES(expand_right(right, index)))
+  void RightPass(const QuicAES128& cipher, int index) noexcept {
+    __m128i block =
+        _mm_or_si128(_mm_shuffle_epi8(right, Load(constants.to_back.data())),
+                     Tweak(index));
+    block = EncryptBlock(cipher, block);
+    left = _mm_xor_si128(
+        left, _mm_and_si128(block, Load(constants.left_mask.data())));
+  }
+
+ private:
+  // plaintext length and pass index in the first two bytes
+  __m128i Tweak(int index) const noexcept {
+    return _mm_cvtsi32_si128(static_cast<int>(length) | index << 8);
+  }
+
+  std::size_t length = 0;
+  const FeistelConstants& constants;
+  __m128i left = _mm_setzero_si128();
+  __m128i right = _mm_setzero_si128();
+};
+
+// splitmix64
+static std::uint64_t NextRandom(std::uint64_t& state) noexcept {
+  std::uint64_t z = (state += 0x9E3779B97F4A7C15);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+}  // namespace QuicLBUtil
+
+bool QuicLBConfig::IsValid() const noexcept {
+  return config_id < kQuicLBUnroutableConfigID && server_id_length >= 1 &&
+         server_id_length <= kQuicLBMaxServerIDLength &&
+         nonce_length >= kQuicLBMinNonceLength &&
+         nonce_length <= kQuicLBMaxNonceLength &&
+         std::size_t{server_id_length} + nonce_length <=
+             kQuicLBMaxPlaintextLength;
+}
+
+QuicLBConnectionIDGenerator::QuicLBConnectionIDGenerator(
+    const QuicLBConfig& lb_config,
+    std::span<const std::uint8_t> id) noexcept
+    : config(lb_config) {
+  if (!config.IsValid() || id.size() != config.server_id_length) {
+    return;
+  }
+  std::copy(id.begin(), id.end(), server_id.begin());
+  if (config.encrypted) {
+    cipher.SetKey(config.key);
+  }
+
+  std::random_device device;
+  random_state = (std::uint64_t{device()} << 32) | device();
+  for (auto& byte : nonce_prefix) {
+    byte = static_cast<std::uint8_t>(Random());
+  }
+  counter = Random();
+  valid = true;
+}
+
+std::uint64_t QuicLBConnectionIDGenerator::Random() noexcept {
+  return QuicLBUtil::NextRandom(random_state);
+}
+
+QuicLBErrorStatus QuicLBConnectionIDGenerator::Generate(
+    std::span<std::uint8_t> connection_id) noexcept {
+  if (!valid || connection_id.size() < ConnectionIDLength()) {
+    return QuicLBErrorStatus::kInvalid;
+  }
+
+  std::size_t nonce_length = config.nonce_length;
+  std::size_t counter_length = std::min<std::size_t>(nonce_length, 8);
+  if (config.encrypted && counter_length < 8 &&
+      issued >> (counter_length * 8) != 0) {
+    return QuicLBErrorStatus::kExhausted;
+  }
+
+  std::uint8_t first_byte = static_cast<std::uint8_t>(config.config_id << 5);
+  if (config.length_self_description) {
+    first_byte |= static_cast<std::uint8_t>(ConnectionIDLength() - 1);
+  } else {
+    first_byte |= static_cast<std::uint8_t>(Random() & 0x1F);
+  }
+
+  std::array<std::uint8_t, kQuicLBMaxPlaintextLength> plaintext;
+  std::memcpy(plaintext.data(), server_id.data(), config.server_id_length);
+  std::uint8_t* nonce = plaintext.data() + config.server_id_length;
+  if (config.encrypted) {
+    std::memcpy(nonce, nonce_prefix.data(), nonce_length - counter_length);
+    std::uint64_t value = counter + issued;
+    for (std::size_t i = nonce_length; i > nonce_length - counter_length;
+         i--) {
+      nonce[i - 1] = static_cast<std::uint8_t>(value);
+      value >>= 8;
+    }
+  } else {
+    for (std::size_t i = 0; i < nonce_length; i += 8) {
+      std::uint64_t value = Random();
+      std::memcpy(nonce + i, &value,
+                  std::min<std::size_t>(8, nonce_length - i));
+    }
+  }
+  issued++;
+
+  connection_id[0] = first_byte;
+  std::size_t length = config.server_id_length + nonce_length;
+  if (!config.encrypted) {
+    std::memcpy(connection_id.data() + 1, plaintext.data(), length);
+  } else if (length == kQuicAESBlockSize) {
+    cipher.EncryptBlock(plaintext.data(), connection_id.data() + 1);
+  } else {
+    QuicLBUtil::Feistel feistel(length);
+    feistel.Split(plaintext.data());
+    feistel.LeftPass(cipher, 1);
+    feistel.RightPass(cipher, 2);
+    feistel.LeftPass(cipher, 3);
+    feistel.RightPass(cipher, 4);
+    feistel.Merge(connection_id.data() + 1);
+  }
+  return QuicLBErrorStatus::kSuccess;
+}
+
+QuicLBConnectionIDDecoder::QuicLBConnectionIDDecoder(
+    const QuicLBConfig& lb_config) noexcept
+    : config(lb_config) {
+  if (!config.IsValid()) {
+    return;
+  }
+  if (config.encrypted) {
+    cipher.SetKey(config.key);
+  }
+  valid = true;
+}
+
+QuicLBErrorStatus QuicLBConnectionIDDecoder::ServerID(
+    std::span<const std::uint8_t> connection_id,
+    std::span<std::uint8_t> server_id) const noexcept {
+  if (!valid || server_id.size() < config.server_id_length) {
+    return QuicLBErrorStatus::kInvalid;
+  }
+  if (connection_id.size() < config.ConnectionIDLength()) {
+    return QuicLBErrorStatus::kLength;
+  }
+  if (ConfigID(connection_id[0]) != config.config_id) {
+    return QuicLBErrorStatus::kConfig;
+  }
+
+  const std::uint8_t* ciphertext = connection_id.data() + 1;
+  std::size_t length = std::size_t{config.server_id_length} +
+                       config.nonce_length;
+  if (!config.encrypted) {
+    std::memcpy(server_id.data(), ciphertext, config.server_id_length);
+    return QuicLBErrorStatus::kSuccess;
+  }
+
+  std::array<std::uint8_t, kQuicLBMaxPlaintextLength> plaintext;
+  if (length == kQuicAESBlockSize) {
+    cipher.DecryptBlock(ciphertext, plaintext.data());
+  } else {
+    QuicLBUtil::Feistel feistel(length);
+    feistel.Split(ciphertext);
+    feistel.RightPass(cipher, 4);
+    feistel.LeftPass(cipher, 3);
+    feistel.RightPass(cipher, 2);
+    // The last pass only changes the right half; skip it when the Server
+    // ID lies entirely in the bytes of the left half.
+    if (config.server_id_length > feistel.Half() - feistel.Odd()) {
+      feistel.LeftPass(cipher, 1);
+    }
+    feistel.Merge(plaintext.data());
+  }
+  std::memcpy(server_id.data(), plaintext.data(), config.server_id_length);
+  return QuicLBErrorStatus::kSuccess;
+}
+
+}  // namespace bedrock::network
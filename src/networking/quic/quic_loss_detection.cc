@@ -0,0 +1,347 @@
+#include "networking/quic/quic_loss_detection.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace bedrock::network {
+
+using std::chrono::microseconds;
+using TimePoint = std::chrono::steady_clock::time_point;
+
+void QuicRTTEstimator::Update(microseconds latest_rtt,
+                              microseconds ack_delay) noexcept {
+  latest = latest_rtt;
+  if (!has_sample) {
+    has_sample = true;
+    min = latest_rtt;
+    smoothed = latest_rtt;
+    variance = latest_rtt / 2;
+    return;
+  }
+
+  min = std::min(min, latest_rtt);
+  // never let ack delay push the sample below min_rtt
+  microseconds adjusted = latest_rtt;
+  if (latest_rtt >= min + ack_delay) {
+    adjusted = latest_rtt - ack_delay;
+  }
+  microseconds deviation =
+      smoothed > adjusted ? smoothed - adjusted : adjusted - smoothed;
+  variance = (3 * variance + deviation) / 4;
+  smoothed = (7 * smoothed + adjusted) / 8;
+}
+
+microseconds QuicRTTEstimator::ProbeTimeout() const noexcept {
+  return smoothed + std::max(4 * variance, kQuicTimerGranularity);
+}
+
+microseconds QuicRTTEstimator::LossDelay() const noexcept {
+  microseconds delay = std::max(latest, smoothed) *
+                       kQuicTimeThresholdNumerator /
+                       kQuicTimeThresholdDenominator;
+  return std::max(delay, kQuicTimerGranularity);
+}
+
+QuicSentPacketRing::QuicSentPacketRing(std::size_t capacity) noexcept {
+  std::size_t size = std::bit_ceil(std::max<std::size_t>(capacity, 1));
+  packets = std::make_unique<QuicSentPacket[]>(size);
+  mask = size - 1;
+}
+
+QuicLossDetectionErrorStatus QuicSentPacketRing::Add(
+    std::uint64_t packet_number, const QuicSentPacket& packet) noexcept {
+  if (packet_number < next) {
+    return QuicLossDetectionErrorStatus::kInvalid;
+  }
+  if (packet_number - first > mask) {
+    return QuicLossDetectionErrorStatus::kNoSpace;
+  }
+  for (; next < packet_number; next++) {
+    At(next).state = QuicSentPacketState::kEmpty;
+  }
+  At(next++) = packet;
+  Advance();
+  return QuicLossDetectionErrorStatus::kSuccess;
+}
+
+void QuicSentPacketRing::Advance() noexcept {
+  while (first < next && At(first).state != QuicSentPacketState::kInFlight) {
+    first++;
+  }
+}
+
+void QuicSentPacketRing::Clear() noexcept { first = next; }
+
+QuicLossDetection::QuicLossDetection(
+    std::size_t max_packets_in_flight) noexcept
+    : spaces{PacketNumberSpace(kQuicHandshakeMaxPacketsInFlight),
+             PacketNumberSpace(kQuicHandshakeMaxPacketsInFlight),
+             PacketNumberSpace(max_packets_in_flight)} {}
+
+QuicLossDetectionErrorStatus QuicLossDetection::OnPacketSent(
+    QuicPacketNumberSpaceV1 space, std::uint64_t packet_number,
+    std::uint32_t bytes, bool ack_eliciting, bool in_flight,
+    TimePoint now) noexcept {
+  PacketNumberSpace& pn_space = Space(space);
+  QuicSentPacket packet;
+  packet.time_sent = now;
+  packet.bytes = bytes;
+  packet.ack_eliciting = ack_eliciting;
+  packet.in_flight = in_flight;
+  // packets that are neither tracked for loss nor congestion are released
+  // right away
+  packet.state = ack_eliciting || in_flight ? QuicSentPacketState::kInFlight
+                                            : QuicSentPacketState::kEmpty;
+  QuicLossDetectionErrorStatus status =
+      pn_space.sent.Add(packet_number, packet);
+  if (status != QuicLossDetectionErrorStatus::kSuccess) {
+    return status;
+  }
+
+  if (in_flight) {
+    bytes_in_flight += bytes;
+  }
+  if (ack_eliciting && in_flight) {
+    pn_space.ack_eliciting_in_flight++;
+    pn_space.last_ack_eliciting_time = now;
+  }
+  return QuicLossDetectionErrorStatus::kSuccess;
+}
+
+QuicLossDetectionErrorStatus QuicLossDetection::OnAckReceived(
+    QuicPacketNumberSpaceV1 space, std::span<const QuicAckRangeV1> ranges,
+    microseconds ack_delay, TimePoint now, std::span<std::uint64_t> lost,
+    QuicLossDetectionOutcome& outcome) noexcept {
+  outcome = QuicLossDetectionOutcome();
+  PacketNumberSpace& pn_space = Space(space);
+  QuicSentPacketRing& sent = pn_space.sent;
+  if (ranges.empty()) {
+    return QuicLossDetectionErrorStatus::kSuccess;
+  }
+  std::uint64_t largest = ranges[0].largest;
+  if (largest >= sent.Next()) {
+    return QuicLossDetectionErrorStatus::kInvalid;
+  }
+  if (!pn_space.has_largest_acked || largest > pn_space.largest_acked) {
+    pn_space.largest_acked = largest;
+    pn_space.has_largest_acked = true;
+  }
+
+  bool largest_newly_acked = false;
+  bool ack_eliciting_acked = false;
+  for (const QuicAckRangeV1& range : ranges) {
+    if (range.largest < sent.First()) {
+      break;
+    }
+    for (std::uint64_t pn = std::max(range.smallest, sent.First());
+         pn <= range.largest; pn++) {
+      QuicSentPacket& packet = sent.At(pn);
+      if (packet.state != QuicSentPacketState::kInFlight) {
+        continue;
+      }
+      packet.state = QuicSentPacketState::kAcked;
+      OnPacketLeftFlight(pn_space, packet);
+      if (packet.in_flight) {
+        outcome.acked_bytes += packet.bytes;
+      }
+      outcome.acked_packets++;
+      ack_eliciting_acked |= packet.ack_eliciting;
+      if (pn == largest) {
+        largest_newly_acked = true;
+      }
+      outcome.largest_acked_time_sent =
+          std::max(outcome.largest_acked_time_sent, packet.time_sent);
+    }
+  }
+  if (outcome.acked_packets == 0) {
+    return QuicLossDetectionErrorStatus::kSuccess;
+  }
+
+  // rfc9002 section 5.1: only a newly acknowledged, ack-eliciting largest
+  // packet gives an RTT sample
+  if (largest_newly_acked && ack_eliciting_acked) {
+    if (space != QuicPacketNumberSpaceV1::kApplicationData) {
+      ack_delay = microseconds(0);
+    } else if (handshake_confirmed) {
+      ack_delay = std::min(ack_delay, peer_max_ack_delay);
+    }
+    if (!rtt.HasSample()) {
+      first_rtt_sample_time = now;
+    }
+    rtt.Update(std::chrono::duration_cast<microseconds>(
+                   now - sent.At(largest).time_sent),
+               ack_delay);
+    outcome.rtt_updated = true;
+  }
+
+  DetectLostPackets(pn_space, now, lost, outcome);
+  pto_count = 0;
+  sent.Advance();
+  return QuicLossDetectionErrorStatus::kSuccess;
+}
+
+// rfc9002 appendix A.10
+void QuicLossDetection::DetectLostPackets(
+    PacketNumberSpace& pn_space, TimePoint now,
+    std::span<std::uint64_t> lost,
+    QuicLossDetectionOutcome& outcome) noexcept {
+  QuicSentPacketRing& sent = pn_space.sent;
+  pn_space.loss_time = TimePoint::max();
+  if (!pn_space.has_largest_acked) {
+    return;
+  }
+
+  microseconds loss_delay = rtt.LossDelay();
+  TimePoint lost_send_time = now - loss_delay;
+  microseconds congestion_period =
+      (rtt.ProbeTimeout() + peer_max_ack_delay) *
+      kQuicPersistentCongestionThreshold;
+  // sent time of the first packet in the current run of lost ack-eliciting
+  // packets with no acknowledged packet in between
+  TimePoint run_start = TimePoint::max();
+
+  std::uint64_t end = std::min(pn_space.largest_acked + 1, sent.Next());
+  for (std::uint64_t pn = sent.First(); pn < end; pn++) {
+    QuicSentPacket& packet = sent.At(pn);
+    if (packet.state == QuicSentPacketState::kAcked) {
+      run_start = TimePoint::max();
+      continue;
+    }
+    if (packet.state != QuicSentPacketState::kInFlight) {
+      continue;
+    }
+    if (packet.time_sent > lost_send_time &&
+        pn_space.largest_acked < pn + kQuicPacketThreshold) {
+      pn_space.loss_time =
+          std::min(pn_space.loss_time, packet.time_sent + loss_delay);
+      continue;
+    }
+    if (outcome.lost_packets == lost.size()) {
+      // output full, the timer picks up the rest right away
+      pn_space.loss_time = now;
+      break;
+    }
+
+    packet.state = QuicSentPacketState::kLost;
+    OnPacketLeftFlight(pn_space, packet);
+    lost[outcome.lost_packets++] = pn;
+    if (packet.in_flight) {
+      outcome.lost_bytes += packet.bytes;
+    }
+    outcome.largest_lost_time_sent =
+        std::max(outcome.largest_lost_time_sent, packet.time_sent);
+    if (packet.ack_eliciting && packet.time_sent > first_rtt_sample_time) {
+      run_start = std::min(run_start, packet.time_sent);
+      if (packet.time_sent - run_start > congestion_period) {
+        outcome.persistent_congestion = true;
+      }
+    }
+  }
+}
+
+void QuicLossDetection::OnPacketLeftFlight(
+    PacketNumberSpace& pn_space, const QuicSentPacket& packet) noexcept {
+  if (packet.in_flight) {
+    bytes_in_flight -= packet.bytes;
+    if (packet.ack_eliciting) {
+      pn_space.ack_eliciting_in_flight--;
+    }
+  }
+}
+
+// rfc9002 appendix A.8
+TimePoint QuicLossDetection::ProbeTimeout(
+    QuicPacketNumberSpaceV1& space) const noexcept {
+  std::int64_t backoff = std::int64_t{1} << std::min(pto_count, 30u);
+  microseconds duration = rtt.ProbeTimeout() * backoff;
+  TimePoint timeout = TimePoint::max();
+  for (std::size_t i = 0; i < kQuicPacketNumberSpaceCountV1; i++) {
+    auto candidate = static_cast<QuicPacketNumberSpaceV1>(i);
+    const PacketNumberSpace& pn_space = Space(candidate);
+    if (pn_space.ack_eliciting_in_flight == 0) {
+      continue;
+    }
+    if (candidate == QuicPacketNumberSpaceV1::kApplicationData) {
+      // no application data probes before the handshake is confirmed
+      if (!handshake_confirmed) {
+        break;
+      }
+      duration += peer_max_ack_delay * backoff;
+    }
+    TimePoint time = pn_space.last_ack_eliciting_time + duration;
+    if (time < timeout) {
+      timeout = time;
+      space = candidate;
+    }
+  }
+  return timeout;
+}
+
+TimePoint QuicLossDetection::LossDetectionTimer() const noexcept {
+  TimePoint loss_time = TimePoint::max();
+  for (const PacketNumberSpace& pn_space : spaces) {
+    loss_time = std::min(loss_time, pn_space.loss_time);
+  }
+  if (loss_time != TimePoint::max()) {
+    return loss_time;
+  }
+  QuicPacketNumberSpaceV1 space;
+  return ProbeTimeout(space);
+}
+
+// rfc9002 appendix A.9
+QuicLossDetectionTimeout QuicLossDetection::OnLossDetectionTimeout(
+    TimePoint now, std::span<std::uint64_t> lost,
+    QuicPacketNumberSpaceV1& space,
+    QuicLossDetectionOutcome& outcome) noexcept {
+  outcome = QuicLossDetectionOutcome();
+  TimePoint loss_time = TimePoint::max();
+  for (std::size_t i = 0; i < kQuicPacketNumberSpaceCountV1; i++) {
+    if (spaces[i].loss_time < loss_time) {
+      loss_time = spaces[i].loss_time;
+      space = static_cast<QuicPacketNumberSpaceV1>(i);
+    }
+  }
+  if (loss_time != TimePoint::max()) {
+    if (now < loss_time) {
+      return QuicLossDetectionTimeout::kNone;
+    }
+    PacketNumberSpace& pn_space = Space(space);
+    DetectLostPackets(pn_space, now, lost, outcome);
+    pn_space.sent.Advance();
+    return QuicLossDetectionTimeout::kLossDetected;
+  }
+
+  if (ProbeTimeout(space) > now) {
+    return QuicLossDetectionTimeout::kNone;
+  }
+  pto_count++;
+  return QuicLossDetectionTimeout::kProbe;
+}
+
+void QuicLossDetection::DiscardSpace(QuicPacketNumberSpaceV1 space) noexcept {
+  PacketNumberSpace& pn_space = Space(space);
+  QuicSentPacketRing& sent = pn_space.sent;
+  for (std::uint64_t pn = sent.First(); pn < sent.Next(); pn++) {
+    QuicSentPacket& packet = sent.At(pn);
+    if (packet.state == QuicSentPacketState::kInFlight) {
+      OnPacketLeftFlight(pn_space, packet);
+      packet.state = QuicSentPacketState::kEmpty;
+    }
+  }
+  sent.Clear();
+  pn_space.loss_time = TimePoint::max();
+  pn_space.ack_eliciting_in_flight = 0;
+  pto_count = 0;
+}
+
+// Losses of packets sent on the old path must not add up to persistent
+// congestion on the new one, so that waits for a sample on the new path
+// too.
+void QuicLossDetection::OnPathChanged() noexcept {
+  rtt = {};
+  pto_count = 0;
+  first_rtt_sample_time = TimePoint::max();
+}
+
+}  // namespace bedrock::network
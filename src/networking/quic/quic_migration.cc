@@ -0,0 +1,397 @@
+#include "networking/quic/quic_migration.h"
+
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "networking/quic/quic_loss_detection.h"
+
+namespace bedrock::network {
+
+QuicPathAddress QuicPathAddress::From(const Address& address) noexcept {
+  QuicPathAddress path_address;
+  IPVersion version = address.GetIPVersion().data;
+  if (version == IPVersion::kIPV4) {
+    auto ipv4 = static_cast<::sockaddr_in>(address);
+    path_address.version = 4;
+    std::memcpy(path_address.ip.data(), &ipv4.sin_addr, 4);
+    path_address.port = ipv4.sin_port;
+  } else if (version == IPVersion::kIPV6) {
+    auto ipv6 = static_cast<::sockaddr_in6>(address);
+    path_address.version = 6;
+    std::memcpy(path_address.ip.data(), &ipv6.sin6_addr, 16);
+    path_address.port = ipv6.sin6_port;
+  }
+  return path_address;
+}
+
+QuicPeerConnectionIDs::QuicPeerConnectionIDs(
+    std::span<const std::uint8_t> connection_id,
+    std::size_t active_connection_id_limit) noexcept
+    : limit(std::clamp<std::size_t>(active_connection_id_limit, 2,
+                                    kQuicActiveConnectionIDLimit)) {
+  Entry& entry = entries[0];
+  std::size_t length =
+      std::min(connection_id.size(), entry.connection_id.size());
+  std::copy_n(connection_id.begin(), length, entry.connection_id.begin());
+  entry.length = static_cast<std::uint8_t>(length);
+}
+
+std::size_t QuicPeerConnectionIDs::Find(std::uint64_t sequence) const noexcept {
+  for (std::size_t index = 0; index < count; index++) {
+    if (entries[index].sequence == sequence) {
+      return index;
+    }
+  }
+  return count;
+}
+
+QuicMigrationErrorStatus QuicPeerConnectionIDs::QueueRetirement(
+    std::uint64_t sequence) noexcept {
+  auto pending = std::span(retirements).first(retirement_count);
+  if (std::find(pending.begin(), pending.end(), sequence) != pending.end()) {
+    return QuicMigrationErrorStatus::kSuccess;
+  }
+  if (retirement_count == retirements.size()) {
+    return QuicMigrationErrorStatus::kLimitExceeded;
+  }
+  retirements[retirement_count++] = sequence;
+  return QuicMigrationErrorStatus::kSuccess;
+}
+
+QuicMigrationErrorStatus QuicPeerConnectionIDs::Retire(
+    std::size_t index) noexcept {
+  QuicMigrationErrorStatus status = QueueRetirement(entries[index].sequence);
+  count--;
+  entries[index] = entries[count];
+  if (current == count) {
+    current = index;
+  }
+  return status;
+}
+
+QuicMigrationErrorStatus QuicPeerConnectionIDs::OnNewConnectionID(
+    const QuicFrameV1& frame) noexcept {
+  // A peer that gave a zero-length connection ID can not issue others
+  // (rfc9000 section 19.15).
+  if (entries[current].length == 0) {
+    return QuicMigrationErrorStatus::kProtocolViolation;
+  }
+
+  std::uint64_t sequence = frame.id;
+  std::size_t known = Find(sequence);
+  if (known != count) {
+    // a retransmission must repeat the frame exactly (rfc9000 section 5.1.1)
+    const Entry& entry = entries[known];
+    bool same = std::ranges::equal(
+                    frame.data, std::span(entry.connection_id)
+                                    .first(entry.length)) &&
+                std::ranges::equal(frame.aux, entry.token);
+    return same ? QuicMigrationErrorStatus::kSuccess
+                : QuicMigrationErrorStatus::kProtocolViolation;
+  }
+
+  QuicMigrationErrorStatus status = QuicMigrationErrorStatus::kSuccess;
+  if (frame.offset > retire_prior_to) {
+    retire_prior_to = frame.offset;
+    for (std::size_t index = 0;
+         index < count && status == QuicMigrationErrorStatus::kSuccess;) {
+      if (index != current && entries[index].sequence < retire_prior_to) {
+        status = Retire(index);
+      } else {
+        index++;
+      }
+    }
+    if (status != QuicMigrationErrorStatus::kSuccess) {
+      return status;
+    }
+  }
+
+  if (sequence < retire_prior_to || sequence < CurrentSequence()) {
+    // retired already, or passed over and never to be used (rfc9000 section
+    // 5.1.2)
+    status = QueueRetirement(sequence);
+  } else {
+    // The ID in use counts until it is retired below. Nothing is stored
+    // past the limit (rfc9000 section 5.1.1).
+    bool retiring_current = CurrentSequence() < retire_prior_to;
+    if (count - (retiring_current ? 1 : 0) >= limit) {
+      return QuicMigrationErrorStatus::kLimitExceeded;
+    }
+    Entry& entry = entries[count++];
+    entry.sequence = sequence;
+    entry.length = static_cast<std::uint8_t>(
+        std::min(frame.data.size(), entry.connection_id.size()));
+    std::copy_n(frame.data.begin(), entry.length, entry.connection_id.begin());
+    entry.has_token = frame.aux.size() == entry.token.size();
+    if (entry.has_token) {
+      std::copy(frame.aux.begin(), frame.aux.end(), entry.token.begin());
+    }
+  }
+  // The frame's own ID is at least Retire Prior To, so there is always one
+  // left to move to.
+  if (status == QuicMigrationErrorStatus::kSuccess &&
+      CurrentSequence() < retire_prior_to) {
+    status = Rotate();
+  }
+  return status;
+}
+
+QuicMigrationErrorStatus QuicPeerConnectionIDs::Rotate() noexcept {
+  if (entries[current].length == 0) {
+    return QuicMigrationErrorStatus::kSuccess;
+  }
+  std::size_t next = count;
+  for (std::size_t index = 0; index < count; index++) {
+    if (index != current &&
+        (next == count || entries[index].sequence < entries[next].sequence)) {
+      next = index;
+    }
+  }
+  if (next == count) {
+    return QuicMigrationErrorStatus::kNoConnectionID;
+  }
+  std::size_t previous = current;
+  current = next;
+  return Retire(previous);
+}
+
+bool QuicPeerConnectionIDs::IsStatelessReset(
+    std::span<const std::uint8_t> token) const noexcept {
+  if (token.size() != kQuicStatelessResetTokenLengthV1) {
+    return false;
+  }
+  bool found = false;
+  for (std::size_t index = 0; index < count; index++) {
+    const Entry& entry = entries[index];
+    // no early exit, so the time taken says nothing about the token
+    std::uint8_t difference = 0;
+    for (std::size_t i = 0; i < token.size(); i++) {
+      difference |= static_cast<std::uint8_t>(token[i] ^ entry.token[i]);
+    }
+    found |= entry.has_token && difference == 0;
+  }
+  return found;
+}
+
+QuicPathManager::QuicPathManager(const Address& peer) noexcept {
+  Path& path = paths[0];
+  path.in_use = true;
+  path.validated = true;
+  path.peer = peer;
+  path.address = QuicPathAddress::From(peer);
+}
+
+std::uint64_t QuicPathManager::Allowance(const Path& path) noexcept {
+  if (path.validated || !path.amplification_limited) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  std::uint64_t limit = kQuicAmplificationFactor * path.bytes_received;
+  return limit > path.bytes_sent ? limit - path.bytes_sent : 0;
+}
+
+std::size_t QuicPathManager::Find(
+    const QuicPathAddress& address) const noexcept {
+  for (std::size_t index = 0; index < paths.size(); index++) {
+    if (paths[index].in_use && paths[index].address == address) {
+      return index;
+    }
+  }
+  return kNoPath;
+}
+
+std::size_t QuicPathManager::Allocate() noexcept {
+  for (std::size_t index = 0; index < paths.size(); index++) {
+    if (!paths[index].in_use) {
+      return index;
+    }
+  }
+  // At most two slots are taken by the active and fallback paths.
+  std::size_t index = 0;
+  while (index == active || index == fallback) {
+    index++;
+  }
+  return index;
+}
+
+// The new path's RTT is unknown, so challenges go out no faster than
+// Initial packets on a fresh connection would be retransmitted, and
+// validation gives up after three times that (rfc9000 sections 8.2.1 and
+// 8.2.4).
+void QuicPathManager::StartValidation(
+    Path& path, std::chrono::steady_clock::time_point now) noexcept {
+  path.validated = false;
+  path.validating = true;
+  path.challenge_due = true;
+  path.challenge_interval =
+      std::max(current_probe_timeout, QuicRTTEstimator().ProbeTimeout());
+  path.deadline = now + 3 * path.challenge_interval;
+}
+
+std::size_t QuicPathManager::ProbeIndex() const noexcept {
+  for (std::size_t index = 0; index < paths.size(); index++) {
+    const Path& path = paths[index];
+    if (path.in_use && (path.response_due || path.challenge_due) &&
+        Allowance(path) != 0) {
+      return index;
+    }
+  }
+  return kNoPath;
+}
+
+std::span<const std::uint8_t> QuicPathManager::NextChallenge(
+    Path& path) noexcept {
+  auto& challenge =
+      path.challenges[path.challenge_count % path.challenges.size()];
+  path.challenge_count++;
+  std::random_device device;
+  for (std::size_t i = 0; i < challenge.size(); i += 4) {
+    std::uint32_t value = device();
+    std::memcpy(challenge.data() + i, &value, 4);
+  }
+  return challenge;
+}
+
+void QuicPathManager::OnProbeSent(
+    Path& path, bool challenged, std::size_t size,
+    std::chrono::steady_clock::time_point now) noexcept {
+  path.response_due = false;
+  if (challenged) {
+    path.challenge_due = false;
+    path.challenge_sent = now;
+  }
+  path.bytes_sent += size;
+}
+
+QuicPathEvent QuicPathManager::OnPacketReceived(
+    const Address& from, std::size_t size, bool probing,
+    bool largest_packet_number,
+    std::chrono::steady_clock::time_point now) noexcept {
+  QuicPathAddress address = QuicPathAddress::From(from);
+  Path& current = paths[active];
+  if (address == current.address) {
+    current.bytes_received += size;
+    return QuicPathEvent::kNone;
+  }
+
+  QuicPathEvent event = QuicPathEvent::kNone;
+  std::size_t index = Find(address);
+  if (index == kNoPath) {
+    index = Allocate();
+    Path& path = paths[index];
+    path = Path();
+    path.in_use = true;
+    path.amplification_limited = true;
+    path.peer = from;
+    path.address = address;
+    StartValidation(path, now);
+    event = QuicPathEvent::kProbed;
+  }
+  Path& path = paths[index];
+  path.bytes_received += size;
+  if (probing || !largest_packet_number) {
+    return event;
+  }
+
+  // The peer moved (rfc9000 section 9.3). The old path is kept to fall
+  // back to if it was validated and the new one turns out not to be.
+  bool rebound = address.SameHost(current.address);
+  if (current.validated) {
+    fallback = active;
+  } else if (fallback == index) {
+    fallback = kNoPath;
+  }
+  active = index;
+  if (!path.validated && !path.validating) {
+    StartValidation(path, now);
+  }
+  return rebound ? QuicPathEvent::kRebound : QuicPathEvent::kMigrated;
+}
+
+void QuicPathManager::OnPathChallenge(
+    const Address& from, std::span<const std::uint8_t> data) noexcept {
+  std::size_t index = Find(QuicPathAddress::From(from));
+  if (index == kNoPath || data.size() != kQuicPathChallengeDataLengthV1) {
+    return;
+  }
+  Path& path = paths[index];
+  std::copy(data.begin(), data.end(), path.response.begin());
+  path.response_due = true;
+}
+
+QuicPathEvent QuicPathManager::OnPathResponse(
+    std::span<const std::uint8_t> data) noexcept {
+  for (Path& path : paths) {
+    if (!path.in_use || !path.validating) {
+      continue;
+    }
+    std::size_t sent = std::min(path.challenge_count, path.challenges.size());
+    for (std::size_t i = 0; i < sent; i++) {
+      if (std::ranges::equal(data, path.challenges[i])) {
+        path.validated = true;
+        path.validating = false;
+        path.challenge_due = false;
+        return QuicPathEvent::kValidated;
+      }
+    }
+  }
+  return QuicPathEvent::kNone;
+}
+
+QuicPathEvent QuicPathManager::Migrate(
+    std::chrono::steady_clock::time_point now) noexcept {
+  fallback = kNoPath;
+  StartValidation(paths[active], now);
+  return QuicPathEvent::kMigrated;
+}
+
+std::chrono::steady_clock::time_point QuicPathManager::Timer() const noexcept {
+  auto timer = std::chrono::steady_clock::time_point::max();
+  for (const Path& path : paths) {
+    if (!path.in_use || !path.validating) {
+      continue;
+    }
+    timer = std::min(timer, path.deadline);
+    if (!path.challenge_due) {
+      timer = std::min(timer, path.challenge_sent + path.challenge_interval);
+    }
+  }
+  return timer;
+}
+
+QuicPathEvent QuicPathManager::OnTimeout(
+    std::chrono::steady_clock::time_point now) noexcept {
+  QuicPathEvent event = QuicPathEvent::kNone;
+  for (std::size_t index = 0; index < paths.size(); index++) {
+    Path& path = paths[index];
+    if (!path.in_use || !path.validating) {
+      continue;
+    }
+    if (now < path.deadline) {
+      if (!path.challenge_due &&
+          now >= path.challenge_sent + path.challenge_interval) {
+        path.challenge_due = true;
+      }
+      continue;
+    }
+
+    path.validating = false;
+    path.challenge_due = false;
+    if (index != active) {
+      path.in_use = false;
+    } else if (fallback != kNoPath) {
+      // rfc9000 section 9.3.2
+      path.in_use = false;
+      active = fallback;
+      fallback = kNoPath;
+      event = QuicPathEvent::kReverted;
+      continue;
+    }
+    if (event != QuicPathEvent::kReverted) {
+      event = QuicPathEvent::kFailed;
+    }
+  }
+  return event;
+}
+
+}  // namespace bedrock::network
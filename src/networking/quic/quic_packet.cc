@@ -2,62 +2,97 @@
 
 namespace bedrock::network {
 
-bool QuicPacketBase::HeaderForm() const { return data[0] & 0x80; }
+namespace QuicPacketUtil {
+
+// Returns a reader positioned after the first connection_ids length prefixed
+// connection IDs that follow the Version field.
+static QuicWireReader SkipConnectionIDs(std::span<const std::uint8_t> packet,
+                                        int connection_ids) {
+  QuicWireReader reader(
+      packet,
+      QuicLongPacketHeaderLayout::DestinationConnectionIDLength::kOffset);
+  for (int i = 0; i < connection_ids; i++) {
+    reader.Skip(reader.Read<std::uint8_t>());
+  }
+  return reader;
+}
+
+static std::uint32_t Version(std::span<const std::uint8_t> packet) {
+  if (packet.size() < QuicLongPacketHeaderLayout::kSize) {
+    return 0;
+  }
+  return QuicLongPacketHeaderLayout::Version::Load(packet.data());
+}
+
+static std::uint8_t ConnectionIDLength(std::span<const std::uint8_t> packet,
+                                       int index) {
+  return SkipConnectionIDs(packet, index).Read<std::uint8_t>();
+}
+
+static std::span<const std::uint8_t> ConnectionID(
+    std::span<const std::uint8_t> packet, int index) {
+  QuicWireReader reader = SkipConnectionIDs(packet, index);
+  return reader.ReadBytes(reader.Read<std::uint8_t>());
+}
+
+}  // namespace QuicPacketUtil
+
+bool QuicPacketBase::HeaderForm() const {
+  return !data.empty() && (data[0] & 0x80);
+}
 std::uint8_t QuicPacketBase::VersionSpecificBits() const {
-  return data[0] & 0x7F;
+  return data.empty() ? 0 : data[0] & 0x7F;
 }
 
 std::uint32_t QuicLongPacketHeader::Version() const {
-  return *reinterpret_cast<const std::uint32_t*>(span().subspan(1).data());
+  return QuicPacketUtil::Version(span());
 }
 std::uint8_t QuicLongPacketHeader::DestinationConnectionIDLength() const {
-  return data[5];
+  return QuicPacketUtil::ConnectionIDLength(span(), 0);
 }
 std::span<const std::uint8_t> QuicLongPacketHeader::DestinationConnectionID()
     const {
-  return span().subspan(6, DestinationConnectionIDLength());
+  return QuicPacketUtil::ConnectionID(span(), 0);
 }
 std::uint8_t QuicLongPacketHeader::SourceConnectionIDLength() const {
-  return data[6 + DestinationConnectionIDLength()];
+  return QuicPacketUtil::ConnectionIDLength(span(), 1);
 }
 std::span<const std::uint8_t> QuicLongPacketHeader::SourceConnectionID() const {
-  return span().subspan(7 + DestinationConnectionIDLength(),
-                        SourceConnectionIDLength());
+  return QuicPacketUtil::ConnectionID(span(), 1);
 }
 std::span<const std::uint8_t> QuicLongPacketHeader::VersionspecificData()
     const {
-  return span().subspan(7 + DestinationConnectionIDLength() +
-                        SourceConnectionIDLength());
+  return QuicPacketUtil::SkipConnectionIDs(span(), 2).Rest();
 }
 
 std::uint32_t QuicVersionNegotiationPacket::Version() const {
-  return *reinterpret_cast<const std::uint32_t*>(data.data() + 1);
+  return QuicPacketUtil::Version(span());
 }
 std::uint8_t QuicVersionNegotiationPacket::DestinationConnectionIDLength()
     const {
-  return data[5];
+  return QuicPacketUtil::ConnectionIDLength(span(), 0);
 }
 std::span<const std::uint8_t>
 QuicVersionNegotiationPacket::DestinationConnectionID() const {
-  return span().subspan(6, DestinationConnectionIDLength());
+  return QuicPacketUtil::ConnectionID(span(), 0);
 }
 std::uint8_t QuicVersionNegotiationPacket::SourceConnectionIDLength() const {
-  return data[6 + DestinationConnectionIDLength()];
+  return QuicPacketUtil::ConnectionIDLength(span(), 1);
 }
 std::span<const std::uint8_t> QuicVersionNegotiationPacket::SourceConnectionID()
     const {
-  return span().subspan(7 + DestinationConnectionIDLength(),
-                        SourceConnectionIDLength());
+  return QuicPacketUtil::ConnectionID(span(), 1);
 }
-std::span<const std::uint32_t> QuicVersionNegotiationPacket::SupportedVersion()
-    const {
-  std::size_t offset =
-      7 + DestinationConnectionIDLength() + SourceConnectionIDLength();
-  return std::span<const std::uint32_t>(
-      reinterpret_cast<const std::uint32_t*>(data.data() + offset),
-      (data.size() - offset) / 4);
+std::size_t QuicVersionNegotiationPacket::SupportedVersionCount() const {
+  return QuicPacketUtil::SkipConnectionIDs(span(), 2).Remaining() / 4;
+}
+std::uint32_t QuicVersionNegotiationPacket::SupportedVersion(
+    std::size_t index) const {
+  QuicWireReader reader = QuicPacketUtil::SkipConnectionIDs(span(), 2);
+  reader.Skip(index * 4);
+  return reader.Read<std::uint32_t>();
 }
 
 QuicShortPacketHeader::~QuicShortPacketHeader() = default;
 
-}  // namespace bedrock::network
\ No newline at end of file
+}  // namespace bedrock::network
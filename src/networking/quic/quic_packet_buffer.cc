@@ -0,0 +1,44 @@
+#include "networking/quic/quic_packet_buffer.h"
+
+namespace bedrock::network {
+
+QuicPacketBufferPool::QuicPacketBufferPool(std::size_t buffer_count) noexcept
+    : capacity(buffer_count),
+      available(buffer_count),
+      buffers(std::make_unique<QuicPacketBuffer[]>(buffer_count)) {
+  for (std::size_t i = buffer_count; i > 0; i--) {
+    buffers[i - 1].pool = this;
+    buffers[i - 1].next_free = free_list;
+    free_list = &buffers[i - 1];
+  }
+}
+
+QuicPacketBufferRef QuicPacketBufferPool::Allocate() noexcept {
+  QuicPacketBuffer* buffer = free_list;
+  if (buffer == nullptr) {
+    // Acquire pairs with the release in Free(), so the last reader of each
+    // returned buffer is done before it is written again.
+    buffer = returned.exchange(nullptr, std::memory_order_acquire);
+    if (buffer == nullptr) {
+      return {};
+    }
+  }
+  free_list = buffer->next_free;
+  available.fetch_sub(1, std::memory_order_relaxed);
+  buffer->next_free = nullptr;
+  buffer->references = 1;
+  buffer->size = 0;
+  return QuicPacketBufferRef(buffer);
+}
+
+void QuicPacketBufferPool::Free(QuicPacketBuffer* buffer) noexcept {
+  QuicPacketBuffer* head = returned.load(std::memory_order_relaxed);
+  do {
+    buffer->next_free = head;
+  } while (!returned.compare_exchange_weak(head, buffer,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  available.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace bedrock::network
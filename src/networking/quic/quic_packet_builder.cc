@@ -0,0 +1,618 @@
+#include "networking/quic/quic_packet_builder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+namespace QuicPacketBuilderUtil {
+
+// A 2 byte Length field caps a long header packet at 16383 bytes after it.
+static constexpr std::size_t kLengthFieldSize = 2;
+static constexpr std::size_t kMaxLongPacketLength = 0x3FFF;
+static constexpr std::size_t kMaxConnectionIDLength = 20;
+// Header protection samples 16 bytes starting 4 bytes after the packet number
+static constexpr std::size_t kMinPacketNumberAndPayload = 4;
+
+static std::uint8_t* WriteBytes(std::uint8_t* out,
+                                std::span<const std::uint8_t> bytes) {
+  if (!bytes.empty()) {
+    std::memcpy(out, bytes.data(), bytes.size());
+  }
+  return out + bytes.size();
+}
+
+static std::size_t FrameSize(const QuicFrameV1& frame) {
+  switch (frame.type) {
+    case QuicFrameTypeV1::kPadding:
+      return std::max<std::size_t>(1, static_cast<std::size_t>(frame.length));
+    case QuicFrameTypeV1::kPing:
+    case QuicFrameTypeV1::kHandshakeDone:
+      return 1;
+    case QuicFrameTypeV1::kAck:
+      return 1 + QuicVarIntLength(frame.id) + QuicVarIntLength(frame.extra) +
+             QuicVarIntLength(frame.length) + QuicVarIntLength(frame.offset) +
+             frame.data.size() + frame.aux.size();
+    case QuicFrameTypeV1::kResetStream:
+      return 1 + QuicVarIntLength(frame.id) + QuicVarIntLength(frame.extra) +
+             QuicVarIntLength(frame.offset);
+    case QuicFrameTypeV1::kStopSending:
+      return 1 + QuicVarIntLength(frame.id) + QuicVarIntLength(frame.extra);
+    case QuicFrameTypeV1::kCrypto:
+      return 1 + QuicVarIntLength(frame.offset) +
+             QuicVarIntLength(frame.data.size()) + frame.data.size();
+    case QuicFrameTypeV1::kNewToken:
+      return 1 + QuicVarIntLength(frame.data.size()) + frame.data.size();
+    case QuicFrameTypeV1::kStream:
+      return 1 + QuicVarIntLength(frame.id) +
+             (frame.offset != 0 ? QuicVarIntLength(frame.offset) : 0) +
+             QuicVarIntLength(frame.data.size()) + frame.data.size();
+    case QuicFrameTypeV1::kMaxData:
+    case QuicFrameTypeV1::kMaxStreamsBidi:
+    case QuicFrameTypeV1::kMaxStreamsUni:
+    case QuicFrameTypeV1::kDataBlocked:
+    case QuicFrameTypeV1::kStreamsBlockedBidi:
+    case QuicFrameTypeV1::kStreamsBlockedUni:
+      return 1 + QuicVarIntLength(frame.offset);
+    case QuicFrameTypeV1::kMaxStreamData:
+    case QuicFrameTypeV1::kStreamDataBlocked:
+      return 1 + QuicVarIntLength(frame.id) + QuicVarIntLength(frame.offset);
+    case QuicFrameTypeV1::kNewConnectionID:
+      return 1 + QuicVarIntLength(frame.id) + QuicVarIntLength(frame.offset) +
+             1 + frame.data.size() + frame.aux.size();
+    case QuicFrameTypeV1::kRetireConnectionID:
+      return 1 + QuicVarIntLength(frame.id);
+    case QuicFrameTypeV1::kPathChallenge:
+    case QuicFrameTypeV1::kPathResponse:
+      return 1 + frame.data.size();
+    case QuicFrameTypeV1::kConnectionClose:
+      return 1 + QuicVarIntLength(frame.extra) +
+             QuicVarIntLength(frame.offset) +
+             QuicVarIntLength(frame.data.size()) + frame.data.size();
+    case QuicFrameTypeV1::kConnectionCloseApplication:
+      return 1 + QuicVarIntLength(frame.extra) +
+             QuicVarIntLength(frame.data.size()) + frame.data.size();
+    case QuicFrameTypeV1::kDatagram:
+      return 1 + QuicVarIntLength(frame.data.size()) + frame.data.size();
+  }
+  return 0;
+}
+
+static bool FrameValid(const QuicFrameV1& frame) {
+  switch (frame.type) {
+    case QuicFrameTypeV1::kNewConnectionID:
+      return !frame.data.empty() &&
+             frame.data.size() <= kMaxConnectionIDLength &&
+             frame.aux.size() == kQuicStatelessResetTokenLengthV1;
+    case QuicFrameTypeV1::kPathChallenge:
+    case QuicFrameTypeV1::kPathResponse:
+      return frame.data.size() == kQuicPathChallengeDataLengthV1;
+    case QuicFrameTypeV1::kNewToken:
+      return !frame.data.empty();
+    default:
+      return true;
+  }
+}
+
+static std::uint8_t* WriteFrame(std::uint8_t* out, const QuicFrameV1& frame) {
+  std::uint8_t type = static_cast<std::uint8_t>(frame.type);
+
+  switch (frame.type) {
+    case QuicFrameTypeV1::kPadding: {
+      std::size_t length =
+          std::max<std::size_t>(1, static_cast<std::size_t>(frame.length));
+      std::memset(out, 0, length);
+      return out + length;
+    }
+    case QuicFrameTypeV1::kPing:
+    case QuicFrameTypeV1::kHandshakeDone:
+      *out++ = type;
+      return out;
+    case QuicFrameTypeV1::kAck:
+      *out++ = type | (frame.flags & kQuicAckFrameEcnBitV1);
+      out = StoreQuicVarInt(out, frame.id);
+      out = StoreQuicVarInt(out, frame.extra);
+      out = StoreQuicVarInt(out, frame.length);
+      out = StoreQuicVarInt(out, frame.offset);
+      out = WriteBytes(out, frame.data);
+      return WriteBytes(out, frame.aux);
+    case QuicFrameTypeV1::kResetStream:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.id);
+      out = StoreQuicVarInt(out, frame.extra);
+      return StoreQuicVarInt(out, frame.offset);
+    case QuicFrameTypeV1::kStopSending:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.id);
+      return StoreQuicVarInt(out, frame.extra);
+    case QuicFrameTypeV1::kCrypto:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.offset);
+      out = StoreQuicVarInt(out, frame.data.size());
+      return WriteBytes(out, frame.data);
+    case QuicFrameTypeV1::kNewToken:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.data.size());
+      return WriteBytes(out, frame.data);
+    case QuicFrameTypeV1::kStream:
+      *out++ = type | kQuicStreamFrameLenBitV1 |
+               (frame.offset != 0 ? kQuicStreamFrameOffBitV1 : 0) |
+               (frame.flags & kQuicStreamFrameFinBitV1);
+      out = StoreQuicVarInt(out, frame.id);
+      if (frame.offset != 0) {
+        out = StoreQuicVarInt(out, frame.offset);
+      }
+      out = StoreQuicVarInt(out, frame.data.size());
+      return WriteBytes(out, frame.data);
+    case QuicFrameTypeV1::kMaxData:
+    case QuicFrameTypeV1::kMaxStreamsBidi:
+    case QuicFrameTypeV1::kMaxStreamsUni:
+    case QuicFrameTypeV1::kDataBlocked:
+    case QuicFrameTypeV1::kStreamsBlockedBidi:
+    case QuicFrameTypeV1::kStreamsBlockedUni:
+      *out++ = type;
+      return StoreQuicVarInt(out, frame.offset);
+    case QuicFrameTypeV1::kMaxStreamData:
+    case QuicFrameTypeV1::kStreamDataBlocked:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.id);
+      return StoreQuicVarInt(out, frame.offset);
+    case QuicFrameTypeV1::kNewConnectionID:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.id);
+      out = StoreQuicVarInt(out, frame.offset);
+      *out++ = static_cast<std::uint8_t>(frame.data.size());
+      out = WriteBytes(out, frame.data);
+      return WriteBytes(out, frame.aux);
+    case QuicFrameTypeV1::kRetireConnectionID:
+      *out++ = type;
+      return StoreQuicVarInt(out, frame.id);
+    case QuicFrameTypeV1::kPathChallenge:
+    case QuicFrameTypeV1::kPathResponse:
+      *out++ = type;
+      return WriteBytes(out, frame.data);
+    case QuicFrameTypeV1::kConnectionClose:
+    case QuicFrameTypeV1::kConnectionCloseApplication:
+      *out++ = type;
+      out = StoreQuicVarInt(out, frame.extra);
+      if (frame.type == QuicFrameTypeV1::kConnectionClose) {
+        out = StoreQuicVarInt(out, frame.offset);
+      }
+      out = StoreQuicVarInt(out, frame.data.size());
+      return WriteBytes(out, frame.data);
+    case QuicFrameTypeV1::kDatagram:
+      *out++ = type | kQuicDatagramFrameLenBitV1;
+      out = StoreQuicVarInt(out, frame.data.size());
+      return WriteBytes(out, frame.data);
+  }
+  return out;
+}
+
+// Largest data length that fits in available bytes after header_size bytes
+// of frame header plus a Length field describing the result.
+static std::size_t FitData(std::size_t available, std::size_t header_size,
+                           std::size_t data_size) {
+  for (std::size_t length_size : {std::size_t{1}, std::size_t{2},
+                                   std::size_t{4}, std::size_t{8}}) {
+    if (available < header_size + length_size) {
+      return 0;
+    }
+    std::size_t fit =
+        std::min(data_size, available - header_size - length_size);
+    if (QuicVarIntLength(fit) <= length_size) {
+      return fit;
+    }
+  }
+  return 0;
+}
+
+}  // namespace QuicPacketBuilderUtil
+
+template <QuicVersionTraits Version>
+QuicPacketBuilder<Version>::QuicPacketBuilder(
+    std::span<std::uint8_t> send_buffer, std::size_t max_datagram_size) noexcept
+    : buffer(send_buffer), max_datagram(max_datagram_size) {}
+
+template <QuicVersionTraits Version>
+void QuicPacketBuilder<Version>::Reset() noexcept {
+  position = 0;
+  datagram_size = 0;
+  length_offset = 0;
+  packet_open = false;
+  datagram_closed = false;
+  packet_count = 0;
+}
+
+template <QuicVersionTraits Version>
+void QuicPacketBuilder<Version>::SetMaxDatagramSize(
+    std::size_t max_datagram_size) noexcept {
+  max_datagram = max_datagram_size;
+}
+
+template <QuicVersionTraits Version>
+std::size_t QuicPacketBuilder<Version>::Limit() const noexcept {
+  std::size_t limit = std::min(max_datagram, buffer.size());
+  if (packet_open && packets[packet_count - 1].long_header) {
+    limit = std::min(limit, length_offset +
+                                QuicPacketBuilderUtil::kLengthFieldSize +
+                                QuicPacketBuilderUtil::kMaxLongPacketLength);
+  }
+  return limit;
+}
+
+template <QuicVersionTraits Version>
+std::size_t QuicPacketBuilder<Version>::Remaining() const noexcept {
+  if (!packet_open) {
+    return 0;
+  }
+  std::size_t limit = Limit();
+  if (limit < position + kQuicAeadTagLengthV1) {
+    return 0;
+  }
+  return limit - position - kQuicAeadTagLengthV1;
+}
+
+// Long Header Packet {
+//   Header Form (1) = 1,
+//   Fixed Bit (1) = 1,
+//   Long Packet Type (2),
+//   Reserved Bits (2),
+//   Packet Number Length (2),
+//   Version (32),
+//   Destination Connection ID Length (8),
+//   Destination Connection ID (0..160),
+//   Source Connection ID Length (8),
+//   Source Connection ID (0..160),
+//   [Token Length (i), Token (..)],
+//   Length (i),
+//   Packet Number (8..32),
+//   Packet Payload (8..),
+// }
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::BeginLongPacket(
+    QuicLongHeaderPacketTypeV1 type,
+    std::span<const std::uint8_t> destination_connection_id,
+    std::span<const std::uint8_t> source_connection_id,
+    std::span<const std::uint8_t> token, std::uint64_t packet_number,
+    std::uint8_t packet_number_length) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (packet_open || datagram_closed || packet_count == packets.size()) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  if (type == QuicLongHeaderPacketTypeV1::kRetry || packet_number_length < 1 ||
+      packet_number_length > 4 ||
+      destination_connection_id.size() > kMaxConnectionIDLength ||
+      source_connection_id.size() > kMaxConnectionIDLength) {
+    return QuicPacketBuilderErrorStatus::kInvalid;
+  }
+  if (type != QuicLongHeaderPacketTypeV1::kInitial) {
+    token = {};
+  }
+
+  std::size_t header_size =
+      1 + 4 + 1 + destination_connection_id.size() + 1 +
+      source_connection_id.size() + kLengthFieldSize + packet_number_length;
+  if (type == QuicLongHeaderPacketTypeV1::kInitial) {
+    header_size += QuicVarIntLength(token.size()) + token.size();
+  }
+  std::size_t limit = std::min(max_datagram, buffer.size());
+  if (limit < position + header_size + kMinPacketNumberAndPayload +
+                  kQuicAeadTagLengthV1) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+
+  QuicBuiltPacketV1& packet = packets[packet_count++];
+  packet = {};
+  packet.header_offset = position;
+  packet.packet_number = packet_number;
+  packet.packet_number_length = packet_number_length;
+  packet.long_header = true;
+
+  std::uint8_t* out = Cursor();
+  *out++ = static_cast<std::uint8_t>(0xC0 | Version::LongPacketTypeBits(type) |
+                                     (packet_number_length - 1));
+  StoreBigEndian<std::uint32_t>(out, Version::kVersion);
+  out += 4;
+  *out++ = static_cast<std::uint8_t>(destination_connection_id.size());
+  out = WriteBytes(out, destination_connection_id);
+  *out++ = static_cast<std::uint8_t>(source_connection_id.size());
+  out = WriteBytes(out, source_connection_id);
+  if (type == QuicLongHeaderPacketTypeV1::kInitial) {
+    out = StoreQuicVarInt(out, token.size());
+    out = WriteBytes(out, token);
+  }
+  length_offset = static_cast<std::size_t>(out - buffer.data());
+  out += kLengthFieldSize;
+  packet.packet_number_offset = static_cast<std::size_t>(out - buffer.data());
+  StoreBigEndian(out, packet_number, packet_number_length);
+  out += packet_number_length;
+  packet.payload_offset = static_cast<std::size_t>(out - buffer.data());
+
+  position = packet.payload_offset;
+  packet_open = true;
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+// 1-RTT Packet {
+//   Header Form (1) = 0,
+//   Fixed Bit (1) = 1,
+//   Spin Bit (1),
+//   Reserved Bits (2),
+//   Key Phase (1),
+//   Packet Number Length (2),
+//   Destination Connection ID (0..160),
+//   Packet Number (8..32),
+//   Packet Payload (8..),
+// }
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::BeginShortPacket(
+    std::span<const std::uint8_t> destination_connection_id,
+    std::uint64_t packet_number, std::uint8_t packet_number_length,
+    bool key_phase, bool spin_bit) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (packet_open || datagram_closed || packet_count == packets.size()) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  if (packet_number_length < 1 || packet_number_length > 4 ||
+      destination_connection_id.size() > kMaxConnectionIDLength) {
+    return QuicPacketBuilderErrorStatus::kInvalid;
+  }
+
+  std::size_t header_size =
+      1 + destination_connection_id.size() + packet_number_length;
+  std::size_t limit = std::min(max_datagram, buffer.size());
+  if (limit < position + header_size + kMinPacketNumberAndPayload +
+                  kQuicAeadTagLengthV1) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+
+  QuicBuiltPacketV1& packet = packets[packet_count++];
+  packet = {};
+  packet.header_offset = position;
+  packet.packet_number = packet_number;
+  packet.packet_number_length = packet_number_length;
+  packet.long_header = false;
+
+  std::uint8_t* out = Cursor();
+  *out++ = static_cast<std::uint8_t>(0x40 | (spin_bit ? 0x20 : 0x00) |
+                                     (key_phase ? 0x04 : 0x00) |
+                                     (packet_number_length - 1));
+  out = WriteBytes(out, destination_connection_id);
+  packet.packet_number_offset = static_cast<std::size_t>(out - buffer.data());
+  StoreBigEndian(out, packet_number, packet_number_length);
+  out += packet_number_length;
+  packet.payload_offset = static_cast<std::size_t>(out - buffer.data());
+
+  position = packet.payload_offset;
+  packet_open = true;
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::AppendFrame(
+    const QuicFrameV1& frame) noexcept {
+  if (!packet_open) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  if (!QuicPacketBuilderUtil::FrameValid(frame)) {
+    return QuicPacketBuilderErrorStatus::kInvalid;
+  }
+  if (QuicPacketBuilderUtil::FrameSize(frame) > Remaining()) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+
+  std::uint8_t* end = QuicPacketBuilderUtil::WriteFrame(Cursor(), frame);
+  position = static_cast<std::size_t>(end - buffer.data());
+  packets[packet_count - 1].ack_eliciting |= IsAckEliciting(frame.type);
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+template <QuicVersionTraits Version>
+std::size_t QuicPacketBuilder<Version>::AppendFrames(
+    std::span<const QuicFrameV1> frames) noexcept {
+  std::size_t count = 0;
+  for (const auto& frame : frames) {
+    if (AppendFrame(frame) != QuicPacketBuilderErrorStatus::kSuccess) {
+      break;
+    }
+    count++;
+  }
+  return count;
+}
+
+template <QuicVersionTraits Version>
+std::size_t QuicPacketBuilder<Version>::AppendStreamFrame(
+    std::uint64_t stream_id, std::uint64_t offset,
+    std::span<const std::uint8_t> data, bool fin) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (!packet_open) {
+    return 0;
+  }
+  std::size_t header_size = 1 + QuicVarIntLength(stream_id) +
+                            (offset != 0 ? QuicVarIntLength(offset) : 0);
+  std::size_t fit = FitData(Remaining(), header_size, data.size());
+  // an empty frame is only worth sending to carry FIN
+  if (fit == 0 && !(fin && data.empty() && Remaining() >= header_size + 1)) {
+    return 0;
+  }
+
+  QuicFrameV1 frame;
+  frame.type = QuicFrameTypeV1::kStream;
+  frame.id = stream_id;
+  frame.offset = offset;
+  frame.data = data.subspan(0, fit);
+  frame.flags = (fin && fit == data.size()) ? kQuicStreamFrameFinBitV1 : 0;
+
+  std::uint8_t* end = WriteFrame(Cursor(), frame);
+  position = static_cast<std::size_t>(end - buffer.data());
+  packets[packet_count - 1].ack_eliciting = true;
+  return fit;
+}
+
+template <QuicVersionTraits Version>
+std::size_t QuicPacketBuilder<Version>::AppendCryptoFrame(
+    std::uint64_t offset, std::span<const std::uint8_t> data) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (!packet_open) {
+    return 0;
+  }
+  std::size_t fit =
+      FitData(Remaining(), 1 + QuicVarIntLength(offset), data.size());
+  if (fit == 0) {
+    return 0;
+  }
+
+  QuicFrameV1 frame;
+  frame.type = QuicFrameTypeV1::kCrypto;
+  frame.offset = offset;
+  frame.data = data.subspan(0, fit);
+
+  std::uint8_t* end = WriteFrame(Cursor(), frame);
+  position = static_cast<std::size_t>(end - buffer.data());
+  packets[packet_count - 1].ack_eliciting = true;
+  return fit;
+}
+
+// A datagram is never split. When it only fits without its Length field,
+// PADDING goes in front so that the frame runs to the end of the packet.
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::AppendDatagramFrame(
+    std::span<const std::uint8_t> data) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (!packet_open) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  std::size_t available = Remaining();
+  if (available < 1 + data.size()) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+
+  std::uint8_t* out = Cursor();
+  if (1 + QuicVarIntLength(data.size()) + data.size() <= available) {
+    *out++ = static_cast<std::uint8_t>(QuicFrameTypeV1::kDatagram) |
+             kQuicDatagramFrameLenBitV1;
+    out = StoreQuicVarInt(out, data.size());
+  } else {
+    std::size_t padding = available - 1 - data.size();
+    std::memset(out, 0, padding);
+    out += padding;
+    *out++ = static_cast<std::uint8_t>(QuicFrameTypeV1::kDatagram);
+  }
+  out = WriteBytes(out, data);
+  position = static_cast<std::size_t>(out - buffer.data());
+  packets[packet_count - 1].ack_eliciting = true;
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+// ACK Range {
+//   Gap (i),
+//   ACK Range Length (i),
+// }
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::AppendAckFrame(
+    std::span<const QuicAckRangeV1> ranges, std::uint64_t ack_delay) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (!packet_open) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  if (ranges.empty() || ranges[0].smallest > ranges[0].largest) {
+    return QuicPacketBuilderErrorStatus::kInvalid;
+  }
+  for (std::size_t i = 1; i < ranges.size(); i++) {
+    if (ranges[i].smallest > ranges[i].largest ||
+        ranges[i].largest + 2 > ranges[i - 1].smallest) {
+      return QuicPacketBuilderErrorStatus::kInvalid;
+    }
+  }
+
+  std::size_t available = Remaining();
+  std::size_t size = 1 + QuicVarIntLength(ranges[0].largest) +
+                     QuicVarIntLength(ack_delay) +
+                     QuicVarIntLength(ranges[0].largest - ranges[0].smallest);
+  if (size + 1 > available) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+  std::size_t count = 1;
+  for (; count < ranges.size(); count++) {
+    std::uint64_t gap = ranges[count - 1].smallest - ranges[count].largest - 2;
+    std::uint64_t length = ranges[count].largest - ranges[count].smallest;
+    std::size_t range_size = QuicVarIntLength(gap) + QuicVarIntLength(length);
+    if (size + range_size + QuicVarIntLength(count) > available) {
+      break;
+    }
+    size += range_size;
+  }
+
+  std::uint8_t* out = Cursor();
+  *out++ = static_cast<std::uint8_t>(QuicFrameTypeV1::kAck);
+  out = StoreQuicVarInt(out, ranges[0].largest);
+  out = StoreQuicVarInt(out, ack_delay);
+  out = StoreQuicVarInt(out, count - 1);
+  out = StoreQuicVarInt(out, ranges[0].largest - ranges[0].smallest);
+  for (std::size_t i = 1; i < count; i++) {
+    out = StoreQuicVarInt(out, ranges[i - 1].smallest - ranges[i].largest - 2);
+    out = StoreQuicVarInt(out, ranges[i].largest - ranges[i].smallest);
+  }
+  position = static_cast<std::size_t>(out - buffer.data());
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::AppendPadding(
+    std::size_t length) noexcept {
+  if (!packet_open) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  if (length > Remaining()) {
+    return QuicPacketBuilderErrorStatus::kNoSpace;
+  }
+  std::memset(Cursor(), 0, length);
+  position += length;
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+template <QuicVersionTraits Version>
+QuicPacketBuilderErrorStatus QuicPacketBuilder<Version>::FinishPacket(
+    std::size_t pad_datagram_to) noexcept {
+  using namespace QuicPacketBuilderUtil;
+
+  if (!packet_open) {
+    return QuicPacketBuilderErrorStatus::kInternal;
+  }
+  QuicBuiltPacketV1& packet = packets[packet_count - 1];
+
+  std::size_t written = position - packet.packet_number_offset;
+  if (written < kMinPacketNumberAndPayload) {
+    AppendPadding(kMinPacketNumberAndPayload - written);
+  }
+  std::size_t target = std::min(pad_datagram_to, Limit());
+  if (target > position + kQuicAeadTagLengthV1) {
+    AppendPadding(target - position - kQuicAeadTagLengthV1);
+  }
+
+  position += kQuicAeadTagLengthV1;
+  packet.end_offset = position;
+  if (packet.long_header) {
+    std::size_t length = position - length_offset - kLengthFieldSize;
+    StoreQuicVarInt(buffer.data() + length_offset, length, kLengthFieldSize);
+  } else {
+    datagram_closed = true;
+  }
+
+  datagram_size = position;
+  packet_open = false;
+  return QuicPacketBuilderErrorStatus::kSuccess;
+}
+
+template class QuicPacketBuilder<QuicVersion1>;
+template class QuicPacketBuilder<QuicVersion2>;
+
+}  // namespace bedrock::network
@@ -0,0 +1,297 @@
+#include "networking/quic/quic_packet_protection.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+namespace QuicPacketProtectionUtil {
+
+// Bits of the first byte covered by header protection: Reserved Bits and
+// Packet Number Length, plus Key Phase for short headers.
+static constexpr std::uint8_t kLongHeaderMask = 0x0F;
+static constexpr std::uint8_t kShortHeaderMask = 0x1F;
+
+static std::uint8_t FirstByteMask(bool long_header) noexcept {
+  return long_header ? kLongHeaderMask : kShortHeaderMask;
+}
+
+// XORs the first length bytes of the mask after its first byte into the
+// Packet Number field with a single 4 byte load and store, and returns the
+// field as it reads afterwards. The sample that follows the field
+// guarantees the 4 bytes exist even when the field is shorter.
+static std::uint32_t MaskPacketNumber(std::uint8_t* packet_number,
+                                      const QuicHeaderProtectionMask& mask,
+                                      std::size_t length) noexcept {
+  std::size_t unused_bits = 32 - length * 8;
+  std::uint32_t field_mask = LoadBigEndian<std::uint32_t>(mask.data() + 1) >>
+                             unused_bits << unused_bits;
+  std::uint32_t field =
+      LoadBigEndian<std::uint32_t>(packet_number) ^ field_mask;
+  StoreBigEndian(packet_number, field);
+  return field >> unused_bits;
+}
+
+}  // namespace QuicPacketProtectionUtil
+
+void QuicPacketProtectionKeys::SetKeys(
+    std::span<const std::uint8_t, kQuicAES128KeySize> key,
+    std::span<const std::uint8_t, kQuicAEADNonceSize> packet_iv,
+    std::span<const std::uint8_t, kQuicAES128KeySize>
+        header_protection_key) noexcept {
+  aead.SetKey(key);
+  std::copy(packet_iv.begin(), packet_iv.end(), iv.begin());
+  header_protection.SetKey(header_protection_key);
+}
+
+void QuicPacketProtectionKeys::SetSecret(std::span<const std::uint8_t> secret,
+                                         std::string_view key_label,
+                                         std::string_view iv_label,
+                                         std::string_view hp_label) noexcept {
+  std::array<std::uint8_t, kQuicAES128KeySize> key;
+  std::array<std::uint8_t, kQuicAEADNonceSize> packet_iv;
+  std::array<std::uint8_t, kQuicAES128KeySize> header_protection_key;
+  QuicHKDFExpandLabel(secret, key_label, key);
+  QuicHKDFExpandLabel(secret, iv_label, packet_iv);
+  QuicHKDFExpandLabel(secret, hp_label, header_protection_key);
+  SetKeys(key, packet_iv, header_protection_key);
+}
+
+// The 62 bit packet number, left padded to the iv length, XORed into the iv
+std::array<std::uint8_t, kQuicAEADNonceSize> QuicPacketProtectionKeys::Nonce(
+    std::uint64_t packet_number) const noexcept {
+  std::array<std::uint8_t, kQuicAEADNonceSize> nonce = iv;
+  std::uint64_t tail = LoadBigEndian<std::uint64_t>(nonce.data() + 4);
+  StoreBigEndian(nonce.data() + 4, tail ^ packet_number);
+  return nonce;
+}
+
+QuicHeaderProtectionMask QuicPacketProtectionKeys::HeaderProtectionMask(
+    const std::uint8_t* sample) const noexcept {
+  std::array<std::uint8_t, kQuicAESBlockSize> block;
+  header_protection.EncryptBlock(sample, block.data());
+  QuicHeaderProtectionMask mask;
+  std::memcpy(mask.data(), block.data(), mask.size());
+  return mask;
+}
+
+void QuicPacketProtectionKeys::HeaderProtectionMasks(
+    const std::uint8_t* const* samples, QuicHeaderProtectionMask* masks,
+    std::size_t count) const noexcept {
+  count = std::min(count, kQuicHeaderProtectionBatchSize);
+  std::array<std::uint8_t, kQuicHeaderProtectionBatchSize * kQuicAESBlockSize>
+      blocks;
+  header_protection.EncryptBlocks(samples, blocks.data(), count);
+  for (std::size_t i = 0; i < count; i++) {
+    std::memcpy(masks[i].data(), blocks.data() + i * kQuicAESBlockSize,
+                masks[i].size());
+  }
+}
+
+QuicPacketProtectionErrorStatus QuicPacketProtectionKeys::Protect(
+    std::span<std::uint8_t> datagram,
+    const QuicBuiltPacketV1& packet) const noexcept {
+  if (packet.end_offset > datagram.size() ||
+      packet.payload_offset + kQuicAEADTagSize > packet.end_offset ||
+      packet.packet_number_offset + packet.packet_number_length !=
+          packet.payload_offset) {
+    return QuicPacketProtectionErrorStatus::kMalformed;
+  }
+  std::size_t sample_offset =
+      packet.packet_number_offset + kQuicHeaderProtectionSampleOffset;
+  if (sample_offset + kQuicHeaderProtectionSampleSize > packet.end_offset) {
+    return QuicPacketProtectionErrorStatus::kTooShort;
+  }
+
+  std::uint8_t* base = datagram.data();
+  std::size_t tag_offset = packet.end_offset - kQuicAEADTagSize;
+  aead.Seal(Nonce(packet.packet_number),
+            std::span<const std::uint8_t>(
+                base + packet.header_offset,
+                packet.payload_offset - packet.header_offset),
+            std::span<std::uint8_t>(base + packet.payload_offset,
+                                    tag_offset - packet.payload_offset),
+            base + tag_offset);
+
+  QuicHeaderProtectionMask mask = HeaderProtectionMask(base + sample_offset);
+  base[packet.header_offset] ^= static_cast<std::uint8_t>(
+      mask[0] & QuicPacketProtectionUtil::FirstByteMask(packet.long_header));
+  QuicPacketProtectionUtil::MaskPacketNumber(
+      base + packet.packet_number_offset, mask, packet.packet_number_length);
+  return QuicPacketProtectionErrorStatus::kSuccess;
+}
+
+QuicPacketProtectionErrorStatus QuicPacketProtectionKeys::SampleOffset(
+    std::span<const std::uint8_t> datagram, const QuicBuiltPacketV1& packet,
+    std::size_t& sample_offset) noexcept {
+  if (packet.end_offset > datagram.size() ||
+      packet.packet_number_offset <= packet.header_offset) {
+    return QuicPacketProtectionErrorStatus::kMalformed;
+  }
+  sample_offset =
+      packet.packet_number_offset + kQuicHeaderProtectionSampleOffset;
+  if (sample_offset + kQuicHeaderProtectionSampleSize > packet.end_offset) {
+    return QuicPacketProtectionErrorStatus::kTooShort;
+  }
+  return QuicPacketProtectionErrorStatus::kSuccess;
+}
+
+void QuicPacketProtectionKeys::RemoveHeaderProtection(
+    std::span<std::uint8_t> datagram, QuicBuiltPacketV1& packet,
+    const QuicHeaderProtectionMask& mask,
+    std::uint64_t largest_packet_number) const noexcept {
+  std::uint8_t* base = datagram.data();
+  std::uint8_t& first_byte = base[packet.header_offset];
+  first_byte ^= static_cast<std::uint8_t>(
+      mask[0] & QuicPacketProtectionUtil::FirstByteMask(packet.long_header));
+  packet.packet_number_length =
+      static_cast<std::uint8_t>((first_byte & 0b11) + 1);
+
+  std::uint64_t truncated = QuicPacketProtectionUtil::MaskPacketNumber(
+      base + packet.packet_number_offset, mask, packet.packet_number_length);
+  packet.payload_offset =
+      packet.packet_number_offset + packet.packet_number_length;
+  packet.packet_number = DecodeQuicPacketNumber(
+      largest_packet_number, truncated, packet.packet_number_length);
+}
+
+QuicPacketProtectionErrorStatus QuicPacketProtectionKeys::OpenPayload(
+    std::span<std::uint8_t> datagram,
+    const QuicBuiltPacketV1& packet) const noexcept {
+  // the sample check leaves room for the tag after the longest Packet Number
+  std::uint8_t* base = datagram.data();
+  std::size_t tag_offset = packet.end_offset - kQuicAEADTagSize;
+  bool authentic = aead.Open(
+      Nonce(packet.packet_number),
+      std::span<const std::uint8_t>(
+          base + packet.header_offset,
+          packet.payload_offset - packet.header_offset),
+      std::span<std::uint8_t>(base + packet.payload_offset,
+                              tag_offset - packet.payload_offset),
+      base + tag_offset);
+  return authentic ? QuicPacketProtectionErrorStatus::kSuccess
+                   : QuicPacketProtectionErrorStatus::kAuthentication;
+}
+
+QuicPacketProtectionErrorStatus QuicPacketProtectionKeys::Unprotect(
+    std::span<std::uint8_t> datagram, QuicBuiltPacketV1& packet,
+    std::uint64_t largest_packet_number) const noexcept {
+  std::size_t sample_offset = 0;
+  QuicPacketProtectionErrorStatus status =
+      SampleOffset(datagram, packet, sample_offset);
+  if (status != QuicPacketProtectionErrorStatus::kSuccess) {
+    return status;
+  }
+  RemoveHeaderProtection(
+      datagram, packet, HeaderProtectionMask(datagram.data() + sample_offset),
+      largest_packet_number);
+  return OpenPayload(datagram, packet);
+}
+
+void QuicPacketProtectionKeys::UnprotectBatch(
+    std::span<const std::span<std::uint8_t>> datagrams,
+    std::span<QuicBuiltPacketV1> packets, std::uint64_t largest_packet_number,
+    std::span<QuicPacketProtectionErrorStatus> results) const noexcept {
+  std::size_t count = std::min({datagrams.size(), packets.size(),
+                                results.size()});
+  for (std::size_t first = 0; first < count;
+       first += kQuicHeaderProtectionBatchSize) {
+    std::size_t last =
+        std::min(count, first + kQuicHeaderProtectionBatchSize);
+
+    // Only packets with a valid sample take part in the batch
+    std::array<const std::uint8_t*, kQuicHeaderProtectionBatchSize> samples;
+    std::array<std::size_t, kQuicHeaderProtectionBatchSize> sampled;
+    std::size_t sample_count = 0;
+    for (std::size_t i = first; i < last; i++) {
+      std::size_t sample_offset = 0;
+      results[i] = SampleOffset(datagrams[i], packets[i], sample_offset);
+      if (results[i] == QuicPacketProtectionErrorStatus::kSuccess) {
+        samples[sample_count] = datagrams[i].data() + sample_offset;
+        sampled[sample_count++] = i;
+      }
+    }
+
+    std::array<QuicHeaderProtectionMask, kQuicHeaderProtectionBatchSize>
+        masks;
+    HeaderProtectionMasks(samples.data(), masks.data(), sample_count);
+    for (std::size_t j = 0; j < sample_count; j++) {
+      std::size_t i = sampled[j];
+      RemoveHeaderProtection(datagrams[i], packets[i], masks[j],
+                             largest_packet_number);
+      results[i] = OpenPayload(datagrams[i], packets[i]);
+    }
+  }
+}
+
+template <QuicVersionTraits Version>
+void DeriveQuicInitialKeys(
+    std::span<const std::uint8_t> destination_connection_id,
+    QuicInitialKeys& keys) noexcept {
+  QuicSHA256Digest initial_secret =
+      QuicHKDFExtract(Version::kInitialSalt, destination_connection_id);
+  QuicSHA256Digest secret;
+  QuicHKDFExpandLabel(initial_secret, "client in", secret);
+  keys.client.SetSecret<Version>(secret);
+  QuicHKDFExpandLabel(initial_secret, "server in", secret);
+  keys.server.SetSecret<Version>(secret);
+}
+
+template <QuicVersionTraits Version>
+QuicPacketProtectionErrorStatus LocateQuicProtectedPacket(
+    std::span<const std::uint8_t> datagram, std::size_t offset,
+    std::size_t short_connection_id_length,
+    QuicBuiltPacketV1& packet) noexcept {
+  QuicWireReader reader(datagram, offset);
+  std::uint8_t first_byte = reader.Read<std::uint8_t>();
+  if (!reader.Ok()) {
+    return QuicPacketProtectionErrorStatus::kMalformed;
+  }
+
+  packet = QuicBuiltPacketV1{};
+  packet.header_offset = offset;
+  packet.long_header = first_byte & 0x80;
+  if (!packet.long_header) {
+    reader.Skip(short_connection_id_length);
+    packet.packet_number_offset = reader.Position();
+    packet.end_offset = datagram.size();
+    return reader.Ok() ? QuicPacketProtectionErrorStatus::kSuccess
+                       : QuicPacketProtectionErrorStatus::kMalformed;
+  }
+
+  if (reader.Read<std::uint32_t>() != Version::kVersion) {
+    return QuicPacketProtectionErrorStatus::kMalformed;
+  }
+  QuicLongHeaderPacketTypeV1 type = Version::LongPacketType(first_byte);
+  if (type == QuicLongHeaderPacketTypeV1::kRetry) {
+    return QuicPacketProtectionErrorStatus::kMalformed;
+  }
+  reader.Skip(reader.Read<std::uint8_t>());
+  reader.Skip(reader.Read<std::uint8_t>());
+  if (type == QuicLongHeaderPacketTypeV1::kInitial) {
+    reader.Skip(reader.ReadVarInt());
+  }
+  std::uint64_t length = reader.ReadVarInt();
+  packet.packet_number_offset = reader.Position();
+  reader.Skip(length);
+  packet.end_offset = reader.Position();
+  return reader.Ok() ? QuicPacketProtectionErrorStatus::kSuccess
+                     : QuicPacketProtectionErrorStatus::kMalformed;
+}
+
+template void DeriveQuicInitialKeys<QuicVersion1>(
+    std::span<const std::uint8_t>, QuicInitialKeys&) noexcept;
+template void DeriveQuicInitialKeys<QuicVersion2>(
+    std::span<const std::uint8_t>, QuicInitialKeys&) noexcept;
+template QuicPacketProtectionErrorStatus
+LocateQuicProtectedPacket<QuicVersion1>(std::span<const std::uint8_t>,
+                                        std::size_t, std::size_t,
+                                        QuicBuiltPacketV1&) noexcept;
+template QuicPacketProtectionErrorStatus
+LocateQuicProtectedPacket<QuicVersion2>(std::span<const std::uint8_t>,
+                                        std::size_t, std::size_t,
+                                        QuicBuiltPacketV1&) noexcept;
+
+}  // namespace bedrock::network
@@ -0,0 +1,197 @@
+#include "networking/quic/quic_path_mtu.h"
+
+#include <algorithm>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+std::size_t WriteQuicMaxUDPPayloadSize(
+    std::uint64_t max_udp_payload_size, std::span<std::uint8_t> out) noexcept {
+  std::size_t value_size = QuicVarIntLength(max_udp_payload_size);
+  std::size_t size = QuicVarIntLength(kQuicMaxUDPPayloadSizeParameterID) +
+                     QuicVarIntLength(value_size) + value_size;
+  if (out.size() < size) {
+    return 0;
+  }
+  std::uint8_t* cursor =
+      StoreQuicVarInt(out.data(), kQuicMaxUDPPayloadSizeParameterID);
+  cursor = StoreQuicVarInt(cursor, value_size);
+  StoreQuicVarInt(cursor, max_udp_payload_size);
+  return size;
+}
+
+bool ReadQuicMaxUDPPayloadSize(
+    std::span<const std::uint8_t> transport_parameters,
+    std::uint64_t& max_udp_payload_size) noexcept {
+  max_udp_payload_size = kQuicMaxUDPPayloadSize;
+  QuicWireReader reader(transport_parameters);
+  while (!reader.Empty()) {
+    std::uint64_t id = reader.ReadVarInt();
+    std::uint64_t length = reader.ReadVarInt();
+    std::span<const std::uint8_t> value = reader.ReadBytes(length);
+    if (!reader.Ok()) {
+      return false;
+    }
+    if (id != kQuicMaxUDPPayloadSizeParameterID) {
+      continue;
+    }
+    QuicWireReader value_reader(value);
+    max_udp_payload_size = value_reader.ReadVarInt();
+    if (!value_reader.Ok() || !value_reader.Empty() ||
+        max_udp_payload_size < kQuicBasePLPMTU) {
+      max_udp_payload_size = kQuicMaxUDPPayloadSize;
+      return false;
+    }
+  }
+  return true;
+}
+
+QuicPathMTUDiscovery::QuicPathMTUDiscovery(
+    std::size_t max_udp_payload_size) noexcept
+    : max_size(std::clamp(max_udp_payload_size, kQuicBasePLPMTU,
+                          kQuicLocalMaxUDPPayloadSize)),
+      search_high(max_size) {}
+
+void QuicPathMTUDiscovery::Enable() noexcept {
+  if (state != QuicPMTUState::kDisabled) {
+    return;
+  }
+  state = QuicPMTUState::kSearching;
+  search_high = max_size;
+  NextProbe();
+}
+
+void QuicPathMTUDiscovery::SetPeerMaxUDPPayloadSize(
+    std::size_t size) noexcept {
+  max_size = std::min(max_size, std::max(size, kQuicBasePLPMTU));
+  search_high = std::min(search_high, max_size);
+  if (plpmtu > max_size) {
+    plpmtu = max_size;
+  }
+  if (state == QuicPMTUState::kSearching && !probe_in_flight) {
+    NextProbe();
+  }
+}
+
+bool QuicPathMTUDiscovery::OnPeerTransportParameters(
+    std::span<const std::uint8_t> transport_parameters) noexcept {
+  std::uint64_t size = 0;
+  if (!ReadQuicMaxUDPPayloadSize(transport_parameters, size)) {
+    return false;
+  }
+  SetPeerMaxUDPPayloadSize(size);
+  return true;
+}
+
+// search_completed stays unset until the first call after the search
+// completes, which starts the raise timer.
+bool QuicPathMTUDiscovery::ShouldProbe(
+    std::chrono::steady_clock::time_point now) noexcept {
+  switch (state) {
+    case QuicPMTUState::kDisabled:
+      return false;
+    case QuicPMTUState::kSearching:
+      return !probe_in_flight;
+    case QuicPMTUState::kSearchComplete:
+      break;
+  }
+  if (search_completed == std::chrono::steady_clock::time_point{}) {
+    search_completed = now;
+    return false;
+  }
+  if (now - search_completed < kQuicPMTURaiseInterval) {
+    return false;
+  }
+  search_completed = now;
+  search_high = max_size;
+  state = QuicPMTUState::kSearching;
+  NextProbe();
+  return state == QuicPMTUState::kSearching;
+}
+
+void QuicPathMTUDiscovery::OnProbeSent(std::uint64_t packet_number) noexcept {
+  probe_in_flight = true;
+  probe_packet_number = packet_number;
+  probe_count++;
+}
+
+void QuicPathMTUDiscovery::OnProbeAcked(std::uint64_t packet_number) noexcept {
+  if (!IsProbe(packet_number)) {
+    return;
+  }
+  probe_in_flight = false;
+  large_losses = 0;
+  plpmtu = std::max(plpmtu, std::min(probe_size, max_size));
+  if (state == QuicPMTUState::kSearching) {
+    NextProbe();
+  }
+}
+
+void QuicPathMTUDiscovery::OnProbeLost(std::uint64_t packet_number) noexcept {
+  if (!IsProbe(packet_number)) {
+    return;
+  }
+  probe_in_flight = false;
+  // one loss may be congestion; the same size is tried again until
+  // kQuicMaxPMTUProbes were lost
+  if (probe_count >= kQuicMaxPMTUProbes) {
+    search_high = probe_size - 1;
+    NextProbe();
+  }
+}
+
+void QuicPathMTUDiscovery::OnPacketTooBig(std::size_t size) noexcept {
+  if (state == QuicPMTUState::kDisabled || size <= kQuicBasePLPMTU) {
+    return;
+  }
+  if (size <= plpmtu) {
+    Restart(size - 1);
+    return;
+  }
+  search_high = std::min(search_high, size - 1);
+  if (probe_in_flight && probe_size >= size) {
+    probe_in_flight = false;
+  }
+  if (state == QuicPMTUState::kSearching && !probe_in_flight) {
+    NextProbe();
+  }
+}
+
+void QuicPathMTUDiscovery::OnPacketAcked(std::size_t size) noexcept {
+  if (size > kQuicBasePLPMTU) {
+    large_losses = 0;
+  }
+}
+
+void QuicPathMTUDiscovery::OnPacketLost(std::size_t size) noexcept {
+  if (state == QuicPMTUState::kDisabled || size <= kQuicBasePLPMTU) {
+    return;
+  }
+  if (++large_losses >= kQuicPMTUBlackHoleThreshold) {
+    Restart(plpmtu - 1);
+  }
+}
+
+void QuicPathMTUDiscovery::NextProbe() noexcept {
+  probe_count = 0;
+  if (search_high < plpmtu + kQuicPMTUSearchGranularity) {
+    state = QuicPMTUState::kSearchComplete;
+    search_completed = {};
+    return;
+  }
+  probe_size = plpmtu + (search_high - plpmtu + 1) / 2;
+}
+
+// Falls back to the base PLPMTU, which every path carries, and searches
+// again up to high (rfc8899 section 5.2, BASE state).
+void QuicPathMTUDiscovery::Restart(std::size_t high) noexcept {
+  plpmtu = kQuicBasePLPMTU;
+  search_high = std::max(high, kQuicBasePLPMTU);
+  large_losses = 0;
+  probe_in_flight = false;
+  state = QuicPMTUState::kSearching;
+  NextProbe();
+}
+
+}  // namespace bedrock::network
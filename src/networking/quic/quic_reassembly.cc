@@ -0,0 +1,146 @@
+#include "networking/quic/quic_reassembly.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace bedrock::network {
+
+QuicReassemblyErrorStatus QuicReassemblyBuffer::Insert(
+    std::uint64_t offset, std::span<const std::uint8_t> data, bool fin,
+    const QuicPacketBufferRef& packet) {
+  std::uint64_t end = offset + data.size();
+  if (final_size_known) {
+    if (end > largest_received || (fin && end != largest_received)) {
+      return QuicReassemblyErrorStatus::kFinalSize;
+    }
+  } else if (fin && end < largest_received) {
+    return QuicReassemblyErrorStatus::kFinalSize;
+  }
+  if (end > limit) {
+    return QuicReassemblyErrorStatus::kFlowControl;
+  }
+
+  // everything below contiguous_end is held already, so new data can only
+  // go into gaps between the fragments from index contiguous on
+  std::uint64_t begin = std::max(offset, contiguous_end);
+  auto first = std::partition_point(
+      fragments.begin() + static_cast<std::ptrdiff_t>(contiguous),
+      fragments.end(),
+      [begin](const Fragment& fragment) { return fragment.End() <= begin; });
+  // Walks the gaps of [begin, end) left by the fragments from first on.
+  auto for_each_gap = [&](auto&& visit) {
+    std::uint64_t cursor = begin;
+    for (auto it = first; cursor < end; ++it) {
+      std::uint64_t gap_end =
+          it == fragments.end() ? end : std::min(end, it->offset);
+      if (cursor < gap_end && !visit(it, cursor, gap_end)) {
+        return;
+      }
+      if (it == fragments.end()) {
+        return;
+      }
+      cursor = std::max(cursor, it->End());
+    }
+  };
+
+  std::size_t gaps = 0;
+  for_each_gap([&gaps](auto, std::uint64_t, std::uint64_t) {
+    gaps++;
+    return true;
+  });
+  if (gaps != 0 && FragmentCount() + gaps > fragment_limit) {
+    return QuicReassemblyErrorStatus::kBusy;
+  }
+  if (gaps == 1) {
+    // the common case, also for in-order data
+    for_each_gap([&](auto it, std::uint64_t from, std::uint64_t to) {
+      fragments.insert(it, Fragment{from, data.data() + (from - offset),
+                                    to - from, packet});
+      return false;
+    });
+  } else if (gaps > 1) {
+    std::vector<Fragment> pieces;
+    pieces.reserve(gaps);
+    std::ptrdiff_t position = first - fragments.begin();
+    for_each_gap([&](auto, std::uint64_t from, std::uint64_t to) {
+      pieces.push_back(
+          Fragment{from, data.data() + (from - offset), to - from, packet});
+      return true;
+    });
+    // gaps alternate with the existing fragments, so merge the two runs
+    std::vector<Fragment> merged;
+    merged.reserve(fragments.size() + gaps);
+    std::move(fragments.begin(), fragments.begin() + position,
+              std::back_inserter(merged));
+    std::merge(std::make_move_iterator(fragments.begin() + position),
+               std::make_move_iterator(fragments.end()),
+               std::make_move_iterator(pieces.begin()),
+               std::make_move_iterator(pieces.end()),
+               std::back_inserter(merged),
+               [](const Fragment& lhs, const Fragment& rhs) {
+                 return lhs.offset < rhs.offset;
+               });
+    fragments = std::move(merged);
+  }
+
+  largest_received = std::max(largest_received, end);
+  final_size_known |= fin;
+  ExtendContiguous();
+  return QuicReassemblyErrorStatus::kSuccess;
+}
+
+std::span<const std::uint8_t> QuicReassemblyBuffer::Front() const noexcept {
+  if (head == contiguous) {
+    return {};
+  }
+  const Fragment& fragment = fragments[head];
+  return {fragment.data, fragment.length};
+}
+
+std::size_t QuicReassemblyBuffer::Peek(
+    std::span<std::span<const std::uint8_t>> spans) const {
+  std::size_t count = std::min(spans.size(), contiguous - head);
+  for (std::size_t i = 0; i < count; i++) {
+    const Fragment& fragment = fragments[head + i];
+    spans[i] = {fragment.data, fragment.length};
+  }
+  return count;
+}
+
+void QuicReassemblyBuffer::Consume(std::uint64_t bytes) noexcept {
+  bytes = std::min(bytes, ReadableBytes());
+  read_offset += bytes;
+  while (bytes != 0) {
+    Fragment& fragment = fragments[head];
+    std::uint64_t taken = std::min(bytes, fragment.length);
+    fragment.offset += taken;
+    fragment.data += taken;
+    fragment.length -= taken;
+    bytes -= taken;
+    if (fragment.length == 0) {
+      fragment.packet.Reset();
+      head++;
+    }
+  }
+  // drop the read prefix once it outweighs the unread fragments
+  if (head == fragments.size()) {
+    fragments.clear();
+    contiguous = 0;
+    head = 0;
+  } else if (head >= 64 && head * 2 >= fragments.size()) {
+    fragments.erase(fragments.begin(),
+                    fragments.begin() + static_cast<std::ptrdiff_t>(head));
+    contiguous -= head;
+    head = 0;
+  }
+}
+
+void QuicReassemblyBuffer::ExtendContiguous() noexcept {
+  while (contiguous < fragments.size() &&
+         fragments[contiguous].offset == contiguous_end) {
+    contiguous_end = fragments[contiguous].End();
+    contiguous++;
+  }
+}
+
+}  // namespace bedrock::network
@@ -0,0 +1,367 @@
+#include "networking/quic/quic_retry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+namespace QuicRetryUtil {
+
+// IP version, address and port of the peer, authenticated with the token
+using AddressBytes = std::array<std::uint8_t, 1 + 16 + 2>;
+
+static AddressBytes SerializeAddress(const Address& peer) noexcept {
+  AddressBytes bytes{};
+  IPVersion version = peer.GetIPVersion().data;
+  if (version == IPVersion::kIPV4) {
+    auto address = static_cast<::sockaddr_in>(peer);
+    bytes[0] = 4;
+    std::memcpy(bytes.data() + 1, &address.sin_addr, 4);
+    std::memcpy(bytes.data() + 17, &address.sin_port, 2);
+  } else if (version == IPVersion::kIPV6) {
+    auto address = static_cast<::sockaddr_in6>(peer);
+    bytes[0] = 6;
+    std::memcpy(bytes.data() + 1, &address.sin6_addr, 16);
+    std::memcpy(bytes.data() + 17, &address.sin6_port, 2);
+  }
+  return bytes;
+}
+
+template <typename TimePoint>
+static std::uint64_t Milliseconds(TimePoint time) noexcept {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          time.time_since_epoch())
+          .count());
+}
+
+static constexpr std::size_t kEpochSize = 1;
+static constexpr std::size_t kTimeSize = 8;
+
+}  // namespace QuicRetryUtil
+
+template <QuicVersionTraits Version>
+QuicRetryErrorStatus ParseQuicInitialHeader(
+    std::span<const std::uint8_t> datagram,
+    QuicInitialHeaderView& header) noexcept {
+  QuicWireReader reader(datagram);
+  std::uint8_t first_byte = reader.Read<std::uint8_t>();
+  if (!(first_byte & 0x80) ||
+      reader.Read<std::uint32_t>() != Version::kVersion ||
+      Version::LongPacketType(first_byte) !=
+          QuicLongHeaderPacketTypeV1::kInitial) {
+    return QuicRetryErrorStatus::kMalformed;
+  }
+  header.destination_connection_id =
+      reader.ReadBytes(reader.Read<std::uint8_t>());
+  header.source_connection_id = reader.ReadBytes(reader.Read<std::uint8_t>());
+  header.token = reader.ReadBytes(reader.ReadVarInt());
+  if (!reader.Ok() ||
+      header.destination_connection_id.size() > kQuicMaxConnectionIDLength ||
+      header.source_connection_id.size() > kQuicMaxConnectionIDLength) {
+    return QuicRetryErrorStatus::kMalformed;
+  }
+  return QuicRetryErrorStatus::kSuccess;
+}
+
+// Retry Pseudo-Packet {
+//   ODCID Length (8),
+//   Original Destination Connection ID (0..160),
+//   Retry packet without the Retry Integrity Tag
+// }
+template <QuicVersionTraits Version>
+static void RetryIntegrityTag(std::span<const std::uint8_t> retry_packet,
+                              std::span<const std::uint8_t> original_id,
+                              std::uint8_t* tag) noexcept {
+  std::array<std::uint8_t, 1 + kQuicMaxConnectionIDLength +
+                               kQuicMaxRetryPacketSize>
+      pseudo_packet;
+  pseudo_packet[0] = static_cast<std::uint8_t>(original_id.size());
+  std::copy(original_id.begin(), original_id.end(), pseudo_packet.begin() + 1);
+  std::copy(retry_packet.begin(), retry_packet.end(),
+            pseudo_packet.begin() + 1 +
+                static_cast<std::ptrdiff_t>(original_id.size()));
+
+  QuicAES128GCM aead(Version::kRetryIntegrityKey);
+  aead.Seal(Version::kRetryIntegrityNonce,
+            std::span(pseudo_packet)
+                .first(1 + original_id.size() + retry_packet.size()),
+            {}, tag);
+}
+
+template <QuicVersionTraits Version>
+bool VerifyQuicRetryIntegrity(
+    std::span<const std::uint8_t> retry_packet,
+    std::span<const std::uint8_t> original_connection_id) noexcept {
+  if (retry_packet.size() < kQuicRetryIntegrityTagSize ||
+      retry_packet.size() > kQuicMaxRetryPacketSize ||
+      original_connection_id.size() > kQuicMaxConnectionIDLength) {
+    return false;
+  }
+  std::array<std::uint8_t, kQuicRetryIntegrityTagSize> tag;
+  RetryIntegrityTag<Version>(
+      retry_packet.first(retry_packet.size() - kQuicRetryIntegrityTagSize),
+      original_connection_id, tag.data());
+  // constant time, like any tag comparison
+  std::uint8_t difference = 0;
+  for (std::size_t i = 0; i < tag.size(); i++) {
+    difference |= static_cast<std::uint8_t>(
+        tag[i] ^ retry_packet[retry_packet.size() - tag.size() + i]);
+  }
+  return difference == 0;
+}
+
+QuicRetryResponder::QuicRetryResponder(
+    const QuicRetryConfig& retry_config) noexcept
+    : config(retry_config) {
+  if (config.key_rotation_period.count() <= 0) {
+    config.key_rotation_period = std::chrono::seconds(30);
+  }
+  // An all-zero secret is public, so tokens sealed under it could be forged
+  if (std::all_of(config.secret.begin(), config.secret.end(),
+                  [](std::uint8_t byte) { return byte == 0; })) {
+    config.secret = GenerateSecret();
+  }
+  std::random_device device;
+  nonce_prefix = device();
+}
+
+QuicRetrySecret QuicRetryResponder::GenerateSecret() noexcept {
+  std::random_device device;
+  QuicRetrySecret secret;
+  for (std::size_t i = 0; i < secret.size(); i += 4) {
+    std::uint32_t value = device();
+    std::memcpy(secret.data() + i, &value, 4);
+  }
+  return secret;
+}
+
+bool QuicRetryResponder::RetryRequired(
+    std::chrono::steady_clock::time_point now) noexcept {
+  if (config.handshake_rate_threshold == 0) {
+    return true;
+  }
+
+  std::int64_t milliseconds =
+      static_cast<std::int64_t>(QuicRetryUtil::Milliseconds(now));
+  std::int64_t current = milliseconds / 1000;
+  if (current != window) {
+    previous_window_count = current == window + 1 ? window_count : 0;
+    window_count = 0;
+    window = current;
+  }
+  window_count++;
+
+  // The previous window counts in proportion to its overlap with the last
+  // second.
+  std::uint64_t elapsed = static_cast<std::uint64_t>(milliseconds % 1000);
+  std::uint64_t rate =
+      window_count + previous_window_count * (1000 - elapsed) / 1000;
+  return rate > config.handshake_rate_threshold;
+}
+
+std::uint64_t QuicRetryResponder::Epoch(
+    std::chrono::system_clock::time_point now) const noexcept {
+  return QuicRetryUtil::Milliseconds(now) /
+         static_cast<std::uint64_t>(config.key_rotation_period.count());
+}
+
+// key = HMAC-SHA256(secret, "quic retry token" || epoch)[0..16)
+const QuicAES128GCM& QuicRetryResponder::EpochKey(
+    std::uint64_t epoch) noexcept {
+  CachedKey& cached = keys[epoch & 1];
+  if (!cached.valid || cached.epoch != epoch) {
+    constexpr std::string_view kLabel = "quic retry token";
+    std::array<std::uint8_t, kLabel.size() + 8> input;
+    std::memcpy(input.data(), kLabel.data(), kLabel.size());
+    StoreBigEndian(input.data() + kLabel.size(), epoch);
+    QuicSHA256Digest digest = QuicHMACSHA256(config.secret, input);
+    cached.aead.SetKey(std::span(digest).first<kQuicAES128KeySize>());
+    cached.epoch = epoch;
+    cached.valid = true;
+  }
+  return cached.aead;
+}
+
+// Token {
+//   Key Epoch (8), low byte of the epoch
+//   Nonce (96),
+//   Sealed {
+//     Issue Time (64), milliseconds of the system clock
+//     ODCID Length (8),
+//     Original Destination Connection ID (0..160),
+//   },
+//   Tag (128),
+// }
+QuicRetryErrorStatus QuicRetryResponder::IssueToken(
+    const Address& peer, std::span<const std::uint8_t> original_connection_id,
+    std::chrono::system_clock::time_point now, std::span<std::uint8_t> token,
+    std::size_t& size) noexcept {
+  using QuicRetryUtil::kEpochSize;
+  using QuicRetryUtil::kTimeSize;
+
+  std::size_t sealed_size = kTimeSize + 1 + original_connection_id.size();
+  std::size_t token_size =
+      kEpochSize + kQuicAEADNonceSize + sealed_size + kQuicAEADTagSize;
+  if (original_connection_id.size() > kQuicMaxConnectionIDLength) {
+    return QuicRetryErrorStatus::kMalformed;
+  }
+  if (token.size() < token_size) {
+    return QuicRetryErrorStatus::kNoSpace;
+  }
+
+  std::uint64_t epoch = Epoch(now);
+  std::uint8_t* out = token.data();
+  out[0] = static_cast<std::uint8_t>(epoch);
+  std::uint8_t* nonce = out + kEpochSize;
+  StoreBigEndian(nonce, nonce_prefix);
+  StoreBigEndian(nonce + 4, nonce_counter++);
+
+  std::uint8_t* sealed = nonce + kQuicAEADNonceSize;
+  StoreBigEndian(sealed, QuicRetryUtil::Milliseconds(now));
+  sealed[kTimeSize] = static_cast<std::uint8_t>(original_connection_id.size());
+  std::copy(original_connection_id.begin(), original_connection_id.end(),
+            sealed + kTimeSize + 1);
+
+  QuicRetryUtil::AddressBytes address = QuicRetryUtil::SerializeAddress(peer);
+  EpochKey(epoch).Seal(
+      std::span<const std::uint8_t, kQuicAEADNonceSize>(nonce,
+                                                        kQuicAEADNonceSize),
+      address, std::span<std::uint8_t>(sealed, sealed_size),
+      sealed + sealed_size);
+  size = token_size;
+  return QuicRetryErrorStatus::kSuccess;
+}
+
+QuicRetryErrorStatus QuicRetryResponder::ValidateToken(
+    std::span<const std::uint8_t> token, const Address& peer,
+    std::chrono::system_clock::time_point now,
+    std::span<std::uint8_t> original_connection_id,
+    std::size_t& size) noexcept {
+  using QuicRetryUtil::kEpochSize;
+  using QuicRetryUtil::kTimeSize;
+
+  constexpr std::size_t kMinTokenSize =
+      kEpochSize + kQuicAEADNonceSize + kTimeSize + 1 + kQuicAEADTagSize;
+  if (token.size() < kMinTokenSize || token.size() > kQuicMaxRetryTokenSize) {
+    return QuicRetryErrorStatus::kInvalid;
+  }
+
+  // Only the current and the previous epoch are accepted
+  std::uint64_t epoch = Epoch(now);
+  if (token[0] != static_cast<std::uint8_t>(epoch)) {
+    if (epoch == 0 || token[0] != static_cast<std::uint8_t>(epoch - 1)) {
+      return QuicRetryErrorStatus::kExpired;
+    }
+    epoch--;
+  }
+
+  std::array<std::uint8_t, kQuicMaxRetryTokenSize> copy;
+  std::copy(token.begin(), token.end(), copy.begin());
+  std::uint8_t* nonce = copy.data() + kEpochSize;
+  std::uint8_t* sealed = nonce + kQuicAEADNonceSize;
+  std::size_t sealed_size =
+      token.size() - kEpochSize - kQuicAEADNonceSize - kQuicAEADTagSize;
+  QuicRetryUtil::AddressBytes address = QuicRetryUtil::SerializeAddress(peer);
+  if (!EpochKey(epoch).Open(
+          std::span<const std::uint8_t, kQuicAEADNonceSize>(
+              nonce, kQuicAEADNonceSize),
+          address, std::span<std::uint8_t>(sealed, sealed_size),
+          sealed + sealed_size)) {
+    return QuicRetryErrorStatus::kInvalid;
+  }
+
+  std::uint64_t issued = LoadBigEndian<std::uint64_t>(sealed);
+  std::uint64_t milliseconds = QuicRetryUtil::Milliseconds(now);
+  if (issued > milliseconds ||
+      milliseconds - issued >
+          static_cast<std::uint64_t>(config.token_lifetime.count())) {
+    return QuicRetryErrorStatus::kExpired;
+  }
+  std::size_t id_size = sealed[kTimeSize];
+  if (id_size != sealed_size - kTimeSize - 1) {
+    return QuicRetryErrorStatus::kInvalid;
+  }
+  if (original_connection_id.size() < id_size) {
+    return QuicRetryErrorStatus::kNoSpace;
+  }
+  std::memcpy(original_connection_id.data(), sealed + kTimeSize + 1, id_size);
+  size = id_size;
+  return QuicRetryErrorStatus::kSuccess;
+}
+
+// Retry Packet {
+//   Header Form (1) = 1,
+//   Fixed Bit (1) = 1,
+//   Long Packet Type (2) = 3,
+//   Unused (4),
+//   Version (32),
+//   Destination Connection ID Length (8),
+//   Destination Connection ID (0..160),
+//   Source Connection ID Length (8),
+//   Source Connection ID (0..160),
+//   Retry Token (..),
+//   Retry Integrity Tag (128),
+// }
+template <QuicVersionTraits Version>
+QuicRetryErrorStatus QuicRetryResponder::Respond(
+    const QuicInitialHeaderView& initial, const Address& peer,
+    std::span<const std::uint8_t> retry_connection_id,
+    std::chrono::system_clock::time_point now,
+    std::span<std::uint8_t> response, std::size_t& size) noexcept {
+  if (retry_connection_id.size() > kQuicMaxConnectionIDLength ||
+      initial.source_connection_id.size() > kQuicMaxConnectionIDLength) {
+    return QuicRetryErrorStatus::kMalformed;
+  }
+
+  std::array<std::uint8_t, kQuicMaxRetryTokenSize> token;
+  std::size_t token_size = 0;
+  QuicRetryErrorStatus status = IssueToken(
+      peer, initial.destination_connection_id, now, token, token_size);
+  if (status != QuicRetryErrorStatus::kSuccess) {
+    return status;
+  }
+
+  QuicWireWriter writer(response);
+  writer.Write(static_cast<std::uint8_t>(
+      0xC0 | Version::LongPacketTypeBits(QuicLongHeaderPacketTypeV1::kRetry)));
+  writer.Write(Version::kVersion);
+  writer.Write(static_cast<std::uint8_t>(initial.source_connection_id.size()));
+  writer.WriteBytes(initial.source_connection_id);
+  writer.Write(static_cast<std::uint8_t>(retry_connection_id.size()));
+  writer.WriteBytes(retry_connection_id);
+  writer.WriteBytes(std::span(token).first(token_size));
+  std::size_t tag_offset = writer.Position();
+  writer.Skip(kQuicRetryIntegrityTagSize);
+  if (!writer.Ok()) {
+    return QuicRetryErrorStatus::kNoSpace;
+  }
+
+  RetryIntegrityTag<Version>(response.first(tag_offset),
+                             initial.destination_connection_id,
+                             response.data() + tag_offset);
+  size = writer.Position();
+  return QuicRetryErrorStatus::kSuccess;
+}
+
+template QuicRetryErrorStatus ParseQuicInitialHeader<QuicVersion1>(
+    std::span<const std::uint8_t>, QuicInitialHeaderView&) noexcept;
+template QuicRetryErrorStatus ParseQuicInitialHeader<QuicVersion2>(
+    std::span<const std::uint8_t>, QuicInitialHeaderView&) noexcept;
+template bool VerifyQuicRetryIntegrity<QuicVersion1>(
+    std::span<const std::uint8_t>, std::span<const std::uint8_t>) noexcept;
+template bool VerifyQuicRetryIntegrity<QuicVersion2>(
+    std::span<const std::uint8_t>, std::span<const std::uint8_t>) noexcept;
+template QuicRetryErrorStatus QuicRetryResponder::Respond<QuicVersion1>(
+    const QuicInitialHeaderView&, const Address&,
+    std::span<const std::uint8_t>, std::chrono::system_clock::time_point,
+    std::span<std::uint8_t>, std::size_t&) noexcept;
+template QuicRetryErrorStatus QuicRetryResponder::Respond<QuicVersion2>(
+    const QuicInitialHeaderView&, const Address&,
+    std::span<const std::uint8_t>, std::chrono::system_clock::time_point,
+    std::span<std::uint8_t>, std::size_t&) noexcept;
+
+}  // namespace bedrock::network
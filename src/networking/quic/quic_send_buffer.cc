@@ -0,0 +1,205 @@
+#include "networking/quic/quic_send_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bedrock::network {
+
+void QuicByteRangeSet::Add(std::uint64_t begin, std::uint64_t end) {
+  if (begin >= end) {
+    return;
+  }
+  // first range that ends at or after begin, and so touches or follows it
+  auto first = std::partition_point(
+      ranges.begin(), ranges.end(),
+      [begin](const Range& range) { return range.end < begin; });
+  auto last = first;
+  while (last != ranges.end() && last->begin <= end) {
+    begin = std::min(begin, last->begin);
+    end = std::max(end, last->end);
+    ++last;
+  }
+  if (first == last) {
+    ranges.insert(first, Range{begin, end});
+    return;
+  }
+  *first = Range{begin, end};
+  ranges.erase(first + 1, last);
+}
+
+void QuicByteRangeSet::Subtract(std::uint64_t begin, std::uint64_t end) {
+  if (begin >= end) {
+    return;
+  }
+  auto first = std::partition_point(
+      ranges.begin(), ranges.end(),
+      [begin](const Range& range) { return range.end <= begin; });
+  if (first == ranges.end() || first->begin >= end) {
+    return;
+  }
+  // a range strictly containing [begin, end) splits in two
+  if (first->begin < begin && first->end > end) {
+    Range upper{end, first->end};
+    first->end = begin;
+    ranges.insert(first + 1, upper);
+    return;
+  }
+  if (first->begin < begin) {
+    first->end = begin;
+    ++first;
+  }
+  auto last = first;
+  while (last != ranges.end() && last->end <= end) {
+    ++last;
+  }
+  if (last != ranges.end() && last->begin < end) {
+    last->begin = end;
+  }
+  ranges.erase(first, last);
+}
+
+void QuicByteRangeSet::TrimBelow(std::uint64_t offset) {
+  Subtract(0, offset);
+}
+
+std::size_t QuicSendBuffer::Write(std::span<const std::uint8_t> data) {
+  if (finished || BufferedBytes() >= buffer_limit) {
+    return 0;
+  }
+  std::size_t taken = static_cast<std::size_t>(
+      std::min<std::uint64_t>(data.size(), buffer_limit - BufferedBytes()));
+  std::size_t copied = 0;
+  while (copied < taken) {
+    std::uint64_t index = write_offset / kQuicSendBufferBlockSize - first_block;
+    if (index == blocks.size()) {
+      blocks.push_back(spare ? std::move(spare)
+                             : std::make_unique_for_overwrite<std::uint8_t[]>(
+                                   kQuicSendBufferBlockSize));
+    }
+    std::size_t within = write_offset % kQuicSendBufferBlockSize;
+    std::size_t length =
+        std::min(taken - copied, kQuicSendBufferBlockSize - within);
+    std::memcpy(blocks[index].get() + within, data.data() + copied, length);
+    copied += length;
+    write_offset += length;
+  }
+  return taken;
+}
+
+bool QuicSendBuffer::HasDataToSend(std::uint64_t send_limit) const noexcept {
+  return !lost.Empty() || sent_offset < std::min(write_offset, send_limit) ||
+         (fin_pending && sent_offset == write_offset);
+}
+
+bool QuicSendBuffer::NextFrame(std::uint64_t send_limit,
+                               QuicSentStreamFrameV1& frame) const noexcept {
+  auto contiguous = [](std::uint64_t offset, std::uint64_t length) {
+    return std::min<std::uint64_t>(
+        length, kQuicSendBufferBlockSize - offset % kQuicSendBufferBlockSize);
+  };
+
+  if (!lost.Empty()) {
+    const QuicByteRangeSet::Range& range = lost.Front();
+    frame.offset = range.begin;
+    frame.length = contiguous(range.begin, range.end - range.begin);
+  } else if (std::uint64_t end = std::min(write_offset, send_limit);
+             sent_offset < end) {
+    frame.offset = sent_offset;
+    frame.length = contiguous(sent_offset, end - sent_offset);
+  } else if (fin_pending && sent_offset == write_offset) {
+    frame.offset = write_offset;
+    frame.length = 0;
+  } else {
+    return false;
+  }
+  frame.fin = fin_pending && frame.offset + frame.length == write_offset;
+  return true;
+}
+
+std::span<const std::uint8_t> QuicSendBuffer::Data(
+    std::uint64_t offset, std::uint64_t length) const noexcept {
+  if (length == 0) {
+    return {};
+  }
+  std::uint64_t index = offset / kQuicSendBufferBlockSize - first_block;
+  std::size_t within = offset % kQuicSendBufferBlockSize;
+  return {blocks[index].get() + within,
+          static_cast<std::size_t>(std::min<std::uint64_t>(
+              length, kQuicSendBufferBlockSize - within))};
+}
+
+void QuicSendBuffer::OnSent(const QuicSentStreamFrameV1& frame) {
+  std::uint64_t end = frame.offset + frame.length;
+  sent_offset = std::max(sent_offset, end);
+  lost.Subtract(frame.offset, end);
+  if (frame.fin) {
+    fin_pending = false;
+  }
+}
+
+void QuicSendBuffer::OnAcked(const QuicSentStreamFrameV1& frame) {
+  std::uint64_t end = frame.offset + frame.length;
+  if (frame.fin) {
+    fin_acked = true;
+    fin_pending = false;
+  }
+  if (end <= acked_offset) {
+    return;
+  }
+  acked.Add(std::max(frame.offset, acked_offset), end);
+  lost.Subtract(frame.offset, end);
+  if (acked.Front().begin == acked_offset) {
+    acked_offset = acked.Front().end;
+    acked.TrimBelow(acked_offset);
+    lost.TrimBelow(acked_offset);
+    Release();
+  }
+}
+
+void QuicSendBuffer::OnLost(const QuicSentStreamFrameV1& frame) {
+  if (frame.fin && !fin_acked) {
+    fin_pending = true;
+  }
+  std::uint64_t begin = std::max(frame.offset, acked_offset);
+  std::uint64_t end = frame.offset + frame.length;
+  if (begin >= end) {
+    return;
+  }
+  lost.Add(begin, end);
+  // parts another transmission already got through need no repair
+  for (const QuicByteRangeSet::Range& range : acked.Ranges()) {
+    if (range.begin >= end) {
+      break;
+    }
+    lost.Subtract(range.begin, range.end);
+  }
+}
+
+void QuicSendBuffer::Release() {
+  if (acked_offset == write_offset) {
+    // nothing left to hold, not even the partly written last block
+    if (!spare && !blocks.empty()) {
+      spare = std::move(blocks.front());
+    }
+    blocks.clear();
+    first_block = write_offset / kQuicSendBufferBlockSize;
+    return;
+  }
+  std::size_t released = 0;
+  while (released < blocks.size() &&
+         (first_block + released + 1) * kQuicSendBufferBlockSize <=
+             acked_offset) {
+    released++;
+  }
+  if (released == 0) {
+    return;
+  }
+  if (!spare) {
+    spare = std::move(blocks.front());
+  }
+  blocks.erase(blocks.begin(),
+               blocks.begin() + static_cast<std::ptrdiff_t>(released));
+  first_block += released;
+}
+
+}  // namespace bedrock::network
@@ -0,0 +1,163 @@
+#include "networking/quic/quic_session_ticket.h"
+
+#include <bit>
+
+namespace bedrock::network {
+
+QuicSessionTicketErrorStatus QuicSessionTicket::SetIdentity(
+    std::span<const std::uint8_t> ticket) noexcept {
+  if (ticket.size() > identity.size()) {
+    return QuicSessionTicketErrorStatus::kTooLarge;
+  }
+  std::copy(ticket.begin(), ticket.end(), identity.begin());
+  identity_size = static_cast<std::uint16_t>(ticket.size());
+  return QuicSessionTicketErrorStatus::kSuccess;
+}
+
+std::uint32_t QuicSessionTicket::ObfuscatedAge(
+    std::chrono::steady_clock::time_point now) const noexcept {
+  auto age =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - received);
+  return static_cast<std::uint32_t>(age.count()) + age_add;
+}
+
+QuicSessionTicketCache::QuicSessionTicketCache(std::size_t capacity) noexcept {
+  std::size_t buckets = std::bit_ceil(std::max<std::size_t>(
+      1, (capacity + kQuicSessionTicketCacheWays - 1) /
+             kQuicSessionTicketCacheWays));
+  slots = std::make_unique<Slot[]>(buckets * kQuicSessionTicketCacheWays);
+  entries = std::make_unique<Entry[]>(buckets * kQuicSessionTicketCacheWays);
+  mask = buckets - 1;
+}
+
+// FNV-1a. Clients choose the server names they connect to, so there is no
+// one to aim collisions at a bucket.
+std::uint64_t QuicSessionTicketCache::Hash(
+    std::string_view server_name) noexcept {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (char c : server_name) {
+    hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001b3;
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+void QuicSessionTicketCache::Free(Shard& shard, std::size_t index) noexcept {
+  slots[index].hash = 0;
+  shard.size.fetch_sub(1, std::memory_order_relaxed);
+}
+
+QuicSessionTicketErrorStatus QuicSessionTicketCache::Insert(
+    std::string_view server_name, const QuicSessionTicket& ticket,
+    std::chrono::steady_clock::time_point now) noexcept {
+  if (server_name.size() > kQuicMaxServerNameLength) {
+    return QuicSessionTicketErrorStatus::kTooLarge;
+  }
+  if (ticket.Expired(now)) {
+    return QuicSessionTicketErrorStatus::kExpired;
+  }
+
+  std::uint64_t hash = Hash(server_name);
+  std::size_t bucket = Bucket(hash);
+  Shard& shard = ShardOf(bucket);
+  std::lock_guard lock(shard.mutex);
+
+  // Preference: the server's oldest ticket once it has its share, then a
+  // free slot, then an expired one, then the oldest of the bucket.
+  std::size_t first = bucket * kQuicSessionTicketCacheWays;
+  std::size_t end = first + kQuicSessionTicketCacheWays;
+  std::size_t same_server = 0;
+  std::size_t oldest_of_server = end;
+  std::size_t free_slot = end;
+  std::size_t expired = end;
+  std::size_t oldest = end;
+  for (std::size_t index = first; index < end; index++) {
+    const Slot& slot = slots[index];
+    if (slot.hash == 0) {
+      free_slot = std::min(free_slot, index);
+      continue;
+    }
+    if (slot.expiry <= now) {
+      expired = index;
+    }
+    if (oldest == end || slot.received < slots[oldest].received) {
+      oldest = index;
+    }
+    if (slot.hash == hash && entries[index].Matches(server_name)) {
+      same_server++;
+      if (oldest_of_server == end ||
+          slot.received < slots[oldest_of_server].received) {
+        oldest_of_server = index;
+      }
+    }
+  }
+
+  std::size_t index = oldest;
+  if (same_server >= kQuicSessionTicketsPerServer) {
+    index = oldest_of_server;
+  } else if (free_slot != end) {
+    index = free_slot;
+    shard.size.fetch_add(1, std::memory_order_relaxed);
+  } else if (expired != end) {
+    index = expired;
+  }
+
+  Entry& entry = entries[index];
+  entry.name_length = static_cast<std::uint8_t>(server_name.size());
+  std::copy(server_name.begin(), server_name.end(), entry.name.begin());
+  entry.ticket = ticket;
+  slots[index] = {hash, ticket.received, ticket.Expiry()};
+  return QuicSessionTicketErrorStatus::kSuccess;
+}
+
+QuicSessionTicketErrorStatus QuicSessionTicketCache::Take(
+    std::string_view server_name, std::chrono::steady_clock::time_point now,
+    QuicSessionTicket& ticket) noexcept {
+  std::uint64_t hash = Hash(server_name);
+  std::size_t bucket = Bucket(hash);
+  Shard& shard = ShardOf(bucket);
+  std::lock_guard lock(shard.mutex);
+
+  std::size_t first = bucket * kQuicSessionTicketCacheWays;
+  std::size_t end = first + kQuicSessionTicketCacheWays;
+  std::size_t newest = end;
+  for (std::size_t index = first; index < end; index++) {
+    const Slot& slot = slots[index];
+    if (slot.hash != hash || !entries[index].Matches(server_name)) {
+      continue;
+    }
+    if (slot.expiry <= now) {
+      Free(shard, index);
+    } else if (newest == end || slot.received > slots[newest].received) {
+      newest = index;
+    }
+  }
+  if (newest == end) {
+    return QuicSessionTicketErrorStatus::kNotFound;
+  }
+  ticket = entries[newest].ticket;
+  Free(shard, newest);
+  return QuicSessionTicketErrorStatus::kSuccess;
+}
+
+void QuicSessionTicketCache::Erase(std::string_view server_name) noexcept {
+  std::uint64_t hash = Hash(server_name);
+  std::size_t bucket = Bucket(hash);
+  Shard& shard = ShardOf(bucket);
+  std::lock_guard lock(shard.mutex);
+  for (std::size_t index = bucket * kQuicSessionTicketCacheWays;
+       index < (bucket + 1) * kQuicSessionTicketCacheWays; index++) {
+    if (slots[index].hash == hash && entries[index].Matches(server_name)) {
+      Free(shard, index);
+    }
+  }
+}
+
+std::size_t QuicSessionTicketCache::Size() const noexcept {
+  std::size_t size = 0;
+  for (const Shard& shard : shards) {
+    size += shard.size.load(std::memory_order_relaxed);
+  }
+  return size;
+}
+
+}  // namespace bedrock::network
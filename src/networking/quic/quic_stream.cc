@@ -0,0 +1,143 @@
+#include "networking/quic/quic_stream.h"
+
+#include <algorithm>
+
+namespace bedrock::network {
+
+void QuicStreamTableV1::SetStreamLimit(QuicStreamTypeV1 type,
+                                       std::uint64_t max_streams) noexcept {
+  Lane& lane = lanes[static_cast<std::size_t>(type)];
+  lane.limit = std::max(lane.limit, std::min(max_streams, kQuicMaxStreamsV1));
+}
+
+void QuicStreamTableV1::SetInitialMaxStreamData(
+    QuicStreamTypeV1 type, std::uint64_t send_limit,
+    std::uint64_t receive_limit) noexcept {
+  Lane& lane = lanes[static_cast<std::size_t>(type)];
+  lane.initial_send_limit = send_limit;
+  lane.initial_receive_limit = receive_limit;
+}
+
+std::uint64_t QuicStreamTableV1::NextStreamID(
+    QuicStreamTypeV1 type) const noexcept {
+  return lanes[static_cast<std::size_t>(type)].opened << 2 |
+         static_cast<std::uint64_t>(type);
+}
+
+QuicStreamErrorStatus QuicStreamTableV1::Open(std::uint64_t id, bool local,
+                                              QuicStreamRecordV1*& record) {
+  record = nullptr;
+  Lane& lane = LaneOf(id);
+  std::uint64_t number = id >> 2;
+  if (number < lane.opened) {
+    return Lookup(id, record);
+  }
+  // only the initiator opens new streams
+  if (local != IsLocal(id)) {
+    return QuicStreamErrorStatus::kState;
+  }
+  if (number >= lane.limit) {
+    return QuicStreamErrorStatus::kLimit;
+  }
+
+  QuicStreamRecordV1 initial;
+  initial.send_limit = lane.initial_send_limit;
+  initial.receive_limit = lane.initial_receive_limit;
+  if (IsQuicStreamUniDirectional(id)) {
+    if (local) {
+      initial.receive_state = QuicReceiveStreamStateV1::kDataRead;
+    } else {
+      initial.send_state = QuicSendStreamStateV1::kDataRecvd;
+    }
+  }
+  std::uint64_t added = number + 1 - lane.opened;
+  lane.records.resize(lane.records.size() + added, initial);
+  lane.opened = number + 1;
+  open_count += added;
+  record = &lane.records.back();
+  return QuicStreamErrorStatus::kSuccess;
+}
+
+QuicStreamRecordV1* QuicStreamTableV1::Find(std::uint64_t id) noexcept {
+  QuicStreamRecordV1* record;
+  Lookup(id, record);
+  return record;
+}
+
+QuicStreamErrorStatus QuicStreamTableV1::OnSendEvent(
+    std::uint64_t id, QuicSendStreamEventV1 event) noexcept {
+  QuicStreamRecordV1* record;
+  QuicStreamErrorStatus status = Lookup(id, record);
+  if (status != QuicStreamErrorStatus::kSuccess) {
+    return status;
+  }
+  // the peer's unidirectional streams have no sending part
+  if (IsQuicStreamUniDirectional(id) && !IsLocal(id)) {
+    return QuicStreamErrorStatus::kState;
+  }
+  if (!TransitionQuicStream(record->send_state, event)) {
+    return QuicStreamErrorStatus::kState;
+  }
+  if (record->Closed()) {
+    open_count--;
+    Release(LaneOf(id));
+  }
+  return QuicStreamErrorStatus::kSuccess;
+}
+
+QuicStreamErrorStatus QuicStreamTableV1::OnReceiveEvent(
+    std::uint64_t id, QuicReceiveStreamEventV1 event) noexcept {
+  QuicStreamRecordV1* record;
+  QuicStreamErrorStatus status = Lookup(id, record);
+  if (status != QuicStreamErrorStatus::kSuccess) {
+    return status;
+  }
+  if (IsQuicStreamUniDirectional(id) && IsLocal(id)) {
+    return QuicStreamErrorStatus::kState;
+  }
+  if (!TransitionQuicStream(record->receive_state, event)) {
+    return QuicStreamErrorStatus::kState;
+  }
+  if (record->Closed()) {
+    open_count--;
+    Release(LaneOf(id));
+  }
+  return QuicStreamErrorStatus::kSuccess;
+}
+
+QuicStreamErrorStatus QuicStreamTableV1::Lookup(
+    std::uint64_t id, QuicStreamRecordV1*& record) noexcept {
+  record = nullptr;
+  Lane& lane = LaneOf(id);
+  std::uint64_t number = id >> 2;
+  if (number >= lane.opened) {
+    return QuicStreamErrorStatus::kNotFound;
+  }
+  if (number < lane.base) {
+    return QuicStreamErrorStatus::kClosed;
+  }
+  QuicStreamRecordV1& found =
+      lane.records[lane.head + (number - lane.base)];
+  if (found.Closed()) {
+    return QuicStreamErrorStatus::kClosed;
+  }
+  record = &found;
+  return QuicStreamErrorStatus::kSuccess;
+}
+
+void QuicStreamTableV1::Release(Lane& lane) noexcept {
+  while (lane.head < lane.records.size() && lane.records[lane.head].Closed()) {
+    lane.head++;
+    lane.base++;
+  }
+  // compact once the released prefix outweighs the live records, which
+  // keeps the erase amortized O(1) per stream
+  if (lane.head >= 64 && lane.head * 2 >= lane.records.size()) {
+    lane.records.erase(lane.records.begin(),
+                       lane.records.begin() +
+                           static_cast<std::ptrdiff_t>(lane.head));
+    lane.head = 0;
+  }
+}
+
+}  // namespace bedrock::network
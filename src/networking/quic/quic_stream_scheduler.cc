@@ -0,0 +1,155 @@
+#include "networking/quic/quic_stream_scheduler.h"
+
+#include <bit>
+
+namespace bedrock::network {
+
+namespace QuicStreamSchedulerUtil {
+
+static std::string_view Trim(std::string_view text) noexcept {
+  std::size_t begin = text.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  std::size_t end = text.find_last_not_of(" \t");
+  return text.substr(begin, end - begin + 1);
+}
+
+}  // namespace QuicStreamSchedulerUtil
+
+QuicStreamPriority ParseQuicStreamPriority(std::string_view field) noexcept {
+  using namespace QuicStreamSchedulerUtil;
+
+  QuicStreamPriority priority;
+  while (!field.empty()) {
+    std::size_t comma = field.find(',');
+    std::string_view member = Trim(field.substr(0, comma));
+    field = comma == std::string_view::npos ? std::string_view()
+                                            : field.substr(comma + 1);
+    // parameters of the member itself do not concern us
+    member = member.substr(0, member.find(';'));
+    std::size_t equals = member.find('=');
+    std::string_view key = Trim(member.substr(0, equals));
+    std::string_view value = equals == std::string_view::npos
+                                 ? std::string_view("?1")
+                                 : Trim(member.substr(equals + 1));
+    if (key == "u" && value.size() == 1 && value[0] >= '0' &&
+        value[0] < '0' + kQuicUrgencyLevels) {
+      priority.urgency = static_cast<std::uint8_t>(value[0] - '0');
+    } else if (key == "i" && (value == "?0" || value == "?1")) {
+      priority.incremental = value == "?1";
+    }
+  }
+  return priority;
+}
+
+QuicStreamScheduler::Handle QuicStreamScheduler::Add(
+    std::uint64_t stream_id, QuicStreamPriority priority) {
+  Handle handle = free_slots;
+  if (handle == kInvalidHandle) {
+    handle = static_cast<Handle>(slots.size());
+    slots.emplace_back();
+  } else {
+    free_slots = slots[handle].next;
+  }
+  Slot& slot = slots[handle];
+  slot = Slot{};
+  slot.stream_id = stream_id;
+  slot.urgency = priority.urgency < kQuicUrgencyLevels ? priority.urgency
+                                                       : kQuicDefaultUrgency;
+  slot.incremental = priority.incremental;
+  return handle;
+}
+
+void QuicStreamScheduler::Remove(Handle handle) noexcept {
+  Unschedule(handle);
+  slots[handle].next = free_slots;
+  free_slots = handle;
+}
+
+void QuicStreamScheduler::SetPriority(Handle handle,
+                                      QuicStreamPriority priority) noexcept {
+  Slot& slot = slots[handle];
+  bool scheduled = slot.scheduled;
+  Unschedule(handle);
+  slot.urgency = priority.urgency < kQuicUrgencyLevels ? priority.urgency
+                                                       : kQuicDefaultUrgency;
+  slot.incremental = priority.incremental;
+  if (scheduled) {
+    Schedule(handle);
+  }
+}
+
+void QuicStreamScheduler::Schedule(Handle handle) noexcept {
+  if (slots[handle].scheduled) {
+    return;
+  }
+  slots[handle].scheduled = true;
+  scheduled_count++;
+  PushBack(handle);
+}
+
+void QuicStreamScheduler::Unschedule(Handle handle) noexcept {
+  if (!slots[handle].scheduled) {
+    return;
+  }
+  Unlink(handle);
+  slots[handle].scheduled = false;
+  scheduled_count--;
+}
+
+QuicStreamScheduler::Handle QuicStreamScheduler::Next() const noexcept {
+  if (non_empty == 0) {
+    return kInvalidHandle;
+  }
+  return queues[static_cast<std::size_t>(std::countr_zero(non_empty))].head;
+}
+
+void QuicStreamScheduler::OnSent(Handle handle, bool more_data) noexcept {
+  if (!more_data) {
+    Unschedule(handle);
+    return;
+  }
+  if (slots[handle].scheduled && slots[handle].incremental) {
+    Unlink(handle);
+    PushBack(handle);
+  }
+}
+
+void QuicStreamScheduler::PushBack(Handle handle) noexcept {
+  Slot& slot = slots[handle];
+  std::size_t index = QueueIndex(slot);
+  Queue& queue = queues[index];
+  slot.previous = queue.tail;
+  slot.next = kInvalidHandle;
+  if (queue.tail == kInvalidHandle) {
+    queue.head = handle;
+    non_empty |= std::uint32_t{1} << index;
+  } else {
+    slots[queue.tail].next = handle;
+  }
+  queue.tail = handle;
+}
+
+void QuicStreamScheduler::Unlink(Handle handle) noexcept {
+  Slot& slot = slots[handle];
+  std::size_t index = QueueIndex(slot);
+  Queue& queue = queues[index];
+  if (slot.previous == kInvalidHandle) {
+    queue.head = slot.next;
+  } else {
+    slots[slot.previous].next = slot.next;
+  }
+  if (slot.next == kInvalidHandle) {
+    queue.tail = slot.previous;
+  } else {
+    slots[slot.next].previous = slot.previous;
+  }
+  if (queue.head == kInvalidHandle) {
+    non_empty &= ~(std::uint32_t{1} << index);
+  }
+  slot.previous = kInvalidHandle;
+  slot.next = kInvalidHandle;
+}
+
+}  // namespace bedrock::network
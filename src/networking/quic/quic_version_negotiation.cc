@@ -0,0 +1,91 @@
+#include "networking/quic/quic_version_negotiation.h"
+
+#include <algorithm>
+
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/quic/quic_wire.h"
+
+namespace bedrock::network {
+
+QuicVersionNegotiationResponder::QuicVersionNegotiationResponder(
+    std::span<const std::uint32_t> supported_versions) noexcept {
+  for (auto version : supported_versions) {
+    if (version == 0 || version_count == versions.size() ||
+        Supported(version)) {
+      continue;
+    }
+    versions[version_count] = version;
+    StoreBigEndian(encoded_versions.data() + version_count * 4, version);
+    version_count++;
+  }
+}
+
+bool QuicVersionNegotiationResponder::Supported(
+    std::uint32_t version) const noexcept {
+  auto end = versions.begin() + static_cast<std::ptrdiff_t>(version_count);
+  return std::find(versions.begin(), end, version) != end;
+}
+
+// Version Negotiation Packet {
+//   Header Form (1) = 1,
+//   Unused (7),
+//   Version (32) = 0,
+//   Destination Connection ID Length (8),
+//   Destination Connection ID (0..2040),
+//   Source Connection ID Length (8),
+//   Source Connection ID (0..2040),
+//   Supported Version (32) ...,
+// }
+QuicVersionNegotiationErrorStatus QuicVersionNegotiationResponder::Respond(
+    std::span<const std::uint8_t> datagram, std::span<std::uint8_t> response,
+    std::size_t& size) const noexcept {
+  using Layout = QuicLongPacketHeaderLayout;
+
+  if (datagram.size() < Layout::kSize ||
+      !(Layout::FirstByte::Load(datagram.data()) & 0x80)) {
+    return QuicVersionNegotiationErrorStatus::kShortHeader;
+  }
+  std::uint32_t version = Layout::Version::Load(datagram.data());
+  if (version == 0) {
+    return QuicVersionNegotiationErrorStatus::kNegotiation;
+  }
+  if (Supported(version)) {
+    return QuicVersionNegotiationErrorStatus::kSupported;
+  }
+  // rfc9000 section 6.1: only answer datagrams big enough to be an Initial,
+  // which also keeps the response smaller than the packet that caused it.
+  if (datagram.size() < kQuicMinInitialDatagramSizeV1) {
+    return QuicVersionNegotiationErrorStatus::kTooSmall;
+  }
+
+  // Both connection IDs always fit in a datagram of that size.
+  static_assert(Layout::kSize + 255 + 1 + 255 < kQuicMinInitialDatagramSizeV1);
+  QuicWireReader reader(datagram,
+                        Layout::DestinationConnectionIDLength::kOffset);
+  auto destination_connection_id =
+      reader.ReadBytes(reader.Read<std::uint8_t>());
+  auto source_connection_id = reader.ReadBytes(reader.Read<std::uint8_t>());
+
+  std::size_t response_size = Layout::kSize + source_connection_id.size() +
+                              1 + destination_connection_id.size() +
+                              version_count * 4;
+  if (response.size() < response_size) {
+    return QuicVersionNegotiationErrorStatus::kNoSpace;
+  }
+
+  // The Unused bits are arbitrary; reusing the client's keeps this free of
+  // any random state, with the QUIC bit set as rfc9000 section 17.2.1 asks.
+  QuicWireWriter writer(response);
+  writer.Write(static_cast<std::uint8_t>(datagram[0] | 0xC0));
+  writer.Write(std::uint32_t{0});
+  writer.Write(static_cast<std::uint8_t>(source_connection_id.size()));
+  writer.WriteBytes(source_connection_id);
+  writer.Write(static_cast<std::uint8_t>(destination_connection_id.size()));
+  writer.WriteBytes(destination_connection_id);
+  writer.WriteBytes(std::span(encoded_versions).first(version_count * 4));
+
+  size = response_size;
+  return QuicVersionNegotiationErrorStatus::kSuccess;
+}
+
+}  // namespace bedrock::network
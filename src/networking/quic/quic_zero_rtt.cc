@@ -0,0 +1,165 @@
+#include "networking/quic/quic_zero_rtt.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace bedrock::network {
+
+QuicSHA256Digest DeriveQuicResumptionPSK(
+    std::span<const std::uint8_t> resumption_master_secret,
+    std::span<const std::uint8_t> ticket_nonce) noexcept {
+  QuicSHA256Digest psk;
+  QuicHKDFExpandLabel(resumption_master_secret, "resumption", psk,
+                      ticket_nonce);
+  return psk;
+}
+
+QuicSHA256Digest DeriveQuicEarlyTrafficSecret(
+    std::span<const std::uint8_t> psk,
+    const QuicSHA256Digest& client_hello_hash) noexcept {
+  constexpr std::array<std::uint8_t, kQuicSHA256Size> kZeroSalt{};
+  QuicSHA256Digest early_secret = QuicHKDFExtract(kZeroSalt, psk);
+  QuicSHA256Digest secret;
+  QuicHKDFExpandLabel(early_secret, "c e traffic", secret, client_hello_hash);
+  return secret;
+}
+
+QuicZeroRTTAntiReplay::QuicZeroRTTAntiReplay(
+    std::size_t capacity, std::chrono::milliseconds replay_window) noexcept
+    : window(std::max(replay_window, std::chrono::milliseconds(1))) {
+  std::size_t per_shard = (capacity + kQuicZeroRTTAntiReplayShards - 1) /
+                          kQuicZeroRTTAntiReplayShards;
+  // Same margin for uneven hashing as the connection ID table: four
+  // standard deviations above the mean, then a load factor of 3/4.
+  per_shard += static_cast<std::size_t>(
+      4 * std::sqrt(static_cast<double>(per_shard)));
+  std::size_t slot_count =
+      std::bit_ceil(std::max<std::size_t>(16, per_shard * 4 / 3 + 1));
+  mask = slot_count - 1;
+  limit = slot_count * 3 / 4;
+  for (Shard& shard : shards) {
+    for (auto& generation : shard.generations) {
+      generation = std::make_unique<std::uint64_t[]>(slot_count);
+    }
+  }
+
+  std::random_device device;
+  std::array<std::uint8_t, kQuicAES128KeySize> key;
+  for (std::size_t i = 0; i < key.size(); i += 4) {
+    std::uint32_t value = device();
+    std::memcpy(key.data() + i, &value, 4);
+  }
+  hash_key.SetKey(key);
+}
+
+// CBC-MAC under the secret key over the length and the ID, zero padded to
+// whole blocks. The length goes first so that no ID is a prefix of
+// another's input.
+std::array<std::uint64_t, 2> QuicZeroRTTAntiReplay::Hash(
+    std::span<const std::uint8_t> client_hello_id) const noexcept {
+  constexpr std::size_t kLengthSize = sizeof(std::uint64_t);
+  std::array<std::uint8_t, kQuicAESBlockSize> block{};
+  std::uint64_t length = client_hello_id.size();
+  std::memcpy(block.data(), &length, kLengthSize);
+  std::size_t taken =
+      std::min(client_hello_id.size(), kQuicAESBlockSize - kLengthSize);
+  std::copy_n(client_hello_id.begin(), taken, block.begin() + kLengthSize);
+  hash_key.EncryptBlock(block.data(), block.data());
+
+  for (std::size_t offset = taken; offset < client_hello_id.size();
+       offset += kQuicAESBlockSize) {
+    std::size_t chunk =
+        std::min(kQuicAESBlockSize, client_hello_id.size() - offset);
+    for (std::size_t i = 0; i < chunk; i++) {
+      block[i] ^= client_hello_id[offset + i];
+    }
+    hash_key.EncryptBlock(block.data(), block.data());
+  }
+
+  std::array<std::uint64_t, 2> hash;
+  std::memcpy(hash.data(), block.data(), sizeof(hash));
+  return hash;
+}
+
+void QuicZeroRTTAntiReplay::Advance(Shard& shard,
+                                    std::int64_t generation) const noexcept {
+  // A thread holding an older time than the last caller stays in the
+  // current generation.
+  if (generation <= shard.generation) {
+    return;
+  }
+  // the previous window's records are kept if it is the one just ended
+  std::size_t slot_count = mask + 1;
+  if (generation != shard.generation + 1) {
+    std::fill_n(shard.generations[shard.current].get(), slot_count, 0);
+    shard.sizes[shard.current] = 0;
+  }
+  shard.current ^= 1;
+  std::fill_n(shard.generations[shard.current].get(), slot_count, 0);
+  shard.sizes[shard.current] = 0;
+  shard.generation = generation;
+}
+
+bool QuicZeroRTTAntiReplay::Contains(const Shard& shard,
+                                     std::size_t generation,
+                                     std::uint64_t start,
+                                     std::uint64_t fingerprint) const noexcept {
+  const std::uint64_t* slots = shard.generations[generation].get();
+  for (std::size_t probe = 0; probe <= mask; probe++) {
+    std::uint64_t held = slots[(start + probe) & mask];
+    if (held == fingerprint) {
+      return true;
+    }
+    if (held == 0) {
+      return false;
+    }
+  }
+  return false;
+}
+
+QuicZeroRTTErrorStatus QuicZeroRTTAntiReplay::Accept(
+    std::span<const std::uint8_t> client_hello_id,
+    std::chrono::milliseconds client_ticket_age,
+    std::chrono::milliseconds server_ticket_age,
+    std::chrono::steady_clock::time_point now) noexcept {
+  // Freshness first: it needs no state, and whatever fails it is never
+  // recorded (rfc8446 section 8.3).
+  auto skew = server_ticket_age - client_ticket_age;
+  if (skew > window / 2 || -skew > window / 2) {
+    return QuicZeroRTTErrorStatus::kStale;
+  }
+
+  std::array<std::uint64_t, 2> hash = Hash(client_hello_id);
+  // 0 marks an empty slot
+  std::uint64_t fingerprint = hash[1] == 0 ? 1 : hash[1];
+  std::uint64_t start = hash[0] / kQuicZeroRTTAntiReplayShards;
+  Shard& shard = shards[hash[0] % kQuicZeroRTTAntiReplayShards];
+  std::int64_t generation =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          now.time_since_epoch())
+          .count() /
+      window.count();
+
+  std::lock_guard lock(shard.mutex);
+  Advance(shard, generation);
+  if (Contains(shard, shard.current, start, fingerprint) ||
+      Contains(shard, shard.current ^ 1, start, fingerprint)) {
+    return QuicZeroRTTErrorStatus::kReplay;
+  }
+  if (shard.sizes[shard.current] >= limit) {
+    return QuicZeroRTTErrorStatus::kFull;
+  }
+  std::uint64_t* slots = shard.generations[shard.current].get();
+  std::size_t index = start & mask;
+  while (slots[index] != 0) {
+    index = (index + 1) & mask;
+  }
+  slots[index] = fingerprint;
+  shard.sizes[shard.current]++;
+  return QuicZeroRTTErrorStatus::kSuccess;
+}
+
+}  // namespace bedrock::network
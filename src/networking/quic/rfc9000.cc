@@ -1,13 +1,9 @@
 ﻿#include "networking/quic/rfc9000.h"
 
+#include <cstring>
 #include <span>
 
-#ifdef _WIN32
-#include <winsock.h>
-#else
-#include <arpa/inet.h>
-#endif
-#include <cstring>
+#include "networking/quic/quic_wire.h"
 
 namespace bedrock::network {
 
@@ -48,8 +44,7 @@ QuicVariableIntegerV1& QuicVariableIntegerV1::operator=(
 }
 QuicVariableIntegerV1& QuicVariableIntegerV1::operator=(
     std::uint16_t rhs) noexcept {
-  rhs = htons(rhs);
-  ::memcpy(data.data(), &rhs, 2);
+  StoreBigEndian<std::uint16_t>(data.data(), rhs);
 
   data[0] &= 0b00111111;
   data[0] |= static_cast<std::uint8_t>(QuicIntegerTypeV1::kU14B) << 6;
@@ -57,34 +52,16 @@ QuicVariableIntegerV1& QuicVariableIntegerV1::operator=(
 }
 QuicVariableIntegerV1& QuicVariableIntegerV1::operator=(
     std::uint32_t rhs) noexcept {
-  rhs = htonl(rhs);
-  ::memcpy(data.data(), &rhs, 4);
+  StoreBigEndian<std::uint32_t>(data.data(), rhs);
 
   data[0] &= 0b00111111;
   data[0] |= static_cast<std::uint8_t>(QuicIntegerTypeV1::kU30B) << 6;
   return *this;
 }
 
-inline std::uint64_t bswap64(std::uint64_t x) {
-#if defined(_MSC_VER)
-  return _byteswap_uint64(x);
-#else
-  return __builtin_bswap64(x);
-#endif
-}
-std::uint64_t htonll(std::uint64_t x) {
-#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-  return bswap64(x);
-#else
-  return x;
-#endif
-}
-std::uint64_t ntohll(std::uint64_t x) { return htonll(x); }
-
 QuicVariableIntegerV1& QuicVariableIntegerV1::operator=(
     std::uint64_t rhs) noexcept {
-  rhs = htonll(rhs);
-  ::memcpy(data.data(), &rhs, 8);
+  StoreBigEndian<std::uint64_t>(data.data(), rhs);
 
   data[0] &= 0b00111111;
   data[0] |= static_cast<std::uint8_t>(QuicIntegerTypeV1::kU62B) << 6;
@@ -96,23 +73,17 @@ QuicVariableIntegerV1::operator std::uint8_t() const noexcept {
   return temp;
 }
 QuicVariableIntegerV1::operator std::uint16_t() const noexcept {
-  std::uint16_t temp = 0;
-  ::memcpy(&temp, data.data(), 2);
-  temp = ntohs(temp);
+  std::uint16_t temp = LoadBigEndian<std::uint16_t>(data.data());
   temp &= 0x3FFF;
   return temp;
 }
 QuicVariableIntegerV1::operator std::uint32_t() const noexcept {
-  std::uint32_t temp = 0;
-  ::memcpy(&temp, data.data(), 4);
-  temp = ntohl(temp);
+  std::uint32_t temp = LoadBigEndian<std::uint32_t>(data.data());
   temp &= 0x3FFFFFFF;
   return temp;
 }
 QuicVariableIntegerV1::operator std::uint64_t() const noexcept {
-  std::uint64_t temp = 0;
-  ::memcpy(&temp, data.data(), 8);
-  temp = ntohll(temp);
+  std::uint64_t temp = LoadBigEndian<std::uint64_t>(data.data());
   temp &= 0x3FFFFFFFFFFFFFFF;
   return temp;
 }
@@ -258,4 +258,82 @@ SocketErrorStatus Socket::Write(std::span<const std::byte> data) {
   return SocketErrorStatus::kSuccess;
 }
 
+DataWithStatus<std::uint32_t, SocketErrorStatus> Socket::ReadFrom(
+    std::span<std::byte> buffer, Address& peer) {
+  if (!IsValid()) {
+    return {0, SocketErrorStatus::kInternal};
+  }
+  if (type != SocketType::kUDP) {
+    return {0, SocketErrorStatus::kFailure};
+  }
+
+  ::sockaddr_storage peer_raw_addr = {};
+  ::socklen_t peer_raw_addr_size = sizeof(peer_raw_addr);
+
+#ifdef _WIN32
+  // Windows reports truncation as WSAEMSGSIZE instead.
+  int flags = 0;
+#else
+  int flags = MSG_TRUNC;
+#endif
+  auto retval = ::recvfrom(socket_fd, reinterpret_cast<char*>(buffer.data()),
+                           buffer.size(), flags,
+                           reinterpret_cast<::sockaddr*>(&peer_raw_addr),
+                           &peer_raw_addr_size);
+  if (retval == SOCKET_ERROR) {
+    last_errno = GetSocketLastErrorCode();
+    last_error_message = GetSocketErrorMessage(last_errno);
+    return {0, SocketErrorStatus::kFailure};
+  }
+  peer.SetAddr(peer_raw_addr);
+
+  return {static_cast<std::uint32_t>(retval), SocketErrorStatus::kSuccess};
+}
+
+SocketErrorStatus Socket::SetDontFragment(bool dont_fragment) {
+  if (!IsValid()) {
+    return SocketErrorStatus::kInternal;
+  }
+  if (type != SocketType::kUDP) {
+    return SocketErrorStatus::kFailure;
+  }
+  auto ip_version = addr.GetIPVersion();
+  if (ip_version.status != AddressErrorStatus::kSuccess) {
+    return SocketErrorStatus::kAddress;
+  }
+  bool ipv6 = ip_version.data == IPVersion::kIPV6;
+
+#ifdef _WIN32
+  DWORD value = dont_fragment ? 1 : 0;
+  auto retval = ::setsockopt(socket_fd, ipv6 ? IPPROTO_IPV6 : IPPROTO_IP,
+                             ipv6 ? IPV6_DONTFRAG : IP_DONTFRAGMENT,
+                             reinterpret_cast<const char*>(&value),
+                             sizeof(value));
+#else
+  int value = 0;
+  int retval = 0;
+  if (ipv6) {
+    value = dont_fragment ? IPV6_PMTUDISC_PROBE : IPV6_PMTUDISC_DONT;
+    retval = ::setsockopt(socket_fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &value,
+                          sizeof(value));
+    if (retval != SOCKET_ERROR) {
+      value = dont_fragment ? 1 : 0;
+      retval = ::setsockopt(socket_fd, IPPROTO_IPV6, IPV6_DONTFRAG, &value,
+                            sizeof(value));
+    }
+  } else {
+    value = dont_fragment ? IP_PMTUDISC_PROBE : IP_PMTUDISC_DONT;
+    retval = ::setsockopt(socket_fd, IPPROTO_IP, IP_MTU_DISCOVER, &value,
+                          sizeof(value));
+  }
+#endif
+  if (retval == SOCKET_ERROR) {
+    last_errno = GetSocketLastErrorCode();
+    last_error_message = GetSocketErrorMessage(last_errno);
+    return SocketErrorStatus::kFailure;
+  }
+
+  return SocketErrorStatus::kSuccess;
+}
+
 }  // namespace bedrock::network
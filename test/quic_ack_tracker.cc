@@ -0,0 +1,284 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "networking/quic/quic_ack_tracker.h"
+
+using bedrock::network::kQuicAckTrackerMaxRanges;
+using bedrock::network::QuicAckRangeIteratorV1;
+using bedrock::network::QuicAckRangeV1;
+using bedrock::network::QuicAckTracker;
+using bedrock::network::QuicAckTrackerErrorStatus;
+using bedrock::network::QuicFrameDecoderV1;
+using bedrock::network::QuicFrameErrorStatus;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicPacketBuilderV1;
+using bedrock::network::QuicPacketNumberSpaceV1;
+
+using Clock = std::chrono::steady_clock;
+
+static bool SameRanges(const QuicAckTracker& tracker,
+                       const std::vector<QuicAckRangeV1>& expected) {
+  auto ranges = tracker.Ranges();
+  if (ranges.size() != expected.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].smallest != expected[i].smallest ||
+        ranges[i].largest != expected[i].largest) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool CheckRanges() {
+  QuicAckTracker tracker;
+  Clock::time_point now = Clock::now();
+  if (!tracker.Empty() || tracker.Contains(0)) {
+    std::cout << "new tracker is not empty" << std::endl;
+    return false;
+  }
+
+  for (std::uint64_t pn : {0u, 1u, 2u, 5u, 6u, 9u}) {
+    tracker.OnPacketReceived(pn, true, now);
+  }
+  if (!SameRanges(tracker, {{9, 9}, {5, 6}, {0, 2}}) ||
+      tracker.LargestReceived() != 9 || !tracker.AckImmediately()) {
+    std::cout << "gaps not tracked" << std::endl;
+    return false;
+  }
+  // fill the gaps: join above, join below, then join both
+  tracker.OnPacketReceived(4, true, now);
+  tracker.OnPacketReceived(7, true, now);
+  if (!SameRanges(tracker, {{9, 9}, {4, 7}, {0, 2}})) {
+    std::cout << "reordered packets not merged" << std::endl;
+    return false;
+  }
+  tracker.OnPacketReceived(3, true, now);
+  tracker.OnPacketReceived(8, true, now);
+  if (!SameRanges(tracker, {{0, 9}})) {
+    std::cout << "ranges not joined" << std::endl;
+    return false;
+  }
+  for (std::uint64_t pn : {0u, 4u, 9u}) {
+    if (tracker.OnPacketReceived(pn, true, now) !=
+        QuicAckTrackerErrorStatus::kDuplicate) {
+      std::cout << "duplicate " << pn << " accepted" << std::endl;
+      return false;
+    }
+  }
+
+  // an isolated reordered packet between two ranges
+  tracker.OnPacketReceived(20, true, now);
+  tracker.OnPacketReceived(15, true, now);
+  if (!SameRanges(tracker, {{20, 20}, {15, 15}, {0, 9}}) ||
+      !tracker.Contains(15) || tracker.Contains(14) || tracker.Contains(10)) {
+    std::cout << "isolated packet misplaced" << std::endl;
+    return false;
+  }
+
+  // only ranges at and above an acknowledged ACK's largest are reported
+  tracker.OnAckAcknowledged(15);
+  if (!SameRanges(tracker, {{20, 20}, {15, 15}}) ||
+      tracker.OnPacketReceived(12, true, now) !=
+          QuicAckTrackerErrorStatus::kDuplicate) {
+    std::cout << "acknowledged ranges not discarded" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Every other packet lost: one range per received packet, so the smallest
+// ranges fall off once the cap is reached.
+static bool CheckCap() {
+  QuicAckTracker tracker;
+  Clock::time_point now = Clock::now();
+  constexpr std::uint64_t kPackets = 10 * kQuicAckTrackerMaxRanges;
+  for (std::uint64_t pn = 0; pn < kPackets; pn += 2) {
+    tracker.OnPacketReceived(pn, true, now);
+  }
+  auto ranges = tracker.Ranges();
+  if (ranges.size() != kQuicAckTrackerMaxRanges ||
+      ranges.front().largest != kPackets - 2 ||
+      ranges.back().smallest != kPackets - 2 * kQuicAckTrackerMaxRanges) {
+    std::cout << "range cap not enforced" << std::endl;
+    return false;
+  }
+  // the largest dropped packet
+  std::uint64_t dropped = ranges.back().smallest - 2;
+  if (tracker.OnPacketReceived(1, true, now) !=
+          QuicAckTrackerErrorStatus::kDuplicate ||
+      tracker.OnPacketReceived(dropped, true, now) !=
+          QuicAckTrackerErrorStatus::kDuplicate) {
+    std::cout << "packet below the window accepted" << std::endl;
+    return false;
+  }
+  // a missing packet inside the window fills its gap
+  if (tracker.OnPacketReceived(kPackets - 3, true, now) !=
+          QuicAckTrackerErrorStatus::kSuccess ||
+      tracker.Ranges().size() != kQuicAckTrackerMaxRanges - 1) {
+    std::cout << "gap inside the window not filled" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Random reordering and loss against a std::set of the received packets
+static bool CheckReordering() {
+  std::mt19937_64 random(7);
+  QuicAckTracker tracker;
+  std::set<std::uint64_t> received;
+  Clock::time_point now = Clock::now();
+
+  for (std::uint64_t base = 0; base < 200000; base += 16) {
+    std::array<std::uint64_t, 16> burst;
+    for (std::uint64_t i = 0; i < burst.size(); i++) {
+      burst[i] = base + i;
+    }
+    std::shuffle(burst.begin(), burst.end(), random);
+    for (std::uint64_t pn : burst) {
+      if (random() % 8 == 0) {
+        continue;  // lost
+      }
+      bool duplicate = received.count(pn) != 0;
+      QuicAckTrackerErrorStatus status =
+          tracker.OnPacketReceived(pn, false, now);
+      if ((status == QuicAckTrackerErrorStatus::kDuplicate) != duplicate) {
+        std::cout << "packet " << pn << " misclassified" << std::endl;
+        return false;
+      }
+      received.insert(pn);
+    }
+  }
+
+  auto ranges = tracker.Ranges();
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].smallest > ranges[i].largest ||
+        (i != 0 && ranges[i].largest + 2 > ranges[i - 1].smallest)) {
+      std::cout << "ranges not sorted and disjoint" << std::endl;
+      return false;
+    }
+  }
+  for (std::uint64_t pn = ranges.back().smallest; pn <= ranges[0].largest;
+       pn++) {
+    if (tracker.Contains(pn) != (received.count(pn) != 0)) {
+      std::cout << "packet " << pn << " tracked wrongly" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// The ACK frame written from the tracker decodes back to its ranges.
+static bool CheckAckFrame() {
+  QuicAckTracker tracker(QuicPacketNumberSpaceV1::kApplicationData);
+  Clock::time_point received = Clock::now();
+  for (std::uint64_t pn : {3u, 4u, 5u, 10u, 11u, 40u}) {
+    tracker.OnPacketReceived(pn, pn != 4, received);
+  }
+  if (!tracker.AckPending()) {
+    std::cout << "no ACK pending" << std::endl;
+    return false;
+  }
+
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1500);
+  const std::array<std::uint8_t, 4> dcid = {1, 2, 3, 4};
+  builder.BeginShortPacket(dcid, 1, 1, false);
+  if (tracker.WriteAckFrame(builder, received + std::chrono::microseconds(800),
+                            3) != QuicPacketBuilderErrorStatus::kSuccess ||
+      tracker.AckPending() || tracker.AckImmediately()) {
+    std::cout << "ACK not written" << std::endl;
+    return false;
+  }
+  builder.FinishPacket();
+
+  const auto& packet = builder.Packets()[0];
+  QuicFrameDecoderV1 decoder(builder.Datagram().subspan(
+      packet.payload_offset, packet.end_offset - packet.payload_offset -
+                                 bedrock::network::kQuicAeadTagLengthV1));
+  QuicFrameV1 frame;
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kAck || frame.id != 40 ||
+      frame.extra != 100) {
+    std::cout << "ACK frame header mismatch" << std::endl;
+    return false;
+  }
+  QuicAckRangeIteratorV1 iterator(frame);
+  std::vector<QuicAckRangeV1> decoded;
+  QuicAckRangeV1 range;
+  while (iterator.Next(range) == QuicFrameErrorStatus::kSuccess) {
+    decoded.push_back(range);
+  }
+  if (!SameRanges(tracker, decoded)) {
+    std::cout << "ACK ranges mismatch" << std::endl;
+    return false;
+  }
+
+  // Handshake ACKs are never delayed
+  QuicAckTracker handshake(QuicPacketNumberSpaceV1::kHandshake);
+  handshake.OnPacketReceived(0, true, received);
+  if (!handshake.AckImmediately()) {
+    std::cout << "Handshake ACK delayed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr std::uint64_t kPackets = 1 << 24;
+  Clock::time_point now = Clock::now();
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1500);
+  const std::array<std::uint8_t, 4> dcid = {1, 2, 3, 4};
+
+  // in order, an ACK written every second packet
+  QuicAckTracker in_order;
+  auto begin = Clock::now();
+  for (std::uint64_t pn = 0; pn < kPackets; pn++) {
+    in_order.OnPacketReceived(pn, true, now);
+    if (in_order.AckImmediately()) {
+      builder.Reset();
+      builder.BeginShortPacket(dcid, pn, 4, false);
+      in_order.WriteAckFrame(builder, now);
+    }
+  }
+  double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+  std::cout << "In order: " << static_cast<double>(kPackets) / elapsed / 1e6
+            << " Mpps with an ACK every second packet ("
+            << in_order.Ranges().size() << " range)" << std::endl;
+
+  // one packet in 64 lost and one in 64 swapped with its successor
+  QuicAckTracker reordered;
+  begin = Clock::now();
+  for (std::uint64_t pn = 0; pn < kPackets; pn++) {
+    std::uint64_t slot = pn % 64;
+    if (slot == 0) {
+      continue;
+    }
+    std::uint64_t received = slot == 31 ? pn + 1 : slot == 32 ? pn - 1 : pn;
+    reordered.OnPacketReceived(received, false, now);
+  }
+  elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+  std::cout << "Lossy and reordered: "
+            << static_cast<double>(kPackets) / elapsed / 1e6 << " Mpps ("
+            << reordered.Ranges().size() << " ranges)" << std::endl;
+}
+
+int main() {
+  if (!CheckRanges() || !CheckCap() || !CheckReordering() ||
+      !CheckAckFrame()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC ACK tracker test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "networking/quic/quic_connection_id_table.h"
+
+using bedrock::network::QuicConnectionHandle;
+using bedrock::network::QuicConnectionIDTable;
+using bedrock::network::QuicConnectionIDTableErrorStatus;
+
+constexpr std::size_t kLength = 8;
+using ConnectionID = std::array<std::uint8_t, kLength>;
+
+static std::vector<ConnectionID> RandomIDs(std::size_t count,
+                                           std::uint64_t seed) {
+  std::mt19937_64 random(seed);
+  std::vector<ConnectionID> ids(count);
+  for (auto& id : ids) {
+    std::uint64_t value = random();
+    for (auto& byte : id) {
+      byte = static_cast<std::uint8_t>(value);
+      value >>= 8;
+    }
+  }
+  return ids;
+}
+
+static bool CheckRouting() {
+  QuicConnectionIDTable table(kLength, 1024);
+  auto ids = RandomIDs(3, 1);
+  QuicConnectionHandle handle;
+
+  // two connection IDs of the same connection
+  if (table.Insert(ids[0], {1, 7}) !=
+          QuicConnectionIDTableErrorStatus::kSuccess ||
+      table.Insert(ids[1], {1, 7}) !=
+          QuicConnectionIDTableErrorStatus::kSuccess ||
+      table.Insert(ids[1], {2, 9}) !=
+          QuicConnectionIDTableErrorStatus::kDuplicate ||
+      table.Size() != 2) {
+    std::cout << "insert failed" << std::endl;
+    return false;
+  }
+
+  // a short header packet: first byte, then the connection ID and the rest
+  std::vector<std::uint8_t> packet = {0x41};
+  packet.insert(packet.end(), ids[1].begin(), ids[1].end());
+  packet.insert(packet.end(), {0xAA, 0xBB, 0xCC});
+  if (!table.Find(table.ShortHeaderConnectionID(packet), handle) ||
+      !(handle == QuicConnectionHandle{1, 7}) || table.Find(ids[2], handle)) {
+    std::cout << "short header lookup failed" << std::endl;
+    return false;
+  }
+
+  if (table.Retire(ids[0]) != QuicConnectionIDTableErrorStatus::kSuccess ||
+      table.Retire(ids[0]) != QuicConnectionIDTableErrorStatus::kNotFound ||
+      table.Find(ids[0], handle) || !table.Find(ids[1], handle) ||
+      table.Insert(std::span(ids[2]).first(4), {0, 0}) !=
+          QuicConnectionIDTableErrorStatus::kInvalid) {
+    std::cout << "retirement failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Repeated issue and retire cycles must not leave the table full of
+// tombstones or lose live entries.
+static bool CheckChurn() {
+  constexpr std::size_t kLive = 2048;
+  QuicConnectionIDTable table(kLength, kLive);
+  auto ids = RandomIDs(kLive * 16, 2);
+  QuicConnectionHandle handle;
+
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    if (table.Insert(ids[i], {0, static_cast<std::uint32_t>(i)}) !=
+        QuicConnectionIDTableErrorStatus::kSuccess) {
+      std::cout << "insert failed during churn at " << i << std::endl;
+      return false;
+    }
+    if (i >= kLive && table.Retire(ids[i - kLive]) !=
+                          QuicConnectionIDTableErrorStatus::kSuccess) {
+      std::cout << "retire failed during churn at " << i << std::endl;
+      return false;
+    }
+  }
+  for (std::size_t i = ids.size() - kLive; i < ids.size(); i++) {
+    if (!table.Find(ids[i], handle) || handle.connection != i) {
+      std::cout << "entry lost during churn" << std::endl;
+      return false;
+    }
+  }
+  return table.Size() == kLive;
+}
+
+// Readers must never see a stable entry missing or with a wrong handle while
+// a writer keeps changing other entries of the same shards.
+static bool CheckConcurrent() {
+  constexpr std::size_t kStable = 1 << 14;
+  QuicConnectionIDTable table(kLength, kStable * 2);
+  auto stable = RandomIDs(kStable, 3);
+  auto churn = RandomIDs(kStable / 2, 4);
+  for (std::size_t i = 0; i < stable.size(); i++) {
+    table.Insert(stable[i], {1, static_cast<std::uint32_t>(i)});
+  }
+
+  std::atomic<bool> done = false;
+  std::atomic<std::size_t> errors = 0;
+  std::thread writer([&] {
+    for (int round = 0; round < 20; round++) {
+      for (const auto& id : churn) {
+        table.Insert(id, {2, 0});
+      }
+      for (const auto& id : churn) {
+        table.Retire(id);
+      }
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; r++) {
+    readers.emplace_back([&] {
+      QuicConnectionHandle handle;
+      while (!done) {
+        for (std::size_t i = 0; i < stable.size(); i++) {
+          if (!table.Find(stable[i], handle) || handle.worker != 1 ||
+              handle.connection != i) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  if (errors != 0) {
+    std::cout << errors << " inconsistent concurrent lookups" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr std::size_t kEntries = 1 << 21;
+  constexpr std::size_t kPackets = 1 << 22;
+  QuicConnectionIDTable table(kLength, kEntries);
+  auto ids = RandomIDs(kEntries, 5);
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    table.Insert(ids[i], {0, static_cast<std::uint32_t>(i)});
+  }
+
+  // Destination Connection IDs of received packets in arrival order, spread
+  // over all connections so the table itself is not cache resident.
+  std::vector<ConnectionID> packets(kPackets);
+  std::mt19937 random(6);
+  for (auto& packet : packets) {
+    packet = ids[random() % kEntries];
+  }
+
+  QuicConnectionHandle handle;
+  std::size_t found = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (const auto& packet : packets) {
+    found += table.Find(packet, handle);
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  std::cout << "Resolved " << found << " connection IDs among " << kEntries
+            << " entries one by one in " << elapsed << "s ("
+            << elapsed / static_cast<double>(kPackets) * 1e9 << " ns/packet)"
+            << std::endl;
+
+  // bursts of 32 packets as a recvmmsg loop would hand them over
+  constexpr std::size_t kBurst = 32;
+  std::array<std::span<const std::uint8_t>, kBurst> burst;
+  std::array<QuicConnectionHandle, kBurst> handles;
+  std::array<bool, kBurst> burst_found;
+  found = 0;
+  begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kPackets; i += kBurst) {
+    for (std::size_t j = 0; j < kBurst; j++) {
+      burst[j] = packets[i + j];
+    }
+    found += table.Find(burst, handles, burst_found);
+  }
+  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          begin)
+                .count();
+  std::cout << "Resolved " << found << " connection IDs in bursts of "
+            << kBurst << " in " << elapsed << "s ("
+            << elapsed / static_cast<double>(kPackets) * 1e9 << " ns/packet)"
+            << std::endl;
+}
+
+int main() {
+  if (!CheckRouting() || !CheckChurn() || !CheckConcurrent()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "Connection ID table test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,293 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_datagram.h"
+#include "networking/quic/quic_frame.h"
+#include "networking/quic/quic_packet_buffer.h"
+#include "networking/quic/quic_packet_builder.h"
+
+using bedrock::network::kQuicAeadTagLengthV1;
+using bedrock::network::kQuicPacketBufferCapacity;
+using bedrock::network::QuicBuiltPacketV1;
+using bedrock::network::QuicDatagramChannel;
+using bedrock::network::QuicDatagramErrorStatus;
+using bedrock::network::QuicFrameDecoderV1;
+using bedrock::network::QuicFrameErrorStatus;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+using bedrock::network::QuicPacketBufferPool;
+using bedrock::network::QuicPacketBufferRef;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicPacketBuilderV1;
+using bedrock::network::QuicReceivedDatagramV1;
+using bedrock::network::ReadQuicMaxDatagramFrameSize;
+
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+
+static std::span<const std::uint8_t> Payload(
+    std::span<const std::uint8_t> dgram, const QuicBuiltPacketV1& packet) {
+  return dgram.subspan(packet.payload_offset, packet.end_offset -
+                                                  packet.payload_offset -
+                                                  kQuicAeadTagLengthV1);
+}
+
+static bool CheckNegotiation() {
+  QuicDatagramChannel client(1200);
+  QuicDatagramChannel server(0);
+  std::array<std::uint8_t, 16> parameters{};
+  // an unrelated parameter ahead of ours: initial_max_data = 1000
+  std::size_t size = 0;
+  parameters[size++] = 0x04;
+  parameters[size++] = 0x02;
+  parameters[size++] = 0x43;
+  parameters[size++] = 0xe8;
+  size += client.WriteTransportParameter(
+      std::span<std::uint8_t>(parameters).subspan(size));
+  const std::vector<std::uint8_t> expected = {0x04, 0x02, 0x43, 0xe8,
+                                              0x20, 0x02, 0x44, 0xb0};
+  if (std::vector<std::uint8_t>(parameters.begin(),
+                                parameters.begin() + size) != expected ||
+      server.WriteTransportParameter(parameters) != 0) {
+    std::cout << "transport parameter encoded wrong" << std::endl;
+    return false;
+  }
+
+  server.SetPathMTU(1500, kDcid.size());
+  if (server.Send(std::vector<std::uint8_t>(10)) !=
+          QuicDatagramErrorStatus::kDisabled ||
+      server.OnPeerTransportParameters(
+          std::span<const std::uint8_t>(parameters).subspan(0, size)) !=
+          QuicDatagramErrorStatus::kSuccess ||
+      server.PeerMaxFrameSize() != 1200 || server.MaxPayload() != 1197 ||
+      server.Send(std::vector<std::uint8_t>(1198)) !=
+          QuicDatagramErrorStatus::kTooLarge ||
+      server.Send(std::vector<std::uint8_t>(1197)) !=
+          QuicDatagramErrorStatus::kSuccess) {
+    std::cout << "peer limit not applied" << std::endl;
+    return false;
+  }
+
+  std::uint64_t value = 0;
+  const std::vector<std::uint8_t> truncated = {0x20, 0x04, 0x44};
+  const std::vector<std::uint8_t> trailing = {0x20, 0x02, 0x05, 0x00};
+  if (ReadQuicMaxDatagramFrameSize(truncated, value) !=
+          QuicDatagramErrorStatus::kMalformed ||
+      ReadQuicMaxDatagramFrameSize(trailing, value) !=
+          QuicDatagramErrorStatus::kMalformed ||
+      ReadQuicMaxDatagramFrameSize(expected, value) !=
+          QuicDatagramErrorStatus::kSuccess ||
+      value != 1200) {
+    std::cout << "malformed transport parameter accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Queued datagrams go into the next packet, are decoded and delivered as
+// spans into the received buffer.
+static bool CheckRoundTrip() {
+  QuicDatagramChannel sender(0, 4);
+  QuicDatagramChannel receiver(1200, 2);
+  sender.SetPeerMaxFrameSize(receiver.LocalMaxFrameSize());
+
+  for (std::uint8_t i = 1; i <= 5; i++) {
+    auto status = sender.Send(std::vector<std::uint8_t>(i * 100u, i));
+    if (status != (i <= 4 ? QuicDatagramErrorStatus::kSuccess
+                          : QuicDatagramErrorStatus::kBusy)) {
+      std::cout << "send queue not bounded" << std::endl;
+      return false;
+    }
+  }
+
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1000);
+  builder.BeginShortPacket(kDcid, 1, 1, false);
+  // 100 + 200 + 300 fit in one packet, 400 more do not
+  if (sender.WriteFrames(builder) != 3 || sender.QueuedCount() != 1 ||
+      builder.FinishPacket() != QuicPacketBuilderErrorStatus::kSuccess ||
+      !builder.Packets()[0].ack_eliciting) {
+    std::cout << "datagrams not written to the open packet" << std::endl;
+    return false;
+  }
+
+  QuicPacketBufferPool pool(4);
+  QuicPacketBufferRef packet = pool.Allocate();
+  auto dgram = builder.Datagram();
+  std::memcpy(packet->data.data(), dgram.data(), dgram.size());
+  packet->size = dgram.size();
+  QuicFrameDecoderV1 decoder(
+      Payload(packet->Datagram(), builder.Packets()[0]));
+  QuicFrameV1 frame;
+  while (decoder.Next(frame) == QuicFrameErrorStatus::kSuccess) {
+    if (frame.type != QuicFrameTypeV1::kDatagram ||
+        receiver.OnDatagramFrame(frame, packet) !=
+            QuicDatagramErrorStatus::kSuccess) {
+      std::cout << "DATAGRAM frame not accepted" << std::endl;
+      return false;
+    }
+  }
+  packet.Reset();
+
+  // the first one was dropped to make room
+  QuicReceivedDatagramV1 datagram;
+  if (receiver.DroppedCount() != 1 || !receiver.Receive(datagram) ||
+      datagram.data.size() != 200 || datagram.data[0] != 2 ||
+      datagram.data.data() < datagram.packet->data.data() ||
+      datagram.data.data() >= datagram.packet->data.data() + 1500 ||
+      pool.Available() != 3) {
+    std::cout << "datagram not delivered in place" << std::endl;
+    return false;
+  }
+  if (!receiver.Receive(datagram) || datagram.data.size() != 300 ||
+      receiver.Receive(datagram) || pool.Available() != 3) {
+    std::cout << "second datagram not delivered" << std::endl;
+    return false;
+  }
+  datagram.packet.Reset();
+  if (pool.Available() != 4) {
+    std::cout << "packet buffer not released" << std::endl;
+    return false;
+  }
+
+  // a frame larger than we allowed is a protocol violation
+  QuicDatagramChannel small(100);
+  frame = {};
+  frame.type = QuicFrameTypeV1::kDatagram;
+  std::vector<std::uint8_t> big(100);
+  frame.data = big;
+  if (small.OnDatagramFrame(frame, {}) != QuicDatagramErrorStatus::kProtocol ||
+      QuicDatagramChannel(0).OnDatagramFrame(frame, {}) !=
+          QuicDatagramErrorStatus::kProtocol) {
+    std::cout << "oversized DATAGRAM frame accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// The largest datagram follows the PLPMTU; one queued for a larger path is
+// dropped once the path shrinks.
+static bool CheckPathMTU() {
+  QuicDatagramChannel sender(0, 4);
+  sender.SetPeerMaxFrameSize(65535);
+  // base PLPMTU, 20 byte connection ID: 1200 - 41 - 3
+  if (sender.MaxPayload() != 1156) {
+    std::cout << "default path limit " << sender.MaxPayload() << std::endl;
+    return false;
+  }
+
+  std::vector<std::uint8_t> send_buffer(kQuicPacketBufferCapacity);
+  sender.SetPathMTU(kQuicPacketBufferCapacity, kDcid.size());
+  std::size_t largest = sender.MaxPayload();
+  QuicPacketBuilderV1 builder(send_buffer, kQuicPacketBufferCapacity);
+  builder.BeginShortPacket(kDcid, 1, 4, false);
+  if (largest <= 1156 ||
+      sender.Send(std::vector<std::uint8_t>(largest + 1)) !=
+          QuicDatagramErrorStatus::kTooLarge ||
+      sender.Send(std::vector<std::uint8_t>(largest)) !=
+          QuicDatagramErrorStatus::kSuccess ||
+      sender.WriteFrames(builder) != 1) {
+    std::cout << "datagram of the PLPMTU not sent" << std::endl;
+    return false;
+  }
+
+  sender.Send(std::vector<std::uint8_t>(largest));
+  sender.Send(std::vector<std::uint8_t>(100));
+  sender.SetPathMTU(1200, kDcid.size());
+  builder = QuicPacketBuilderV1(send_buffer, 1200);
+  builder.BeginShortPacket(kDcid, 2, 4, false);
+  if (sender.MaxPayload() != 1168 || sender.WriteFrames(builder) != 1 ||
+      sender.QueuedCount() != 0) {
+    std::cout << "datagram too big for the shrunk path kept" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A datagram that only fits without its Length field still goes out.
+static bool CheckNoLength() {
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1200);
+  builder.BeginShortPacket(kDcid, 1, 1, false);
+  std::size_t remaining = builder.Remaining();
+  std::vector<std::uint8_t> data(remaining - 2, 0x77);
+  if (builder.AppendDatagramFrame(std::vector<std::uint8_t>(remaining)) !=
+          QuicPacketBuilderErrorStatus::kNoSpace ||
+      builder.AppendDatagramFrame(data) !=
+          QuicPacketBuilderErrorStatus::kSuccess ||
+      builder.Remaining() != 0 ||
+      builder.FinishPacket() != QuicPacketBuilderErrorStatus::kSuccess) {
+    std::cout << "datagram without Length not written" << std::endl;
+    return false;
+  }
+
+  QuicFrameDecoderV1 decoder(
+      Payload(builder.Datagram(), builder.Packets()[0]));
+  QuicFrameV1 frame;
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kDatagram || frame.flags != 0 ||
+      frame.data.size() != data.size() || frame.data[0] != 0x77 ||
+      decoder.Next(frame) != QuicFrameErrorStatus::kEnd) {
+    std::cout << "datagram without Length decoded wrong" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Send, packetize, decode and deliver 1000 byte datagrams, one per packet.
+static void Benchmark() {
+  constexpr int kDatagrams = 1 << 20;
+  QuicDatagramChannel sender(0);
+  QuicDatagramChannel receiver;
+  sender.SetPeerMaxFrameSize(receiver.LocalMaxFrameSize());
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1200);
+  QuicPacketBufferPool pool(8);
+  std::vector<std::uint8_t> message(1000, 0x42);
+
+  std::uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kDatagrams; i++) {
+    message[0] = static_cast<std::uint8_t>(i);
+    sender.Send(message);
+    builder.Reset();
+    builder.BeginShortPacket(kDcid, static_cast<std::uint64_t>(i), 2, false);
+    sender.WriteFrames(builder);
+    builder.FinishPacket();
+
+    QuicPacketBufferRef packet = pool.Allocate();
+    auto dgram = builder.Datagram();
+    std::memcpy(packet->data.data(), dgram.data(), dgram.size());
+    packet->size = dgram.size();
+    QuicFrameDecoderV1 decoder(
+        Payload(packet->Datagram(), builder.Packets()[0]));
+    QuicFrameV1 frame;
+    while (decoder.Next(frame) == QuicFrameErrorStatus::kSuccess) {
+      receiver.OnDatagramFrame(frame, packet);
+    }
+    QuicReceivedDatagramV1 datagram;
+    while (receiver.Receive(datagram)) {
+      checksum += datagram.data[0];
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+              kDatagrams;
+  std::cout << "1000 byte datagrams: " << ns << " ns/datagram, "
+            << 1000 * 8 / ns << " Gbps (checksum " << checksum % 1000 << ")"
+            << std::endl;
+}
+
+int main() {
+  if (!CheckNegotiation() || !CheckRoundTrip() || !CheckPathMTU() ||
+      !CheckNoLength()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC datagram test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
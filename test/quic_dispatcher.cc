@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "networking/quic/quic_dispatcher.h"
+#include "networking/socket.h"
+
+using bedrock::network::Address;
+using bedrock::network::IPVersion;
+using bedrock::network::kQuicMaxReceiveDatagramSize;
+using bedrock::network::QuicConnectionHandle;
+using bedrock::network::QuicConnectionIDTable;
+using bedrock::network::QuicDispatcher;
+using bedrock::network::QuicDispatcherErrorStatus;
+using bedrock::network::QuicPacketBufferRef;
+using bedrock::network::QuicReceivedDatagram;
+using bedrock::network::QuicSPSCRing;
+using bedrock::network::Socket;
+using bedrock::network::SocketErrorStatus;
+using bedrock::network::SocketType;
+
+constexpr std::size_t kLength = 8;
+constexpr std::uint32_t kWorkers = 4;
+
+static std::array<std::uint8_t, kLength> ConnectionID(std::uint32_t n) {
+  return {0xC1, 0xD0, 0, 0, static_cast<std::uint8_t>(n >> 24),
+          static_cast<std::uint8_t>(n >> 16), static_cast<std::uint8_t>(n >> 8),
+          static_cast<std::uint8_t>(n)};
+}
+
+// Sizes below a whole header truncate the packet inside its connection ID.
+static std::vector<std::uint8_t> ShortHeaderPacket(std::uint32_t n,
+                                                   std::size_t size) {
+  auto id = ConnectionID(n);
+  std::vector<std::uint8_t> packet(std::max(size, 1 + id.size()), 0xAB);
+  packet[0] = 0x41;
+  std::copy(id.begin(), id.end(), packet.begin() + 1);
+  packet.resize(size);
+  return packet;
+}
+
+static std::vector<std::uint8_t> InitialPacket(
+    std::span<const std::uint8_t> destination_connection_id) {
+  std::vector<std::uint8_t> packet = {0xC0, 0, 0, 0, 1};
+  packet.push_back(
+      static_cast<std::uint8_t>(destination_connection_id.size()));
+  packet.insert(packet.end(), destination_connection_id.begin(),
+                destination_connection_id.end());
+  packet.resize(1200, 0);
+  return packet;
+}
+
+// Elements must come out in order and intact while both sides run at once.
+static bool CheckRing() {
+  constexpr std::uint64_t kCount = 1 << 20;
+  QuicSPSCRing<std::uint64_t> ring(100);
+  if (ring.Capacity() != 128) {
+    std::cout << "ring capacity not rounded up" << std::endl;
+    return false;
+  }
+
+  std::thread producer([&] {
+    for (std::uint64_t i = 0; i < kCount; i++) {
+      std::uint64_t* slot;
+      while ((slot = ring.Reserve()) == nullptr) {
+        std::this_thread::yield();
+      }
+      *slot = i;
+      ring.Push();
+    }
+  });
+  bool ordered = true;
+  for (std::uint64_t i = 0; i < kCount; i++) {
+    std::uint64_t* slot;
+    while ((slot = ring.Front()) == nullptr) {
+      std::this_thread::yield();
+    }
+    ordered = ordered && *slot == i;
+    ring.Pop();
+  }
+  producer.join();
+  if (!ordered || ring.Front() != nullptr) {
+    std::cout << "ring reordered or lost elements" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckRouting() {
+  QuicConnectionIDTable table(kLength, 64);
+  for (std::uint32_t n = 0; n < 16; n++) {
+    table.Insert(ConnectionID(n), {n % kWorkers, n});
+  }
+  QuicDispatcher dispatcher(table, 1, kWorkers, 8);
+  Address peer(IPVersion::kIPV6, "::1", 4433);
+
+  for (std::uint32_t n = 0; n < 16; n++) {
+    if (dispatcher.Dispatch(0, ShortHeaderPacket(n, 100), peer) !=
+        QuicDispatcherErrorStatus::kSuccess) {
+      std::cout << "short header packet not dispatched" << std::endl;
+      return false;
+    }
+  }
+  for (std::size_t worker = 0; worker < kWorkers; worker++) {
+    bool owned = true;
+    std::size_t count = dispatcher.Drain(
+        worker, [&](const QuicReceivedDatagram& datagram) {
+          owned = owned && datagram.routed &&
+                  datagram.handle.worker == worker &&
+                  datagram.handle.connection % kWorkers == worker &&
+                  datagram.Datagram().size() == 100 &&
+                  datagram.Datagram()[1] == 0xC1 &&
+                  datagram.peer.GetPort().data == 4433;
+        });
+    if (count != 4 || !owned) {
+      std::cout << "worker " << worker << " got the wrong packets"
+                << std::endl;
+      return false;
+    }
+  }
+
+  // Initials of an unknown connection stay together on one worker.
+  std::array<std::uint8_t, 12> client_id = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::size_t initial_workers = 0;
+  for (int i = 0; i < 3; i++) {
+    dispatcher.Dispatch(0, InitialPacket(client_id), peer);
+  }
+  for (std::size_t worker = 0; worker < kWorkers; worker++) {
+    bool unrouted = true;
+    std::size_t count = dispatcher.Drain(
+        worker, [&](const QuicReceivedDatagram& datagram) {
+          unrouted = unrouted && !datagram.routed;
+        });
+    if (count != 0) {
+      initial_workers++;
+    }
+    if (!unrouted || (count != 0 && count != 3)) {
+      std::cout << "connection attempt was split" << std::endl;
+      return false;
+    }
+  }
+  // A long header packet carrying a server chosen ID follows the table.
+  auto handshake = InitialPacket(ConnectionID(7));
+  handshake[0] = 0xE0;
+  dispatcher.Dispatch(0, handshake, peer);
+  std::size_t routed = 0;
+  dispatcher.Drain(3, [&](const QuicReceivedDatagram& datagram) {
+    routed += datagram.routed && datagram.handle.connection == 7;
+  });
+
+  std::vector<std::uint8_t> oversized(kQuicMaxReceiveDatagramSize + 1, 0);
+  oversized[0] = 0x40;
+  if (initial_workers != 1 || routed != 1 ||
+      dispatcher.Dispatch(0, ShortHeaderPacket(99, 100), peer) !=
+          QuicDispatcherErrorStatus::kUnknownConnection ||
+      dispatcher.Dispatch(0, ShortHeaderPacket(1, 5), peer) !=
+          QuicDispatcherErrorStatus::kMalformed ||
+      dispatcher.Dispatch(0, std::span(client_id).first(4), peer) !=
+          QuicDispatcherErrorStatus::kMalformed ||
+      dispatcher.Dispatch(0, oversized, peer) !=
+          QuicDispatcherErrorStatus::kTruncated ||
+      dispatcher.Dispatch(1, ShortHeaderPacket(0, 100), peer) !=
+          QuicDispatcherErrorStatus::kInvalidReceiver ||
+      dispatcher.Drain(kWorkers, [](const auto&) {}) != 0) {
+    std::cout << "invalid packets were dispatched" << std::endl;
+    return false;
+  }
+
+  // Packets beyond a worker's ring capacity are dropped.
+  std::size_t full = 0;
+  for (int i = 0; i < 10; i++) {
+    full += dispatcher.Dispatch(0, ShortHeaderPacket(0, 100), peer) ==
+            QuicDispatcherErrorStatus::kFull;
+  }
+  if (full != 2 || dispatcher.Drain(0, [](const auto&) {}) != 8) {
+    std::cout << "full ring not reported" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Handlers may keep a datagram's buffer. Its data stays intact while the
+// pool reuses other buffers, and an exhausted pool drops datagrams instead.
+static bool CheckRetained() {
+  QuicConnectionIDTable table(kLength, 64);
+  table.Insert(ConnectionID(0), {0, 0});
+  // 4 ring slots, the spare and one retained buffer
+  QuicDispatcher dispatcher(table, 1, 1, 4, 1);
+  Address peer(IPVersion::kIPV6, "::1", 4433);
+
+  std::vector<QuicPacketBufferRef> retained;
+  for (std::size_t size = 100; size < 104; size++) {
+    dispatcher.Dispatch(0, ShortHeaderPacket(0, size), peer);
+  }
+  dispatcher.Drain(0, [&](const QuicReceivedDatagram& datagram) {
+    retained.push_back(datagram.buffer);
+  });
+  // Four buffers are retained, one more than planned for, so the pool runs
+  // dry with the ring half empty.
+  std::size_t full = 0;
+  for (int i = 0; i < 3; i++) {
+    full += dispatcher.Dispatch(0, ShortHeaderPacket(0, 200), peer) ==
+            QuicDispatcherErrorStatus::kFull;
+  }
+  bool intact = retained.size() == 4;
+  for (std::size_t i = 0; i < retained.size(); i++) {
+    intact = intact && retained[i]->size == 100 + i &&
+             retained[i]->Datagram()[1] == 0xC1;
+  }
+  if (full != 1 || !intact) {
+    std::cout << "retained buffer reused or pool exhaustion missed"
+              << std::endl;
+    return false;
+  }
+
+  retained.clear();
+  if (dispatcher.Drain(0, [](const auto&) {}) != 2 ||
+      dispatcher.Dispatch(0, ShortHeaderPacket(0, 200), peer) !=
+          QuicDispatcherErrorStatus::kSuccess) {
+    std::cout << "released buffers not reused" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Datagrams read from a real UDP socket reach their worker with the
+// sender's address.
+static bool CheckSocket() {
+  QuicConnectionIDTable table(kLength, 64);
+  table.Insert(ConnectionID(5), {2, 5});
+  QuicDispatcher dispatcher(table, 1, kWorkers, 8);
+
+  Address address(IPVersion::kIPV6, "::1", 0);
+  Socket server(SocketType::kUDP, address);
+  if (server.Init() != SocketErrorStatus::kSuccess ||
+      server.Bind() != SocketErrorStatus::kSuccess) {
+    std::cout << "bind failed: " << server.GetErrorMessage() << std::endl;
+    return false;
+  }
+  std::uint16_t port = server.GetAddr().data.GetPort().data;
+
+  Socket client(SocketType::kUDP, Address(IPVersion::kIPV6, "::1", port));
+  if (client.Init() != SocketErrorStatus::kSuccess) {
+    std::cout << "client failed: " << client.GetErrorMessage() << std::endl;
+    return false;
+  }
+  if (dispatcher.Receive(1, server) !=
+      QuicDispatcherErrorStatus::kInvalidReceiver) {
+    std::cout << "receiver index not checked" << std::endl;
+    return false;
+  }
+  auto packet = ShortHeaderPacket(5, 300);
+  client.Write(std::as_bytes(std::span(packet)));
+  if (dispatcher.Receive(0, server) != QuicDispatcherErrorStatus::kSuccess) {
+    std::cout << "receive failed: " << server.GetErrorMessage() << std::endl;
+    return false;
+  }
+
+  bool intact = false;
+  dispatcher.Drain(2, [&](const QuicReceivedDatagram& datagram) {
+    intact = datagram.handle.connection == 5 &&
+             std::equal(packet.begin(), packet.end(),
+                        datagram.Datagram().begin(),
+                        datagram.Datagram().end()) &&
+             datagram.peer.GetPort().data != 0;
+  });
+  if (!intact) {
+    std::cout << "received datagram not delivered intact" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// One receiver thread feeding worker threads, as a server's receive path
+// would after recvmmsg.
+static void Benchmark() {
+  constexpr std::size_t kConnections = 1 << 16;
+  constexpr std::size_t kPackets = 1 << 21;
+  QuicConnectionIDTable table(kLength, kConnections);
+  std::vector<std::vector<std::uint8_t>> packets;
+  for (std::uint32_t n = 0; n < kConnections; n++) {
+    table.Insert(ConnectionID(n), {n % kWorkers, n});
+  }
+  for (std::uint32_t n = 0; n < 1024; n++) {
+    packets.push_back(
+        ShortHeaderPacket(static_cast<std::uint32_t>((n * 2654435761u) %
+                                                     kConnections),
+                          1200));
+  }
+  QuicDispatcher dispatcher(table, 1, kWorkers, 1024);
+  Address peer(IPVersion::kIPV6, "::1", 4433);
+
+  std::atomic<bool> done = false;
+  std::atomic<std::size_t> handled = 0;
+  std::vector<std::thread> workers;
+  for (std::size_t worker = 0; worker < kWorkers; worker++) {
+    workers.emplace_back([&, worker] {
+      std::size_t count = 0;
+      for (;;) {
+        // read before draining, so nothing pushed before done is missed
+        bool finished = done;
+        std::size_t drained = dispatcher.Drain(
+            worker, [&](const QuicReceivedDatagram& datagram) {
+              count += datagram.Datagram().back() == 0xAB;
+            });
+        if (drained == 0) {
+          if (finished) {
+            break;
+          }
+          std::this_thread::yield();
+        }
+      }
+      handled += count;
+    });
+  }
+
+  std::size_t dropped = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kPackets; i++) {
+    while (dispatcher.Dispatch(0, packets[i % packets.size()], peer) ==
+           QuicDispatcherErrorStatus::kFull) {
+      dropped++;
+      std::this_thread::yield();
+    }
+  }
+  done = true;
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+  std::cout << "Dispatched " << handled << " datagrams of 1200 bytes to "
+            << kWorkers << " workers in " << elapsed << "s ("
+            << static_cast<double>(kPackets) / elapsed / 1e6 << " Mpps, "
+            << dropped << " retries on full rings, "
+            << std::thread::hardware_concurrency() << " cores)" << std::endl;
+}
+
+int main() {
+  if (!CheckRing() || !CheckRouting() || !CheckRetained() ||
+      !CheckSocket()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC dispatcher test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
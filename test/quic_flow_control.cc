@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "networking/quic/quic_flow_control.h"
+
+using bedrock::network::kQuicDefaultStreamWindow;
+using bedrock::network::QuicConnectionWindowFor;
+using bedrock::network::QuicFlowControlBudget;
+using bedrock::network::QuicFlowControlErrorStatus;
+using bedrock::network::QuicReceiveFlowController;
+using bedrock::network::QuicRTTEstimator;
+using bedrock::network::QuicStreamCreditController;
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+static const Clock::time_point kStart = Clock::time_point(milliseconds(1000));
+
+static bool CheckCredit() {
+  QuicRTTEstimator rtt;
+  rtt.Update(milliseconds(50), milliseconds(0));
+  // a fixed window: max_window equal to the initial one
+  QuicReceiveFlowController stream(1000, 1000);
+  if (stream.OnDataReceived(1001) !=
+          QuicFlowControlErrorStatus::kFlowControl ||
+      stream.OnDataReceived(800) != QuicFlowControlErrorStatus::kSuccess ||
+      stream.OnDataConsumed(400, kStart, rtt) ||
+      !stream.OnDataConsumed(500, kStart, rtt) || stream.MaxData() != 1500 ||
+      stream.Window() != 1000) {
+    std::cout << "credit not extended at half the window" << std::endl;
+    return false;
+  }
+
+  QuicStreamCreditController streams(100);
+  for (int i = 0; i < 49; i++) {
+    if (streams.OnStreamClosed()) {
+      std::cout << "MAX_STREAMS sent too early" << std::endl;
+      return false;
+    }
+  }
+  if (!streams.OnStreamClosed() || streams.MaxStreams() != 150) {
+    std::cout << "MAX_STREAMS not sent" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Idle streams are never charged; busy ones share the budget and give it
+// back when they go away.
+static bool CheckBudget() {
+  QuicFlowControlBudget budget(8 << 20);
+  std::vector<QuicReceiveFlowController> streams;
+  for (int i = 0; i < 10000; i++) {
+    streams.emplace_back(kQuicDefaultStreamWindow, 16 << 20, &budget);
+  }
+  if (budget.Reserved() != 0) {
+    std::cout << "idle streams charged" << std::endl;
+    return false;
+  }
+
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < 20; i++) {
+    streams[i].EnsureWindow(1 << 20);
+    total += streams[i].Window() - kQuicDefaultStreamWindow;
+  }
+  if (budget.Reserved() != total || total > budget.Limit() ||
+      budget.Reserved() != budget.Limit() ||
+      streams[19].Window() != kQuicDefaultStreamWindow) {
+    std::cout << "budget not enforced" << std::endl;
+    return false;
+  }
+  // moving a controller moves its charge with it
+  QuicReceiveFlowController moved = std::move(streams[0]);
+  streams.clear();
+  if (budget.Reserved() != moved.Window() - kQuicDefaultStreamWindow) {
+    std::cout << "budget not released" << std::endl;
+    return false;
+  }
+  moved.ReleaseBudget();
+
+  QuicReceiveFlowController connection(
+      QuicConnectionWindowFor(kQuicDefaultStreamWindow), 24 << 20, &budget);
+  connection.OnStreamWindowGrown(4 << 20);
+  if (connection.Window() != 6 << 20 || budget.Reserved() == 0) {
+    std::cout << "connection window not raised" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// One stream over a 1 Gbps path with a 50 ms RTT, simulated in 1 ms steps.
+// The reader consumes at most read_rate bytes per millisecond. Returns the
+// goodput of the last second in Mbps and the final window.
+static std::pair<double, std::uint64_t> Simulate(std::uint64_t max_window,
+                                                 std::uint64_t read_rate) {
+  constexpr std::uint64_t kLinkRate = 125000;  // bytes per ms
+  constexpr int kOneWay = 25;
+  constexpr int kDuration = 4000;
+  QuicRTTEstimator rtt;
+  rtt.Update(milliseconds(2 * kOneWay), milliseconds(0));
+  QuicReceiveFlowController stream(kQuicDefaultStreamWindow, max_window);
+
+  std::uint64_t sent = 0;
+  std::uint64_t peer_max_data = stream.MaxData();
+  std::uint64_t consumed = 0;
+  std::uint64_t consumed_at_last_second = 0;
+  // (arrival time, offset) of data and of MAX_STREAM_DATA frames
+  std::deque<std::pair<int, std::uint64_t>> data;
+  std::deque<std::pair<int, std::uint64_t>> updates;
+  for (int t = 0; t < kDuration; t++) {
+    Clock::time_point now = kStart + milliseconds(t);
+    while (!updates.empty() && updates.front().first == t) {
+      peer_max_data = std::max(peer_max_data, updates.front().second);
+      updates.pop_front();
+    }
+    std::uint64_t burst = std::min(kLinkRate, peer_max_data - sent);
+    if (burst != 0) {
+      sent += burst;
+      data.emplace_back(t + kOneWay, sent);
+    }
+
+    while (!data.empty() && data.front().first == t) {
+      if (stream.OnDataReceived(data.front().second) !=
+          QuicFlowControlErrorStatus::kSuccess) {
+        std::cout << "flow control violated" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      data.pop_front();
+    }
+    consumed = std::min(stream.Received(), consumed + read_rate);
+    if (stream.OnDataConsumed(consumed, now, rtt)) {
+      updates.emplace_back(t + kOneWay, stream.MaxData());
+    }
+    if (t == kDuration - 1000) {
+      consumed_at_last_second = consumed;
+    }
+  }
+  return {static_cast<double>(consumed - consumed_at_last_second) * 8 / 1e6,
+          stream.Window()};
+}
+
+static bool CheckAutoTune() {
+  auto [fixed, fixed_window] = Simulate(kQuicDefaultStreamWindow, 1 << 30);
+  auto [tuned, tuned_window] = Simulate(16 << 20, 1 << 30);
+  // a reader taking 20 MB/s needs a far smaller window
+  auto [slow, slow_window] = Simulate(16 << 20, 20000);
+  std::cout << "fixed 64 KiB window: " << fixed << " Mbps" << std::endl;
+  std::cout << "auto-tuned: " << tuned << " Mbps, window "
+            << tuned_window / 1024 << " KiB" << std::endl;
+  std::cout << "auto-tuned, 160 Mbps reader: " << slow << " Mbps, window "
+            << slow_window / 1024 << " KiB" << std::endl;
+  if (fixed_window != kQuicDefaultStreamWindow || fixed > 20 ||
+      tuned < 900 || slow < 150 || slow_window >= tuned_window) {
+    std::cout << "auto-tuning failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  if (!CheckCredit() || !CheckBudget() || !CheckAutoTune()) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "QUIC flow control test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_frame.h"
+
+using bedrock::network::QuicAckRangeIteratorV1;
+using bedrock::network::QuicAckRangeV1;
+using bedrock::network::QuicFrameDecoderV1;
+using bedrock::network::QuicFrameErrorStatus;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+
+static void AppendVarInt(std::vector<std::uint8_t>& out, std::uint64_t value) {
+  if (value < 0x40) {
+    out.push_back(static_cast<std::uint8_t>(value));
+  } else if (value < 0x4000) {
+    out.push_back(static_cast<std::uint8_t>(0x40 | (value >> 8)));
+    out.push_back(static_cast<std::uint8_t>(value));
+  } else if (value < 0x40000000) {
+    out.push_back(static_cast<std::uint8_t>(0x80 | (value >> 24)));
+    out.push_back(static_cast<std::uint8_t>(value >> 16));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+    out.push_back(static_cast<std::uint8_t>(value));
+  } else {
+    out.push_back(static_cast<std::uint8_t>(0xC0 | (value >> 56)));
+    for (int shift = 48; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+  }
+}
+
+static std::vector<std::uint8_t> BuildPayload() {
+  std::vector<std::uint8_t> payload;
+
+  // ACK: largest 100, delay 25, 2 ranges, first range 9 -> [91,100]
+  // gap 3 len 4 -> [82,86], gap 0 len 0 -> [80,80]
+  payload.push_back(0x02);
+  AppendVarInt(payload, 100);
+  AppendVarInt(payload, 25);
+  AppendVarInt(payload, 2);
+  AppendVarInt(payload, 9);
+  AppendVarInt(payload, 3);
+  AppendVarInt(payload, 4);
+  AppendVarInt(payload, 0);
+  AppendVarInt(payload, 0);
+
+  // CRYPTO offset 0 length 5
+  payload.push_back(0x06);
+  AppendVarInt(payload, 0);
+  AppendVarInt(payload, 5);
+  for (std::uint8_t i = 0; i < 5; i++) payload.push_back(i);
+
+  // STREAM with OFF and LEN: id 4, offset 1000, length 3, FIN
+  payload.push_back(0x0f);
+  AppendVarInt(payload, 4);
+  AppendVarInt(payload, 1000);
+  AppendVarInt(payload, 3);
+  payload.push_back('a');
+  payload.push_back('b');
+  payload.push_back('c');
+
+  // MAX_DATA, MAX_STREAM_DATA
+  payload.push_back(0x10);
+  AppendVarInt(payload, 1 << 20);
+  payload.push_back(0x11);
+  AppendVarInt(payload, 8);
+  AppendVarInt(payload, 65536);
+
+  // NEW_CONNECTION_ID: seq 1, retire prior to 0, 8 byte id, reset token
+  payload.push_back(0x18);
+  AppendVarInt(payload, 1);
+  AppendVarInt(payload, 0);
+  payload.push_back(8);
+  for (std::uint8_t i = 0; i < 8; i++) payload.push_back(0xC0 | i);
+  for (std::uint8_t i = 0; i < 16; i++) payload.push_back(0xE0 | i);
+
+  // PING, then 37 bytes of PADDING, then STREAM without length
+  payload.push_back(0x01);
+  payload.insert(payload.end(), 37, 0x00);
+  payload.push_back(0x08);
+  AppendVarInt(payload, 0);
+  payload.push_back('z');
+  payload.push_back('z');
+
+  return payload;
+}
+
+static bool CheckDecode(const std::vector<std::uint8_t>& payload) {
+  QuicFrameDecoderV1 decoder(payload, false);
+  QuicFrameV1 frame;
+
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kAck || frame.id != 100 ||
+      frame.extra != 25 || frame.length != 2) {
+    std::cout << "ACK mismatch" << std::endl;
+    return false;
+  }
+  QuicAckRangeIteratorV1 ranges(frame);
+  QuicAckRangeV1 range;
+  const QuicAckRangeV1 expected[] = {{91, 100}, {82, 86}, {80, 80}};
+  for (const auto& want : expected) {
+    if (ranges.Next(range) != QuicFrameErrorStatus::kSuccess ||
+        range.smallest != want.smallest || range.largest != want.largest) {
+      std::cout << "ACK range mismatch" << std::endl;
+      return false;
+    }
+  }
+  if (ranges.Next(range) != QuicFrameErrorStatus::kEnd) {
+    std::cout << "ACK range count mismatch" << std::endl;
+    return false;
+  }
+
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kCrypto || frame.data.size() != 5 ||
+      frame.data[4] != 4) {
+    std::cout << "CRYPTO mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kStream || frame.id != 4 ||
+      frame.offset != 1000 || frame.data.size() != 3 || frame.data[2] != 'c' ||
+      !(frame.flags & bedrock::network::kQuicStreamFrameFinBitV1)) {
+    std::cout << "STREAM mismatch" << std::endl;
+    return false;
+  }
+  // the record must point into the payload, not at a copy
+  if (frame.data.data() < payload.data() ||
+      frame.data.data() >= payload.data() + payload.size()) {
+    std::cout << "STREAM data is not a view into the payload" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kMaxData || frame.offset != (1 << 20)) {
+    std::cout << "MAX_DATA mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kMaxStreamData || frame.id != 8 ||
+      frame.offset != 65536) {
+    std::cout << "MAX_STREAM_DATA mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kNewConnectionID || frame.id != 1 ||
+      frame.data.size() != 8 || frame.aux.size() != 16 ||
+      frame.aux[15] != 0xEF) {
+    std::cout << "NEW_CONNECTION_ID mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kPing) {
+    std::cout << "PING mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kPadding || frame.length != 37) {
+    std::cout << "PADDING mismatch " << frame.length << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kStream || frame.data.size() != 2) {
+    std::cout << "implicit length STREAM mismatch" << std::endl;
+    return false;
+  }
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kEnd) {
+    std::cout << "decoder did not reach the end" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckErrors(const std::vector<std::uint8_t>& payload) {
+  QuicFrameV1 frame;
+
+  // Every prefix that ends inside one of the frames up to PING must report
+  // truncation, and one that ends between two frames must decode cleanly.
+  // PADDING and the implicit length STREAM after PING are valid at any
+  // length, so cutting them only makes them shorter.
+  std::vector<std::size_t> boundaries;
+  QuicFrameDecoderV1 full_decoder(payload, false);
+  do {
+    boundaries.push_back(full_decoder.Offset());
+  } while (full_decoder.Next(frame) == QuicFrameErrorStatus::kSuccess &&
+           frame.type != QuicFrameTypeV1::kPing);
+  boundaries.push_back(full_decoder.Offset());
+  for (std::size_t size = 1; size <= full_decoder.Offset(); size++) {
+    std::span<const std::uint8_t> prefix(payload.data(), size);
+    QuicFrameDecoderV1 truncated_decoder(prefix, false);
+    QuicFrameErrorStatus status = QuicFrameErrorStatus::kSuccess;
+    while (status == QuicFrameErrorStatus::kSuccess) {
+      status = truncated_decoder.Next(frame);
+    }
+    bool boundary = std::find(boundaries.begin(), boundaries.end(), size) !=
+                    boundaries.end();
+    if (status != (boundary ? QuicFrameErrorStatus::kEnd
+                            : QuicFrameErrorStatus::kTruncated)) {
+      std::cout << "truncation at " << size << " bytes not detected"
+                << std::endl;
+      return false;
+    }
+  }
+
+  // STREAM and CRYPTO data may not end beyond 2^62-1
+  const std::array<std::uint8_t, 2> data_types = {0x0e, 0x06};
+  for (std::uint8_t type : data_types) {
+    std::vector<std::uint8_t> overflow = {type};
+    if (type == 0x0e) {
+      AppendVarInt(overflow, 4);
+    }
+    AppendVarInt(overflow, (std::uint64_t{1} << 62) - 2);
+    AppendVarInt(overflow, 2);
+    overflow.insert(overflow.end(), {'x', 'y'});
+    QuicFrameDecoderV1 overflow_decoder(overflow);
+    if (overflow_decoder.Next(frame) != QuicFrameErrorStatus::kMalformed) {
+      std::cout << "data beyond 2^62-1 not detected" << std::endl;
+      return false;
+    }
+    overflow[overflow.size() - 3] = 1;
+    QuicFrameDecoderV1 limit_decoder(overflow);
+    if (limit_decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+        frame.offset + frame.length != (std::uint64_t{1} << 62) - 1) {
+      std::cout << "data up to 2^62-1 rejected" << std::endl;
+      return false;
+    }
+  }
+
+  const std::vector<std::uint8_t> unknown = {0x01, 0x3f};
+  QuicFrameDecoderV1 unknown_decoder(unknown);
+  if (unknown_decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      unknown_decoder.Next(frame) != QuicFrameErrorStatus::kUnknownType) {
+    std::cout << "unknown frame type not detected" << std::endl;
+    return false;
+  }
+
+  // ACK whose first range goes below zero
+  const std::vector<std::uint8_t> bad_ack = {0x02, 0x01, 0x00, 0x00, 0x05};
+  QuicFrameDecoderV1 bad_ack_decoder(bad_ack);
+  if (bad_ack_decoder.Next(frame) != QuicFrameErrorStatus::kMalformed) {
+    std::cout << "malformed ACK not detected" << std::endl;
+    return false;
+  }
+
+  // padding only payload
+  const std::vector<std::uint8_t> padding(1200, 0x00);
+  QuicFrameDecoderV1 padding_decoder(padding);
+  if (padding_decoder.Next(frame) != QuicFrameErrorStatus::kEnd ||
+      padding_decoder.Offset() != padding.size()) {
+    std::cout << "padding fast path mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark(const std::vector<std::uint8_t>& payload) {
+  constexpr int kIterations = 200000;
+  std::array<QuicFrameV1, 16> frames;
+  std::size_t total = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    QuicFrameDecoderV1 decoder(payload);
+    QuicFrameErrorStatus status;
+    total += decoder.Decode(frames, status);
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+  std::vector<std::uint8_t> padded(1200, 0x00);
+  padded[0] = 0x01;
+  std::size_t padded_total = 0;
+  auto padded_begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    QuicFrameDecoderV1 decoder(padded);
+    QuicFrameErrorStatus status;
+    padded_total += decoder.Decode(frames, status);
+  }
+  auto padded_elapsed = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - padded_begin)
+                            .count();
+
+  std::cout << "Decoded " << total << " frames in " << elapsed << "s ("
+            << static_cast<double>(total) / elapsed / 1e6 << " Mframes/s)"
+            << std::endl;
+  std::cout << "Decoded " << kIterations << " padded 1200 byte payloads ("
+            << padded_total << " frames) in " << padded_elapsed << "s ("
+            << 1200.0 * kIterations / padded_elapsed / 1e9 << " GB/s)"
+            << std::endl;
+}
+
+int main() {
+  auto payload = BuildPayload();
+
+  if (!CheckDecode(payload) || !CheckErrors(payload)) {
+    return EXIT_FAILURE;
+  }
+
+  Benchmark(payload);
+
+  std::cout << "Frame decoder test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_initial_key_cache.h"
+#include "networking/quic/quic_packet_protection.h"
+
+using bedrock::network::DeriveQuicInitialKeys;
+using bedrock::network::QuicInitialKeyCache;
+using bedrock::network::QuicInitialKeys;
+using bedrock::network::QuicVersion1;
+using bedrock::network::QuicVersion2;
+
+static constexpr std::array<std::uint8_t, 16> kSample = {
+    0xd1, 0xb1, 0xc9, 0x8d, 0xd7, 0x68, 0x9f, 0xb8,
+    0xec, 0x11, 0xd2, 0x42, 0xb1, 0x23, 0xdc, 0x9b};
+
+// Keys are compared through their header protection masks, which differ for
+// any other DCID or version.
+static bool SameKeys(const QuicInitialKeys& a, const QuicInitialKeys& b) {
+  return a.client.HeaderProtectionMask(kSample.data()) ==
+             b.client.HeaderProtectionMask(kSample.data()) &&
+         a.server.HeaderProtectionMask(kSample.data()) ==
+             b.server.HeaderProtectionMask(kSample.data());
+}
+
+// Fixed bucket hash key, so placement and the flood result are reproducible
+static constexpr std::array<std::uint8_t, 16> kHashKey = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+static std::array<std::uint8_t, 8> MakeID(std::uint64_t value) {
+  std::array<std::uint8_t, 8> id;
+  for (std::size_t i = 0; i < id.size(); i++) {
+    id[i] = static_cast<std::uint8_t>(value >> (i * 8));
+  }
+  return id;
+}
+
+static bool CheckCache() {
+  QuicInitialKeyCache cache(64);
+  if (cache.Capacity() != 64) {
+    std::cout << "unexpected capacity " << cache.Capacity() << std::endl;
+    return false;
+  }
+
+  auto id = MakeID(0x0857513ef0c89483);
+  QuicInitialKeys v1;
+  QuicInitialKeys v2;
+  DeriveQuicInitialKeys<QuicVersion1>(id, v1);
+  DeriveQuicInitialKeys<QuicVersion2>(id, v2);
+  if (!SameKeys(cache.Find<QuicVersion1>(id), v1) ||
+      !SameKeys(cache.Find<QuicVersion2>(id), v2) ||
+      !SameKeys(cache.Find<QuicVersion1>(id), v1) ||
+      !SameKeys(cache.Find<QuicVersion2>(id), v2) || SameKeys(v1, v2)) {
+    std::cout << "cached keys differ from derived ones" << std::endl;
+    return false;
+  }
+  if (cache.Hits() != 2 || cache.Misses() != 2) {
+    std::cout << "versions must be cached separately" << std::endl;
+    return false;
+  }
+
+  // a shorter ID with the same leading bytes is another key
+  QuicInitialKeys shorter;
+  DeriveQuicInitialKeys<QuicVersion1>(std::span(id).first(7), shorter);
+  if (!SameKeys(cache.Find<QuicVersion1>(std::span(id).first(7)), shorter)) {
+    std::cout << "prefix of a cached ID was served its keys" << std::endl;
+    return false;
+  }
+
+  // IDs above 20 bytes are served but never cached
+  std::array<std::uint8_t, 24> long_id{};
+  QuicInitialKeys long_keys;
+  DeriveQuicInitialKeys<QuicVersion1>(long_id, long_keys);
+  std::uint64_t hits = cache.Hits();
+  if (!SameKeys(cache.Find<QuicVersion1>(long_id), long_keys) ||
+      !SameKeys(cache.Find<QuicVersion1>(long_id), long_keys) ||
+      cache.Hits() != hits) {
+    std::cout << "long connection ID mishandled" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A single bucket whose entries are all referenced keeps them for a new ID
+// and only gives up a slot once the clock hand has aged one.
+static bool CheckReplacement() {
+  QuicInitialKeyCache cache(4, kHashKey);
+  for (std::uint64_t round = 0; round < 2; round++) {
+    for (std::uint64_t i = 0; i < 4; i++) {
+      cache.Find<QuicVersion1>(MakeID(i));
+    }
+  }
+  auto id = MakeID(100);
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<QuicVersion1>(id, keys);
+  // uncached, then stored over the entry the hand aged, then a hit
+  for (int n = 0; n < 3; n++) {
+    if (!SameKeys(cache.Find<QuicVersion1>(id), keys)) {
+      std::cout << "wrong keys for a full bucket" << std::endl;
+      return false;
+    }
+  }
+  if (cache.Hits() != 5 || cache.Misses() != 6) {
+    std::cout << "full bucket evicted a referenced entry (" << cache.Hits()
+              << " hits, " << cache.Misses() << " misses)" << std::endl;
+    return false;
+  }
+  for (std::uint64_t i = 1; i < 4; i++) {
+    cache.Find<QuicVersion1>(MakeID(i));
+  }
+  if (cache.Hits() != 8) {
+    std::cout << "the aged entry was not the one replaced" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Connections whose Initials are retransmitted must keep their entries while
+// a flood of one-off spoofed IDs streams through the cache.
+static bool CheckFlood() {
+  constexpr std::size_t kCapacity = 256;
+  constexpr std::uint64_t kConnections = 64;
+  constexpr std::uint64_t kFlood = 20000;
+  QuicInitialKeyCache cache(kCapacity, kHashKey);
+
+  for (std::uint64_t round = 0; round < 2; round++) {
+    for (std::uint64_t i = 0; i < kConnections; i++) {
+      cache.Find<QuicVersion1>(MakeID(i));
+    }
+  }
+  std::uint64_t hits = cache.Hits();
+  std::uint64_t retransmits = 0;
+  for (std::uint64_t i = 0; i < kFlood; i++) {
+    cache.Find<QuicVersion1>(MakeID(0x5000000000000000 + i));
+    if (i % 64 == 0) {
+      cache.Find<QuicVersion1>(MakeID(i / 64 % kConnections));
+      retransmits++;
+    }
+  }
+  std::uint64_t retransmit_hits = cache.Hits() - hits;
+  std::cout << retransmit_hits << " of " << retransmits
+            << " retransmitted Initials hit during a flood of " << kFlood
+            << " spoofed IDs" << std::endl;
+  if (retransmit_hits * 10 < retransmits * 9) {
+    std::cout << "flood evicted live connections" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr std::size_t kLookups = 1 << 14;
+  QuicInitialKeyCache cache(1024);
+  std::vector<std::array<std::uint8_t, 8>> ids;
+  for (std::uint64_t i = 0; i < 256; i++) {
+    ids.push_back(MakeID(i * 0x9E3779B97F4A7C15));
+  }
+
+  std::size_t checksum = 0;
+  QuicInitialKeys keys;
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kLookups; i++) {
+    DeriveQuicInitialKeys<QuicVersion1>(ids[i % ids.size()], keys);
+    checksum += keys.client.HeaderProtectionMask(kSample.data())[0];
+  }
+  double derive = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+  for (const auto& id : ids) {
+    cache.Find<QuicVersion1>(id);
+  }
+  begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kLookups; i++) {
+    const QuicInitialKeys& cached =
+        cache.Find<QuicVersion1>(ids[i % ids.size()]);
+    checksum -= cached.client.HeaderProtectionMask(kSample.data())[0];
+  }
+  double lookup = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+  double count = static_cast<double>(kLookups);
+  std::cout << "Initial keys: " << derive / count * 1e9
+            << " ns derived, " << lookup / count * 1e9 << " ns through the "
+            << "cache (" << cache.Hits() << " hits, checksum " << checksum
+            << ")" << std::endl;
+}
+
+int main() {
+  if (!CheckCache() || !CheckReplacement() || !CheckFlood()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "Initial key cache test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
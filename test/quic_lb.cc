@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "networking/quic/quic_crypto.h"
+#include "networking/quic/quic_lb.h"
+
+using bedrock::network::QuicAES128;
+using bedrock::network::QuicLBConfig;
+using bedrock::network::QuicLBConnectionIDDecoder;
+using bedrock::network::QuicLBConnectionIDGenerator;
+using bedrock::network::QuicLBErrorStatus;
+
+static constexpr std::array<std::uint8_t, 16> kKey = {
+    0x8f, 0x95, 0xf0, 0x92, 0x45, 0x76, 0x5f, 0x80,
+    0x25, 0x69, 0x34, 0xe5, 0x0c, 0x66, 0x20, 0x7f};
+
+static std::vector<std::uint8_t> FromHex(std::string_view hex) {
+  std::vector<std::uint8_t> bytes;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    auto nibble = [](char c) {
+      return c <= '9' ? c - '0' : c - 'a' + 10;
+    };
+    bytes.push_back(
+        static_cast<std::uint8_t>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+  }
+  return bytes;
+}
+
+// FIPS-197 appendix C.1
+static bool CheckAES() {
+  std::array<std::uint8_t, 16> key;
+  std::array<std::uint8_t, 16> plaintext;
+  for (std::uint8_t i = 0; i < 16; i++) {
+    key[i] = i;
+    plaintext[i] = static_cast<std::uint8_t>(i * 0x11);
+  }
+  const std::array<std::uint8_t, 16> expected = {
+      0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+      0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+
+  QuicAES128 cipher(key);
+  std::array<std::uint8_t, 16> block;
+  cipher.EncryptBlock(plaintext.data(), block.data());
+  if (block != expected) {
+    std::cout << "AES-128 known answer mismatch" << std::endl;
+    return false;
+  }
+  cipher.DecryptBlock(block.data(), block.data());
+  if (block != plaintext) {
+    std::cout << "AES-128 decryption mismatch" << std::endl;
+    return false;
+  }
+
+  // the interleaved path must match block by block encryption
+  std::array<std::uint8_t, 16 * 7> blocks;
+  std::array<std::uint8_t, 16 * 7> encrypted;
+  for (std::size_t i = 0; i < blocks.size(); i++) {
+    blocks[i] = static_cast<std::uint8_t>(i * 7);
+  }
+  cipher.Encrypt(blocks, encrypted);
+  for (std::size_t i = 0; i < blocks.size(); i += 16) {
+    cipher.EncryptBlock(blocks.data() + i, block.data());
+    if (!std::equal(block.begin(), block.end(), encrypted.begin() +
+                                                    static_cast<long>(i))) {
+      std::cout << "batched AES-128 mismatch" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every valid length combination must give back its server ID in both
+// modes, including the single block and odd length Feistel cases.
+static bool CheckRoundTrip() {
+  for (int encrypted = 0; encrypted < 2; encrypted++) {
+    for (std::uint8_t server_id_length = 1; server_id_length <= 15;
+         server_id_length++) {
+      for (std::uint8_t nonce_length = 4;
+           server_id_length + nonce_length <= 19; nonce_length++) {
+        QuicLBConfig config;
+        config.config_id = 2;
+        config.server_id_length = server_id_length;
+        config.nonce_length = nonce_length;
+        config.encrypted = encrypted;
+        config.length_self_description = nonce_length & 1;
+        config.key = kKey;
+
+        std::vector<std::uint8_t> server_id(server_id_length);
+        for (std::size_t i = 0; i < server_id.size(); i++) {
+          server_id[i] = static_cast<std::uint8_t>(0xA0 + i * 3);
+        }
+        QuicLBConnectionIDGenerator generator(config, server_id);
+        QuicLBConnectionIDDecoder decoder(config);
+        if (!generator.IsValid() || !decoder.IsValid()) {
+          std::cout << "valid configuration rejected" << std::endl;
+          return false;
+        }
+
+        std::set<std::vector<std::uint8_t>> issued;
+        for (int n = 0; n < 64; n++) {
+          std::vector<std::uint8_t> connection_id(
+              generator.ConnectionIDLength());
+          std::vector<std::uint8_t> decoded(server_id_length);
+          if (generator.Generate(connection_id) !=
+                  QuicLBErrorStatus::kSuccess ||
+              decoder.ServerID(connection_id, decoded) !=
+                  QuicLBErrorStatus::kSuccess ||
+              decoded != server_id ||
+              QuicLBConnectionIDDecoder::ConfigID(connection_id[0]) != 2 ||
+              (config.length_self_description &&
+               (connection_id[0] & 0x1F) != connection_id.size() - 1)) {
+            std::cout << "round trip failed for " << int{server_id_length}
+                      << "+" << int{nonce_length}
+                      << (encrypted ? " encrypted" : " plaintext")
+                      << std::endl;
+            return false;
+          }
+          issued.insert(connection_id);
+        }
+        // encrypted IDs must hide the server ID
+        if (issued.size() != 64 ||
+            (encrypted &&
+             std::all_of(issued.begin(), issued.end(), [&](const auto& id) {
+               return std::equal(server_id.begin(), server_id.end(),
+                                 id.begin() + 1);
+             }))) {
+          std::cout << "connection IDs repeat or expose the server ID"
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Encrypted mode known answers (draft-ietf-quic-load-balancers section 5).
+// The 16-byte case is a single AES block; the odd lengths exercise the
+// four-pass Feistel network, whose round input carries both the plaintext
+// length and the pass index.
+static bool CheckKnownAnswers() {
+  struct Vector {
+   public:
+    std::string_view key;
+    std::string_view server_id;
+    std::uint8_t nonce_length;
+    bool length_self_description;
+    std::string_view connection_id;
+  };
+  const Vector vectors[] = {
+      {"fdf726a9893ec05c0632d3956680baf0", "ed793a", 4, true,
+       "07f71fff191ad58a"},
+      {"fdf726a9893ec05c0632d3956680baf0", "ed793a51d49b8f5fab65", 5, true,
+       "2fdefc85441527a533b07ce53f87e17d"},
+      {"8f95f09245765f80256934e50c66207f", "ed793a51d49b8f5f", 8, true,
+       "504dd2d05a7b0de9b2b9907afb5ecf8cc3"},
+      {"8f95f09245765f80256934e50c66207f", "ed793a51d49b8f5fab", 8, true,
+       "11b1426a9b4e3161016b9b4b46696798dabd"},
+      {"8f95f09245765f80256934e50c66207f", "12345678", 4, false,
+       "35e80c74f76fbb4313"},
+      {"4d9d0fd25a25e7f321ef464e13f9fa3d", "ed793a51d49b8f5fab65d4", 8, false,
+       "55afd30b51741055c21cdfd02f336467115784c4"},
+  };
+  for (const Vector& vector : vectors) {
+    std::vector<std::uint8_t> key = FromHex(vector.key);
+    std::vector<std::uint8_t> server_id = FromHex(vector.server_id);
+    std::vector<std::uint8_t> connection_id = FromHex(vector.connection_id);
+    QuicLBConfig config;
+    config.config_id =
+        QuicLBConnectionIDDecoder::ConfigID(connection_id[0]);
+    config.server_id_length = static_cast<std::uint8_t>(server_id.size());
+    config.nonce_length = vector.nonce_length;
+    config.length_self_description = vector.length_self_description;
+    config.encrypted = true;
+    std::copy(key.begin(), key.end(), config.key.begin());
+
+    std::vector<std::uint8_t> decoded(server_id.size());
+    if (QuicLBConnectionIDDecoder(config).ServerID(connection_id, decoded) !=
+            QuicLBErrorStatus::kSuccess ||
+        decoded != server_id) {
+      std::cout << "known answer mismatch for " << vector.connection_id
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool CheckRejected() {
+  QuicLBConfig config;
+  config.server_id_length = 3;
+  config.nonce_length = 4;
+  config.encrypted = true;
+  config.key = kKey;
+  std::array<std::uint8_t, 3> server_id = {1, 2, 3};
+  std::array<std::uint8_t, 3> decoded;
+  std::array<std::uint8_t, 8> connection_id;
+
+  QuicLBConnectionIDGenerator generator(config, server_id);
+  QuicLBConnectionIDDecoder decoder(config);
+  generator.Generate(connection_id);
+  connection_id[0] |= 0xE0;
+
+  QuicLBConfig too_long = config;
+  too_long.nonce_length = 17;
+  QuicLBConfig unroutable = config;
+  unroutable.config_id = 7;
+  if (decoder.ServerID(connection_id, decoded) !=
+          QuicLBErrorStatus::kConfig ||
+      decoder.ServerID(std::span(connection_id).first(7), decoded) !=
+          QuicLBErrorStatus::kLength ||
+      QuicLBConnectionIDDecoder(too_long).IsValid() ||
+      QuicLBConnectionIDDecoder(unroutable).IsValid() ||
+      QuicLBConnectionIDGenerator(config, std::span(server_id).first(2))
+          .IsValid()) {
+    std::cout << "invalid input accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark(std::uint8_t server_id_length,
+                      std::uint8_t nonce_length) {
+  constexpr std::size_t kIDs = 1 << 20;
+  QuicLBConfig config;
+  config.server_id_length = server_id_length;
+  config.nonce_length = nonce_length;
+  config.encrypted = true;
+  config.key = kKey;
+  std::vector<std::uint8_t> server_id(server_id_length, 0x5A);
+  QuicLBConnectionIDGenerator generator(config, server_id);
+  QuicLBConnectionIDDecoder decoder(config);
+
+  std::size_t length = generator.ConnectionIDLength();
+  std::vector<std::uint8_t> ids(1024 * length);
+  for (std::size_t i = 0; i < 1024; i++) {
+    generator.Generate(std::span(ids).subspan(i * length, length));
+  }
+  std::vector<std::uint8_t> decoded(server_id_length);
+  std::size_t matched = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kIDs; i++) {
+    decoder.ServerID(std::span(ids).subspan((i % 1024) * length, length),
+                     decoded);
+    matched += decoded[0] == 0x5A;
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  std::cout << "Decoded " << matched << " encrypted " << int{server_id_length}
+            << "+" << int{nonce_length} << " byte connection IDs in "
+            << elapsed << "s ("
+            << elapsed / static_cast<double>(kIDs) * 1e9 << " ns/ID)"
+            << std::endl;
+}
+
+int main() {
+  if (!CheckAES() || !CheckKnownAnswers() || !CheckRoundTrip() ||
+      !CheckRejected()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark(6, 10);  // single block
+  Benchmark(3, 4);   // Feistel, Server ID in the left half
+  Benchmark(8, 5);   // Feistel, all four passes
+
+  std::cout << "QUIC-LB connection ID test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
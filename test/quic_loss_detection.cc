@@ -0,0 +1,295 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_ack_tracker.h"
+#include "networking/quic/quic_loss_detection.h"
+
+using bedrock::network::kQuicTimerGranularity;
+using bedrock::network::QuicAckRangeV1;
+using bedrock::network::QuicAckTracker;
+using bedrock::network::QuicLossDetection;
+using bedrock::network::QuicLossDetectionErrorStatus;
+using bedrock::network::QuicLossDetectionOutcome;
+using bedrock::network::QuicLossDetectionTimeout;
+using bedrock::network::QuicPacketNumberSpaceV1;
+using bedrock::network::QuicRTTEstimator;
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+static constexpr auto kAppData = QuicPacketNumberSpaceV1::kApplicationData;
+// Synthetic clock, so every run sees the same timings
+static const Clock::time_point kStart = Clock::time_point(milliseconds(1000));
+
+// rfc9002 section 5.3
+static bool CheckRTT() {
+  QuicRTTEstimator rtt;
+  rtt.Update(milliseconds(100), milliseconds(0));
+  if (rtt.SmoothedRTT() != milliseconds(100) ||
+      rtt.RTTVariance() != milliseconds(50) ||
+      rtt.MinRTT() != milliseconds(100)) {
+    std::cout << "first RTT sample not taken as is" << std::endl;
+    return false;
+  }
+  rtt.Update(milliseconds(200), milliseconds(20));
+  if (rtt.SmoothedRTT() != milliseconds(110) ||
+      rtt.RTTVariance() != microseconds(57500) ||
+      rtt.LatestRTT() != milliseconds(200)) {
+    std::cout << "RTT sample mismatch: smoothed "
+              << rtt.SmoothedRTT().count() << " us" << std::endl;
+    return false;
+  }
+  // ack delay never takes the sample below min_rtt
+  rtt.Update(milliseconds(105), milliseconds(50));
+  if (rtt.MinRTT() != milliseconds(100) ||
+      rtt.SmoothedRTT() != microseconds((7 * 110000 + 105000) / 8)) {
+    std::cout << "ack delay over-subtracted" << std::endl;
+    return false;
+  }
+  if (rtt.ProbeTimeout() != rtt.SmoothedRTT() + 4 * rtt.RTTVariance() ||
+      rtt.LossDelay() < kQuicTimerGranularity) {
+    std::cout << "timeouts mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void SendPackets(QuicLossDetection& detection, std::uint64_t from,
+                        std::uint64_t to, Clock::time_point time) {
+  for (std::uint64_t pn = from; pn < to; pn++) {
+    detection.OnPacketSent(kAppData, pn, 1200, true, true, time);
+  }
+}
+
+static bool CheckThresholds() {
+  QuicLossDetection detection(1024);
+  detection.SetHandshakeConfirmed();
+  SendPackets(detection, 0, 10, kStart);
+  if (detection.BytesInFlight() != 12000) {
+    std::cout << "bytes in flight not counted" << std::endl;
+    return false;
+  }
+
+  // 6 is three below the largest acknowledged, 7 only two
+  std::array<std::uint64_t, 16> lost;
+  QuicLossDetectionOutcome outcome;
+  const std::array<QuicAckRangeV1, 2> ranges = {{{8, 9}, {0, 5}}};
+  if (detection.OnAckReceived(kAppData, ranges, microseconds(0),
+                              kStart + milliseconds(50), lost, outcome) !=
+          QuicLossDetectionErrorStatus::kSuccess ||
+      outcome.acked_packets != 8 || outcome.lost_packets != 1 ||
+      lost[0] != 6 || !outcome.rtt_updated ||
+      detection.RTT().SmoothedRTT() != milliseconds(50) ||
+      detection.BytesInFlight() != 1200) {
+    std::cout << "packet threshold loss mismatch" << std::endl;
+    return false;
+  }
+
+  // 7 is declared lost 9/8 RTT after it was sent
+  Clock::time_point timer = detection.LossDetectionTimer();
+  QuicPacketNumberSpaceV1 space;
+  if (timer != kStart + microseconds(56250) ||
+      detection.OnLossDetectionTimeout(timer - microseconds(1), lost, space,
+                                       outcome) !=
+          QuicLossDetectionTimeout::kNone ||
+      detection.OnLossDetectionTimeout(timer, lost, space, outcome) !=
+          QuicLossDetectionTimeout::kLossDetected ||
+      space != kAppData || outcome.lost_packets != 1 || lost[0] != 7 ||
+      detection.BytesInFlight() != 0) {
+    std::cout << "time threshold loss mismatch" << std::endl;
+    return false;
+  }
+
+  // duplicate ACKs change nothing
+  detection.OnAckReceived(kAppData, ranges, microseconds(0),
+                          kStart + milliseconds(60), lost, outcome);
+  if (outcome.acked_packets != 0 || outcome.lost_packets != 0) {
+    std::cout << "duplicate ACK processed again" << std::endl;
+    return false;
+  }
+  const std::array<QuicAckRangeV1, 1> unsent = {{{0, 10}}};
+  if (detection.OnAckReceived(kAppData, unsent, microseconds(0),
+                              kStart + milliseconds(60), lost,
+                              outcome) !=
+      QuicLossDetectionErrorStatus::kInvalid) {
+    std::cout << "ACK of an unsent packet accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckProbeTimeout() {
+  QuicLossDetection detection(1024);
+  detection.SetMaxAckDelay(milliseconds(25));
+  detection.OnPacketSent(QuicPacketNumberSpaceV1::kHandshake, 0, 1200, true,
+                         true, kStart);
+  // application data gets no PTO before the handshake is confirmed
+  detection.OnPacketSent(kAppData, 0, 1200, true, true, kStart);
+
+  microseconds pto = detection.RTT().ProbeTimeout();
+  std::array<std::uint64_t, 4> lost;
+  QuicLossDetectionOutcome outcome;
+  QuicPacketNumberSpaceV1 space = kAppData;
+  if (detection.LossDetectionTimer() != kStart + pto ||
+      detection.OnLossDetectionTimeout(kStart + pto, lost, space, outcome) !=
+          QuicLossDetectionTimeout::kProbe ||
+      space != QuicPacketNumberSpaceV1::kHandshake ||
+      detection.PTOCount() != 1 ||
+      detection.LossDetectionTimer() != kStart + 2 * pto) {
+    std::cout << "PTO mismatch" << std::endl;
+    return false;
+  }
+
+  // once Handshake keys are gone, the application data PTO includes
+  // max_ack_delay
+  detection.DiscardSpace(QuicPacketNumberSpaceV1::kHandshake);
+  detection.SetHandshakeConfirmed();
+  if (detection.BytesInFlight() != 1200 ||
+      detection.LossDetectionTimer() !=
+          kStart + pto + milliseconds(25)) {
+    std::cout << "application data PTO mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckPersistentCongestion() {
+  QuicLossDetection detection(1024);
+  detection.SetHandshakeConfirmed();
+  std::array<std::uint64_t, 64> lost;
+  QuicLossDetectionOutcome outcome;
+
+  // first RTT sample of 10 ms
+  detection.OnPacketSent(kAppData, 0, 1200, true, true, kStart);
+  const std::array<QuicAckRangeV1, 1> first = {{{0, 0}}};
+  detection.OnAckReceived(kAppData, first, microseconds(0),
+                          kStart + milliseconds(10), lost, outcome);
+
+  // a second of blackhole, then three packets get through
+  for (std::uint64_t pn = 1; pn <= 20; pn++) {
+    detection.OnPacketSent(kAppData, pn, 1200, true, true,
+                           kStart + milliseconds(50 * pn));
+  }
+  SendPackets(detection, 21, 24, kStart + milliseconds(1100));
+  const std::array<QuicAckRangeV1, 1> late = {{{21, 23}}};
+  detection.OnAckReceived(kAppData, late, microseconds(0),
+                          kStart + milliseconds(1110), lost, outcome);
+  if (outcome.lost_packets != 20 || !outcome.persistent_congestion ||
+      outcome.largest_lost_time_sent != kStart + milliseconds(1000)) {
+    std::cout << "persistent congestion not declared" << std::endl;
+    return false;
+  }
+
+  // a short burst of losses is not persistent congestion
+  SendPackets(detection, 24, 30, kStart + milliseconds(1200));
+  const std::array<QuicAckRangeV1, 1> tail = {{{29, 29}}};
+  detection.OnAckReceived(kAppData, tail, microseconds(0),
+                          kStart + milliseconds(1210), lost, outcome);
+  if (outcome.lost_packets != 3 || outcome.persistent_congestion) {
+    std::cout << "short loss taken as persistent congestion" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckLimits() {
+  QuicLossDetection detection(16);
+  SendPackets(detection, 0, 16, kStart);
+  if (detection.OnPacketSent(kAppData, 16, 1200, true, true, kStart) !=
+          QuicLossDetectionErrorStatus::kNoSpace ||
+      detection.OnPacketSent(kAppData, 3, 1200, true, true, kStart) !=
+          QuicLossDetectionErrorStatus::kInvalid) {
+    std::cout << "sent packet window not enforced" << std::endl;
+    return false;
+  }
+
+  // losses beyond the output span are declared by the timer
+  std::array<std::uint64_t, 4> lost;
+  QuicLossDetectionOutcome outcome;
+  const std::array<QuicAckRangeV1, 1> ranges = {{{15, 15}}};
+  Clock::time_point now = kStart + milliseconds(5);
+  detection.OnAckReceived(kAppData, ranges, microseconds(0), now, lost,
+                          outcome);
+  QuicPacketNumberSpaceV1 space;
+  std::size_t total = outcome.lost_packets;
+  while (detection.LossDetectionTimer() <= now &&
+         detection.OnLossDetectionTimeout(now, lost, space, outcome) ==
+             QuicLossDetectionTimeout::kLossDetected) {
+    total += outcome.lost_packets;
+  }
+  if (total != 13 || detection.BytesInFlight() != 2 * 1200) {
+    std::cout << "lost packets past the output span missed" << std::endl;
+    return false;
+  }
+  // the window slid past the released packets
+  if (detection.OnPacketSent(kAppData, 16, 1200, true, true, now) !=
+      QuicLossDetectionErrorStatus::kSuccess) {
+    std::cout << "window did not slide" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// ACK processing cost with a given number of packets in flight. The peer's
+// ACK tracker receives each packet in_flight packets after it was sent,
+// drops one in lose_every, and acknowledges every second packet.
+static void Benchmark(std::size_t in_flight, std::uint64_t lose_every) {
+  constexpr std::uint64_t kPackets = 1 << 22;
+  QuicLossDetection detection(2 * in_flight);
+  detection.SetHandshakeConfirmed();
+  QuicAckTracker peer;
+  std::array<std::uint64_t, 64> lost;
+  QuicLossDetectionOutcome outcome;
+
+  std::uint64_t acks = 0;
+  std::uint64_t lost_total = 0;
+  double elapsed = 0;
+  for (std::uint64_t pn = 0; pn < kPackets; pn++) {
+    Clock::time_point now = kStart + microseconds(pn);
+    detection.OnPacketSent(kAppData, pn, 1200, true, true, now);
+    if (pn < in_flight) {
+      continue;
+    }
+    std::uint64_t arrived = pn - in_flight;
+    if (lose_every != 0 && arrived % lose_every == lose_every / 2) {
+      continue;
+    }
+    peer.OnPacketReceived(arrived, true, now);
+    if (!peer.AckImmediately()) {
+      continue;
+    }
+    auto ranges = peer.Ranges();
+    auto begin = Clock::now();
+    detection.OnAckReceived(kAppData, ranges, microseconds(0), now, lost,
+                            outcome);
+    elapsed += std::chrono::duration<double>(Clock::now() - begin).count();
+    // the peer stops reporting what our ACK of its ACK covered
+    peer.OnAckAcknowledged(ranges[0].largest > 64 ? ranges[0].largest - 64
+                                                   : 0);
+    acks++;
+    lost_total += outcome.lost_packets;
+  }
+  std::cout << in_flight << " packets in flight, "
+            << (lose_every == 0 ? 0.0 : 100.0 / static_cast<double>(lose_every))
+            << "% lost: " << elapsed / static_cast<double>(acks) * 1e9
+            << " ns per ACK (" << acks << " ACKs, " << lost_total
+            << " lost, " << detection.RTT().SmoothedRTT().count()
+            << " us RTT)" << std::endl;
+}
+
+int main() {
+  if (!CheckRTT() || !CheckThresholds() || !CheckProbeTimeout() ||
+      !CheckPersistentCongestion() || !CheckLimits()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark(1024, 0);
+  Benchmark(65536, 0);
+  Benchmark(65536, 100);
+
+  std::cout << "QUIC loss detection test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,547 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "networking/quic/quic_congestion_control.h"
+#include "networking/quic/quic_loss_detection.h"
+#include "networking/quic/quic_migration.h"
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/socket.h"
+
+using bedrock::network::Address;
+using bedrock::network::IPVersion;
+using bedrock::network::kQuicActiveConnectionIDLimit;
+using bedrock::network::kQuicMinInitialDatagramSizeV1;
+using bedrock::network::QuicAckRangeV1;
+using bedrock::network::QuicBBR;
+using bedrock::network::QuicCongestionController;
+using bedrock::network::QuicCubic;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+using bedrock::network::QuicLossDetection;
+using bedrock::network::QuicLossDetectionOutcome;
+using bedrock::network::QuicMigrationErrorStatus;
+using bedrock::network::QuicNewReno;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicPacketBuilderV1;
+using bedrock::network::QuicPacketNumberSpaceV1;
+using bedrock::network::QuicPathAddress;
+using bedrock::network::QuicPathEvent;
+using bedrock::network::QuicPathManager;
+using bedrock::network::QuicPeerConnectionIDs;
+using bedrock::network::QuicRTTEstimator;
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+static const Clock::time_point kStart = Clock::time_point(milliseconds(1000));
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+using ChallengeData = std::array<std::uint8_t, 8>;
+
+static bool SamePeer(const Address& a, const Address& b) {
+  return QuicPathAddress::From(a) == QuicPathAddress::From(b);
+}
+
+// NEW_CONNECTION_ID whose connection ID and token are derived from
+// sequence.
+struct NewConnectionID {
+ public:
+  NewConnectionID(std::uint64_t sequence, std::uint64_t retire_prior_to) {
+    connection_id.fill(static_cast<std::uint8_t>(sequence));
+    token.fill(static_cast<std::uint8_t>(0x80 | sequence));
+    frame.type = QuicFrameTypeV1::kNewConnectionID;
+    frame.id = sequence;
+    frame.offset = retire_prior_to;
+    frame.length = connection_id.size();
+    frame.data = connection_id;
+    frame.aux = token;
+  }
+
+  std::array<std::uint8_t, 8> connection_id;
+  std::array<std::uint8_t, 16> token;
+  QuicFrameV1 frame;
+};
+
+// Sequence numbers of the RETIRE_CONNECTION_ID frames written.
+static std::size_t WriteRetirements(QuicPeerConnectionIDs& ids,
+                                    std::span<std::uint64_t> sequences) {
+  std::array<std::uint8_t, 1500> buffer;
+  QuicPacketBuilderV1 builder(buffer, buffer.size());
+  builder.BeginShortPacket(kDcid, 0, 2, false);
+  std::size_t payload = builder.Packets()[0].payload_offset;
+  std::size_t written = ids.WriteFrames(builder);
+  for (std::size_t i = 0; i < written; i++) {
+    // type 0x19 and a one byte sequence number
+    if (buffer[payload + 2 * i] != 0x19) {
+      return 0;
+    }
+    sequences[i] = buffer[payload + 2 * i + 1];
+  }
+  return written;
+}
+
+static bool CheckConnectionIDs() {
+  const std::array<std::uint8_t, 4> initial = {9, 9, 9, 9};
+  QuicPeerConnectionIDs ids(initial, 4);
+  if (ids.Rotate() != QuicMigrationErrorStatus::kNoConnectionID ||
+      ids.CurrentSequence() != 0) {
+    std::cout << "rotated without a spare connection ID" << std::endl;
+    return false;
+  }
+
+  NewConnectionID one(1, 0), two(2, 0), three(3, 0);
+  if (ids.OnNewConnectionID(two.frame) != QuicMigrationErrorStatus::kSuccess ||
+      ids.OnNewConnectionID(one.frame) != QuicMigrationErrorStatus::kSuccess ||
+      ids.OnNewConnectionID(one.frame) != QuicMigrationErrorStatus::kSuccess ||
+      ids.OnNewConnectionID(three.frame) !=
+          QuicMigrationErrorStatus::kSuccess ||
+      ids.Unused() != 3) {
+    std::cout << "connection IDs not stored" << std::endl;
+    return false;
+  }
+  NewConnectionID forged(2, 0);
+  forged.connection_id[0] ^= 1;
+  if (ids.OnNewConnectionID(forged.frame) !=
+      QuicMigrationErrorStatus::kProtocolViolation) {
+    std::cout << "sequence number reused for another ID" << std::endl;
+    return false;
+  }
+
+  // a migration takes the lowest unused sequence number and retires the
+  // old one
+  std::array<std::uint64_t, 16> retired;
+  if (ids.Rotate() != QuicMigrationErrorStatus::kSuccess ||
+      ids.CurrentSequence() != 1 || ids.Current()[0] != 1 ||
+      ids.Current().size() != 8 || ids.Unused() != 2 ||
+      WriteRetirements(ids, retired) != 1 || retired[0] != 0 ||
+      ids.PendingRetirements() != 0) {
+    std::cout << "rotation did not retire the old ID" << std::endl;
+    return false;
+  }
+  if (!ids.IsStatelessReset(three.token) ||
+      ids.IsStatelessReset(forged.connection_id)) {
+    std::cout << "stateless reset token not recognized" << std::endl;
+    return false;
+  }
+
+  // Retire Prior To 3 retires 1 (in use) and 2; 5 is stored; 0 arrives
+  // late and is retired at once.
+  NewConnectionID five(5, 3), zero(0, 0);
+  if (ids.OnNewConnectionID(five.frame) !=
+          QuicMigrationErrorStatus::kSuccess ||
+      ids.CurrentSequence() != 3 || ids.Unused() != 1 ||
+      ids.OnNewConnectionID(zero.frame) !=
+          QuicMigrationErrorStatus::kSuccess ||
+      ids.PendingRetirements() != 3) {
+    std::cout << "Retire Prior To not applied" << std::endl;
+    return false;
+  }
+  std::size_t count = WriteRetirements(ids, retired);
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    mask |= std::uint64_t{1} << retired[i];
+  }
+  if (count != 3 || mask != 0b111 ||
+      ids.OnRetireLost(2) != QuicMigrationErrorStatus::kSuccess ||
+      ids.PendingRetirements() != 1) {
+    std::cout << "retired " << count << " IDs, mask " << mask << std::endl;
+    return false;
+  }
+
+  // more than active_connection_id_limit
+  NewConnectionID six(6, 0), seven(7, 0), eight(8, 0);
+  if (ids.OnNewConnectionID(six.frame) != QuicMigrationErrorStatus::kSuccess ||
+      ids.OnNewConnectionID(seven.frame) !=
+          QuicMigrationErrorStatus::kSuccess ||
+      ids.OnNewConnectionID(eight.frame) !=
+          QuicMigrationErrorStatus::kLimitExceeded) {
+    std::cout << "connection ID limit not enforced" << std::endl;
+    return false;
+  }
+
+  // IDs past the limit are refused, not stored, however many arrive; one
+  // whose Retire Prior To frees room is taken.
+  QuicPeerConnectionIDs full(initial, kQuicActiveConnectionIDLimit);
+  for (std::uint64_t sequence = 1; sequence < 3 * kQuicActiveConnectionIDLimit;
+       sequence++) {
+    NewConnectionID id(sequence, 0);
+    QuicMigrationErrorStatus expected =
+        sequence < kQuicActiveConnectionIDLimit
+            ? QuicMigrationErrorStatus::kSuccess
+            : QuicMigrationErrorStatus::kLimitExceeded;
+    if (full.OnNewConnectionID(id.frame) != expected ||
+        full.Unused() + 1 >
+            std::min<std::size_t>(sequence + 1, kQuicActiveConnectionIDLimit)) {
+      std::cout << "connection ID " << sequence << " past the limit"
+                << std::endl;
+      return false;
+    }
+  }
+  NewConnectionID later(3 * kQuicActiveConnectionIDLimit, 5);
+  if (full.OnNewConnectionID(later.frame) !=
+          QuicMigrationErrorStatus::kSuccess ||
+      full.CurrentSequence() != 5 ||
+      full.Unused() + 1 != kQuicActiveConnectionIDLimit - 4) {
+    std::cout << "Retire Prior To did not make room" << std::endl;
+    return false;
+  }
+
+  QuicPeerConnectionIDs empty({}, kQuicActiveConnectionIDLimit);
+  if (empty.OnNewConnectionID(one.frame) !=
+          QuicMigrationErrorStatus::kProtocolViolation ||
+      empty.Rotate() != QuicMigrationErrorStatus::kSuccess) {
+    std::cout << "zero-length connection ID mishandled" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Writes the due probe into a fresh datagram. Returns its size, with the
+// PATH_CHALLENGE data if the probe carries one.
+static std::size_t SendProbe(QuicPathManager& manager, Clock::time_point now,
+                             Address& destination, ChallengeData& challenge,
+                             bool& challenged) {
+  std::array<std::uint8_t, 1500> buffer;
+  QuicPacketBuilderV1 builder(buffer, buffer.size());
+  builder.BeginShortPacket(kDcid, 0, 2, false);
+  if (manager.WriteProbe(builder, now, destination) !=
+      QuicPacketBuilderErrorStatus::kSuccess) {
+    return 0;
+  }
+  // at most a PATH_RESPONSE and then a PATH_CHALLENGE, 9 bytes each
+  std::size_t offset = builder.Packets()[0].payload_offset;
+  challenged = false;
+  for (int frame = 0; frame < 2; frame++, offset += 9) {
+    if (buffer[offset] == 0x1a) {
+      std::copy_n(buffer.begin() + static_cast<std::ptrdiff_t>(offset) + 1,
+                  challenge.size(), challenge.begin());
+      challenged = true;
+    }
+  }
+  return builder.Datagram().size();
+}
+
+// A probe from a new address is answered and the address validated, while
+// the connection stays where it is.
+static bool CheckValidation() {
+  Address client(IPVersion::kIPV4, "192.0.2.1", 50000);
+  Address probed(IPVersion::kIPV6, "2001:db8::1", 50001);
+  QuicPathManager manager(client);
+  Clock::time_point now = kStart;
+
+  if (manager.OnPacketReceived(client, 1200, false, true, now) !=
+          QuicPathEvent::kNone ||
+      manager.ProbeDue() ||
+      manager.SendAllowance() != std::numeric_limits<std::uint64_t>::max()) {
+    std::cout << "handshake path not validated" << std::endl;
+    return false;
+  }
+
+  // The client probes from probed: its challenge is answered and ours
+  // goes out in the same datagram, within three times 100 bytes.
+  const ChallengeData from_client = {1, 1, 2, 3, 5, 8, 13, 21};
+  if (manager.OnPacketReceived(probed, 100, true, true, now) !=
+      QuicPathEvent::kProbed) {
+    std::cout << "new address not probed" << std::endl;
+    return false;
+  }
+  manager.OnPathChallenge(probed, from_client);
+  Address destination;
+  ChallengeData challenge{};
+  bool challenged = false;
+  std::size_t size =
+      SendProbe(manager, now, destination, challenge, challenged);
+  if (size != 300 || !challenged || !SamePeer(destination, probed) ||
+      !SamePeer(manager.Peer(), client) || manager.ProbeDue()) {
+    std::cout << "probe of " << size << " bytes" << std::endl;
+    return false;
+  }
+
+  // more bytes received lift the limit: the next probe fills 1200 bytes
+  const ChallengeData again = {2, 7, 1, 8, 2, 8, 1, 8};
+  manager.OnPacketReceived(probed, 1200, true, false, now);
+  manager.OnPathChallenge(probed, again);
+  size = SendProbe(manager, now, destination, challenge, challenged);
+  if (size != kQuicMinInitialDatagramSizeV1 || challenged) {
+    std::cout << "response of " << size << " bytes" << std::endl;
+    return false;
+  }
+
+  const ChallengeData wrong = {0, 0, 0, 0, 0, 0, 0, 1};
+  if (manager.OnPathResponse(wrong) != QuicPathEvent::kNone) {
+    std::cout << "wrong PATH_RESPONSE accepted" << std::endl;
+    return false;
+  }
+  if (manager.OnPathResponse(challenge) != QuicPathEvent::kValidated ||
+      !SamePeer(manager.Peer(), client) ||
+      manager.Timer() != Clock::time_point::max()) {
+    std::cout << "probed path not validated" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// The connection follows a non-probing packet to a new address; a port
+// change alone is NAT rebinding.
+static bool CheckMigration() {
+  Address client(IPVersion::kIPV4, "192.0.2.1", 50000);
+  Address rebound(IPVersion::kIPV4, "192.0.2.1", 61000);
+  Address mobile(IPVersion::kIPV4, "198.51.100.7", 40000);
+  QuicPathManager manager(client);
+  Clock::time_point now = kStart;
+
+  // a reordered packet does not move the connection
+  if (manager.OnPacketReceived(rebound, 1000, false, false, now) !=
+          QuicPathEvent::kProbed ||
+      !SamePeer(manager.Peer(), client) ||
+      manager.OnPacketReceived(rebound, 1000, false, true, now) !=
+          QuicPathEvent::kRebound ||
+      !SamePeer(manager.Peer(), rebound) || manager.Validated()) {
+    std::cout << "NAT rebinding not followed" << std::endl;
+    return false;
+  }
+  Address destination;
+  ChallengeData challenge{};
+  bool challenged = false;
+  SendProbe(manager, now, destination, challenge, challenged);
+  if (manager.OnPathResponse(challenge) != QuicPathEvent::kValidated ||
+      !manager.Validated()) {
+    std::cout << "rebound path not validated" << std::endl;
+    return false;
+  }
+
+  // Until validation, sending to the new address is held to three times
+  // what came from it.
+  if (manager.OnPacketReceived(mobile, 500, false, true, now) !=
+          QuicPathEvent::kMigrated ||
+      !SamePeer(manager.Peer(), mobile) || manager.SendAllowance() != 1500) {
+    std::cout << "migration not followed" << std::endl;
+    return false;
+  }
+  std::size_t size =
+      SendProbe(manager, now, destination, challenge, challenged);
+  manager.OnDatagramSent(100);
+  if (size != 1200 || manager.SendAllowance() != 200 ||
+      manager.OnPathResponse(challenge) != QuicPathEvent::kValidated ||
+      manager.SendAllowance() != std::numeric_limits<std::uint64_t>::max()) {
+    std::cout << "amplification limit not applied" << std::endl;
+    return false;
+  }
+
+  // Packets from the old address again, this time with the largest packet
+  // number: the peer went back to a path that was validated before.
+  if (manager.OnPacketReceived(rebound, 1000, false, true, now) !=
+          QuicPathEvent::kMigrated ||
+      !manager.Validated() || manager.ProbeDue()) {
+    std::cout << "return to a validated path revalidated" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Challenges are repeated, and a path that never answers is given up;
+// the connection returns to where it was.
+static bool CheckTimeout() {
+  Address client(IPVersion::kIPV4, "192.0.2.1", 50000);
+  Address spoofed(IPVersion::kIPV4, "203.0.113.66", 443);
+  QuicPathManager manager(client);
+  manager.SetProbeTimeout(milliseconds(100));
+  Clock::time_point now = kStart;
+
+  if (manager.OnPacketReceived(spoofed, 1200, false, true, now) !=
+      QuicPathEvent::kMigrated) {
+    std::cout << "migration not followed" << std::endl;
+    return false;
+  }
+  Address destination;
+  ChallengeData first{};
+  ChallengeData second{};
+  bool challenged = false;
+  SendProbe(manager, now, destination, first, challenged);
+  // The Initial probe timeout of 999 ms sets the pace, not the 100 ms of
+  // the old path.
+  const microseconds interval = QuicRTTEstimator().ProbeTimeout();
+  if (manager.Timer() != now + interval ||
+      manager.OnTimeout(now + interval) != QuicPathEvent::kNone ||
+      !manager.ProbeDue()) {
+    std::cout << "challenge not repeated" << std::endl;
+    return false;
+  }
+  now += interval;
+  SendProbe(manager, now, destination, second, challenged);
+  if (!challenged || first == second) {
+    std::cout << "challenge data repeated" << std::endl;
+    return false;
+  }
+  if (manager.OnTimeout(kStart + 3 * interval) != QuicPathEvent::kReverted ||
+      !SamePeer(manager.Peer(), client) || !manager.Validated() ||
+      manager.Timer() != Clock::time_point::max()) {
+    std::cout << "did not fall back to the old path" << std::endl;
+    return false;
+  }
+
+  // a probed path that fails changes nothing
+  manager.OnPacketReceived(spoofed, 1200, true, true, now);
+  if (manager.OnTimeout(now + 3 * interval) != QuicPathEvent::kFailed ||
+      !SamePeer(manager.Peer(), client)) {
+    std::cout << "failed probe moved the connection" << std::endl;
+    return false;
+  }
+
+  // A client moving to a new local address revalidates the path and is
+  // not held by the amplification limit. Without a path to return to, a
+  // failure leaves the connection unvalidated.
+  Address server(IPVersion::kIPV6, "2001:db8::443", 443);
+  QuicPathManager client_manager(server);
+  if (client_manager.Migrate(now) != QuicPathEvent::kMigrated ||
+      !client_manager.ProbeDue() || client_manager.Validated() ||
+      client_manager.SendAllowance() !=
+          std::numeric_limits<std::uint64_t>::max()) {
+    std::cout << "client migration not started" << std::endl;
+    return false;
+  }
+  SendProbe(client_manager, now, destination, first, challenged);
+  if (!SamePeer(destination, server) ||
+      client_manager.OnPathResponse(first) != QuicPathEvent::kValidated) {
+    std::cout << "client path not validated" << std::endl;
+    return false;
+  }
+  client_manager.Migrate(now);
+  if (client_manager.OnTimeout(now + 3 * interval) != QuicPathEvent::kFailed ||
+      client_manager.Validated()) {
+    std::cout << "client path failure not reported" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// What the controller learned on the old path is gone: the window and
+// pacing rate are those of a new connection.
+template <QuicCongestionController Controller>
+static bool CheckCongestionReset(const char* name) {
+  const Controller fresh;
+  Controller controller;
+  QuicRTTEstimator rtt;
+  rtt.Update(milliseconds(20), microseconds(0));
+  QuicLossDetectionOutcome outcome;
+  outcome.acked_bytes = 12000;
+  outcome.acked_packets = 10;
+  outcome.rtt_updated = true;
+  Clock::time_point now = kStart;
+  for (int round = 0; round < 20; round++) {
+    outcome.largest_acked_time_sent = now;
+    now += milliseconds(20);
+    controller.OnPacketsAcked(outcome, rtt, 0, now);
+  }
+  QuicLossDetectionOutcome loss;
+  loss.lost_bytes = 1200;
+  loss.largest_lost_time_sent = now;
+  controller.OnPacketsLost(loss, rtt, 0, now + milliseconds(1));
+  bool learned =
+      controller.CongestionWindow() != fresh.CongestionWindow() ||
+      controller.PacingRate(rtt) != fresh.PacingRate(rtt);
+
+  controller.OnPathChanged();
+  if (!learned ||
+      controller.CongestionWindow() != fresh.CongestionWindow() ||
+      controller.PacingRate(rtt) != fresh.PacingRate(rtt)) {
+    std::cout << name << " state kept across the path change" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckPathStateReset() {
+  if (!CheckCongestionReset<QuicNewReno>("NewReno") ||
+      !CheckCongestionReset<QuicCubic>("CUBIC") ||
+      !CheckCongestionReset<QuicBBR>("BBR")) {
+    return false;
+  }
+
+  // RTT samples start over; packets in flight on the old path stay
+  // tracked.
+  constexpr auto kAppData = QuicPacketNumberSpaceV1::kApplicationData;
+  QuicLossDetection detection(64);
+  detection.SetHandshakeConfirmed();
+  for (std::uint64_t pn = 0; pn < 4; pn++) {
+    detection.OnPacketSent(kAppData, pn, 1200, true, true, kStart);
+  }
+  std::array<std::uint64_t, 4> lost;
+  QuicLossDetectionOutcome outcome;
+  const std::array<QuicAckRangeV1, 1> ranges = {{{0, 1}}};
+  detection.OnAckReceived(kAppData, ranges, microseconds(0),
+                          kStart + milliseconds(20), lost, outcome);
+  if (!detection.RTT().HasSample() ||
+      detection.RTT().SmoothedRTT() != milliseconds(20)) {
+    std::cout << "no RTT sample" << std::endl;
+    return false;
+  }
+  detection.OnPathChanged();
+  QuicRTTEstimator fresh;
+  if (detection.RTT().HasSample() ||
+      detection.RTT().SmoothedRTT() != fresh.SmoothedRTT() ||
+      detection.BytesInFlight() != 2400 || detection.PTOCount() != 0) {
+    std::cout << "RTT not reset on the new path" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr int kPackets = 2000000;
+  constexpr int kMigrations = 20000;
+  constexpr std::size_t kAddresses = 64;
+  Address client(IPVersion::kIPV6, "2001:db8::1", 50000);
+  std::vector<Address> addresses;
+  for (std::size_t i = 0; i < kAddresses; i++) {
+    addresses.emplace_back(IPVersion::kIPV6,
+                           "2001:db8:1::" + std::to_string(i + 1), 50000);
+  }
+  QuicPathManager manager(client);
+
+  auto start = Clock::now();
+  std::size_t events = 0;
+  for (int i = 0; i < kPackets; i++) {
+    events += manager.OnPacketReceived(client, 1200, false, true, kStart) !=
+              QuicPathEvent::kNone;
+  }
+  double per_packet =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+      kPackets;
+
+  // every migration is to an address not seen before, which is validated
+  Address destination;
+  ChallengeData challenge{};
+  bool challenged = false;
+  start = Clock::now();
+  for (std::size_t i = 0; i < kMigrations; i++) {
+    const Address& to = addresses[i % kAddresses];
+    events += manager.OnPacketReceived(to, 1200, false, true, kStart) ==
+              QuicPathEvent::kMigrated;
+    SendProbe(manager, kStart, destination, challenge, challenged);
+    events += manager.OnPathResponse(challenge) == QuicPathEvent::kValidated;
+  }
+  double per_migration =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+      kMigrations;
+  std::cout << "packet on the current path: " << per_packet
+            << " ns, migration with validation: " << per_migration / 1000
+            << " us (" << events << " events)" << std::endl;
+}
+
+int main() {
+  if (!CheckConnectionIDs() || !CheckValidation() || !CheckMigration() ||
+      !CheckTimeout() || !CheckPathStateReset()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC migration test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_frame.h"
+#include "networking/quic/quic_packet_builder.h"
+
+using bedrock::network::QuicAckRangeV1;
+using bedrock::network::QuicBuiltPacketV1;
+using bedrock::network::QuicFrameDecoderV1;
+using bedrock::network::QuicFrameErrorStatus;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+using bedrock::network::QuicLongHeaderPacketTypeV1;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicPacketBuilderV1;
+
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+static const std::array<std::uint8_t, 4> kScid = {9, 10, 11, 12};
+
+// Frames of a packet, without the reserved AEAD tag
+static std::span<const std::uint8_t> Payload(
+    std::span<const std::uint8_t> dgram, const QuicBuiltPacketV1& packet) {
+  return dgram.subspan(packet.payload_offset,
+                       packet.end_offset - packet.payload_offset -
+                           bedrock::network::kQuicAeadTagLengthV1);
+}
+
+static bool CheckCoalesced() {
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, 1500);
+
+  std::vector<std::uint8_t> crypto(300, 0x5A);
+  std::vector<std::uint8_t> stream(100, 0x33);
+  const std::array<QuicAckRangeV1, 2> ranges = {{{10, 12}, {3, 7}}};
+
+  if (builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kInitial, kDcid,
+                              kScid, {}, 0, 1) !=
+          QuicPacketBuilderErrorStatus::kSuccess ||
+      builder.AppendCryptoFrame(0, crypto) != crypto.size() ||
+      builder.FinishPacket() != QuicPacketBuilderErrorStatus::kSuccess) {
+    std::cout << "Initial packet failed" << std::endl;
+    return false;
+  }
+  if (builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kHandshake, kDcid,
+                              kScid, {}, 0x1234, 2) !=
+          QuicPacketBuilderErrorStatus::kSuccess ||
+      builder.AppendAckFrame(ranges, 7) !=
+          QuicPacketBuilderErrorStatus::kSuccess ||
+      builder.FinishPacket() != QuicPacketBuilderErrorStatus::kSuccess) {
+    std::cout << "Handshake packet failed" << std::endl;
+    return false;
+  }
+  if (builder.BeginShortPacket(kDcid, 5, 1, false) !=
+          QuicPacketBuilderErrorStatus::kSuccess ||
+      builder.AppendStreamFrame(0, 0, stream, true) != stream.size() ||
+      builder.FinishPacket(1200) != QuicPacketBuilderErrorStatus::kSuccess) {
+    std::cout << "1-RTT packet failed" << std::endl;
+    return false;
+  }
+  // the short header closes the datagram
+  if (builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kHandshake, kDcid,
+                              kScid, {}, 1, 1) !=
+      QuicPacketBuilderErrorStatus::kInternal) {
+    std::cout << "datagram was not closed by the short header" << std::endl;
+    return false;
+  }
+
+  auto dgram = builder.Datagram();
+  auto packets = builder.Packets();
+  if (dgram.size() != 1200 || packets.size() != 3) {
+    std::cout << "unexpected datagram size " << dgram.size() << std::endl;
+    return false;
+  }
+
+  // Initial: first byte, version and back-filled Length
+  const auto& initial = packets[0];
+  std::size_t length_offset = initial.packet_number_offset - 2;
+  std::size_t length = ((dgram[length_offset] & 0x3F) << 8) |
+                       dgram[length_offset + 1];
+  if (dgram[0] != 0xC0 || dgram[4] != 1 ||
+      length != initial.end_offset - initial.packet_number_offset) {
+    std::cout << "Initial header mismatch" << std::endl;
+    return false;
+  }
+  QuicFrameV1 frame;
+  QuicFrameDecoderV1 initial_frames(Payload(dgram, initial));
+  if (initial_frames.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kCrypto ||
+      frame.data.size() != crypto.size()) {
+    std::cout << "Initial payload mismatch" << std::endl;
+    return false;
+  }
+
+  const auto& handshake = packets[1];
+  if (dgram[handshake.header_offset] != 0xE1 ||
+      dgram[handshake.packet_number_offset] != 0x12 ||
+      dgram[handshake.packet_number_offset + 1] != 0x34) {
+    std::cout << "Handshake header mismatch" << std::endl;
+    return false;
+  }
+  QuicFrameDecoderV1 handshake_frames(Payload(dgram, handshake));
+  if (handshake_frames.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kAck || frame.id != 12 ||
+      frame.length != 1 || handshake.ack_eliciting) {
+    std::cout << "Handshake payload mismatch" << std::endl;
+    return false;
+  }
+
+  const auto& short_packet = packets[2];
+  QuicFrameDecoderV1 short_frames(Payload(dgram, short_packet));
+  if (dgram[short_packet.header_offset] != 0x40 ||
+      short_frames.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.type != QuicFrameTypeV1::kStream ||
+      frame.data.size() != stream.size() ||
+      short_frames.Next(frame) != QuicFrameErrorStatus::kEnd) {
+    std::cout << "1-RTT payload mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckMtu() {
+  constexpr std::size_t kMtu = 1350;
+  std::array<std::uint8_t, 2048> send_buffer{};
+  QuicPacketBuilderV1 builder(send_buffer, kMtu);
+  std::vector<std::uint8_t> stream(4096, 0x11);
+
+  builder.BeginShortPacket(kDcid, 77, 2, true);
+  std::size_t written = builder.AppendStreamFrame(4, 65536, stream, true);
+  builder.FinishPacket();
+
+  if (written == 0 || written >= stream.size() ||
+      builder.Datagram().size() != kMtu) {
+    std::cout << "MTU not respected: " << builder.Datagram().size()
+              << std::endl;
+    return false;
+  }
+
+  QuicFrameV1 frame;
+  QuicFrameDecoderV1 decoder(Payload(builder.Datagram(), builder.Packets()[0]));
+  if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+      frame.offset != 65536 || frame.data.size() != written ||
+      (frame.flags & bedrock::network::kQuicStreamFrameFinBitV1)) {
+    std::cout << "partial STREAM frame mismatch" << std::endl;
+    return false;
+  }
+
+  // round trip through the generic record encoder
+  builder.Reset();
+  const std::array<std::uint8_t, 8> challenge = {1, 1, 2, 3, 5, 8, 13, 21};
+  std::array<QuicFrameV1, 3> frames{};
+  frames[0].type = QuicFrameTypeV1::kMaxStreamData;
+  frames[0].id = 4;
+  frames[0].offset = 1 << 24;
+  frames[1].type = QuicFrameTypeV1::kPathChallenge;
+  frames[1].data = challenge;
+  frames[2].type = QuicFrameTypeV1::kConnectionClose;
+  frames[2].extra = 0x0a;
+  frames[2].offset = 0x06;
+  builder.BeginShortPacket(kDcid, 78, 1, false);
+  if (builder.AppendFrames(frames) != frames.size()) {
+    std::cout << "AppendFrames failed" << std::endl;
+    return false;
+  }
+  builder.FinishPacket();
+  QuicFrameDecoderV1 record_decoder(
+      Payload(builder.Datagram(), builder.Packets()[0]));
+  for (const auto& want : frames) {
+    if (record_decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+        frame.type != want.type || frame.id != want.id ||
+        frame.offset != want.offset || frame.extra != want.extra ||
+        frame.data.size() != want.data.size()) {
+      std::cout << "record round trip mismatch" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  if (!CheckCoalesced() || !CheckMtu()) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Packet builder test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
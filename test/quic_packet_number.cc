@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "networking/quic/quic_packet_number.h"
+
+using bedrock::network::DecodeQuicPacketNumber;
+using bedrock::network::kQuicMaxPacketNumber;
+using bedrock::network::kQuicNoPacketNumber;
+using bedrock::network::QuicPacketNumberLength;
+using bedrock::network::TruncateQuicPacketNumber;
+
+// rfc9000 appendix A.2 and A.3
+static_assert(QuicPacketNumberLength(0xac5c02, 0xabe8b3) == 2);
+static_assert(QuicPacketNumberLength(0xace8fe, 0xabe8b3) == 3);
+static_assert(QuicPacketNumberLength(0, kQuicNoPacketNumber) == 1);
+static_assert(DecodeQuicPacketNumber(0xa82f30ea, 0x9b32, 2) == 0xa82f9b32);
+static_assert(DecodeQuicPacketNumber(kQuicNoPacketNumber, 0x00, 1) == 0);
+
+// The pseudocode of rfc9000 appendix A.3, as written there.
+static std::uint64_t ReferenceDecode(std::uint64_t largest,
+                                     std::uint64_t truncated,
+                                     std::size_t length) {
+  std::uint64_t expected = largest + 1;
+  std::uint64_t window = std::uint64_t{1} << (length * 8);
+  std::uint64_t half_window = window / 2;
+  std::uint64_t candidate = (expected & ~(window - 1)) | truncated;
+  if (candidate + half_window <= expected &&
+      candidate < (std::uint64_t{1} << 62) - window) {
+    return candidate + window;
+  }
+  if (candidate > expected + half_window && candidate >= window) {
+    return candidate - window;
+  }
+  return candidate;
+}
+
+// Largest packet numbers near the edges of the number space are the
+// interesting ones, so a third of them are drawn from there.
+static std::uint64_t RandomLargest(std::mt19937_64& random) {
+  switch (random() % 6) {
+    case 0:
+      return random() % 70000;
+    case 1:
+      return kQuicMaxPacketNumber - random() % 70000;
+    default:
+      return random() & kQuicMaxPacketNumber;
+  }
+}
+
+// Whatever arrives within the window the sender assumed decodes back to
+// the number sent, and the decoder agrees with the reference everywhere.
+static bool CheckRandom() {
+  std::mt19937_64 random(1);
+  for (int i = 0; i < 4000000; i++) {
+    std::uint64_t largest_acked = RandomLargest(random);
+    std::uint64_t packet_number =
+        largest_acked + 1 + random() % (std::uint64_t{1} << (random() % 31));
+    if (packet_number > kQuicMaxPacketNumber) {
+      continue;
+    }
+    std::uint8_t length = QuicPacketNumberLength(packet_number, largest_acked);
+    std::uint64_t truncated = TruncateQuicPacketNumber(packet_number, length);
+    // the receiver has seen anything from the largest acknowledged packet
+    // up to the one before this, or a later one that was reordered
+    std::uint64_t span = packet_number - largest_acked;
+    std::uint64_t largest_received = largest_acked + random() % (2 * span);
+    if (largest_received > kQuicMaxPacketNumber) {
+      largest_received = largest_acked;
+    }
+    if (DecodeQuicPacketNumber(largest_received, truncated, length) !=
+        packet_number) {
+      std::cout << "packet " << packet_number << " sent in " << +length
+                << " bytes after " << largest_acked << " decoded wrong"
+                << std::endl;
+      return false;
+    }
+
+    std::size_t any_length = 1 + random() % 4;
+    std::uint64_t any = TruncateQuicPacketNumber(random(), any_length);
+    // past the end of the number space the reference yields numbers that
+    // can not exist, where the decoder stays within bounds
+    std::uint64_t decoded =
+        DecodeQuicPacketNumber(largest_received, any, any_length);
+    std::uint64_t reference =
+        ReferenceDecode(largest_received, any, any_length);
+    if (decoded > kQuicMaxPacketNumber ||
+        (reference <= kQuicMaxPacketNumber && decoded != reference)) {
+      std::cout << "decoder differs from rfc9000 appendix A.3 at "
+                << largest_received << ", " << any << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr std::size_t kCount = 1 << 16;
+  constexpr std::uint64_t kRounds = 256;
+  std::mt19937_64 random(2);
+  std::vector<std::uint64_t> truncated(kCount);
+  std::vector<std::size_t> lengths(kCount);
+  std::uint64_t largest = 1 << 20;
+  for (std::size_t i = 0; i < kCount; i++) {
+    lengths[i] = 1 + random() % 4;
+    truncated[i] = TruncateQuicPacketNumber(largest + random() % 256,
+                                            lengths[i]);
+  }
+
+  std::uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint64_t round = 0; round < kRounds; round++) {
+    for (std::size_t i = 0; i < kCount; i++) {
+      checksum +=
+          DecodeQuicPacketNumber(largest + round, truncated[i], lengths[i]);
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (std::uint64_t round = 0; round < kRounds; round++) {
+    for (std::size_t i = 0; i < kCount; i++) {
+      checksum += QuicPacketNumberLength(largest + truncated[i], round);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double total = static_cast<double>(kCount) * kRounds;
+  std::cout << "decode: "
+            << std::chrono::duration<double, std::nano>(middle - start)
+                       .count() /
+                   total
+            << " ns, encode length: "
+            << std::chrono::duration<double, std::nano>(end - middle).count() /
+                   total
+            << " ns (checksum " << checksum % 1000 << ")" << std::endl;
+}
+
+int main() {
+  if (!CheckRandom()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC packet number test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,537 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "networking/quic/quic_crypto.h"
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/quic/quic_packet_protection.h"
+
+using bedrock::network::DecodeQuicPacketNumber;
+using bedrock::network::DeriveQuicInitialKeys;
+using bedrock::network::kQuicHKDFMaxContextSize;
+using bedrock::network::kQuicHKDFMaxLabelSize;
+using bedrock::network::kQuicHKDFMaxOutputSize;
+using bedrock::network::LocateQuicProtectedPacket;
+using bedrock::network::QuicAES128GCM;
+using bedrock::network::QuicBuiltPacketV1;
+using bedrock::network::QuicHKDFExpandLabel;
+using bedrock::network::QuicHKDFExtract;
+using bedrock::network::QuicInitialKeys;
+using bedrock::network::QuicLongHeaderPacketTypeV1;
+using bedrock::network::QuicPacketBuilder;
+using bedrock::network::QuicPacketProtectionErrorStatus;
+using bedrock::network::QuicPacketProtectionKeys;
+using bedrock::network::QuicSHA256;
+using bedrock::network::QuicSHA256Digest;
+using bedrock::network::QuicVersion1;
+using bedrock::network::QuicVersion2;
+
+static std::vector<std::uint8_t> FromHex(std::string_view hex) {
+  std::vector<std::uint8_t> bytes;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    auto nibble = [](char c) {
+      return c <= '9' ? c - '0' : c - 'a' + 10;
+    };
+    bytes.push_back(
+        static_cast<std::uint8_t>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+  }
+  return bytes;
+}
+
+template <typename Bytes>
+static bool Expect(const char* name, const Bytes& actual,
+                   std::string_view expected) {
+  std::vector<std::uint8_t> wanted = FromHex(expected);
+  if (!std::equal(actual.begin(), actual.end(), wanted.begin(),
+                  wanted.end())) {
+    std::cout << name << " mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static constexpr std::array<std::uint8_t, 8> kConnectionID = {
+    0x83, 0x94, 0xc8, 0xf0, 0x3e, 0x51, 0x57, 0x08};
+
+// FIPS 180-2 appendix B.1 and rfc9001 appendix A.1
+static bool CheckKeyDerivation() {
+  const std::array<std::uint8_t, 3> abc = {'a', 'b', 'c'};
+  if (!Expect("SHA-256", QuicSHA256::Hash(abc),
+              "ba7816bf8f01cfea414140de5dae2223"
+              "b00361a396177a9cb410ff61f20015ad")) {
+    return false;
+  }
+
+  QuicSHA256Digest initial_secret =
+      QuicHKDFExtract(QuicVersion1::kInitialSalt, kConnectionID);
+  QuicSHA256Digest client_secret;
+  QuicHKDFExpandLabel(initial_secret, "client in", client_secret);
+  QuicSHA256Digest server_secret;
+  QuicHKDFExpandLabel(initial_secret, "server in", server_secret);
+  std::array<std::uint8_t, 16> key;
+  std::array<std::uint8_t, 12> iv;
+  std::array<std::uint8_t, 16> hp;
+  QuicHKDFExpandLabel(client_secret, "quic key", key);
+  QuicHKDFExpandLabel(client_secret, "quic iv", iv);
+  QuicHKDFExpandLabel(client_secret, "quic hp", hp);
+  if (!Expect("initial secret", initial_secret,
+              "7db5df06e7a69e432496adedb0085192"
+              "3595221596ae2ae9fb8115c1e9ed0a44") ||
+      !Expect("client initial secret", client_secret,
+              "c00cf151ca5be075ed0ebfb5c80323c4"
+              "2d6b7db67881289af4008f1f6c357aea") ||
+      !Expect("server initial secret", server_secret,
+              "3c199828fd139efd216c155ad844cc81"
+              "fb82fa8d7446fa7d78be803acdda951b") ||
+      !Expect("client key", key, "1f369613dd76d5467730efcbe3b1a22d") ||
+      !Expect("client iv", iv, "fa044b2f42a3fd3b46fb255c") ||
+      !Expect("client hp", hp, "9f50449e04a0e810283a1e9933adedd2")) {
+    return false;
+  }
+
+  // rfc9001 appendix A.2 and A.3 header protection samples
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<QuicVersion1>(kConnectionID, keys);
+  std::vector<std::uint8_t> client_sample =
+      FromHex("d1b1c98dd7689fb8ec11d242b123dc9b");
+  std::vector<std::uint8_t> server_sample =
+      FromHex("2cd0991cd25b0aac406a5816b6394100");
+  return Expect("client mask",
+                keys.client.HeaderProtectionMask(client_sample.data()),
+                "437b9aec36") &&
+         Expect("server mask",
+                keys.server.HeaderProtectionMask(server_sample.data()),
+                "2ec0d8356a");
+}
+
+// The longest label HkdfLabel can hold (checked against OpenSSL
+// HKDF-Expand), and anything longer refused.
+static bool CheckExpandLabelLimits() {
+  std::vector<std::uint8_t> secret(32, 0x01);
+  std::string label(kQuicHKDFMaxLabelSize, 'a');
+  QuicSHA256Digest output;
+  if (!QuicHKDFExpandLabel(secret, label, output) ||
+      !Expect("longest label", output,
+              "58a80e21a7066fa5918d7ad6a288d02f"
+              "51a0b517afa4121c0400b500d550bfba")) {
+    return false;
+  }
+  std::vector<std::uint8_t> context(kQuicHKDFMaxContextSize, 0x02);
+  if (!QuicHKDFExpandLabel(secret, label, output, context) ||
+      !Expect("longest label and context", output,
+              "0eae5ca85e00986ad856189cf6e97097"
+              "683915844c8c6abda6a56c7a861d20dd")) {
+    return false;
+  }
+
+  std::vector<std::uint8_t> long_context(kQuicHKDFMaxContextSize + 1);
+  std::vector<std::uint8_t> longest(kQuicHKDFMaxOutputSize);
+  std::vector<std::uint8_t> too_long(kQuicHKDFMaxOutputSize + 1);
+  auto zero = [](std::uint8_t byte) { return byte == 0; };
+  if (!QuicHKDFExpandLabel(secret, "key", longest) ||
+      QuicHKDFExpandLabel(secret, label + "a", output) ||
+      QuicHKDFExpandLabel(secret, "key", too_long) ||
+      QuicHKDFExpandLabel(secret, "c e traffic", output, long_context) ||
+      !std::all_of(output.begin(), output.end(), zero) ||
+      !std::all_of(too_long.begin(), too_long.end(), zero)) {
+    std::cout << "HKDF-Expand-Label limits not enforced" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// GCM specification test cases 1 to 4
+static bool CheckAEAD() {
+  struct TestCase {
+    std::string_view key;
+    std::string_view iv;
+    std::string_view plaintext;
+    std::string_view aad;
+    std::string_view ciphertext;
+    std::string_view tag;
+  };
+  constexpr std::string_view kKey = "feffe9928665731c6d6a8f9467308308";
+  constexpr std::string_view kIV = "cafebabefacedbaddecaf888";
+  constexpr std::string_view kPlaintext =
+      "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+      "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255";
+  constexpr std::string_view kCiphertext =
+      "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+      "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985";
+  const std::array<TestCase, 4> cases = {{
+      {"00000000000000000000000000000000", "000000000000000000000000", "",
+       "", "", "58e2fccefa7e3061367f1d57a4e7455a"},
+      {"00000000000000000000000000000000", "000000000000000000000000",
+       "00000000000000000000000000000000", "",
+       "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"},
+      {kKey, kIV, kPlaintext, "", kCiphertext,
+       "4d5c2af327cd64a62cf35abd2ba6fab4"},
+      {kKey, kIV, kPlaintext.substr(0, 120),
+       "feedfacedeadbeeffeedfacedeadbeefabaddad2", kCiphertext.substr(0, 120),
+       "5bc94fbc3221a5db94fae95ae7121a47"},
+  }};
+
+  for (const TestCase& test : cases) {
+    std::vector<std::uint8_t> key = FromHex(test.key);
+    std::vector<std::uint8_t> iv = FromHex(test.iv);
+    std::vector<std::uint8_t> text = FromHex(test.plaintext);
+    std::vector<std::uint8_t> aad = FromHex(test.aad);
+    QuicAES128GCM aead(std::span<const std::uint8_t, 16>(key.data(), 16));
+    std::span<const std::uint8_t, 12> nonce(iv.data(), 12);
+    std::array<std::uint8_t, 16> tag;
+    aead.Seal(nonce, aad, text, tag.data());
+    if (!Expect("GCM ciphertext", text, test.ciphertext) ||
+        !Expect("GCM tag", tag, test.tag)) {
+      return false;
+    }
+    if (!aead.Open(nonce, aad, text, tag.data()) ||
+        !Expect("GCM plaintext", text, test.plaintext)) {
+      std::cout << "GCM open failed" << std::endl;
+      return false;
+    }
+    tag[0] ^= 1;
+    if (aead.Open(nonce, aad, text, tag.data())) {
+      std::cout << "GCM accepted a forged tag" << std::endl;
+      return false;
+    }
+  }
+
+  // rfc9000 appendix A.3
+  if (DecodeQuicPacketNumber(0xa82f30ea, 0x9b32, 2) != 0xa82f9b32 ||
+      DecodeQuicPacketNumber(0xff, 0x02, 1) != 0x102 ||
+      DecodeQuicPacketNumber(0x102, 0xff, 1) != 0xff) {
+    std::cout << "packet number decoding mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A coalesced Initial + 1-RTT datagram protected by the sender must come back
+// unchanged through locating and unprotecting each packet, and any flipped
+// bit must fail authentication.
+template <typename Version>
+static bool CheckRoundTrip() {
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<Version>(kConnectionID, keys);
+  const QuicPacketProtectionKeys& one_rtt = keys.server;
+
+  std::vector<std::uint8_t> buffer(1452);
+  QuicPacketBuilder<Version> builder(buffer, buffer.size());
+  std::array<std::uint8_t, 300> crypto;
+  for (std::size_t i = 0; i < crypto.size(); i++) {
+    crypto[i] = static_cast<std::uint8_t>(i);
+  }
+  const std::array<std::uint8_t, 3> token = {1, 2, 3};
+  builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kInitial, kConnectionID,
+                          kConnectionID, token, 2, 4);
+  builder.AppendCryptoFrame(0, crypto);
+  builder.FinishPacket(600);
+  builder.BeginShortPacket(kConnectionID, 0x1234, 2, true);
+  builder.AppendStreamFrame(0, 0, std::span(crypto).first(177), true);
+  builder.FinishPacket();
+
+  std::span<std::uint8_t> datagram = builder.Datagram();
+  std::vector<std::uint8_t> plaintext(datagram.begin(), datagram.end());
+  auto packets = builder.Packets();
+  if (packets.size() != 2 ||
+      keys.client.Protect(datagram, packets[0]) !=
+          QuicPacketProtectionErrorStatus::kSuccess ||
+      one_rtt.Protect(datagram, packets[1]) !=
+          QuicPacketProtectionErrorStatus::kSuccess) {
+    std::cout << "protect failed" << std::endl;
+    return false;
+  }
+  std::vector<std::uint8_t> protected_datagram(datagram.begin(),
+                                               datagram.end());
+
+  for (std::size_t flipped = 0; flipped <= protected_datagram.size();
+       flipped += 7) {
+    std::vector<std::uint8_t> received = protected_datagram;
+    bool tampered = flipped < received.size();
+    if (tampered) {
+      received[flipped] ^= 0x10;
+    }
+    std::size_t offset = 0;
+    bool authentic = true;
+    for (std::size_t i = 0; i < packets.size() && authentic; i++) {
+      QuicBuiltPacketV1 packet;
+      if (LocateQuicProtectedPacket<Version>(received, offset,
+                                             kConnectionID.size(), packet) !=
+          QuicPacketProtectionErrorStatus::kSuccess) {
+        authentic = false;
+        break;
+      }
+      const QuicPacketProtectionKeys& keys_of_packet =
+          packet.long_header ? keys.client : one_rtt;
+      std::uint64_t largest = packet.long_header ? 0 : 0x1200;
+      authentic = keys_of_packet.Unprotect(received, packet, largest) ==
+                  QuicPacketProtectionErrorStatus::kSuccess;
+      if (authentic && (packet.packet_number != packets[i].packet_number ||
+                        packet.payload_offset != packets[i].payload_offset ||
+                        packet.end_offset != packets[i].end_offset)) {
+        std::cout << "located packet differs from the built one" << std::endl;
+        return false;
+      }
+      offset = packet.end_offset;
+    }
+    if (authentic == tampered) {
+      std::cout << "tampering at byte " << flipped << " was "
+                << (tampered ? "accepted" : "rejected") << std::endl;
+      return false;
+    }
+    if (!tampered) {
+      // tag bytes are not restored by decryption
+      for (const QuicBuiltPacketV1& packet : packets) {
+        if (!std::equal(received.begin() +
+                            static_cast<long>(packet.header_offset),
+                        received.begin() +
+                            static_cast<long>(packet.end_offset - 16),
+                        plaintext.begin() +
+                            static_cast<long>(packet.header_offset))) {
+          std::cout << "round trip mismatch" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Protected short header packets of mixed sizes, one per datagram
+static std::vector<std::vector<std::uint8_t>> MakeBurst(
+    const QuicPacketProtectionKeys& keys, std::size_t count,
+    std::size_t min_size, std::size_t max_size) {
+  std::vector<std::vector<std::uint8_t>> burst;
+  std::vector<std::uint8_t> data(max_size);
+  for (std::size_t i = 0; i < count; i++) {
+    std::size_t size = min_size + (i * 397) % (max_size - min_size + 1);
+    std::vector<std::uint8_t> datagram(size);
+    QuicPacketBuilder<QuicVersion1> builder(datagram, datagram.size());
+    builder.BeginShortPacket(kConnectionID, 100 + i, 1 + i % 4, i & 1);
+    builder.AppendStreamFrame(4, 0, data, false);
+    builder.FinishPacket(size);
+    keys.Protect(datagram, builder.Packets()[0]);
+    datagram.resize(builder.Datagram().size());
+    burst.push_back(std::move(datagram));
+  }
+  return burst;
+}
+
+static void LocateBurst(std::vector<std::vector<std::uint8_t>>& burst,
+                        std::vector<std::span<std::uint8_t>>& datagrams,
+                        std::vector<QuicBuiltPacketV1>& packets) {
+  datagrams.clear();
+  packets.resize(burst.size());
+  for (std::size_t i = 0; i < burst.size(); i++) {
+    datagrams.push_back(burst[i]);
+    LocateQuicProtectedPacket<QuicVersion1>(burst[i], 0,
+                                            kConnectionID.size(), packets[i]);
+  }
+}
+
+// The batched path must agree with unprotecting packet by packet, including
+// packets that fail, and batched masks must equal single ones.
+static bool CheckBatch() {
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<QuicVersion1>(kConnectionID, keys);
+
+  std::array<std::uint8_t, 16 * 11> samples;
+  for (std::size_t i = 0; i < samples.size(); i++) {
+    samples[i] = static_cast<std::uint8_t>(i * 31 + 7);
+  }
+  for (std::size_t count = 0; count <= 8; count++) {
+    std::array<const std::uint8_t*, 8> pointers;
+    std::array<std::array<std::uint8_t, 5>, 8> masks;
+    for (std::size_t i = 0; i < count; i++) {
+      pointers[i] = samples.data() + i * 19;
+    }
+    keys.client.HeaderProtectionMasks(pointers.data(), masks.data(), count);
+    for (std::size_t i = 0; i < count; i++) {
+      if (masks[i] != keys.client.HeaderProtectionMask(pointers[i])) {
+        std::cout << "batched header protection mask mismatch" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  auto burst = MakeBurst(keys.client, 19, 40, 1200);
+  burst[3][burst[3].size() - 20] ^= 1;  // fails authentication
+  burst[5].resize(24);                  // no room for a sample
+  auto single = burst;
+
+  std::vector<std::span<std::uint8_t>> datagrams;
+  std::vector<QuicBuiltPacketV1> packets;
+  LocateBurst(burst, datagrams, packets);
+  std::vector<QuicPacketProtectionErrorStatus> results(burst.size());
+  keys.client.UnprotectBatch(datagrams, packets, 99, results);
+
+  std::vector<QuicBuiltPacketV1> single_packets;
+  LocateBurst(single, datagrams, single_packets);
+  for (std::size_t i = 0; i < single.size(); i++) {
+    QuicPacketProtectionErrorStatus expected =
+        keys.client.Unprotect(single[i], single_packets[i], 99);
+    if (results[i] != expected || burst[i] != single[i] ||
+        (expected == QuicPacketProtectionErrorStatus::kSuccess &&
+         packets[i].packet_number != 100 + i)) {
+      std::cout << "batched unprotect differs at packet " << i << std::endl;
+      return false;
+    }
+  }
+  if (results[3] != QuicPacketProtectionErrorStatus::kAuthentication ||
+      results[5] != QuicPacketProtectionErrorStatus::kTooShort) {
+    std::cout << "batched unprotect accepted a bad packet" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Header protection alone and whole bursts of small packets, where the mask
+// is a large share of the work, one at a time against batched.
+static void BenchmarkBatch() {
+  constexpr std::size_t kMasks = 1 << 20;
+  constexpr std::size_t kBursts = 1 << 12;
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<QuicVersion1>(kConnectionID, keys);
+
+  std::vector<std::uint8_t> samples(1 << 12);
+  for (std::size_t i = 0; i < samples.size(); i++) {
+    samples[i] = static_cast<std::uint8_t>(i * 131 + 17);
+  }
+  std::size_t checksum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kMasks; i++) {
+    checksum += keys.client.HeaderProtectionMask(
+        samples.data() + (i * 16) % (samples.size() - 16))[0];
+  }
+  double single = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+  begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kMasks; i += 8) {
+    std::array<const std::uint8_t*, 8> pointers;
+    std::array<std::array<std::uint8_t, 5>, 8> masks;
+    for (std::size_t j = 0; j < 8; j++) {
+      pointers[j] = samples.data() + ((i + j) * 16) % (samples.size() - 16);
+    }
+    keys.client.HeaderProtectionMasks(pointers.data(), masks.data(), 8);
+    for (const auto& mask : masks) {
+      checksum -= mask[0];
+    }
+  }
+  double batched = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  double count = static_cast<double>(kMasks);
+  std::cout << "Header protection masks: " << single / count * 1e9
+            << " ns/mask one at a time, " << batched / count * 1e9
+            << " ns/mask in batches of 8 (checksum " << checksum << ")"
+            << std::endl;
+
+  auto sealed = MakeBurst(keys.client, 32, 60, 120);
+  auto burst = sealed;
+  std::vector<std::span<std::uint8_t>> datagrams;
+  std::vector<QuicBuiltPacketV1> packets;
+  std::vector<QuicPacketProtectionErrorStatus> results(burst.size());
+  std::size_t opened = 0;
+  single = 0;
+  batched = 0;
+  for (std::size_t round = 0; round < kBursts; round++) {
+    burst = sealed;
+    LocateBurst(burst, datagrams, packets);
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < burst.size(); i++) {
+      opened += keys.client.Unprotect(datagrams[i], packets[i], 99) ==
+                QuicPacketProtectionErrorStatus::kSuccess;
+    }
+    single += std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - begin)
+                  .count();
+
+    burst = sealed;
+    LocateBurst(burst, datagrams, packets);
+    begin = std::chrono::steady_clock::now();
+    keys.client.UnprotectBatch(datagrams, packets, 99, results);
+    batched += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - begin)
+                   .count();
+    for (auto result : results) {
+      opened += result == QuicPacketProtectionErrorStatus::kSuccess;
+    }
+  }
+  count = static_cast<double>(kBursts * sealed.size());
+  std::cout << "Unprotect 60-120 byte packets: " << single / count * 1e9
+            << " ns/packet one at a time, " << batched / count * 1e9
+            << " ns/packet batched, " << opened << " authenticated"
+            << std::endl;
+}
+
+// One short header packet filling a datagram, sealed or opened in place
+static void Benchmark(std::size_t datagram_size) {
+  constexpr std::size_t kPackets = 1 << 16;
+  QuicInitialKeys keys;
+  DeriveQuicInitialKeys<QuicVersion1>(kConnectionID, keys);
+
+  std::vector<std::uint8_t> buffer(datagram_size);
+  QuicPacketBuilder<QuicVersion1> builder(buffer, buffer.size());
+  std::vector<std::uint8_t> data(datagram_size);
+  builder.BeginShortPacket(kConnectionID, 1, 4, false);
+  builder.AppendStreamFrame(4, 0, data, false);
+  builder.FinishPacket(datagram_size);
+  QuicBuiltPacketV1 built = builder.Packets()[0];
+  std::span<std::uint8_t> datagram = builder.Datagram();
+
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kPackets; i++) {
+    keys.client.Protect(datagram, built);
+  }
+  double seal = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+
+  builder.Reset();
+  builder.BeginShortPacket(kConnectionID, 1, 4, false);
+  builder.AppendStreamFrame(4, 0, data, false);
+  builder.FinishPacket(datagram_size);
+  keys.client.Protect(datagram, built);
+  std::vector<std::uint8_t> sealed(datagram.begin(), datagram.end());
+  std::size_t opened = 0;
+  begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kPackets; i++) {
+    std::copy(sealed.begin(), sealed.end(), datagram.begin());
+    QuicBuiltPacketV1 packet;
+    LocateQuicProtectedPacket<QuicVersion1>(datagram, 0,
+                                            kConnectionID.size(), packet);
+    opened += keys.client.Unprotect(datagram, packet, 0) ==
+              QuicPacketProtectionErrorStatus::kSuccess;
+  }
+  double open = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+
+  double count = static_cast<double>(kPackets);
+  double bits = count * static_cast<double>(datagram.size() * 8);
+  std::cout << datagram.size() << " byte packets: protect "
+            << bits / seal / 1e9 << " Gbps (" << seal / count * 1e9
+            << " ns/packet), unprotect " << bits / open / 1e9 << " Gbps ("
+            << open / count * 1e9 << " ns/packet), " << opened
+            << " authenticated" << std::endl;
+}
+
+int main() {
+  if (!CheckKeyDerivation() || !CheckExpandLabelLimits() || !CheckAEAD() ||
+      !CheckRoundTrip<QuicVersion1>() || !CheckRoundTrip<QuicVersion2>() ||
+      !CheckBatch()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark(1200);
+  Benchmark(1452);
+  BenchmarkBatch();
+
+  std::cout << "QUIC packet protection test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/quic/quic_path_mtu.h"
+#include "networking/socket.h"
+
+using bedrock::network::Address;
+using bedrock::network::IPVersion;
+using bedrock::network::kQuicBasePLPMTU;
+using bedrock::network::kQuicLocalMaxUDPPayloadSize;
+using bedrock::network::kQuicMaxUDPPayloadSize;
+using bedrock::network::kQuicPMTURaiseInterval;
+using bedrock::network::kQuicPMTUSearchGranularity;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicPacketBuilderV1;
+using bedrock::network::QuicPathMTUDiscovery;
+using bedrock::network::QuicPMTUState;
+using bedrock::network::ReadQuicMaxUDPPayloadSize;
+using bedrock::network::Socket;
+using bedrock::network::SocketErrorStatus;
+using bedrock::network::SocketType;
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+static const Clock::time_point kStart = Clock::time_point(milliseconds(1000));
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+
+// Runs probes over a path that carries datagrams up to path_mtu bytes and
+// loses loss_rate of everything. Returns the number of probes sent.
+static int Search(QuicPathMTUDiscovery& discovery, std::size_t path_mtu,
+                  double loss_rate, Clock::time_point now,
+                  std::mt19937& random) {
+  std::bernoulli_distribution lost(loss_rate);
+  int probes = 0;
+  std::uint64_t packet_number = 0;
+  while (discovery.ShouldProbe(now) && probes < 1000) {
+    discovery.OnProbeSent(++packet_number);
+    probes++;
+    if (discovery.ProbeSize() <= path_mtu && !lost(random)) {
+      discovery.OnProbeAcked(packet_number);
+    } else {
+      discovery.OnProbeLost(packet_number);
+    }
+  }
+  return probes;
+}
+
+// The search stops at the largest datagram we can receive ourselves.
+static bool Converged(const QuicPathMTUDiscovery& discovery,
+                      std::size_t path_mtu) {
+  path_mtu = std::min(path_mtu, kQuicLocalMaxUDPPayloadSize);
+  return discovery.State() == QuicPMTUState::kSearchComplete &&
+         discovery.PLPMTU() <= path_mtu &&
+         discovery.PLPMTU() + kQuicPMTUSearchGranularity > path_mtu;
+}
+
+static bool CheckSearch() {
+  std::mt19937 random(1);
+  for (std::size_t path_mtu : {std::size_t{1200}, std::size_t{1280},
+                               std::size_t{1452}, std::size_t{8972},
+                               kQuicMaxUDPPayloadSize}) {
+    for (double loss_rate : {0.0, 0.05}) {
+      QuicPathMTUDiscovery discovery;
+      if (discovery.ShouldProbe(kStart)) {
+        std::cout << "probing before the handshake" << std::endl;
+        return false;
+      }
+      discovery.Enable();
+      int probes = Search(discovery, path_mtu, loss_rate, kStart, random);
+      std::cout << "path " << path_mtu << ", " << loss_rate * 100
+                << "% loss: PLPMTU " << discovery.PLPMTU() << " after "
+                << probes << " probes" << std::endl;
+      if (!Converged(discovery, path_mtu)) {
+        std::cout << "search did not converge" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  // the local limit and the peer's transport parameter bound the search,
+  // and the stack refusing a size ends its probing at once
+  QuicPathMTUDiscovery discovery(1450);
+  discovery.SetPeerMaxUDPPayloadSize(1400);
+  discovery.Enable();
+  discovery.OnProbeSent(1);
+  if (discovery.ProbeSize() > 1400) {
+    std::cout << "probe above the peer's limit" << std::endl;
+    return false;
+  }
+  std::size_t refused = discovery.ProbeSize();
+  discovery.OnPacketTooBig(refused);
+  if (!discovery.ShouldProbe(kStart) || discovery.ProbeSize() >= refused) {
+    std::cout << "too big signal not used" << std::endl;
+    return false;
+  }
+  std::mt19937 lossless(2);
+  Search(discovery, 1250, 0, kStart, lossless);
+  if (!Converged(discovery, 1250)) {
+    std::cout << "search below a refused size did not converge" << std::endl;
+    return false;
+  }
+
+  // a larger local limit than we can receive is not searched
+  QuicPathMTUDiscovery jumbo(9000);
+  jumbo.Enable();
+  Search(jumbo, 9000, 0, kStart, lossless);
+  if (!Converged(jumbo, 9000) ||
+      jumbo.PLPMTU() > kQuicLocalMaxUDPPayloadSize) {
+    std::cout << "search above our own max_udp_payload_size" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// We advertise the receive buffer size and use the peer's limit.
+static bool CheckTransportParameter() {
+  QuicPathMTUDiscovery discovery;
+  std::array<std::uint8_t, 16> parameters{};
+  std::size_t size = discovery.WriteTransportParameter(parameters);
+  std::uint64_t value = 0;
+  if (size == 0 ||
+      !ReadQuicMaxUDPPayloadSize(std::span(parameters).first(size), value) ||
+      value != kQuicLocalMaxUDPPayloadSize ||
+      !ReadQuicMaxUDPPayloadSize({}, value) ||
+      value != kQuicMaxUDPPayloadSize) {
+    std::cout << "max_udp_payload_size encoded wrong" << std::endl;
+    return false;
+  }
+
+  // max_udp_payload_size = 1300, then a value below 1200
+  const std::vector<std::uint8_t> peer = {0x03, 0x02, 0x45, 0x14};
+  const std::vector<std::uint8_t> invalid = {0x03, 0x02, 0x44, 0xaf};
+  discovery.Enable();
+  if (!discovery.OnPeerTransportParameters(peer) ||
+      discovery.ProbeSize() > 1300 ||
+      discovery.OnPeerTransportParameters(invalid)) {
+    std::cout << "peer max_udp_payload_size not applied" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// The path shrinks under a completed search: large packets go missing
+// until the PLPMTU falls back, then the raise timer finds the path grown
+// again.
+static bool CheckBlackHoleAndRaise() {
+  std::mt19937 random(3);
+  QuicPathMTUDiscovery discovery;
+  discovery.Enable();
+  Search(discovery, 8972, 0, kStart, random);
+
+  for (int i = 0; i < 10 && discovery.PLPMTU() > kQuicBasePLPMTU; i++) {
+    discovery.OnPacketAcked(kQuicBasePLPMTU);
+    discovery.OnPacketLost(discovery.PLPMTU());
+  }
+  if (discovery.PLPMTU() != kQuicBasePLPMTU ||
+      discovery.State() != QuicPMTUState::kSearching) {
+    std::cout << "black hole not detected" << std::endl;
+    return false;
+  }
+  Search(discovery, 1400, 0, kStart, random);
+  if (!Converged(discovery, 1400)) {
+    std::cout << "search after a black hole did not converge" << std::endl;
+    return false;
+  }
+
+  // the timer starts with the first check after the search
+  discovery.ShouldProbe(kStart);
+  if (discovery.ShouldProbe(kStart + kQuicPMTURaiseInterval / 2)) {
+    std::cout << "raise timer fired early" << std::endl;
+    return false;
+  }
+  Search(discovery, 8972, 0, kStart + kQuicPMTURaiseInterval, random);
+  if (!Converged(discovery, 8972)) {
+    std::cout << "larger path not found after the raise timer" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Real probes over IPv6 loopback with the Don't Fragment bit set. The
+// loopback MTU of 65536 bytes leaves 65488 for the UDP payload; anything
+// larger fails to send with EMSGSIZE. The search stops at our own
+// max_udp_payload_size before that unless the build raised it.
+static bool CheckLoopback(std::size_t& plpmtu) {
+  Address address(IPVersion::kIPV6, "::1", 0);
+  Socket server(SocketType::kUDP, address);
+  if (server.Init() != SocketErrorStatus::kSuccess ||
+      server.Bind() != SocketErrorStatus::kSuccess) {
+    std::cout << "bind failed: " << server.GetErrorMessage() << std::endl;
+    return false;
+  }
+  std::uint16_t port = server.GetAddr().data.GetPort().data;
+  Socket client(SocketType::kUDP, Address(IPVersion::kIPV6, "::1", port));
+  if (client.Init() != SocketErrorStatus::kSuccess ||
+      client.SetDontFragment(true) != SocketErrorStatus::kSuccess) {
+    std::cout << "client failed: " << client.GetErrorMessage() << std::endl;
+    return false;
+  }
+
+  std::vector<std::uint8_t> send_buffer(kQuicLocalMaxUDPPayloadSize);
+  std::vector<std::byte> receive_buffer(kQuicLocalMaxUDPPayloadSize);
+  QuicPathMTUDiscovery discovery;
+  discovery.Enable();
+  std::uint64_t packet_number = 0;
+  int probes = 0;
+  while (discovery.ShouldProbe(kStart) && probes < 100) {
+    QuicPacketBuilderV1 builder(send_buffer, kQuicBasePLPMTU);
+    builder.BeginShortPacket(kDcid, ++packet_number, 2, false);
+    if (discovery.WriteProbe(builder) !=
+        QuicPacketBuilderErrorStatus::kSuccess) {
+      std::cout << "probe of " << discovery.ProbeSize() << " not built"
+                << std::endl;
+      return false;
+    }
+    discovery.OnProbeSent(packet_number);
+    probes++;
+    if (client.Write(std::as_bytes(builder.Datagram())) !=
+        SocketErrorStatus::kSuccess) {
+      if (client.GetLastErrno() != EMSGSIZE) {
+        std::cout << "send failed: " << client.GetErrorMessage() << std::endl;
+        return false;
+      }
+      discovery.OnPacketTooBig(builder.Datagram().size());
+      continue;
+    }
+    Address peer;
+    auto received = server.ReadFrom(receive_buffer, peer);
+    if (received.status != SocketErrorStatus::kSuccess ||
+        received.data != builder.Datagram().size()) {
+      std::cout << "probe not received whole" << std::endl;
+      return false;
+    }
+    discovery.OnProbeAcked(packet_number);
+  }
+  plpmtu = discovery.PLPMTU();
+  std::cout << "loopback PLPMTU " << plpmtu << " after " << probes
+            << " probes" << std::endl;
+  if (!Converged(discovery, 65488)) {
+    std::cout << "loopback search failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Moves the same bytes over loopback in datagrams of the base size and of
+// the discovered size.
+static void Benchmark(std::size_t plpmtu) {
+  constexpr std::size_t kBytes = 64 << 20;
+  Address address(IPVersion::kIPV6, "::1", 0);
+  Socket server(SocketType::kUDP, address);
+  server.Init();
+  server.Bind();
+  Socket client(SocketType::kUDP,
+                Address(IPVersion::kIPV6, "::1",
+                        server.GetAddr().data.GetPort().data));
+  client.Init();
+  client.SetDontFragment(true);
+
+  std::vector<std::byte> datagram(plpmtu);
+  std::vector<std::byte> receive_buffer(plpmtu);
+  for (std::size_t size : {kQuicBasePLPMTU, plpmtu}) {
+    auto start = Clock::now();
+    std::size_t datagrams = 0;
+    for (std::size_t sent = 0; sent < kBytes; sent += size) {
+      client.Write(std::span(datagram).first(size));
+      Address peer;
+      server.ReadFrom(receive_buffer, peer);
+      datagrams++;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+    std::cout << size << " byte datagrams: " << datagrams << " datagrams, "
+              << static_cast<double>(kBytes) * 8 / seconds / 1e9 << " Gbps"
+              << std::endl;
+  }
+}
+
+int main() {
+  std::size_t plpmtu = 0;
+  if (!CheckSearch() || !CheckTransportParameter() ||
+      !CheckBlackHoleAndRaise() || !CheckLoopback(plpmtu)) {
+    return EXIT_FAILURE;
+  }
+  Benchmark(plpmtu);
+
+  std::cout << "QUIC path MTU discovery test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
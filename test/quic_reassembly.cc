@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "networking/quic/quic_reassembly.h"
+
+using bedrock::network::QuicPacketBufferPool;
+using bedrock::network::QuicPacketBufferRef;
+using bedrock::network::QuicReassemblyBuffer;
+using bedrock::network::QuicReassemblyErrorStatus;
+
+// Packs a copy of source[offset, offset + length) into a fresh packet
+// buffer behind a pretend header, as a decoded STREAM frame would be.
+static QuicReassemblyErrorStatus Deliver(
+    QuicReassemblyBuffer& stream, QuicPacketBufferPool& pool,
+    const std::vector<std::uint8_t>& source, std::uint64_t offset,
+    std::size_t length, bool fin) {
+  constexpr std::size_t kHeader = 30;
+  QuicPacketBufferRef packet = pool.Allocate();
+  if (!packet) {
+    return QuicReassemblyErrorStatus::kBusy;
+  }
+  std::memcpy(packet->data.data() + kHeader, source.data() + offset, length);
+  packet->size = kHeader + length;
+  return stream.Insert(offset, packet->Datagram().subspan(kHeader), fin,
+                       packet);
+}
+
+static void ReadAll(QuicReassemblyBuffer& stream,
+                    std::vector<std::uint8_t>& out) {
+  for (auto span = stream.Front(); !span.empty(); span = stream.Front()) {
+    out.insert(out.end(), span.begin(), span.end());
+    stream.Consume(span.size());
+  }
+}
+
+static bool CheckInOrder() {
+  QuicPacketBufferPool pool(4);
+  std::vector<std::uint8_t> source(3000);
+  for (std::size_t i = 0; i < source.size(); i++) {
+    source[i] = static_cast<std::uint8_t>(i * 7);
+  }
+  QuicReassemblyBuffer stream(source.size());
+  if (Deliver(stream, pool, source, 0, 1000, false) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      stream.ReadableBytes() != 1000 || stream.Front().size() != 1000 ||
+      pool.Available() != 3) {
+    std::cout << "first fragment not readable" << std::endl;
+    return false;
+  }
+  // the application reads straight out of the packet buffer
+  stream.Consume(400);
+  if (stream.Front().size() != 600 || stream.Front()[0] != source[400] ||
+      pool.Available() != 3) {
+    std::cout << "partial read failed" << std::endl;
+    return false;
+  }
+  stream.Consume(600);
+  if (pool.Available() != 4) {
+    std::cout << "read packet buffer not released" << std::endl;
+    return false;
+  }
+
+  Deliver(stream, pool, source, 1000, 1000, false);
+  Deliver(stream, pool, source, 2000, 1000, true);
+  std::array<std::span<const std::uint8_t>, 4> spans;
+  if (!stream.AllDataReceived() || stream.Finished() ||
+      stream.Peek(spans) != 2 || spans[1].data()[999] != source[2999]) {
+    std::cout << "final size handling failed" << std::endl;
+    return false;
+  }
+  stream.Consume(stream.ReadableBytes());
+  if (!stream.Finished() || stream.FragmentCount() != 0 ||
+      pool.Available() != 4) {
+    std::cout << "stream not finished" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckErrors() {
+  QuicPacketBufferPool pool(16);
+  std::vector<std::uint8_t> source(4000);
+  QuicReassemblyBuffer stream(2000, 3);
+  if (Deliver(stream, pool, source, 1500, 501, false) !=
+          QuicReassemblyErrorStatus::kFlowControl ||
+      Deliver(stream, pool, source, 1000, 100, false) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      Deliver(stream, pool, source, 500, 100, true) !=
+          QuicReassemblyErrorStatus::kFinalSize) {
+    std::cout << "flow control or final size not enforced" << std::endl;
+    return false;
+  }
+  if (Deliver(stream, pool, source, 1200, 100, false) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      Deliver(stream, pool, source, 1400, 100, false) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      Deliver(stream, pool, source, 1600, 100, false) !=
+          QuicReassemblyErrorStatus::kBusy ||
+      // fully held already, so nothing to store
+      Deliver(stream, pool, source, 1200, 50, false) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      stream.FragmentCount() != 3) {
+    std::cout << "fragment limit not enforced" << std::endl;
+    return false;
+  }
+  stream.SetMaxData(4000);
+  if (Deliver(stream, pool, source, 1900, 100, true) !=
+          QuicReassemblyErrorStatus::kBusy ||
+      Deliver(stream, pool, source, 0, 1000, false) !=
+          QuicReassemblyErrorStatus::kBusy) {
+    std::cout << "fragment limit not enforced" << std::endl;
+    return false;
+  }
+
+  QuicReassemblyBuffer finished(4000);
+  if (Deliver(finished, pool, source, 0, 100, true) !=
+          QuicReassemblyErrorStatus::kSuccess ||
+      Deliver(finished, pool, source, 50, 100, false) !=
+          QuicReassemblyErrorStatus::kFinalSize ||
+      Deliver(finished, pool, source, 0, 90, true) !=
+          QuicReassemblyErrorStatus::kFinalSize ||
+      Deliver(finished, pool, source, 0, 100, true) !=
+          QuicReassemblyErrorStatus::kSuccess) {
+    std::cout << "final size changes accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Random overlapping and duplicated fragments must read back as the source
+// with every byte stored once.
+static bool CheckOverlaps() {
+  std::mt19937_64 random(42);
+  for (int round = 0; round < 200; round++) {
+    QuicPacketBufferPool pool(256);
+    std::vector<std::uint8_t> source(20000);
+    for (auto& byte : source) {
+      byte = static_cast<std::uint8_t>(random());
+    }
+    QuicReassemblyBuffer stream(source.size());
+    std::vector<std::uint8_t> out;
+    while (!stream.Finished()) {
+      std::uint64_t offset = random() % source.size();
+      // bias towards the read offset so the stream makes progress
+      if (random() % 4 == 0) {
+        offset = stream.ReadOffset() - std::min<std::uint64_t>(
+                                           stream.ReadOffset(), random() % 64);
+      }
+      std::size_t length = static_cast<std::size_t>(
+          std::min<std::uint64_t>(1 + random() % 1400, source.size() - offset));
+      bool fin = offset + length == source.size();
+      if (Deliver(stream, pool, source, offset, length, fin) !=
+          QuicReassemblyErrorStatus::kSuccess) {
+        std::cout << "fragment rejected" << std::endl;
+        return false;
+      }
+      // a packet buffer is only pinned by the fragments in it
+      if (pool.Capacity() - pool.Available() > stream.FragmentCount()) {
+        std::cout << "packet buffer leaked" << std::endl;
+        return false;
+      }
+      if (random() % 3 == 0) {
+        ReadAll(stream, out);
+      }
+    }
+    ReadAll(stream, out);
+    if (out != source || pool.Available() != pool.Capacity()) {
+      std::cout << "reassembled data differs" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Receives a stream of full sized frames, either in order or shuffled
+// within windows of reorder packets with some duplicates, reading whatever
+// is contiguous after each packet.
+static bool Benchmark(const char* name, std::size_t reorder,
+                      std::uint32_t duplicate_per_mille) {
+  constexpr std::size_t kFrame = 1200;
+  constexpr std::uint64_t kFrames = 1 << 20;
+  QuicPacketBufferPool pool(2 * reorder + 16);
+
+  std::vector<std::uint64_t> order;
+  order.reserve(kFrames + kFrames / 100);
+  std::mt19937_64 random(3);
+  for (std::uint64_t window = 0; window < kFrames; window += reorder) {
+    std::size_t begin = order.size();
+    for (std::uint64_t i = window; i < window + reorder; i++) {
+      order.push_back(i);
+      if (random() % 1000 < duplicate_per_mille) {
+        order.push_back(i);
+      }
+    }
+    std::shuffle(order.begin() + static_cast<std::ptrdiff_t>(begin),
+                 order.end(), random);
+  }
+
+  QuicReassemblyBuffer stream(kFrames * kFrame, 2 * reorder + 16);
+  std::uint64_t read = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint64_t frame : order) {
+    QuicPacketBufferRef packet = pool.Allocate();
+    packet->size = kFrame + 30;
+    if (stream.Insert(frame * kFrame, packet->Datagram().subspan(30),
+                      frame == kFrames - 1,
+                      packet) != QuicReassemblyErrorStatus::kSuccess) {
+      std::cout << name << ": fragment rejected" << std::endl;
+      return false;
+    }
+    packet.Reset();
+    for (auto span = stream.Front(); !span.empty(); span = stream.Front()) {
+      read += span.size();
+      stream.Consume(span.size());
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (!stream.Finished() || read != kFrames * kFrame ||
+      pool.Available() != pool.Capacity()) {
+    std::cout << name << ": stream incomplete" << std::endl;
+    return false;
+  }
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << name << ": "
+            << std::chrono::duration<double, std::nano>(end - start).count() /
+                   static_cast<double>(order.size())
+            << " ns/frame, "
+            << static_cast<double>(read) * 8 / seconds / 1e9 << " Gbps"
+            << std::endl;
+  return true;
+}
+
+int main() {
+  if (!CheckInOrder() || !CheckErrors() || !CheckOverlaps()) {
+    return EXIT_FAILURE;
+  }
+  if (!Benchmark("in order", 1, 0) ||
+      !Benchmark("reordered within 256 packets, 1% duplicated", 256, 10)) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "QUIC reassembly test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/quic/quic_retry.h"
+
+using bedrock::network::Address;
+using bedrock::network::IPVersion;
+using bedrock::network::kQuicMaxRetryPacketSize;
+using bedrock::network::kQuicMaxRetryTokenSize;
+using bedrock::network::ParseQuicInitialHeader;
+using bedrock::network::QuicInitialHeaderView;
+using bedrock::network::QuicLongHeaderPacketTypeV1;
+using bedrock::network::QuicPacketBuilder;
+using bedrock::network::QuicRetryConfig;
+using bedrock::network::QuicRetryErrorStatus;
+using bedrock::network::QuicRetryResponder;
+using bedrock::network::QuicVersion1;
+using bedrock::network::QuicVersion2;
+using bedrock::network::VerifyQuicRetryIntegrity;
+
+using Clock = std::chrono::system_clock;
+using std::chrono::milliseconds;
+
+static std::vector<std::uint8_t> FromHex(std::string_view hex) {
+  std::vector<std::uint8_t> bytes;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    auto nibble = [](char c) {
+      return c <= '9' ? c - '0' : c - 'a' + 10;
+    };
+    bytes.push_back(
+        static_cast<std::uint8_t>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+  }
+  return bytes;
+}
+
+static const std::vector<std::uint8_t> kOriginalID =
+    FromHex("8394c8f03e515708");
+
+// rfc9001 appendix A.4 and rfc9369 appendix A.4
+static bool CheckIntegrityTag() {
+  std::vector<std::uint8_t> v1 = FromHex(
+      "ff000000010008f067a5502a4262b5746f6b656e04a265ba2eff4d829058fb3f0f2496"
+      "ba");
+  std::vector<std::uint8_t> v2 = FromHex(
+      "cf6b3343cf0008f067a5502a4262b5746f6b656ec8646ce8bfe33952d955543665dcc7"
+      "b6");
+  if (!VerifyQuicRetryIntegrity<QuicVersion1>(v1, kOriginalID) ||
+      !VerifyQuicRetryIntegrity<QuicVersion2>(v2, kOriginalID)) {
+    std::cout << "Retry integrity tag mismatch" << std::endl;
+    return false;
+  }
+  v1[10] ^= 1;
+  if (VerifyQuicRetryIntegrity<QuicVersion1>(v1, kOriginalID)) {
+    std::cout << "modified Retry accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckTokens() {
+  QuicRetryConfig config;
+  config.key_rotation_period = milliseconds(30000);
+  config.token_lifetime = milliseconds(10000);
+  config.secret = QuicRetryResponder::GenerateSecret();
+  QuicRetryResponder issuer(config);
+  QuicRetryResponder validator(config);  // e.g. another receive worker
+  config.secret = QuicRetryResponder::GenerateSecret();
+  QuicRetryResponder stranger(config);
+
+  Address peer(IPVersion::kIPV4, "192.0.2.1", 4433);
+  Address other_port(IPVersion::kIPV4, "192.0.2.1", 4434);
+  Address other_host(IPVersion::kIPV6, "2001:db8::1", 4433);
+  Clock::time_point now = Clock::time_point(milliseconds(1000000));
+
+  std::array<std::uint8_t, kQuicMaxRetryTokenSize> token;
+  std::size_t token_size = 0;
+  if (issuer.IssueToken(peer, kOriginalID, now, token, token_size) !=
+      QuicRetryErrorStatus::kSuccess) {
+    std::cout << "token not issued" << std::endl;
+    return false;
+  }
+  std::span<const std::uint8_t> issued = std::span(token).first(token_size);
+
+  std::array<std::uint8_t, 20> original;
+  std::size_t original_size = 0;
+  auto validate = [&](QuicRetryResponder& responder, const Address& address,
+                      Clock::time_point time,
+                      std::span<const std::uint8_t> bytes) {
+    return responder.ValidateToken(bytes, address, time, original,
+                                   original_size);
+  };
+  if (validate(validator, peer, now + milliseconds(5), issued) !=
+          QuicRetryErrorStatus::kSuccess ||
+      !std::equal(kOriginalID.begin(), kOriginalID.end(), original.begin(),
+                  original.begin() +
+                      static_cast<std::ptrdiff_t>(original_size))) {
+    std::cout << "token rejected or original ID lost" << std::endl;
+    return false;
+  }
+
+  struct Case {
+    const char* name;
+    QuicRetryResponder& responder;
+    const Address& address;
+    Clock::time_point time;
+    QuicRetryErrorStatus expected;
+  };
+  const std::array<Case, 5> cases = {{
+      {"other port", validator, other_port, now,
+       QuicRetryErrorStatus::kInvalid},
+      {"other host", validator, other_host, now,
+       QuicRetryErrorStatus::kInvalid},
+      {"other secret", stranger, peer, now, QuicRetryErrorStatus::kInvalid},
+      {"past lifetime", validator, peer, now + milliseconds(10001),
+       QuicRetryErrorStatus::kExpired},
+      {"two rotations later", validator, peer, now + milliseconds(60000),
+       QuicRetryErrorStatus::kExpired},
+  }};
+  for (const Case& test : cases) {
+    if (validate(test.responder, test.address, test.time, issued) !=
+        test.expected) {
+      std::cout << "token accepted from " << test.name << std::endl;
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < token_size; i++) {
+    std::array<std::uint8_t, kQuicMaxRetryTokenSize> forged = token;
+    forged[i] ^= 0x01;
+    if (validate(validator, peer, now, std::span(forged).first(token_size)) ==
+        QuicRetryErrorStatus::kSuccess) {
+      std::cout << "token with byte " << i << " flipped accepted"
+                << std::endl;
+      return false;
+    }
+  }
+
+  // A token issued just before a rotation stays valid after it
+  Clock::time_point before_rotation = Clock::time_point(milliseconds(59999));
+  issuer.IssueToken(peer, kOriginalID, before_rotation, token, token_size);
+  if (validate(validator, peer, before_rotation + milliseconds(2),
+               std::span(token).first(token_size)) !=
+      QuicRetryErrorStatus::kSuccess) {
+    std::cout << "token of the previous key epoch rejected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Responders left with the all-zero default secret each generate their own,
+// so neither accepts the other's tokens.
+static bool CheckDefaultSecret() {
+  QuicRetryConfig config;
+  QuicRetryResponder first(config);
+  QuicRetryResponder second(config);
+  Address peer(IPVersion::kIPV4, "192.0.2.1", 4433);
+  Clock::time_point now = Clock::now();
+
+  std::array<std::uint8_t, kQuicMaxRetryTokenSize> token;
+  std::size_t token_size = 0;
+  std::array<std::uint8_t, 20> original;
+  std::size_t original_size = 0;
+  first.IssueToken(peer, kOriginalID, now, token, token_size);
+  if (first.ValidateToken(std::span(token).first(token_size), peer, now,
+                          original, original_size) !=
+      QuicRetryErrorStatus::kSuccess) {
+    std::cout << "token rejected by its issuer" << std::endl;
+    return false;
+  }
+  second.IssueToken(peer, kOriginalID, now, token, token_size);
+  if (first.ValidateToken(std::span(token).first(token_size), peer, now,
+                          original, original_size) !=
+      QuicRetryErrorStatus::kInvalid) {
+    std::cout << "token accepted under another default secret" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A client Initial answered with a Retry whose token validates
+template <typename Version>
+static bool CheckRespond() {
+  QuicRetryConfig config;
+  config.secret = QuicRetryResponder::GenerateSecret();
+  QuicRetryResponder responder(config);
+  Address peer(IPVersion::kIPV6, "2001:db8::7", 51000);
+  Clock::time_point now = Clock::now();
+
+  const std::array<std::uint8_t, 5> client_id = {9, 8, 7, 6, 5};
+  std::vector<std::uint8_t> datagram(1200);
+  QuicPacketBuilder<Version> builder(datagram, datagram.size());
+  builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kInitial, kOriginalID,
+                          client_id, {}, 0, 1);
+  builder.AppendPadding(10);
+  builder.FinishPacket(1200);
+
+  QuicInitialHeaderView initial;
+  if (ParseQuicInitialHeader<Version>(builder.Datagram(), initial) !=
+          QuicRetryErrorStatus::kSuccess ||
+      !initial.token.empty()) {
+    std::cout << "Initial not parsed" << std::endl;
+    return false;
+  }
+  const std::array<std::uint8_t, 8> retry_id = {1, 2, 3, 4, 5, 6, 7, 8};
+  std::array<std::uint8_t, kQuicMaxRetryPacketSize> retry;
+  std::size_t retry_size = 0;
+  if (responder.Respond<Version>(initial, peer, retry_id, now, retry,
+                                 retry_size) !=
+          QuicRetryErrorStatus::kSuccess ||
+      !VerifyQuicRetryIntegrity<Version>(std::span(retry).first(retry_size),
+                                         kOriginalID) ||
+      Version::LongPacketType(retry[0]) !=
+          QuicLongHeaderPacketTypeV1::kRetry ||
+      retry[5] != client_id.size() || retry[11] != retry_id.size()) {
+    std::cout << "Retry malformed" << std::endl;
+    return false;
+  }
+
+  // the client echoes the token in its next Initial
+  std::size_t token_offset = 1 + 4 + 1 + client_id.size() + 1 + 8;
+  std::span<const std::uint8_t> token = std::span(retry).subspan(
+      token_offset, retry_size - token_offset - 16);
+  builder.Reset();
+  builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kInitial, retry_id,
+                          client_id, token, 1, 1);
+  builder.AppendPadding(10);
+  builder.FinishPacket(1200);
+  std::array<std::uint8_t, 20> original;
+  std::size_t original_size = 0;
+  if (ParseQuicInitialHeader<Version>(builder.Datagram(), initial) !=
+          QuicRetryErrorStatus::kSuccess ||
+      responder.ValidateToken(initial.token, peer, now + milliseconds(30),
+                              original, original_size) !=
+          QuicRetryErrorStatus::kSuccess ||
+      original_size != kOriginalID.size()) {
+    std::cout << "echoed token rejected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckRate() {
+  QuicRetryConfig config;
+  config.handshake_rate_threshold = 100;
+  QuicRetryResponder responder(config);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::time_point(milliseconds(500000));
+
+  for (int i = 0; i < 100; i++) {
+    if (responder.RetryRequired(start + milliseconds(i))) {
+      std::cout << "Retry below the threshold" << std::endl;
+      return false;
+    }
+  }
+  for (int i = 100; i < 150; i++) {
+    if (!responder.RetryRequired(start + milliseconds(i))) {
+      std::cout << "no Retry above the threshold" << std::endl;
+      return false;
+    }
+  }
+  // 70% of the last window still counts 300 ms into the next one
+  if (!responder.RetryRequired(start + milliseconds(1300))) {
+    std::cout << "rate forgot the previous window" << std::endl;
+    return false;
+  }
+  if (responder.RetryRequired(start + milliseconds(3000))) {
+    std::cout << "Retry continued after the burst" << std::endl;
+    return false;
+  }
+
+  config.handshake_rate_threshold = 0;
+  QuicRetryResponder always(config);
+  return always.RetryRequired(start);
+}
+
+static void Benchmark() {
+  constexpr std::size_t kTokens = 1 << 16;
+  QuicRetryConfig config;
+  config.secret = QuicRetryResponder::GenerateSecret();
+  QuicRetryResponder responder(config);
+  Address peer(IPVersion::kIPV4, "198.51.100.9", 443);
+  Clock::time_point now = Clock::now();
+
+  std::array<std::uint8_t, kQuicMaxRetryTokenSize> token;
+  std::size_t token_size = 0;
+  std::array<std::uint8_t, 20> original;
+  std::size_t original_size = 0;
+  std::size_t valid = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kTokens; i++) {
+    responder.IssueToken(peer, kOriginalID, now, token, token_size);
+    valid += responder.ValidateToken(std::span(token).first(token_size), peer,
+                                     now, original, original_size) ==
+             QuicRetryErrorStatus::kSuccess;
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  std::cout << "Issued and validated " << valid << " Retry tokens, "
+            << elapsed / static_cast<double>(kTokens) * 1e9 << " ns each"
+            << std::endl;
+}
+
+int main() {
+  if (!CheckIntegrityTag() || !CheckTokens() || !CheckDefaultSecret() ||
+      !CheckRespond<QuicVersion1>() || !CheckRespond<QuicVersion2>() ||
+      !CheckRate()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC Retry test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "networking/quic/quic_frame.h"
+#include "networking/quic/quic_send_buffer.h"
+
+using bedrock::network::kQuicAeadTagLengthV1;
+using bedrock::network::kQuicSendBufferBlockSize;
+using bedrock::network::kQuicStreamFrameFinBitV1;
+using bedrock::network::QuicByteRangeSet;
+using bedrock::network::QuicFrameDecoderV1;
+using bedrock::network::QuicFrameErrorStatus;
+using bedrock::network::QuicFrameTypeV1;
+using bedrock::network::QuicFrameV1;
+using bedrock::network::QuicPacketBuilderV1;
+using bedrock::network::QuicSendBuffer;
+using bedrock::network::QuicSentStreamFrameV1;
+
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+constexpr std::uint64_t kStreamID = 4;
+
+static bool SameRanges(const QuicByteRangeSet& set,
+                       const std::vector<QuicByteRangeSet::Range>& expected) {
+  auto ranges = set.Ranges();
+  return std::equal(ranges.begin(), ranges.end(), expected.begin(),
+                    expected.end(), [](const auto& lhs, const auto& rhs) {
+                      return lhs.begin == rhs.begin && lhs.end == rhs.end;
+                    });
+}
+
+static bool CheckRangeSet() {
+  QuicByteRangeSet set;
+  set.Add(10, 20);
+  set.Add(30, 40);
+  set.Add(20, 25);  // adjacent ranges merge
+  set.Add(50, 60);
+  if (!SameRanges(set, {{10, 25}, {30, 40}, {50, 60}})) {
+    std::cout << "range set add failed" << std::endl;
+    return false;
+  }
+  set.Add(24, 52);
+  set.Subtract(12, 14);
+  if (!SameRanges(set, {{10, 12}, {14, 60}})) {
+    std::cout << "range set merge or split failed" << std::endl;
+    return false;
+  }
+  set.Subtract(11, 30);
+  set.TrimBelow(40);
+  if (!SameRanges(set, {{40, 60}})) {
+    std::cout << "range set subtract failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Transport of one stream: every packet carries one STREAM frame, which is
+// decoded again and written into the receiver's copy.
+class Transfer {
+ public:
+  explicit Transfer(std::size_t size) : source(size), received(size) {
+    for (std::size_t i = 0; i < size; i++) {
+      source[i] = static_cast<std::uint8_t>(i * 13 + i / 256);
+    }
+  }
+
+  // Builds one packet from the buffer; false if nothing was sent.
+  bool SendPacket(QuicSendBuffer& buffer, std::uint64_t send_limit,
+                  QuicSentStreamFrameV1& sent) {
+    QuicPacketBuilderV1 builder(send_buffer, 1200);
+    builder.BeginShortPacket(kDcid, packet_number++, 2, false);
+    if (!buffer.WriteStreamFrame(builder, kStreamID, send_limit, sent)) {
+      return false;
+    }
+    builder.FinishPacket();
+    const auto& packet = builder.Packets()[0];
+    QuicFrameDecoderV1 decoder(builder.Datagram().subspan(
+        packet.payload_offset,
+        packet.end_offset - packet.payload_offset - kQuicAeadTagLengthV1));
+    QuicFrameV1 frame;
+    if (decoder.Next(frame) != QuicFrameErrorStatus::kSuccess ||
+        frame.type != QuicFrameTypeV1::kStream || frame.id != kStreamID ||
+        frame.offset != sent.offset || frame.data.size() != sent.length ||
+        ((frame.flags & kQuicStreamFrameFinBitV1) != 0) != sent.fin) {
+      std::cout << "STREAM frame does not match its record" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    std::copy(frame.data.begin(), frame.data.end(),
+              received.begin() + static_cast<std::ptrdiff_t>(frame.offset));
+    fin_received |= sent.fin;
+    return true;
+  }
+
+  std::vector<std::uint8_t> source;
+  std::vector<std::uint8_t> received;
+  bool fin_received = false;
+
+ private:
+  std::array<std::uint8_t, 1500> send_buffer{};
+  std::uint64_t packet_number = 0;
+};
+
+static bool CheckInOrder() {
+  Transfer transfer(100000);
+  QuicSendBuffer buffer(40000);
+  if (buffer.Write(transfer.source) != 40000 || buffer.BlockCount() != 3) {
+    std::cout << "buffer limit not enforced" << std::endl;
+    return false;
+  }
+  std::size_t written = 40000;
+  std::vector<QuicSentStreamFrameV1> in_flight;
+  QuicSentStreamFrameV1 sent;
+  // the peer allows 30000 bytes for now
+  while (transfer.SendPacket(buffer, 30000, sent)) {
+    in_flight.push_back(sent);
+  }
+  if (buffer.SentOffset() != 30000 || buffer.HasDataToSend(30000)) {
+    std::cout << "send limit not enforced" << std::endl;
+    return false;
+  }
+
+  // acknowledging the first 20000 bytes frees the first block only
+  std::size_t acked = 0;
+  while (in_flight[acked].offset + in_flight[acked].length <= 20000) {
+    buffer.OnAcked(in_flight[acked++]);
+  }
+  if (buffer.AckedOffset() >= 20000 || buffer.BlockCount() != 2 ||
+      buffer.BufferedBytes() != 40000 - buffer.AckedOffset()) {
+    std::cout << "acknowledged block not released" << std::endl;
+    return false;
+  }
+  written += buffer.Write(std::span(transfer.source).subspan(written));
+  while (written < transfer.source.size() || buffer.HasDataToSend(1 << 20)) {
+    while (transfer.SendPacket(buffer, 1 << 20, sent)) {
+      in_flight.push_back(sent);
+    }
+    for (; acked < in_flight.size(); acked++) {
+      buffer.OnAcked(in_flight[acked]);
+    }
+    if (written < transfer.source.size()) {
+      written += buffer.Write(std::span(transfer.source).subspan(written));
+      if (written == transfer.source.size()) {
+        buffer.Finish();
+      }
+    }
+  }
+  if (!buffer.AllDataAcked() || buffer.BlockCount() != 0 ||
+      transfer.received != transfer.source || !transfer.fin_received) {
+    std::cout << "in-order transfer failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A pending FIN rides on the last data, so it can not go out while flow
+// control holds that data back.
+static bool CheckFinBlocked() {
+  Transfer transfer(100);
+  QuicSendBuffer buffer;
+  buffer.Write(transfer.source);
+  buffer.Finish();
+  QuicSentStreamFrameV1 sent;
+  while (transfer.SendPacket(buffer, 50, sent)) {
+  }
+  if (buffer.SentOffset() != 50 || buffer.HasDataToSend(50) ||
+      !buffer.HasDataToSend(100)) {
+    std::cout << "FIN reported sendable past the send limit" << std::endl;
+    return false;
+  }
+  while (transfer.SendPacket(buffer, 100, sent)) {
+  }
+  if (buffer.HasDataToSend(100) || transfer.received != transfer.source ||
+      !transfer.fin_received) {
+    std::cout << "FIN not sent once the limit was raised" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Random loss, reordered and spurious acknowledgements: the receiver must
+// end up with the source and the buffer empty.
+static bool CheckLoss() {
+  std::mt19937_64 random(9);
+  for (int round = 0; round < 50; round++) {
+    Transfer transfer(200000);
+    QuicSendBuffer buffer(transfer.source.size());
+    buffer.Write(transfer.source);
+    buffer.Finish();
+
+    std::vector<QuicSentStreamFrameV1> in_flight;
+    QuicSentStreamFrameV1 sent;
+    while (!buffer.AllDataAcked()) {
+      for (int i = 0; i < 32 && transfer.SendPacket(buffer, 1 << 30, sent);
+           i++) {
+        in_flight.push_back(sent);
+      }
+      std::shuffle(in_flight.begin(), in_flight.end(), random);
+      std::size_t keep = in_flight.size() / 4;
+      for (std::size_t i = keep; i < in_flight.size(); i++) {
+        if (random() % 10 == 0) {
+          buffer.OnLost(in_flight[i]);
+          // sometimes the lost packet was only late
+          if (random() % 4 == 0) {
+            buffer.OnAcked(in_flight[i]);
+          }
+        } else {
+          buffer.OnAcked(in_flight[i]);
+        }
+      }
+      in_flight.resize(keep);
+      // only blocks holding unacknowledged bytes are kept
+      if (buffer.BlockCount() >
+          buffer.BufferedBytes() / kQuicSendBufferBlockSize + 2) {
+        std::cout << "acknowledged blocks kept" << std::endl;
+        return false;
+      }
+      if (in_flight.empty() && !buffer.HasDataToSend(1 << 30) &&
+          !buffer.AllDataAcked()) {
+        std::cout << "transfer stalled" << std::endl;
+        return false;
+      }
+    }
+    if (transfer.received != transfer.source || !transfer.fin_received ||
+        buffer.BlockCount() != 0) {
+      std::cout << "lossy transfer failed" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Streams data through full sized packets with 1% loss. Acknowledgements
+// lag a window of packets behind, as they would over a real path.
+static void Benchmark() {
+  constexpr std::size_t kWindow = 1024;
+  constexpr std::uint64_t kTotal = std::uint64_t{1} << 30;
+  std::vector<std::uint8_t> chunk(256 * 1024, 0x42);
+  std::array<std::uint8_t, 1500> send_buffer{};
+  QuicSendBuffer buffer(4 << 20);
+  std::vector<QuicSentStreamFrameV1> in_flight(kWindow);
+  std::mt19937_64 random(5);
+
+  std::uint64_t written = 0;
+  std::uint64_t packets = 0;
+  std::uint64_t peak = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (!buffer.AllDataAcked()) {
+    if (written < kTotal) {
+      written += buffer.Write(chunk);
+      if (written >= kTotal) {
+        buffer.Finish();
+      }
+    }
+    QuicPacketBuilderV1 builder(send_buffer, 1200);
+    builder.BeginShortPacket(kDcid, packets, 2, false);
+    QuicSentStreamFrameV1& slot = in_flight[packets % kWindow];
+    QuicSentStreamFrameV1 sent;
+    bool sending = buffer.WriteStreamFrame(builder, kStreamID, ~0ull, sent);
+    if (packets >= kWindow || !sending) {
+      if (random() % 100 == 0) {
+        buffer.OnLost(slot);
+      } else {
+        buffer.OnAcked(slot);
+      }
+    }
+    slot = sending ? sent : QuicSentStreamFrameV1{};
+    packets++;
+    peak = std::max(peak, buffer.BufferedBytes());
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "1% loss: "
+            << std::chrono::duration<double, std::nano>(end - start).count() /
+                   static_cast<double>(packets)
+            << " ns/packet, " << static_cast<double>(kTotal) * 8 / seconds / 1e9
+            << " Gbps, peak buffered " << peak / 1024 << " KiB" << std::endl;
+}
+
+int main() {
+  if (!CheckRangeSet() || !CheckInOrder() || !CheckFinBlocked() ||
+      !CheckLoss()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC send buffer test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "networking/quic/quic_session_ticket.h"
+
+using bedrock::network::kQuicMaxSessionTicketLifetime;
+using bedrock::network::kQuicMaxSessionTicketSize;
+using bedrock::network::kQuicSessionTicketCacheWays;
+using bedrock::network::kQuicSessionTicketsPerServer;
+using bedrock::network::QuicSessionTicket;
+using bedrock::network::QuicSessionTicketCache;
+using bedrock::network::QuicSessionTicketErrorStatus;
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static const Clock::time_point kStart = Clock::time_point(milliseconds(1000));
+
+// A ticket whose identity holds serial, so tests can tell tickets apart.
+static QuicSessionTicket MakeTicket(std::uint32_t serial,
+                                    Clock::time_point received,
+                                    seconds lifetime = seconds(3600)) {
+  QuicSessionTicket ticket;
+  ticket.received = received;
+  ticket.lifetime = lifetime;
+  ticket.age_add = serial * 2654435761u;
+  ticket.early_data = true;
+  std::uint8_t identity[200] = {};
+  std::memcpy(identity, &serial, sizeof(serial));
+  ticket.SetIdentity(identity);
+  return ticket;
+}
+
+static std::uint32_t Serial(const QuicSessionTicket& ticket) {
+  std::uint32_t serial;
+  std::memcpy(&serial, ticket.Identity().data(), sizeof(serial));
+  return serial;
+}
+
+// Tickets come back newest first and only once, and a server keeps only
+// its newest few.
+static bool CheckSingleUse() {
+  QuicSessionTicketCache cache(64);
+  for (std::uint32_t serial = 1; serial <= 6; serial++) {
+    cache.Insert("example.com", MakeTicket(serial, kStart + seconds(serial)),
+                 kStart + seconds(serial));
+  }
+  cache.Insert("example.org", MakeTicket(100, kStart), kStart);
+  if (cache.Size() != kQuicSessionTicketsPerServer + 1) {
+    std::cout << "server kept " << cache.Size() - 1 << " tickets"
+              << std::endl;
+    return false;
+  }
+
+  Clock::time_point now = kStart + seconds(10);
+  QuicSessionTicket ticket;
+  for (std::uint32_t serial = 6; serial > 6 - kQuicSessionTicketsPerServer;
+       serial--) {
+    if (cache.Take("example.com", now, ticket) !=
+            QuicSessionTicketErrorStatus::kSuccess ||
+        Serial(ticket) != serial || ticket.Identity().size() != 200) {
+      std::cout << "expected ticket " << serial << std::endl;
+      return false;
+    }
+  }
+  if (cache.Take("example.com", now, ticket) !=
+          QuicSessionTicketErrorStatus::kNotFound ||
+      cache.Take("example.org", now, ticket) !=
+          QuicSessionTicketErrorStatus::kSuccess ||
+      Serial(ticket) != 100 || cache.Size() != 0) {
+    std::cout << "tickets reused or lost" << std::endl;
+    return false;
+  }
+
+  cache.Insert("example.net", MakeTicket(1, kStart), kStart);
+  cache.Erase("example.net");
+  if (cache.Take("example.net", now, ticket) !=
+      QuicSessionTicketErrorStatus::kNotFound) {
+    std::cout << "erased ticket returned" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckExpiry() {
+  QuicSessionTicketCache cache(64);
+  QuicSessionTicket ticket = MakeTicket(1, kStart, seconds(60));
+  if (cache.Insert("example.com", ticket, kStart + seconds(60)) !=
+      QuicSessionTicketErrorStatus::kExpired) {
+    std::cout << "expired ticket cached" << std::endl;
+    return false;
+  }
+  cache.Insert("example.com", ticket, kStart);
+  cache.Insert("example.com", MakeTicket(2, kStart, seconds(30)), kStart);
+  QuicSessionTicket taken;
+  if (cache.Take("example.com", kStart + seconds(45), taken) !=
+          QuicSessionTicketErrorStatus::kSuccess ||
+      Serial(taken) != 1 || cache.Size() != 0) {
+    std::cout << "expired ticket not dropped" << std::endl;
+    return false;
+  }
+
+  // lifetimes beyond seven days are cut to seven days
+  QuicSessionTicket long_lived = MakeTicket(3, kStart, seconds(30 * 86400));
+  if (long_lived.Expired(kStart + kQuicMaxSessionTicketLifetime -
+                         seconds(1)) ||
+      !long_lived.Expired(kStart + kQuicMaxSessionTicketLifetime)) {
+    std::cout << "lifetime not capped" << std::endl;
+    return false;
+  }
+
+  // age_add wraps modulo 2^32
+  ticket.age_add = 0xFFFFFF00;
+  if (ticket.ObfuscatedAge(kStart + milliseconds(0x200)) != 0x100) {
+    std::cout << "obfuscated age " << ticket.ObfuscatedAge(kStart)
+              << std::endl;
+    return false;
+  }
+
+  std::vector<std::uint8_t> huge(kQuicMaxSessionTicketSize + 1);
+  if (ticket.SetIdentity(huge) != QuicSessionTicketErrorStatus::kTooLarge ||
+      cache.Insert(std::string(300, 'a'), ticket, kStart) !=
+          QuicSessionTicketErrorStatus::kTooLarge) {
+    std::cout << "oversized ticket accepted" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Many more servers than slots: memory stays fixed, the newest tickets
+// survive, and expired ones are replaced before live ones.
+static bool CheckBounded() {
+  QuicSessionTicketCache cache(256);
+  for (std::uint32_t serial = 0; serial < 10000; serial++) {
+    Clock::time_point now = kStart + milliseconds(serial);
+    cache.Insert("host" + std::to_string(serial) + ".example.com",
+                 MakeTicket(serial, now), now);
+    if (cache.Size() > cache.Capacity()) {
+      std::cout << "cache grew past its capacity" << std::endl;
+      return false;
+    }
+  }
+  Clock::time_point now = kStart + seconds(10);
+  QuicSessionTicket ticket;
+  if (cache.Take("host9999.example.com", now, ticket) !=
+          QuicSessionTicketErrorStatus::kSuccess ||
+      cache.Take("host0.example.com", now, ticket) !=
+          QuicSessionTicketErrorStatus::kNotFound) {
+    std::cout << "eviction kept the wrong tickets" << std::endl;
+    return false;
+  }
+
+  // One bucket: the older tickets are live, the newest has expired. A
+  // ticket for another server replaces the expired one.
+  QuicSessionTicketCache small(kQuicSessionTicketCacheWays);
+  for (std::uint32_t serial = 0; serial + 1 < kQuicSessionTicketCacheWays;
+       serial++) {
+    small.Insert("host" + std::to_string(serial),
+                 MakeTicket(serial, kStart), kStart);
+  }
+  small.Insert("expiring", MakeTicket(99, kStart + seconds(1), seconds(1)),
+               kStart + seconds(1));
+  now = kStart + seconds(3);
+  small.Insert("newcomer", MakeTicket(100, now), now);
+  std::size_t live = 0;
+  for (std::uint32_t serial = 0; serial + 1 < kQuicSessionTicketCacheWays;
+       serial++) {
+    live += small.Take("host" + std::to_string(serial), now, ticket) ==
+            QuicSessionTicketErrorStatus::kSuccess;
+  }
+  if (live + 1 != kQuicSessionTicketCacheWays ||
+      small.Take("newcomer", now, ticket) !=
+          QuicSessionTicketErrorStatus::kSuccess) {
+    std::cout << "a live ticket was evicted before an expired one"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Threads reconnecting to shared servers never get the same ticket twice.
+static bool CheckConcurrent() {
+  constexpr std::uint32_t kThreads = 8;
+  constexpr std::uint32_t kPerThread = 20000;
+  QuicSessionTicketCache cache(4096);
+  std::vector<std::atomic<std::uint8_t>> taken(kThreads * kPerThread);
+  std::atomic<bool> reused = false;
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t thread = 0; thread < kThreads; thread++) {
+    threads.emplace_back([&, thread] {
+      QuicSessionTicket ticket;
+      for (std::uint32_t i = 0; i < kPerThread; i++) {
+        std::string server = "server" + std::to_string(i % 97);
+        std::uint32_t serial = thread * kPerThread + i;
+        cache.Insert(server, MakeTicket(serial, kStart), kStart);
+        if (i % 2 == 1 &&
+            cache.Take(server, kStart, ticket) ==
+                QuicSessionTicketErrorStatus::kSuccess &&
+            taken[Serial(ticket)].exchange(1) != 0) {
+          reused = true;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  if (reused) {
+    std::cout << "a ticket was taken twice" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr std::uint32_t kServers = 1000;
+  constexpr int kRounds = 200;
+  QuicSessionTicketCache cache(4096);
+  std::vector<std::string> servers;
+  for (std::uint32_t i = 0; i < kServers; i++) {
+    servers.push_back("edge" + std::to_string(i) + ".example.com");
+  }
+  QuicSessionTicket ticket = MakeTicket(1, kStart);
+  QuicSessionTicket taken;
+
+  std::size_t found = 0;
+  auto start = Clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (const std::string& server : servers) {
+      cache.Insert(server, ticket, kStart);
+      found += cache.Take(server, kStart, taken) ==
+               QuicSessionTicketErrorStatus::kSuccess;
+    }
+  }
+  double elapsed =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  std::cout << "insert and take with " << cache.Capacity()
+            << " slots: " << elapsed / (kServers * kRounds) << " ns (" << found
+            << " found)" << std::endl;
+}
+
+int main() {
+  if (!CheckSingleUse() || !CheckExpiry() || !CheckBounded() ||
+      !CheckConcurrent()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "QUIC session ticket test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
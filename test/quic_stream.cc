@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "networking/quic/quic_stream.h"
+
+using bedrock::network::QuicReceiveStreamEventV1;
+using bedrock::network::QuicReceiveStreamStateV1;
+using bedrock::network::QuicSendStreamEventV1;
+using bedrock::network::QuicSendStreamStateV1;
+using bedrock::network::QuicStreamErrorStatus;
+using bedrock::network::QuicStreamRecordV1;
+using bedrock::network::QuicStreamTableV1;
+using bedrock::network::QuicStreamTypeV1;
+using bedrock::network::TransitionQuicStream;
+
+// The tables are usable at compile time.
+static_assert([] {
+  QuicSendStreamStateV1 state = QuicSendStreamStateV1::kReady;
+  return TransitionQuicStream(state, QuicSendStreamEventV1::kSendData) &&
+         TransitionQuicStream(state, QuicSendStreamEventV1::kSendFin) &&
+         TransitionQuicStream(state, QuicSendStreamEventV1::kAllDataAcked) &&
+         state == QuicSendStreamStateV1::kDataRecvd;
+}());
+
+static bool CheckTransitions() {
+  using Send = QuicSendStreamStateV1;
+  using SendEvent = QuicSendStreamEventV1;
+  using Receive = QuicReceiveStreamStateV1;
+  using ReceiveEvent = QuicReceiveStreamEventV1;
+
+  Send send = Send::kReady;
+  if (TransitionQuicStream(send, SendEvent::kAllDataAcked) ||
+      send != Send::kReady) {
+    std::cout << "ACK of unsent data accepted" << std::endl;
+    return false;
+  }
+  if (!TransitionQuicStream(send, SendEvent::kSendData) ||
+      !TransitionQuicStream(send, SendEvent::kSendReset) ||
+      TransitionQuicStream(send, SendEvent::kSendData) ||
+      !TransitionQuicStream(send, SendEvent::kResetAcked) ||
+      send != Send::kResetRecvd ||
+      TransitionQuicStream(send, SendEvent::kSendReset)) {
+    std::cout << "send reset path failed" << std::endl;
+    return false;
+  }
+
+  Receive receive = Receive::kRecv;
+  if (TransitionQuicStream(receive, ReceiveEvent::kAllDataReceived) ||
+      !TransitionQuicStream(receive, ReceiveEvent::kReceiveData) ||
+      !TransitionQuicStream(receive, ReceiveEvent::kReceiveFin) ||
+      !TransitionQuicStream(receive, ReceiveEvent::kAllDataReceived) ||
+      // a reset may still arrive before the application read everything
+      !TransitionQuicStream(receive, ReceiveEvent::kReceiveReset) ||
+      receive != Receive::kResetRecvd ||
+      !TransitionQuicStream(receive, ReceiveEvent::kReceiveData) ||
+      !TransitionQuicStream(receive, ReceiveEvent::kResetRead) ||
+      receive != Receive::kResetRead) {
+    std::cout << "receive reset path failed" << std::endl;
+    return false;
+  }
+  receive = Receive::kDataRecvd;
+  if (!TransitionQuicStream(receive, ReceiveEvent::kAllDataRead) ||
+      !TransitionQuicStream(receive, ReceiveEvent::kReceiveReset) ||
+      receive != Receive::kDataRead) {
+    std::cout << "late reset after read failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckTable() {
+  QuicStreamTableV1 server(true);
+  server.SetStreamLimit(QuicStreamTypeV1::kClientBiDirectional, 4);
+  server.SetStreamLimit(QuicStreamTypeV1::kServerUnDirectional, 2);
+  server.SetInitialMaxStreamData(QuicStreamTypeV1::kClientBiDirectional,
+                                 1000, 2000);
+
+  QuicStreamRecordV1* record;
+  // client stream 8 implicitly opens 0 and 4
+  if (server.Open(8, false, record) != QuicStreamErrorStatus::kSuccess ||
+      server.OpenCount() != 3 || server.Find(0) == nullptr ||
+      server.Find(4) == nullptr || record->send_limit != 1000 ||
+      record->receive_limit != 2000) {
+    std::cout << "implicit open failed" << std::endl;
+    return false;
+  }
+  if (server.Open(16, false, record) != QuicStreamErrorStatus::kLimit ||
+      server.Open(1, false, record) != QuicStreamErrorStatus::kState ||
+      server.Open(0, true, record) != QuicStreamErrorStatus::kSuccess ||
+      record != server.Find(0)) {
+    std::cout << "open checks failed" << std::endl;
+    return false;
+  }
+
+  std::uint64_t id =
+      server.NextStreamID(QuicStreamTypeV1::kServerUnDirectional);
+  if (id != 3 || server.Open(id, true, record) !=
+                     QuicStreamErrorStatus::kSuccess ||
+      server.OnReceiveEvent(id, QuicReceiveStreamEventV1::kReceiveData) !=
+          QuicStreamErrorStatus::kState) {
+    std::cout << "local unidirectional stream failed" << std::endl;
+    return false;
+  }
+  // sending FIN and getting it acknowledged closes a unidirectional stream
+  if (server.OnSendEvent(id, QuicSendStreamEventV1::kSendFin) !=
+          QuicStreamErrorStatus::kSuccess ||
+      server.OnSendEvent(id, QuicSendStreamEventV1::kAllDataAcked) !=
+          QuicStreamErrorStatus::kSuccess ||
+      server.Find(id) != nullptr ||
+      server.OnSendEvent(id, QuicSendStreamEventV1::kSendData) !=
+          QuicStreamErrorStatus::kClosed ||
+      server.OnSendEvent(7, QuicSendStreamEventV1::kSendData) !=
+          QuicStreamErrorStatus::kNotFound) {
+    std::cout << "unidirectional close failed" << std::endl;
+    return false;
+  }
+
+  // close stream 4 before 0: it stays reserved until 0 closes too
+  for (std::uint64_t stream : {4u, 0u}) {
+    server.OnSendEvent(stream, QuicSendStreamEventV1::kSendFin);
+    server.OnSendEvent(stream, QuicSendStreamEventV1::kAllDataAcked);
+    server.OnReceiveEvent(stream, QuicReceiveStreamEventV1::kReceiveFin);
+    server.OnReceiveEvent(stream, QuicReceiveStreamEventV1::kAllDataReceived);
+    if (server.OnReceiveEvent(stream, QuicReceiveStreamEventV1::kAllDataRead) !=
+        QuicStreamErrorStatus::kSuccess) {
+      std::cout << "bidirectional close failed" << std::endl;
+      return false;
+    }
+  }
+  if (server.OpenCount() != 1 || server.Find(0) != nullptr ||
+      server.Find(4) != nullptr || server.Find(8) == nullptr ||
+      server.Open(4, false, record) != QuicStreamErrorStatus::kClosed) {
+    std::cout << "release failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Opens many streams at once, drives each through a full lifecycle in
+// random order and reports the memory and time per stream.
+static bool Benchmark() {
+  constexpr std::uint64_t kStreams = 500000;
+  QuicStreamTableV1 client(false);
+  client.SetStreamLimit(QuicStreamTypeV1::kClientBiDirectional, kStreams);
+
+  auto start = std::chrono::steady_clock::now();
+  QuicStreamRecordV1* record;
+  if (client.Open((kStreams - 1) << 2, true, record) !=
+          QuicStreamErrorStatus::kSuccess ||
+      client.OpenCount() != kStreams) {
+    std::cout << "bulk open failed" << std::endl;
+    return false;
+  }
+  auto opened = std::chrono::steady_clock::now();
+
+  std::vector<std::uint64_t> order(kStreams);
+  for (std::uint64_t i = 0; i < kStreams; i++) {
+    order[i] = i << 2;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+
+  auto driven = std::chrono::steady_clock::now();
+  std::uint64_t transitions = 0;
+  for (std::uint64_t id : order) {
+    QuicStreamRecordV1* stream = client.Find(id);
+    stream->sent_offset += 100;
+    stream->received_offset += 100;
+    bool ok =
+        client.OnSendEvent(id, QuicSendStreamEventV1::kSendData) ==
+            QuicStreamErrorStatus::kSuccess &&
+        client.OnSendEvent(id, QuicSendStreamEventV1::kSendFin) ==
+            QuicStreamErrorStatus::kSuccess &&
+        client.OnReceiveEvent(id, QuicReceiveStreamEventV1::kReceiveFin) ==
+            QuicStreamErrorStatus::kSuccess &&
+        client.OnReceiveEvent(
+            id, QuicReceiveStreamEventV1::kAllDataReceived) ==
+            QuicStreamErrorStatus::kSuccess &&
+        client.OnReceiveEvent(id, QuicReceiveStreamEventV1::kAllDataRead) ==
+            QuicStreamErrorStatus::kSuccess &&
+        client.OnSendEvent(id, QuicSendStreamEventV1::kAllDataAcked) ==
+            QuicStreamErrorStatus::kSuccess;
+    if (!ok) {
+      std::cout << "lifecycle failed for stream " << id << std::endl;
+      return false;
+    }
+    transitions += 6;
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (client.OpenCount() != 0 || client.Find(0) != nullptr) {
+    std::cout << "streams left open" << std::endl;
+    return false;
+  }
+
+  auto ns = [](auto duration) {
+    return std::chrono::duration<double, std::nano>(duration).count();
+  };
+  std::cout << kStreams << " streams, " << sizeof(QuicStreamRecordV1)
+            << " bytes per record, "
+            << static_cast<double>(kStreams * sizeof(QuicStreamRecordV1)) /
+                   (1 << 20)
+            << " MiB" << std::endl;
+  std::cout << "open: " << ns(opened - start) / kStreams
+            << " ns/stream, random order lifecycle: "
+            << ns(end - driven) / static_cast<double>(transitions)
+            << " ns/transition" << std::endl;
+  return true;
+}
+
+int main() {
+  if (!CheckTransitions() || !CheckTable() || !Benchmark()) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "QUIC stream test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
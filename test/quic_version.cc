@@ -0,0 +1,83 @@
+#include <array>
+#include <cstdlib>
+#include <iostream>
+
+#include "networking/quic/quic_packet_builder.h"
+#include "networking/quic/quic_version.h"
+
+using bedrock::network::QuicLongHeaderPacketTypeV1;
+using bedrock::network::QuicPacketBuilder;
+using bedrock::network::QuicPacketBuilderErrorStatus;
+using bedrock::network::QuicVersion1;
+using bedrock::network::QuicVersion2;
+
+static constexpr std::array<QuicLongHeaderPacketTypeV1, 4> kTypes = {
+    QuicLongHeaderPacketTypeV1::kInitial, QuicLongHeaderPacketTypeV1::k0RTT,
+    QuicLongHeaderPacketTypeV1::kHandshake, QuicLongHeaderPacketTypeV1::kRetry};
+
+// rfc9369 section 3.2 codepoints, version 1 keeps the rfc9000 ones
+static_assert(QuicVersion2::LongPacketTypeBits(kTypes[0]) == 0x10);
+static_assert(QuicVersion2::LongPacketTypeBits(kTypes[1]) == 0x20);
+static_assert(QuicVersion2::LongPacketTypeBits(kTypes[2]) == 0x30);
+static_assert(QuicVersion2::LongPacketTypeBits(kTypes[3]) == 0x00);
+static_assert(QuicVersion1::LongPacketTypeBits(kTypes[3]) == 0x30);
+static_assert(QuicVersion2::kVersion == 0x6B3343CF);
+
+template <typename Version>
+static constexpr bool TypesRoundTrip() {
+  for (auto type : kTypes) {
+    auto first_byte =
+        static_cast<std::uint8_t>(0xC0 | Version::LongPacketTypeBits(type));
+    if (Version::LongPacketType(first_byte) != type) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(TypesRoundTrip<QuicVersion1>());
+static_assert(TypesRoundTrip<QuicVersion2>());
+
+static const std::array<std::uint8_t, 8> kDcid = {1, 2, 3, 4, 5, 6, 7, 8};
+
+// Builds an Initial with the builder of the negotiated version.
+static bool BuildInitial(std::uint32_t version, std::uint8_t& first_byte,
+                         std::uint32_t& wire_version) {
+  std::array<std::uint8_t, 1500> send_buffer{};
+  bool built = false;
+
+  bool known = bedrock::network::VisitQuicVersion(version, [&](auto traits) {
+    QuicPacketBuilder<decltype(traits)> builder(send_buffer, 1500);
+    built = builder.BeginLongPacket(QuicLongHeaderPacketTypeV1::kInitial, kDcid,
+                                    {}, {}, 0, 1) ==
+                QuicPacketBuilderErrorStatus::kSuccess &&
+            builder.FinishPacket(1200) ==
+                QuicPacketBuilderErrorStatus::kSuccess;
+  });
+  first_byte = send_buffer[0];
+  wire_version = bedrock::network::LoadBigEndian<std::uint32_t>(
+      send_buffer.data() + 1);
+  return known && built;
+}
+
+int main() {
+  std::uint8_t first_byte = 0;
+  std::uint32_t wire_version = 0;
+
+  if (!BuildInitial(QuicVersion1::kVersion, first_byte, wire_version) ||
+      first_byte != 0xC0 || wire_version != QuicVersion1::kVersion) {
+    std::cout << "version 1 Initial mismatch" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!BuildInitial(QuicVersion2::kVersion, first_byte, wire_version) ||
+      first_byte != 0xD0 || wire_version != QuicVersion2::kVersion) {
+    std::cout << "version 2 Initial mismatch" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (BuildInitial(0x0A0A0A0A, first_byte, wire_version)) {
+    std::cout << "unknown version was dispatched" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "QUIC version test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
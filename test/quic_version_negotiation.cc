@@ -0,0 +1,147 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_version_negotiation.h"
+#include "networking/quic/rfc9000.h"
+
+using bedrock::network::QuicVersionNegotiationBuffer;
+using bedrock::network::QuicVersionNegotiationErrorStatus;
+using bedrock::network::QuicVersionNegotiationPacketV1;
+using bedrock::network::QuicVersionNegotiationResponder;
+
+static const std::array<std::uint32_t, 2> kSupported = {0x00000001,
+                                                        0x6B3343CF};
+
+// 1200 byte long header datagram with the given version and connection IDs
+static std::vector<std::uint8_t> Datagram(std::uint32_t version,
+                                          std::uint8_t dcid_length,
+                                          std::uint8_t scid_length) {
+  std::vector<std::uint8_t> datagram(1200, 0xEE);
+  datagram[0] = 0xC3;
+  bedrock::network::StoreBigEndian(datagram.data() + 1, version);
+  std::size_t position = 5;
+  datagram[position++] = dcid_length;
+  for (std::uint8_t i = 0; i < dcid_length; i++) {
+    datagram[position++] = static_cast<std::uint8_t>(0xD0 + i);
+  }
+  datagram[position++] = scid_length;
+  for (std::uint8_t i = 0; i < scid_length; i++) {
+    datagram[position++] = static_cast<std::uint8_t>(0x50 + i);
+  }
+  return datagram;
+}
+
+static bool CheckResponse() {
+  QuicVersionNegotiationResponder responder(kSupported);
+  auto datagram = Datagram(0x1A2A3A4A, 8, 5);
+
+  QuicVersionNegotiationBuffer buffer;
+  std::size_t size = 0;
+  if (responder.Respond(datagram, buffer, size) !=
+      QuicVersionNegotiationErrorStatus::kSuccess) {
+    std::cout << "no response to an unknown version" << std::endl;
+    return false;
+  }
+
+  QuicVersionNegotiationPacketV1 packet;
+  packet.data.assign(buffer.begin(),
+                     buffer.begin() + static_cast<std::ptrdiff_t>(size));
+  if (!packet.HeaderForm() || !(packet.Unused() & 0x40) ||
+      packet.Version() != 0 || packet.DestinationConnectionIDLength() != 5 ||
+      packet.DestinationConnectionID()[0] != 0x50 ||
+      packet.SourceConnectionIDLength() != 8 ||
+      packet.SourceConnectionID()[7] != 0xD7 ||
+      packet.SupportedVersionCount() != kSupported.size() ||
+      packet.SupportedVersion(0) != kSupported[0] ||
+      packet.SupportedVersion(1) != kSupported[1]) {
+    std::cout << "response does not round trip" << std::endl;
+    return false;
+  }
+
+  // rfc8999 allows long connection IDs for unknown versions
+  auto long_ids = Datagram(0x0A0A0A0A, 255, 255);
+  if (responder.Respond(long_ids, buffer, size) !=
+          QuicVersionNegotiationErrorStatus::kSuccess ||
+      size != 7 + 255 + 255 + 8) {
+    std::cout << "255 byte connection IDs not echoed" << std::endl;
+    return false;
+  }
+  std::array<std::uint8_t, 64> small{};
+  if (responder.Respond(long_ids, small, size) !=
+      QuicVersionNegotiationErrorStatus::kNoSpace) {
+    std::cout << "small response buffer not detected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckIgnored() {
+  QuicVersionNegotiationResponder responder(kSupported);
+  QuicVersionNegotiationBuffer buffer;
+  std::size_t size = 0;
+
+  struct Case {
+    std::vector<std::uint8_t> datagram;
+    QuicVersionNegotiationErrorStatus expected;
+  };
+  std::vector<Case> cases;
+  cases.push_back({Datagram(1, 8, 8),
+                   QuicVersionNegotiationErrorStatus::kSupported});
+  cases.push_back({Datagram(0, 8, 8),
+                   QuicVersionNegotiationErrorStatus::kNegotiation});
+  auto short_header = Datagram(7, 8, 8);
+  short_header[0] = 0x40;
+  cases.push_back(
+      {short_header, QuicVersionNegotiationErrorStatus::kShortHeader});
+  auto small = Datagram(7, 8, 8);
+  small.resize(200);
+  cases.push_back({small, QuicVersionNegotiationErrorStatus::kTooSmall});
+
+  for (const auto& test : cases) {
+    if (responder.Respond(test.datagram, buffer, size) != test.expected) {
+      std::cout << "unexpected status for ignored packet" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void Benchmark() {
+  constexpr int kIterations = 2000000;
+  QuicVersionNegotiationResponder responder(kSupported);
+  auto datagram = Datagram(0xBADBAD00, 20, 20);
+  QuicVersionNegotiationBuffer buffer;
+  std::size_t size = 0;
+  std::size_t answered = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    // a different junk version every packet
+    datagram[4] = static_cast<std::uint8_t>(i);
+    if (responder.Respond(datagram, buffer, size) ==
+        QuicVersionNegotiationErrorStatus::kSuccess) {
+      answered += buffer[size - 1] != 0xFF;
+    }
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+  std::cout << "Answered " << answered << " junk version packets in "
+            << elapsed << "s ("
+            << static_cast<double>(answered) / elapsed / 1e6 << " Mpps)"
+            << std::endl;
+}
+
+int main() {
+  if (!CheckResponse() || !CheckIgnored()) {
+    return EXIT_FAILURE;
+  }
+  Benchmark();
+
+  std::cout << "Version negotiation test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "networking/quic/quic_packet.h"
+#include "networking/quic/quic_wire.h"
+
+using bedrock::network::LoadBigEndian;
+using bedrock::network::QuicWireReader;
+using bedrock::network::QuicWireWriter;
+using bedrock::network::StoreBigEndian;
+
+static constexpr std::array<std::uint8_t, 9> kBytes = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+
+// Compile time evaluation of the same helpers used at run time
+static_assert(LoadBigEndian<std::uint16_t>(kBytes.data() + 1) == 0x0102);
+static_assert(LoadBigEndian<std::uint32_t>(kBytes.data() + 1) == 0x01020304);
+static_assert(LoadBigEndian<std::uint64_t>(kBytes.data() + 1) ==
+              0x0102030405060708);
+static_assert(bedrock::network::QuicLongPacketHeaderLayout::kSize == 6);
+static_assert([] {
+  std::array<std::uint8_t, 8> buffer{};
+  QuicWireWriter writer(buffer);
+  writer.WriteVarInt(494878333);
+  QuicWireReader reader(writer.Written());
+  return reader.ReadVarInt() == 494878333 && reader.Ok() && reader.Empty();
+}());
+
+static bool CheckLoadStore() {
+  // unaligned offsets on purpose
+  std::array<std::uint8_t, 16> buffer{};
+  StoreBigEndian<std::uint32_t>(buffer.data() + 3, 0xDEADBEEF);
+  StoreBigEndian<std::uint64_t>(buffer.data() + 7, 0x0011223344556677);
+  if (buffer[3] != 0xDE || buffer[6] != 0xEF || buffer[7] != 0x00 ||
+      buffer[14] != 0x77 ||
+      LoadBigEndian<std::uint32_t>(buffer.data() + 3) != 0xDEADBEEF ||
+      LoadBigEndian<std::uint64_t>(buffer.data() + 7) != 0x0011223344556677 ||
+      LoadBigEndian(buffer.data() + 3, 3) != 0xDEADBE) {
+    std::cout << "load/store mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckVarInt() {
+  // rfc9000 appendix A.1 sample encodings
+  const std::vector<std::uint8_t> samples = {
+      0xc2, 0x19, 0x7c, 0x5e, 0xff, 0x14, 0xe8, 0x8c,  // 151288809941952652
+      0x9d, 0x7f, 0x3e, 0x7d,                          // 494878333
+      0x7b, 0xbd,                                      // 15293
+      0x25,                                            // 37
+      0x40, 0x25};                                     // 37, two bytes
+  const std::uint64_t expected[] = {151288809941952652u, 494878333, 15293, 37,
+                                    37};
+  QuicWireReader reader(samples);
+  for (auto value : expected) {
+    if (reader.ReadVarInt() != value) {
+      std::cout << "varint decode mismatch" << std::endl;
+      return false;
+    }
+  }
+  if (!reader.Ok() || !reader.Empty() || reader.ReadVarInt() != 0 ||
+      reader.Ok()) {
+    std::cout << "varint end of buffer not detected" << std::endl;
+    return false;
+  }
+
+  std::array<std::uint8_t, 64> buffer{};
+  QuicWireWriter writer(buffer);
+  const std::uint64_t boundaries[] = {0,          63,         64,
+                                      16383,      16384,      1073741823,
+                                      1073741824, (1ull << 62) - 1};
+  for (auto value : boundaries) {
+    writer.WriteVarInt(value);
+  }
+  QuicWireReader round_trip(writer.Written());
+  for (auto value : boundaries) {
+    if (round_trip.ReadVarInt() != value) {
+      std::cout << "varint round trip mismatch at " << value << std::endl;
+      return false;
+    }
+  }
+  return round_trip.Ok() && round_trip.Empty();
+}
+
+static bool CheckStickyErrors() {
+  const std::array<std::uint8_t, 3> short_buffer = {0x80, 0x01, 0x02};
+  QuicWireReader reader(short_buffer);
+  reader.ReadVarInt();  // needs 4 bytes
+  if (reader.Ok() || reader.Read<std::uint8_t>() != 0 ||
+      !reader.ReadBytes(1u).empty()) {
+    std::cout << "reader error is not sticky" << std::endl;
+    return false;
+  }
+  // a failed read leaves the position where it was, so readable bytes
+  // follow it and must still not be returned
+  const std::array<std::uint8_t, 2> bytes = {0x05, 0x06};
+  QuicWireReader bytes_reader(bytes);
+  QuicWireReader int_reader(bytes);
+  if (!bytes_reader.ReadBytes(3u).empty() ||
+      bytes_reader.ReadVarInt() != 0 || bytes_reader.Ok() ||
+      int_reader.Read<std::uint32_t>() != 0 || int_reader.ReadVarInt() != 0 ||
+      int_reader.Read<std::uint8_t>() != 0 || int_reader.Ok()) {
+    std::cout << "read after a failed read succeeded" << std::endl;
+    return false;
+  }
+
+  std::array<std::uint8_t, 3> out{};
+  QuicWireWriter writer(out);
+  writer.Write<std::uint16_t>(0xABCD);
+  writer.Write<std::uint16_t>(0x1234);
+  if (writer.Ok() || writer.Position() != 2 || out[2] != 0) {
+    std::cout << "writer overflow not detected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static bool CheckPacketHeaders() {
+  bedrock::network::QuicLongPacketHeader header;
+  header.data = {0xC3, 0x00, 0x00, 0x00, 0x01, 0x02, 0xAA, 0xBB, 0x01, 0xCC,
+                 0x44};
+  if (header.Version() != 1 || header.DestinationConnectionID().size() != 2 ||
+      header.SourceConnectionID()[0] != 0xCC ||
+      header.VersionspecificData().size() != 1) {
+    std::cout << "long header mismatch" << std::endl;
+    return false;
+  }
+  // connection ID length past the end of the packet
+  header.data = {0xC3, 0x00, 0x00, 0x00, 0x01, 0x14, 0xAA};
+  if (!header.DestinationConnectionID().empty() ||
+      !header.VersionspecificData().empty()) {
+    std::cout << "truncated long header not detected" << std::endl;
+    return false;
+  }
+
+  bedrock::network::QuicVersionNegotiationPacket negotiation;
+  negotiation.data = {0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x7F,
+                      0x00, 0x00, 0x00, 0x01, 0x6B, 0x33, 0x43, 0xCF};
+  if (negotiation.SupportedVersionCount() != 2 ||
+      negotiation.SupportedVersion(0) != 0x00000001 ||
+      negotiation.SupportedVersion(1) != 0x6B3343CF ||
+      negotiation.SupportedVersion(2) != 0) {
+    std::cout << "version negotiation mismatch" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  if (!CheckLoadStore() || !CheckVarInt() || !CheckStickyErrors() ||
+      !CheckPacketHeaders()) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wire cursor test passed." << std::endl;
+  return EXIT_SUCCESS;
+}